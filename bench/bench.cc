@@ -0,0 +1,594 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  bench.cc
+ *
+ *    Description:  Microbenchmarks of hashing, generating, solving and verifying
+ *    				puzzles over a grid of (k, m, l), with JSON output
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 08:05:44 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/server.h"
+#include "server/optserver.h"
+#include "client/client.h"
+#include "client/optclient.h"
+#include "puzzle/crypto_util.h"
+#include "puzzle/sha256_mb.h"
+#include "puzzle/metrics.h"
+#include "puzzle/random.h"
+
+#include <atomic>
+#include <vector>
+#include <time.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+#ifndef KEY_LEN
+#define KEY_LEN 128 /* in bytes */
+#endif
+
+#ifndef DATA_LEN
+#define DATA_LEN 256 /* in bytes */
+#endif
+
+#ifndef MAX_GRID
+#define MAX_GRID 8 /* values per grid axis */
+#endif
+
+
+/*-----------------------------------------------------------------------------
+ *  Counting allocations, the executable's malloc interposes the one of libc
+ *  for the libraries too
+ *-----------------------------------------------------------------------------*/
+
+extern "C" {
+void *__libc_malloc (size_t size);
+void *__libc_calloc (size_t nmemb, size_t size);
+void *__libc_realloc (void *ptr, size_t size);
+void __libc_free (void *ptr);
+}
+
+static std::atomic<uint64_t> alloc_count (0);
+
+extern "C" void *
+malloc (size_t size)
+{
+	alloc_count.fetch_add (1, std::memory_order_relaxed);
+	return __libc_malloc (size);
+}
+
+extern "C" void *
+calloc (size_t nmemb, size_t size)
+{
+	alloc_count.fetch_add (1, std::memory_order_relaxed);
+	return __libc_calloc (nmemb, size);
+}
+
+extern "C" void *
+realloc (void *ptr, size_t size)
+{
+	alloc_count.fetch_add (1, std::memory_order_relaxed);
+	return __libc_realloc (ptr, size);
+}
+
+extern "C" void
+free (void *ptr)
+{
+	__libc_free (ptr);
+}
+
+
+/*-----------------------------------------------------------------------------
+ *  Running and reporting
+ *-----------------------------------------------------------------------------*/
+
+/* struct to hold the arguments for the program */
+typedef struct {
+	unsigned int ks[MAX_GRID], nk;	/* the numbers of sub puzzles */
+	unsigned int ms[MAX_GRID], nm;	/* the bits of difficulty */
+	unsigned int ls[MAX_GRID], nl;	/* the bits of x + z of the optimized scheme */
+	unsigned int seed;				/* the seed of the random inputs */
+	double scale;					/* a factor on the number of iterations */
+	const char *output;				/* the JSON file, NULL for stdout */
+} arguments_t;
+
+/* The outcome of one benchmark */
+typedef struct {
+	const char *name;
+	unsigned int k, m, l;
+	uint64_t iterations;
+	double seconds;				/* the time spent in the operation */
+	double hashes_per_op;		/* the SHA256 hashes per operation */
+	bool hashes_estimated;		/* whether hashes_per_op is an expectation */
+	uint64_t allocations;		/* the allocations during the timed runs */
+} result_t;
+
+/* The state shared by the benchmarks */
+typedef struct {
+	unsigned char key[KEY_LEN];
+	unsigned char data[DATA_LEN];
+	int null_fd;				/* /dev/null, where the library logs go */
+	int stdout_fd;				/* the real stdout */
+	std::vector<result_t> results;
+} bench_t;
+
+/* read command line arguments */
+static int
+read_cmd_args (int argc, char **argv, arguments_t *args);
+
+/* the clock of the benchmarks */
+static inline double
+now_seconds ()
+{
+	timespec t;
+	clock_gettime (CLOCK_MONOTONIC, &t);
+	return t.tv_sec + 1e-9 * t.tv_nsec;
+} /* now_seconds */
+
+/* send the library's printf logs to /dev/null during the timed runs */
+static void
+silence (bench_t *bench)
+{
+	fflush (stdout);
+	dup2 (bench->null_fd, STDOUT_FILENO);
+} /* silence */
+
+static void
+unsilence (bench_t *bench)
+{
+	fflush (stdout);
+	dup2 (bench->stdout_fd, STDOUT_FILENO);
+} /* unsilence */
+
+/* a timed section, the allocations are counted along */
+typedef struct {
+	double start;
+	uint64_t allocs;
+} section_t;
+
+static inline void
+section_begin (section_t *s)
+{
+	s->allocs = alloc_count.load (std::memory_order_relaxed);
+	s->start = now_seconds ();
+} /* section_begin */
+
+static inline void
+section_end (section_t *s, result_t *r)
+{
+	r->seconds += now_seconds () - s->start;
+	r->allocations += alloc_count.load (std::memory_order_relaxed) - s->allocs;
+} /* section_end */
+
+/* get the number of hashes the library counted so far, 0 if the metrics
+ * are compiled out */
+static uint64_t
+hashes_counted ()
+{
+	metrics_snapshot_t snap;
+	metrics_snapshot (&snap);
+	return snap.counters[METRIC_HASHES];
+} /* hashes_counted */
+
+/* replace the expected hashes of a solver with the counted ones */
+static void
+count_hashes (result_t *r, uint64_t before)
+{
+	uint64_t hashes = hashes_counted () - before;
+	if (hashes == 0)
+		return; /* no metrics, keep the estimate */
+
+	r->hashes_per_op = (double) hashes / r->iterations;
+	r->hashes_estimated = false;
+} /* count_hashes */
+
+/* a new result for a benchmark */
+static result_t
+new_result (const char *name, unsigned int k, unsigned int m, unsigned int l,
+		double hashes_per_op, bool estimated)
+{
+	result_t r;
+	r.name = name;
+	r.k = k;
+	r.m = m;
+	r.l = l;
+	r.iterations = 0;
+	r.seconds = 0;
+	r.hashes_per_op = hashes_per_op;
+	r.hashes_estimated = estimated;
+	r.allocations = 0;
+
+	return r;
+} /* new_result */
+
+/* the number of iterations of a benchmark */
+static inline uint64_t
+iterations (const arguments_t *args, double base)
+{
+	uint64_t n = (uint64_t) (base * args->scale);
+	return n > 0 ? n : 1;
+} /* iterations */
+
+/* create random set of bytes from the seeded generator */
+static void
+create_random_bytes (unsigned char *buf, unsigned int buf_len)
+{
+	random_bytes (buf, buf_len);
+} /* create_random_bytes */
+
+
+/*-----------------------------------------------------------------------------
+ *  The benchmarks
+ *-----------------------------------------------------------------------------*/
+
+/* digest_message over an l bit message */
+static void
+bench_digest (bench_t *bench, const arguments_t *args, unsigned int l)
+{
+	unsigned int len = l/8;
+	unsigned char msg[DATA_LEN];
+	if (len > DATA_LEN)
+		len = DATA_LEN;
+	memcpy (msg, bench->data, len);
+
+	result_t r = new_result ("digest_message", 0, 0, l, 1, false);
+	r.iterations = iterations (args, 200000);
+
+	section_t s;
+	section_begin (&s);
+	for (uint64_t it = 0; it < r.iterations; it++)
+	{
+		unsigned int digest_len;
+		unsigned char *digest = digest_message (msg, len, &digest_len);
+		msg[0] ^= digest[0];
+		OPENSSL_free (digest);
+	}
+	section_end (&s, &r);
+
+	bench->results.push_back (r);
+} /* bench_digest */
+
+/* compare_bits over m bits of two equal buffers */
+static void
+bench_compare (bench_t *bench, const arguments_t *args, unsigned int m)
+{
+	unsigned char x[SHA256_DIGEST_LEN], y[SHA256_DIGEST_LEN];
+	memcpy (x, bench->data, sizeof (x));
+	memcpy (y, bench->data, sizeof (y));
+
+	result_t r = new_result ("compare_bits", 0, m, 0, 0, false);
+	r.iterations = iterations (args, 2000000);
+
+	unsigned int matches = 0;
+	section_t s;
+	section_begin (&s);
+	for (uint64_t it = 0; it < r.iterations; it++)
+	{
+		matches += compare_bits (x, y, m);
+		asm volatile ("" : : "r" (x) : "memory");
+	}
+	section_end (&s, &r);
+
+	if (matches != r.iterations)
+		fprintf (stderr, "[ERROR]: compare_bits disagrees with itself!\n");
+
+	bench->results.push_back (r);
+} /* bench_compare */
+
+/* the naive scheme, generation, verification and solving */
+static void
+bench_naive (bench_t *bench, const arguments_t *args, unsigned int k, unsigned int m)
+{
+	section_t s;
+
+	/* generate_puzzle does 2 hashes per sub puzzle */
+	result_t gen = new_result ("generate_puzzle", k, m, 0, 2.0 * k, false);
+	gen.iterations = iterations (args, 20000.0 / k);
+
+	silence (bench);
+	for (uint64_t it = 0; it < gen.iterations; it++)
+	{
+		section_begin (&s);
+		SHA256Challenge *challenge = generate_puzzle (bench->data, DATA_LEN,
+				bench->key, KEY_LEN, (uint32_t) it, k, m);
+		section_end (&s, &gen);
+
+		free_challenge_mem (challenge);
+		free (challenge);
+	}
+
+	/* solvePuzzle searches half of the 2^m candidates on average */
+	result_t solve = new_result ("solvePuzzle", k, m, 0,
+			k * (double) (1ULL << m) / 2, true);
+	solve.iterations = iterations (args, (double) (1 << 20) / (k * (1ULL << m)) + 1);
+
+	SHA256Solution *sol = NULL;
+	uint64_t hashes = hashes_counted ();
+	for (uint64_t it = 0; it < solve.iterations; it++)
+	{
+		SHA256Challenge *challenge = generate_puzzle (bench->data, DATA_LEN,
+				bench->key, KEY_LEN, 1, k, m);
+
+		if (sol)
+		{
+			free_solution_mem (sol);
+			free (sol);
+		}
+
+		section_begin (&s);
+		sol = solvePuzzle (challenge);
+		section_end (&s, &solve);
+
+		free_challenge_mem (challenge);
+		free (challenge);
+	}
+	count_hashes (&solve, hashes);
+
+	/* verify_solution does 1 hash per sub puzzle */
+	result_t verify = new_result ("verify_solution", k, m, 0, k, false);
+	verify.iterations = iterations (args, 20000.0 / k);
+
+	unsigned int verified = 0;
+	section_begin (&s);
+	for (uint64_t it = 0; it < verify.iterations; it++)
+		verified += verify_solution (sol, bench->data, DATA_LEN, bench->key, KEY_LEN, k);
+	section_end (&s, &verify);
+	unsilence (bench);
+
+	if (verified != verify.iterations)
+		fprintf (stderr, "[ERROR]: naive solution with k=%u m=%u did not verify!\n", k, m);
+
+	free_solution_mem (sol);
+	free (sol);
+
+	bench->results.push_back (gen);
+	bench->results.push_back (solve);
+	bench->results.push_back (verify);
+} /* bench_naive */
+
+/* the optimized scheme, generation, verification and solving */
+static void
+bench_opt (bench_t *bench, const arguments_t *args, unsigned int k,
+		unsigned int m, unsigned int l)
+{
+	section_t s;
+
+	/* generate_challenge does a single hash */
+	result_t gen = new_result ("generate_challenge", k, m, l, 1, false);
+	gen.iterations = iterations (args, 100000);
+
+	silence (bench);
+	for (uint64_t it = 0; it < gen.iterations; it++)
+	{
+		section_begin (&s);
+		SHA256OptChallenge *challenge = generate_challenge (bench->data, DATA_LEN,
+				bench->key, KEY_LEN, (uint32_t) it, k, m, l);
+		section_end (&s, &gen);
+
+		OPENSSL_free (challenge->preimage);
+		free (challenge);
+	}
+
+	/* solveChallenge tries 2^m candidates on average */
+	result_t solve = new_result ("solveChallenge", k, m, l,
+			k * (double) (1ULL << m), true);
+	solve.iterations = iterations (args, (double) (1 << 20) / (k * (1ULL << m)) + 1);
+
+	SHA256OptSolution *sol = NULL;
+	uint64_t hashes = hashes_counted ();
+	for (uint64_t it = 0; it < solve.iterations; it++)
+	{
+		SHA256OptChallenge *challenge = generate_challenge (bench->data, DATA_LEN,
+				bench->key, KEY_LEN, 1, k, m, l);
+
+		if (sol)
+			free_solution_mem (sol);
+
+		section_begin (&s);
+		sol = solveChallenge (challenge);
+		section_end (&s, &solve);
+
+		OPENSSL_free (challenge->preimage);
+		free (challenge);
+	}
+	count_hashes (&solve, hashes);
+
+	/* verify_solution hashes x once and each sub puzzle once */
+	result_t verify = new_result ("verify_solution_opt", k, m, l, 1.0 + k, false);
+	verify.iterations = iterations (args, 20000.0 / k);
+
+	unsigned int verified = 0;
+	section_begin (&s);
+	for (uint64_t it = 0; it < verify.iterations; it++)
+		verified += verify_solution (sol, bench->data, DATA_LEN,
+				bench->key, KEY_LEN, l, k, m);
+	section_end (&s, &verify);
+	unsilence (bench);
+
+	if (verified != verify.iterations)
+		fprintf (stderr, "[ERROR]: opt solution with k=%u m=%u l=%u did not verify!\n",
+				k, m, l);
+
+	free_solution_mem (sol);
+
+	bench->results.push_back (gen);
+	bench->results.push_back (solve);
+	bench->results.push_back (verify);
+} /* bench_opt */
+
+/* write the results as JSON */
+static void
+write_json (FILE *out, bench_t *bench, const arguments_t *args)
+{
+	fprintf (out, "{\n");
+	fprintf (out, "  \"seed\": %u,\n", args->seed);
+	fprintf (out, "  \"scale\": %g,\n", args->scale);
+	fprintf (out, "  \"hash_backend\": \"%s\",\n", hash_backend_name (get_hash_backend ()));
+	fprintf (out, "  \"mb_backend\": \"%s\",\n",
+			sha256_mb_backend_name (sha256_mb_get_backend ()));
+	fprintf (out, "  \"results\": [\n");
+
+	for (size_t i = 0; i < bench->results.size (); i++)
+	{
+		result_t *r = &bench->results[i];
+		double ns_per_op = 1e9 * r->seconds / r->iterations;
+		double hashes_per_sec = r->seconds > 0 ?
+			r->hashes_per_op * r->iterations / r->seconds : 0;
+
+		fprintf (out, "    {\"name\": \"%s\", \"k\": %u, \"m\": %u, \"l\": %u, "
+				"\"iterations\": %lu, \"ns_per_op\": %.1f, \"hashes_per_sec\": %.0f, "
+				"\"hashes_estimated\": %s, \"allocs_per_op\": %.2f}%s\n",
+				r->name, r->k, r->m, r->l, (unsigned long) r->iterations,
+				ns_per_op, hashes_per_sec, r->hashes_estimated ? "true" : "false",
+				(double) r->allocations / r->iterations,
+				i + 1 < bench->results.size () ? "," : "");
+	}
+
+	fprintf (out, "  ]\n}\n");
+} /* write_json */
+
+int
+main (int argc, char **argv)
+{
+	arguments_t args;
+	if (read_cmd_args (argc, argv, &args) != 0)
+		exit (-1);
+
+	bench_t bench;
+	bench.null_fd = open ("/dev/null", O_WRONLY);
+	bench.stdout_fd = dup (STDOUT_FILENO);
+	if (bench.null_fd < 0 || bench.stdout_fd < 0)
+	{
+		fprintf (stderr, "[ERROR]: Cannot redirect stdout!\n");
+		exit (-1);
+	}
+
+	/* the same inputs every run, and the same scrambled bits in the
+	 * naive puzzles since they are all generated on this thread */
+	random_seed (args.seed);
+	create_random_bytes (bench.key, KEY_LEN);
+	create_random_bytes (bench.data, DATA_LEN);
+
+	for (unsigned int li = 0; li < args.nl; li++)
+		bench_digest (&bench, &args, args.ls[li]);
+
+	for (unsigned int mi = 0; mi < args.nm; mi++)
+		bench_compare (&bench, &args, args.ms[mi]);
+
+	for (unsigned int ki = 0; ki < args.nk; ki++)
+	{
+		for (unsigned int mi = 0; mi < args.nm; mi++)
+		{
+			bench_naive (&bench, &args, args.ks[ki], args.ms[mi]);
+
+			for (unsigned int li = 0; li < args.nl; li++)
+				bench_opt (&bench, &args, args.ks[ki], args.ms[mi], args.ls[li]);
+		}
+	}
+
+	FILE *out = args.output ? fopen (args.output, "w") : stdout;
+	if (!out)
+	{
+		fprintf (stderr, "[ERROR]: Cannot open %s!\n", args.output);
+		exit (-1);
+	}
+
+	write_json (out, &bench, &args);
+
+	if (out != stdout)
+		fclose (out);
+	close (bench.null_fd);
+	close (bench.stdout_fd);
+
+	return 0;
+} /* main */
+
+/* parse a comma separated list of numbers */
+static int
+parse_list (const char *arg, unsigned int *values, unsigned int *n)
+{
+	*n = 0;
+	while (*arg)
+	{
+		if (*n == MAX_GRID || !isdigit (*arg))
+			return -1;
+
+		char *end;
+		values[(*n)++] = (unsigned int) strtoul (arg, &end, 10);
+
+		arg = (*end == ',') ? end + 1 : end;
+		if (*end && *end != ',')
+			return -1;
+	}
+
+	return *n > 0 ? 0 : -1;
+} /* parse_list */
+
+static int
+read_cmd_args (int argc, char **argv, arguments_t *args)
+{
+	int c;
+
+	/* default values */
+	parse_list ("4,16", args->ks, &args->nk);
+	parse_list ("8,12", args->ms, &args->nm);
+	parse_list ("128,256", args->ls, &args->nl);
+	args->seed = 1;
+	args->scale = 1.0;
+	args->output = NULL;
+
+	while ( (c = getopt (argc, argv, "k:m:l:s:n:o:h")) != -1)
+	{
+		switch (c)
+		{
+			case 'k':
+				if (parse_list (optarg, args->ks, &args->nk) != 0)
+					return -1;
+				break;
+			case 'm':
+				if (parse_list (optarg, args->ms, &args->nm) != 0)
+					return -1;
+				break;
+			case 'l':
+				if (parse_list (optarg, args->ls, &args->nl) != 0)
+					return -1;
+				break;
+			case 's':
+				args->seed = atoi (optarg);
+				break;
+			case 'n':
+				args->scale = atof (optarg);
+				break;
+			case 'o':
+				args->output = optarg;
+				break;
+			case 'h':
+			default:
+				printf ("Usage: %s [-k k1,k2..] [-m m1,m2..] [-l l1,l2..] "
+						"[-s seed] [-n iteration_scale] [-o out.json]\n", argv[0]);
+				return -1;
+		}
+	}
+
+	for (unsigned int i = 0; i < args->nl; i++)
+	{ /* the optimized scheme takes x out of a single digest */
+		if ((args->ls[i]/2) % 8 != 0 || args->ls[i] == 0 || args->ls[i] > 512)
+		{
+			printf ("[ERROR]: l must be a non zero multiple of 16 of at most 512.\n");
+			return -1;
+		}
+	}
+
+	return 0;
+} /* read_cmd_args */
@@ -0,0 +1,324 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  udp_flood.cc
+ *
+ *    Description:  A flood of datagrams against an in-process datagram gateway,
+ *    				reports the packets served per second and per core in JSON
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 05:52:13 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "gateway/udp_gateway.h"
+#include "puzzle/wire.h"
+#include "client/optclient.h"
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/rand.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifndef KEY_LEN
+#define KEY_LEN 32 /* in bytes */
+#endif
+
+/* the datagrams of one sendmmsg */
+#define FLOOD_BATCH 64
+
+/* what the senders send */
+typedef enum {
+	FLOOD_HELLO = 0,	/* padded hellos, every one is minted a challenge */
+	FLOOD_BOGUS,		/* datagrams that are not ours, every one is ignored */
+	FLOOD_REPLAY,		/* one solution over and over, every one is verified */
+} flood_mode_t;
+
+static const char *mode_names[] = { "hello", "bogus", "replay" };
+
+/* struct to hold the arguments for the program */
+typedef struct {
+	unsigned int workers;	/* the gateway's workers */
+	unsigned int senders;	/* the threads flooding it */
+	unsigned int seconds;	/* how long the flood lasts */
+	flood_mode_t mode;
+	unsigned int k, m, l;
+} arguments_t;
+
+/* read command line arguments */
+static int
+read_cmd_args (int argc, char **argv, arguments_t *args);
+
+/* the CPU time of the calling thread */
+static double
+thread_seconds ()
+{
+	timespec t;
+	clock_gettime (CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec + 1e-9 * t.tv_nsec;
+} /* thread_seconds */
+
+/* the CPU time of the whole process */
+static double
+process_seconds ()
+{
+	timespec t;
+	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &t);
+	return t.tv_sec + 1e-9 * t.tv_nsec;
+} /* process_seconds */
+
+/* the wall clock */
+static double
+now_seconds ()
+{
+	timespec t;
+	clock_gettime (CLOCK_MONOTONIC, &t);
+	return t.tv_sec + 1e-9 * t.tv_nsec;
+} /* now_seconds */
+
+/* build the datagram a sender repeats, a solution needs a challenge minted
+ * for the sender's own socket first
+ *
+ * returns the length of the datagram, 0 on failure
+ */
+static size_t
+build_packet (int fd, const arguments_t *args, unsigned char *pkt, size_t len)
+{
+	size_t hello_len = encode_hello (args->l/16, pkt, len);
+
+	if (args->mode == FLOOD_HELLO)
+		return hello_len;
+
+	if (args->mode == FLOOD_BOGUS)
+	{ /* the size of a hello, but not one of ours */
+		memset (pkt, 0xa5, hello_len);
+		return hello_len;
+	}
+
+	unsigned char cpkt[WIRE_HEADER_LEN + 64];
+	struct pollfd p = { fd, POLLIN, 0 };
+	ssize_t clen;
+	WirePacket wire;
+	if (send (fd, pkt, hello_len, 0) != (ssize_t) hello_len || poll (&p, 1, 1000) != 1
+			|| (clen = recv (fd, cpkt, sizeof (cpkt), 0)) <= 0
+			|| wire_parse (cpkt, clen, &wire) != WIRE_OK)
+		return 0;
+
+	SHA256OptChallenge *challenge = decode_optchallenge (&wire);
+	SHA256OptSolution *sol = solveChallenge (challenge);
+	size_t n = encode_solution (sol, args->l, args->k, pkt, len);
+	OPENSSL_free (challenge->preimage);
+	free (challenge);
+	free_solution_mem (sol);
+
+	return n;
+} /* build_packet */
+
+/* blast the same datagram at the gateway until told to stop, the answers
+ * are left to overflow the socket's buffer */
+static void
+sender_main (uint16_t port, const arguments_t *args, std::atomic<bool> *stop,
+		std::atomic<uint64_t> *sent, std::atomic<double> *cpu)
+{
+	int fd = socket (AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in addr;
+	memset (&addr, 0, sizeof (addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons (port);
+	addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+	connect (fd, (struct sockaddr *) &addr, sizeof (addr));
+
+	unsigned char pkt[WIRE_HEADER_LEN + 64 * 64];
+	size_t len = build_packet (fd, args, pkt, sizeof (pkt));
+	if (len == 0)
+	{
+		fprintf (stderr, "[ERROR]: A sender could not build its datagram!\n");
+		close (fd);
+		return;
+	}
+
+	struct iovec iov = { pkt, len };
+	struct mmsghdr msgs[FLOOD_BATCH];
+	memset (msgs, 0, sizeof (msgs));
+	for (unsigned int i = 0; i < FLOOD_BATCH; i++)
+	{
+		msgs[i].msg_hdr.msg_iov = &iov;
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	double start = thread_seconds ();
+	uint64_t count = 0;
+	while (!stop->load (std::memory_order_relaxed))
+	{
+		int n = sendmmsg (fd, msgs, FLOOD_BATCH, 0);
+		if (n > 0)
+			count += n;
+	}
+
+	sent->fetch_add (count);
+	double spent = thread_seconds () - start;
+	for (double c = cpu->load (); !cpu->compare_exchange_weak (c, c + spent); )
+		;
+	close (fd);
+} /* sender_main */
+
+int
+main (int argc, char **argv)
+{
+	arguments_t args;
+	if (read_cmd_args (argc, argv, &args) != 0)
+		exit (-1);
+
+	unsigned char key[KEY_LEN];
+	RAND_bytes (key, KEY_LEN);
+
+	UdpGatewayConfig config;
+	udp_gateway_default_config (&config);
+	config.host = "127.0.0.1";
+	config.nthreads = args.workers;
+	config.rcvbuf = 1 << 22;
+	config.key = key;
+	config.key_len = KEY_LEN;
+	config.k = args.k;
+	config.m = args.m;
+	config.l = args.l;
+	config.max_age = args.seconds + 30;
+
+	/* the library logs the challenges it solves, keep stdout for the JSON */
+	fflush (stdout);
+	int stdout_fd = dup (STDOUT_FILENO);
+	freopen ("/dev/null", "w", stdout);
+
+	PlutusUdpGateway *gw = create_udp_gateway (&config);
+	if (!gw)
+	{
+		fprintf (stderr, "[ERROR]: Could not start the datagram gateway!\n");
+		exit (-1);
+	}
+
+	std::atomic<bool> stop (false);
+	std::atomic<uint64_t> sent (0);
+	std::atomic<double> sender_cpu (0);
+	std::vector<std::thread> senders;
+
+	double cpu_start = process_seconds ();
+	double start = now_seconds ();
+	for (unsigned int s = 0; s < args.senders; s++)
+		senders.push_back (std::thread (sender_main, udp_gateway_port (gw), &args,
+					&stop, &sent, &sender_cpu));
+
+	sleep (args.seconds);
+	stop = true;
+	for (std::thread &t : senders)
+		t.join ();
+
+	/* let the workers drain their buffers before the counters are read */
+	usleep (100000);
+	double wall = now_seconds () - start;
+	double gateway_cpu = process_seconds () - cpu_start - sender_cpu.load ();
+
+	UdpGatewayStats stats;
+	udp_gateway_stats (gw, &stats);
+	free_udp_gateway (gw);
+
+	fflush (stdout);
+	dup2 (stdout_fd, STDOUT_FILENO);
+	close (stdout_fd);
+
+	printf ("{\n  \"mode\": \"%s\", \"workers\": %u, \"senders\": %u, \"seconds\": %.2f,\n"
+			"  \"k\": %u, \"m\": %u, \"l\": %u,\n"
+			"  \"sent\": %lu, \"received\": %lu, \"batches\": %lu, \"minted\": %lu,\n"
+			"  \"admitted\": %lu, \"rejected\": %lu, \"ignored\": %lu, \"send_failed\": %lu,\n"
+			"  \"packets_per_sec\": %.0f, \"gateway_cpu_seconds\": %.2f,"
+			" \"packets_per_core_sec\": %.0f, \"packets_per_batch\": %.1f\n}\n",
+			mode_names[args.mode], args.workers, args.senders, wall, args.k, args.m, args.l,
+			(unsigned long) sent.load (), (unsigned long) stats.received,
+			(unsigned long) stats.batches, (unsigned long) stats.minted,
+			(unsigned long) stats.admitted, (unsigned long) stats.rejected,
+			(unsigned long) stats.ignored, (unsigned long) stats.send_failed,
+			stats.received / wall, gateway_cpu,
+			gateway_cpu > 0 ? stats.received / gateway_cpu : 0,
+			stats.batches ? (double) stats.received / stats.batches : 0);
+
+	return 0;
+} /* main */
+
+static int
+read_cmd_args (int argc, char **argv, arguments_t *args)
+{
+	int c;
+
+	/* default values */
+	args->workers = 1;
+	args->senders = 2;
+	args->seconds = 3;
+	args->mode = FLOOD_HELLO;
+	args->k = 4;
+	args->m = 8;
+	args->l = 128;
+
+	while ( (c = getopt (argc, argv, "t:s:d:w:k:m:l:h")) != -1)
+	{
+		switch (c)
+		{
+			case 't':
+				args->workers = atoi (optarg);
+				break;
+			case 's':
+				args->senders = atoi (optarg);
+				break;
+			case 'd':
+				args->seconds = atoi (optarg);
+				break;
+			case 'w':
+				if (strcmp (optarg, "hello") == 0)
+					args->mode = FLOOD_HELLO;
+				else if (strcmp (optarg, "bogus") == 0)
+					args->mode = FLOOD_BOGUS;
+				else if (strcmp (optarg, "replay") == 0)
+					args->mode = FLOOD_REPLAY;
+				else
+					return -1;
+				break;
+			case 'k':
+				args->k = atoi (optarg);
+				break;
+			case 'm':
+				args->m = atoi (optarg);
+				break;
+			case 'l':
+				args->l = atoi (optarg);
+				break;
+			case 'h':
+			default:
+				printf ("Usage: %s [-t workers] [-s senders] [-d seconds] "
+						"[-w hello|bogus|replay] [-k num_subpuzzle] [-m bits_difficulty] "
+						"[-l prefix_len]\n", argv[0]);
+				return -1;
+		}
+	}
+
+	if (args->workers == 0 || args->senders == 0 || args->k == 0 || args->k > 64
+			|| args->l == 0 || args->l > 512 || (args->l/2) % 8 != 0)
+	{
+		printf ("[ERROR]: Invalid arguments, l must be a non zero multiple of 16 of at most 512.\n");
+		return -1;
+	}
+
+	return 0;
+} /* read_cmd_args */
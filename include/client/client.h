@@ -20,9 +20,12 @@
 #define __CLIENT_H
 
 #include <puzzle/puzzle.h>
+#include <client/solver_pool.h>
+#include <client/step_solver.h>
 
 
-/* solve a puzzle. Returns a puzzle solution structure
+/* solve a puzzle. Returns a puzzle solution structure, NULL if the
+ * difficulty is more than the 63 bits a 64 bit candidate counter enumerates
  *
  * arguments are:
  *
@@ -31,23 +34,64 @@
 
 SHA256Solution *solvePuzzle (SHA256Challenge *challenge);
 
+/* solve a puzzle on a pool of worker threads. The sub puzzles and their
+ * candidate ranges are spread over the workers, and the subsolutions come
+ * back in the same order as the sub puzzles. Unlike solvePuzzle, the
+ * preimages of the challenge are left untouched.
+ *
+ * arguments are:
+ *
+ *  challenge		-- The puzzle challenge to solve
+ *  pool			-- The pool of workers to solve on
+ */
+
+SHA256Solution *solvePuzzleParallel (SHA256Challenge *challenge,
+		SolverPool *pool);
+
+/* start solving a puzzle a step at a time. The sub puzzles are copied, and
+ * the returned solver is stepped with step_solver_run until it leaves
+ * STEP_RUNNING.
+ *
+ * arguments are:
+ *
+ *  challenge		-- The puzzle challenge to solve
+ *  timeout_ms		-- The time after which the search expires, 0 for none
+ *
+ * returns the solver, NULL if the challenge cannot be solved
+ */
+
+StepSolver *solvePuzzleStart (const SHA256Challenge *challenge,
+		uint32_t timeout_ms);
+
+/* end a search started with solvePuzzleStart and free its solver
+ *
+ * arguments are:
+ *
+ *  solver			-- The solver returned by solvePuzzleStart
+ *
+ * returns the puzzle solution, NULL unless the solver reached STEP_SOLVED
+ */
+
+SHA256Solution *solvePuzzleFinish (StepSolver *solver);
+
 
 /*-----------------------------------------------------------------------------
  *  Utility functions needed to setup and solve puzzles
  *-----------------------------------------------------------------------------*/
 
-/* set up a puzzle mask from an iteration number
+/* set up a puzzle mask from an iteration number, the solvers write their
+ * candidates in place and do not go through it
  *
  * arguments are:
  *
  *  itr			-- The iteration number to create a mask for
- *  diff		-- The number of difficulty bits
+ *  diff		-- The number of difficulty bits, at most 64
  *  mask_len	-- The length of the mask (return variable)
  *
- * returns the mask array
+ * returns the mask array, NULL if diff is too large
  */
 
-unsigned char *get_puzzle_mask (unsigned int itr,
+unsigned char *get_puzzle_mask (uint64_t itr,
 	   unsigned int diff, unsigned int *mask_len);
 
 /* clear len left most bits of a char array
@@ -20,6 +20,9 @@
 #define __OPTCLIENT_H
 
 #include "puzzle/optpuzzle.h"
+#include "puzzle/flatpuzzle.h"
+#include "client/solver_pool.h"
+#include "client/step_solver.h"
 
 /* solve a challenge built in the optimized version.
  *
@@ -31,5 +34,55 @@
  */
 SHA256OptSolution 		*solveChallenge (SHA256OptChallenge *challenge);
 
+/* solve a challenge built in the optimized version into a flat solution,
+ * nothing is allocated
+ *
+ * arguments are
+ *
+ *  challenge		-- The challenge to solve
+ *  sol				-- The solution, its zi must have room for k values of
+ *  					len/2 bytes (return variable)
+ *
+ * returns 0 on success, -1 on failure
+ */
+int 					solveChallengeFlat (const SHA256OptChallenge *challenge,
+		SHA256OptFlatSolution *sol);
+
+/* solve a challenge built in the optimized version on a pool of worker
+ * threads. The sub solutions come back in the same order as solveChallenge.
+ *
+ * arguments are
+ *
+ *  challenge		-- The challenge to solve
+ *  pool			-- The pool of workers to solve on
+ *
+ * returns an solution structure
+ */
+SHA256OptSolution 		*solveChallengeParallel (SHA256OptChallenge *challenge,
+		SolverPool *pool);
+
+/* start solving a challenge built in the optimized version a step at a
+ * time. The challenge is copied, and the returned solver is stepped with
+ * step_solver_run until it leaves STEP_RUNNING.
+ *
+ * arguments are
+ *
+ *  challenge		-- The challenge to solve
+ *  timeout_ms		-- The time after which the search expires, 0 for none
+ *
+ * returns the solver, NULL if the challenge is malformed
+ */
+StepSolver 				*solveChallengeStart (const SHA256OptChallenge *challenge,
+		uint32_t timeout_ms);
+
+/* end a search started with solveChallengeStart and free its solver
+ *
+ * arguments are
+ *
+ *  solver			-- The solver returned by solveChallengeStart
+ *
+ * returns the solution, NULL unless the solver reached STEP_SOLVED
+ */
+SHA256OptSolution 		*solveChallengeFinish (StepSolver *solver);
 
 #endif
@@ -0,0 +1,122 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  solver_pool.h
+ *
+ *    Description:  A work stealing pool of threads for solving sub puzzles in parallel
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:05:27 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __SOLVER_POOL_H
+#define __SOLVER_POOL_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* The default number of candidates searched before looking for more work */
+#ifndef SOLVER_POOL_CHUNK
+#define SOLVER_POOL_CHUNK 4096
+#endif
+
+typedef struct SolverPool SolverPool;	/* The pool of worker threads */
+typedef struct SolverJob SolverJob;		/* One parallel solve running on a pool */
+
+/* The search routine run by the workers. It must search the candidates in
+ * [start, end) of sub puzzle sub, check solver_job_cancelled regularly, and
+ * return true with the winning candidate in winner if it finds one.
+ */
+typedef bool (*solver_search_fn) (SolverJob *job,
+		unsigned int sub,
+		uint64_t start,
+		uint64_t end,
+		uint64_t *winner);
+
+/* create a pool of worker threads
+ *
+ * arguments are:
+ *
+ *  nthreads		-- The number of workers, 0 to use one per available core
+ *  chunk			-- The number of candidates searched per task, 0 for the default
+ *
+ * returns the new pool, NULL on failure
+ */
+SolverPool *
+create_solver_pool 		(unsigned int nthreads, uint64_t chunk);
+
+/* stop the workers and free the memory occupied by a pool
+ *
+ * arguments are:
+ *
+ *  pool			-- The pool to free
+ */
+void
+free_solver_pool 		(SolverPool *pool);
+
+/* get the number of workers in a pool
+ *
+ * arguments are:
+ *
+ *  pool			-- The pool
+ *
+ * returns the number of worker threads
+ */
+unsigned int
+solver_pool_size 		(SolverPool *pool);
+
+/* search num_subs candidate spaces of size space in parallel. Each space is
+ * split in ranges that idle workers steal from each other, and the remaining
+ * ranges of a sub puzzle are cancelled as soon as one of them finds a winner.
+ * Only one job runs on a pool at a time, concurrent callers wait their turn.
+ *
+ * arguments are:
+ *
+ *  pool			-- The pool to run on
+ *  num_subs		-- The number of sub puzzles to solve
+ *  space			-- The number of candidates of each sub puzzle
+ *  search			-- The search routine for a range of candidates
+ *  arg				-- The argument passed back through solver_job_arg
+ *  winners			-- The winning candidate of each sub puzzle (return variable)
+ *
+ * returns the number of sub puzzles that were solved
+ */
+unsigned int
+solver_pool_run 		(SolverPool *pool,
+		unsigned int num_subs,
+		uint64_t space,
+		solver_search_fn search,
+		void *arg,
+		uint64_t *winners);
+
+/* get the argument passed to solver_pool_run
+ *
+ * arguments are:
+ *
+ *  job				-- The running job
+ *
+ * returns the argument of the job
+ */
+void *
+solver_job_arg 			(SolverJob *job);
+
+/* check whether the search of a sub puzzle has been cancelled
+ *
+ * arguments are:
+ *
+ *  job				-- The running job, NULL when solving serially
+ *  sub				-- The index of the sub puzzle
+ *
+ * returns true if another range already solved the sub puzzle
+ */
+bool
+solver_job_cancelled 	(SolverJob *job, unsigned int sub);
+
+#endif /* solver_pool.h */
@@ -0,0 +1,167 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  step_solver.h
+ *
+ *    Description:  A resumable solver that searches the sub puzzles a slice at a
+ *    				time, for callers that cannot block such as event loops
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 07:48:36 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __STEP_SOLVER_H
+#define __STEP_SOLVER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* The number of candidates searched between two looks at the budget */
+#ifndef STEP_SOLVER_SLICE
+#define STEP_SOLVER_SLICE 256
+#endif
+
+typedef struct StepSolver StepSolver;	/* A search in progress */
+
+/* The state of a search */
+typedef enum {
+	STEP_RUNNING = 0,		/* Not done yet, step it again */
+	STEP_SOLVED,			/* Every sub puzzle has a winner */
+	STEP_FAILED,			/* A sub puzzle ran out of candidates */
+	STEP_CANCELLED,			/* step_solver_cancel was called */
+	STEP_EXPIRED,			/* The deadline passed first */
+} step_status_t;
+
+/* The progress of a search */
+typedef struct {
+	unsigned int solved;		/* The number of sub puzzles solved */
+	unsigned int total;			/* The number of sub puzzles */
+	uint64_t tried;				/* The candidates hashed so far */
+	uint64_t expected_left;		/* The hashes expected to finish */
+	uint64_t busy_us;			/* The time spent stepping */
+	double hashes_per_sec;		/* The rate observed while stepping */
+	uint64_t eta_us;			/* The stepping time expected to finish, UINT64_MAX
+								   before the rate is known */
+} StepProgress;
+
+/* The search routine of a scheme. It must search the candidates in
+ * [start, end) of sub puzzle sub and return true with the winning candidate
+ * in winner if it finds one. It works like a solver_search_fn, except that
+ * the range is always small and nothing runs concurrently.
+ */
+typedef bool (*step_search_fn) (void *arg,
+		unsigned int sub,
+		uint64_t start,
+		uint64_t end,
+		uint64_t *winner);
+
+/* create a search over num_subs candidate spaces of size space. Nothing is
+ * searched until the solver is stepped.
+ *
+ * arguments are:
+ *
+ *  num_subs		-- The number of sub puzzles to solve
+ *  space			-- The number of candidates of each sub puzzle
+ *  expected		-- The hashes a sub puzzle is expected to take
+ *  search			-- The search routine for a range of candidates
+ *  arg				-- The argument passed back to search
+ *  free_arg		-- Frees arg with the solver, may be NULL
+ *  timeout_ms		-- The time from now after which the search expires, 0
+ *  					for none
+ *
+ * returns the new solver, NULL on failure
+ */
+StepSolver *
+create_step_solver 		(unsigned int num_subs,
+		uint64_t space,
+		uint64_t expected,
+		step_search_fn search,
+		void *arg,
+		void (*free_arg) (void *),
+		uint32_t timeout_ms);
+
+/* free a solver and its argument
+ *
+ * arguments are:
+ *
+ *  solver			-- The solver to free
+ */
+void
+free_step_solver 		(StepSolver *solver);
+
+/* search until the budget runs out or the search ends. The budget is
+ * checked every STEP_SOLVER_SLICE candidates, so a step overshoots its time
+ * by at most one slice, and the next step resumes where this one stopped.
+ *
+ * arguments are:
+ *
+ *  solver			-- The solver to step
+ *  max_tries		-- The largest number of candidates to hash, 0 for no limit
+ *  max_us			-- The longest time to search, 0 for no limit
+ *
+ * returns STEP_RUNNING if the budget ran out first, the final state otherwise
+ */
+step_status_t
+step_solver_run 		(StepSolver *solver, uint64_t max_tries, uint32_t max_us);
+
+/* stop a search, the next step returns STEP_CANCELLED. It may be called
+ * from any thread, also while the solver is being stepped.
+ *
+ * arguments are:
+ *
+ *  solver			-- The solver to cancel
+ */
+void
+step_solver_cancel 		(StepSolver *solver);
+
+/* get the state of a search
+ *
+ * arguments are:
+ *
+ *  solver			-- The solver
+ *
+ * returns the state left by the last step
+ */
+step_status_t
+step_solver_status 		(const StepSolver *solver);
+
+/* get the progress of a search
+ *
+ * arguments are:
+ *
+ *  solver			-- The solver
+ *  progress		-- The progress (return variable)
+ */
+void
+step_solver_progress 	(const StepSolver *solver, StepProgress *progress);
+
+/* get the winning candidates of a solved search
+ *
+ * arguments are:
+ *
+ *  solver			-- The solver
+ *
+ * returns the winner of each sub puzzle, NULL unless STEP_SOLVED
+ */
+const uint64_t *
+step_solver_winners 	(const StepSolver *solver);
+
+/* get the argument passed to create_step_solver
+ *
+ * arguments are:
+ *
+ *  solver			-- The solver
+ *
+ * returns the argument of the search routine
+ */
+void *
+step_solver_arg 		(const StepSolver *solver);
+
+#endif /* step_solver.h */
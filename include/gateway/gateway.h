@@ -0,0 +1,192 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  gateway.h
+ *
+ *    Description:  A multi-threaded TCP gateway that makes every new connection
+ *    				solve an optimized challenge before it is admitted
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 02:31:40 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __GATEWAY_H
+#define __GATEWAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* The most bytes of connection data, the peer's address and port */
+#define GATEWAY_DATA_LEN 	18
+
+/* The handshake on a new connection, in the packets of puzzle/wire.h:
+ *
+ *   gateway -> client		WIRE_OPT_CHALLENGE, minted for the peer's address
+ *   client  -> gateway		WIRE_OPT_SOLUTION, of exactly k sub solutions
+ *
+ * A verified connection is passed on with nothing more written to it, any
+ * bytes the client sent after its solution are left in the socket for the
+ * application. Any other connection is closed.
+ */
+
+typedef struct PlutusGateway PlutusGateway;	/* A running gateway */
+
+/* Called on the worker thread that verified a connection. It owns fd from
+ * then on and must not block for long, the worker's other connections wait.
+ *
+ * arguments are:
+ *
+ *  fd				-- The admitted connection, non blocking
+ *  data			-- The connection data the challenge was minted for
+ *  data_len		-- The length of the data in bytes
+ *  arg				-- The admit_arg of the configuration
+ */
+typedef void (*gateway_admit_fn) (int fd,
+		const unsigned char *data,
+		unsigned int data_len,
+		void *arg);
+
+typedef struct GatewayConfig {
+	const char *host;				/* The IPv4 address to listen on, NULL for any */
+	uint16_t port;					/* The port, 0 for one picked by the kernel */
+	unsigned int nthreads;			/* The workers, 0 for one per available core */
+	int backlog;					/* The listen backlog of each worker */
+
+	const unsigned char *key;		/* The server's secret key */
+	unsigned int key_len;			/* The length of the key in bytes */
+	uint16_t k;						/* The number of subpuzzles in the challenges */
+	uint16_t m;						/* The number of bits of difficulty */
+	unsigned int l;					/* The number of bits of x + z */
+	uint32_t max_age;				/* The seconds a challenge stays valid */
+	size_t replay_bytes;			/* The size of the replay cache, 0 for none */
+
+	unsigned int max_pending;		/* The handshakes in flight per worker before
+									   it stops accepting */
+	unsigned int resume_pending;	/* The handshakes in flight below which it
+									   accepts again */
+	unsigned int accept_batch;		/* The most connections accepted per wake up */
+	unsigned int handshake_ms;		/* The time a client has to send its solution */
+
+	gateway_admit_fn admit;			/* Where admitted connections go, NULL to
+									   hand them off over handoff_path */
+	void *admit_arg;				/* The argument passed to admit */
+	const char *handoff_path;		/* A SOCK_SEQPACKET Unix socket receiving the
+									   admitted connections, see gateway_recv_handoff */
+
+	unsigned int verify_threads;	/* Workers verifying the solutions off the
+									   connection workers, see server/verifier.h,
+									   0 to verify on the connection workers */
+	int verify_node;				/* The NUMA node of those, -1 for any */
+	unsigned int verify_queue;		/* The solutions waiting for those, ordered by
+									   the record of their client and shed past
+									   that, see server/admission.h. 0 to wait in
+									   order, for as long as it takes */
+	uint32_t verify_ms;				/* The time a solution may wait in that queue */
+} GatewayConfig;
+
+/* The counters of a gateway, summed over its workers */
+typedef struct GatewayStats {
+	uint64_t accepted;				/* Connections accepted */
+	uint64_t admitted;				/* Connections verified and passed on */
+	uint64_t rejected;				/* Solutions that did not verify */
+	uint64_t timed_out;				/* Clients that did not answer in time */
+	uint64_t dropped;				/* Connections lost to I/O errors or a failed handoff */
+	uint64_t shed;					/* Solutions left unverified under overload */
+	uint64_t paused;				/* Times a worker stopped accepting */
+	uint64_t pending;				/* Handshakes in flight right now */
+} GatewayStats;
+
+/* fill a configuration with the defaults, the key and the admission are
+ * left for the caller
+ *
+ * arguments are:
+ *
+ *  config			-- The configuration to fill
+ */
+void
+gateway_default_config 	(GatewayConfig *config);
+
+/* bind the listening sockets and start the workers. Every worker has its
+ * own SO_REUSEPORT socket and epoll loop, so the kernel spreads the new
+ * connections over the workers and they share nothing but the keys and
+ * the replay cache.
+ *
+ * arguments are:
+ *
+ *  config			-- The configuration, copied. The key and the handoff
+ *  					path only need to live through the call
+ *
+ * returns the running gateway, NULL on failure
+ */
+PlutusGateway *
+create_gateway 			(const GatewayConfig *config);
+
+/* stop the workers, close every connection still in its handshake and free
+ * the gateway
+ *
+ * arguments are:
+ *
+ *  gw				-- The gateway to free
+ */
+void
+free_gateway 			(PlutusGateway *gw);
+
+/* get the port the gateway listens on
+ *
+ * arguments are:
+ *
+ *  gw				-- The gateway
+ *
+ * returns the port in host order
+ */
+uint16_t
+gateway_port 			(const PlutusGateway *gw);
+
+/* replace the server's key from the next second on, the handshakes in
+ * flight finish with the key they started with. The workers never wait
+ * on it, see server/keyring.h.
+ *
+ * arguments are:
+ *
+ *  gw				-- The gateway
+ *  key				-- The new secret key, only needed through the call
+ *  key_len			-- The length of the key in bytes
+ *
+ * returns the epoch of the new key, -1 if the key was already replaced
+ * within this second
+ */
+int64_t
+gateway_rotate_key 		(PlutusGateway *gw, const unsigned char *key, unsigned int key_len);
+
+/* read the counters of a gateway, any thread may call it at any time
+ *
+ * arguments are:
+ *
+ *  gw				-- The gateway
+ *  stats			-- The counters (return variable)
+ */
+void
+gateway_stats 			(const PlutusGateway *gw, GatewayStats *stats);
+
+/* receive one connection handed off by a gateway
+ *
+ * arguments are:
+ *
+ *  sock			-- A connection accepted on the handoff socket
+ *  data			-- A buffer of GATEWAY_DATA_LEN bytes for the connection
+ *  					data, NULL if not needed
+ *  data_len		-- The length of the data (return variable), NULL if not needed
+ *
+ * returns the admitted connection, -1 on failure or when the gateway is gone
+ */
+int
+gateway_recv_handoff 	(int sock, unsigned char *data, unsigned int *data_len);
+
+#endif /* gateway.h */
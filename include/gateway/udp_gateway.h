@@ -0,0 +1,159 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  udp_gateway.h
+ *
+ *    Description:  The datagram mode of the gateway, challenges are minted and
+ *    				solutions verified a batch of datagrams per system call
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 05:10:26 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __UDP_GATEWAY_H
+#define __UDP_GATEWAY_H
+
+#include <netinet/in.h>
+
+#include "gateway/gateway.h"
+
+/* The most datagrams taken or sent per system call */
+#define UDP_GATEWAY_MAX_BATCH 	64
+
+/* The exchange, in the packets of puzzle/wire.h:
+ *
+ *   client  -> gateway		WIRE_HELLO, padded to at least the size of the
+ *   						challenge
+ *   gateway -> client		WIRE_OPT_CHALLENGE, minted for the client's
+ *   						address and port
+ *   client  -> gateway		WIRE_OPT_SOLUTION
+ *   gateway -> client		WIRE_VERDICT, the verify_status_t of the solution
+ *
+ * Nothing is ever answered with more bytes than it came with, so the
+ * gateway cannot be used to amplify a flood towards a spoofed address.
+ * Datagrams that are not one of ours get no answer at all.
+ */
+
+typedef struct PlutusUdpGateway PlutusUdpGateway;	/* A running datagram gateway */
+
+/* Called on the worker thread that verified a solution
+ *
+ * arguments are:
+ *
+ *  peer			-- The address of the client
+ *  data			-- The connection data the challenge was minted for
+ *  data_len		-- The length of the data in bytes
+ *  arg				-- The admit_arg of the configuration
+ */
+typedef void (*udp_gateway_admit_fn) (const struct sockaddr_in *peer,
+		const unsigned char *data,
+		unsigned int data_len,
+		void *arg);
+
+typedef struct UdpGatewayConfig {
+	const char *host;				/* The IPv4 address to listen on, NULL for any */
+	uint16_t port;					/* The port, 0 for one picked by the kernel */
+	unsigned int nthreads;			/* The workers, 0 for one per available core */
+	unsigned int batch;				/* The datagrams per system call, at most
+									   UDP_GATEWAY_MAX_BATCH */
+	int rcvbuf;						/* The receive buffer of each socket, 0 for
+									   the system's default */
+
+	const unsigned char *key;		/* The server's secret key */
+	unsigned int key_len;			/* The length of the key in bytes */
+	uint16_t k;						/* The number of subpuzzles in the challenges */
+	uint16_t m;						/* The number of bits of difficulty */
+	unsigned int l;					/* The number of bits of x + z */
+	uint32_t max_age;				/* The seconds a challenge stays valid */
+	size_t replay_bytes;			/* The size of the replay cache, 0 for none */
+
+	udp_gateway_admit_fn admit;		/* Told about the verified clients, may be NULL */
+	void *admit_arg;				/* The argument passed to admit */
+} UdpGatewayConfig;
+
+/* The counters of a datagram gateway, summed over its workers */
+typedef struct UdpGatewayStats {
+	uint64_t received;				/* Datagrams received */
+	uint64_t batches;				/* Receive calls that returned datagrams */
+	uint64_t minted;				/* Challenges sent */
+	uint64_t admitted;				/* Solutions verified */
+	uint64_t rejected;				/* Solutions that did not verify */
+	uint64_t ignored;				/* Datagrams left unanswered */
+	uint64_t send_failed;			/* Answers the kernel would not take */
+} UdpGatewayStats;
+
+/* fill a configuration with the defaults, the key is left for the caller
+ *
+ * arguments are:
+ *
+ *  config			-- The configuration to fill
+ */
+void
+udp_gateway_default_config 	(UdpGatewayConfig *config);
+
+/* bind the sockets and start the workers. Like the stream gateway every
+ * worker has its own SO_REUSEPORT socket, and its buffers are all set up
+ * here so that serving a datagram allocates nothing.
+ *
+ * arguments are:
+ *
+ *  config			-- The configuration, copied. The key only needs to
+ *  					live through the call
+ *
+ * returns the running gateway, NULL on failure
+ */
+PlutusUdpGateway *
+create_udp_gateway 			(const UdpGatewayConfig *config);
+
+/* stop the workers and free the gateway
+ *
+ * arguments are:
+ *
+ *  gw				-- The gateway to free
+ */
+void
+free_udp_gateway 			(PlutusUdpGateway *gw);
+
+/* get the port the gateway listens on
+ *
+ * arguments are:
+ *
+ *  gw				-- The gateway
+ *
+ * returns the port in host order
+ */
+uint16_t
+udp_gateway_port 			(const PlutusUdpGateway *gw);
+
+/* replace the server's key from the next second on, see gateway_rotate_key
+ *
+ * arguments are:
+ *
+ *  gw				-- The gateway
+ *  key				-- The new secret key, only needed through the call
+ *  key_len			-- The length of the key in bytes
+ *
+ * returns the epoch of the new key, -1 if the key was already replaced
+ * within this second
+ */
+int64_t
+udp_gateway_rotate_key 		(PlutusUdpGateway *gw, const unsigned char *key, unsigned int key_len);
+
+/* read the counters of a gateway, any thread may call it at any time
+ *
+ * arguments are:
+ *
+ *  gw				-- The gateway
+ *  stats			-- The counters (return variable)
+ */
+void
+udp_gateway_stats 			(const PlutusUdpGateway *gw, UdpGatewayStats *stats);
+
+#endif /* udp_gateway.h */
@@ -0,0 +1,225 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  plutus.h
+ *
+ *    Description:  The C++ interface of the optimized puzzles. Challenges,
+ *    				solutions, minters and replay caches are move-only values
+ *    				that own what they hold, and inputs are taken as spans.
+ *    				Needs C++20.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 06:31:47 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __PLUTUS_H
+#define __PLUTUS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+
+#include "puzzle/flatpuzzle.h"
+#include "server/optserver.h"
+#include "server/replay.h"
+
+namespace plutus {
+
+using bytes = std::span<const unsigned char>;			/* Bytes read by a call */
+using mutable_bytes = std::span<unsigned char>;			/* Bytes written by a call */
+
+/* A SHA256 digest, stored inline */
+using Digest = std::array<unsigned char, SHA256_DIGEST_LEN>;
+
+/* The outcome of a verification, VERIFY_OK and the reasons of rejections */
+using Status = verify_status_t;
+
+/* The parameters of a challenge */
+struct Params {
+	std::uint16_t k;		/* The number of sub puzzles */
+	std::uint16_t m;		/* The number of bits of difficulty */
+	unsigned int l;			/* The number of bits of x + z */
+
+	/* the length of x and of each z_i in bytes */
+	constexpr std::size_t x_len () const { return l / 16; }
+};
+
+/* The server's policy when verifying, the same as SHA256OptVerifyParams */
+struct Policy {
+	std::uint32_t now = 0;					/* The server's current timestamp */
+	std::uint32_t max_age = 0;				/* The largest accepted age, 0 for any */
+	SHA256OptReplayCache *replay = nullptr;	/* The cache of accepted solutions */
+};
+
+
+/*-----------------------------------------------------------------------------
+ *  Challenges and solutions
+ *-----------------------------------------------------------------------------*/
+
+/* A challenge of the optimized scheme. x is kept inline, so a challenge
+ * never touches the heap. */
+class Challenge {
+public:
+	Challenge (Challenge &&) noexcept = default;
+	Challenge &operator= (Challenge &&) noexcept = default;
+	Challenge (const Challenge &) = delete;
+	Challenge &operator= (const Challenge &) = delete;
+
+	std::uint32_t timestamp () const { return timestamp_; }
+	const Params &params () const { return params_; }
+	bytes x () const { return bytes (x_.data (), params_.x_len ()); }
+
+	/* encode the WIRE_OPT_CHALLENGE packet. Like the encoders of
+	 * puzzle/wire.h it returns the full length and only writes the packet
+	 * if it fits, 0 means it cannot be encoded. */
+	std::size_t encode (mutable_bytes buf) const;
+
+	/* read a WIRE_OPT_CHALLENGE packet, nullopt if it is not one */
+	static std::optional<Challenge> decode (bytes pkt);
+
+	/* the challenge as one of the C interface, its preimage points into
+	 * this object and must not be freed */
+	SHA256OptChallenge native () const;
+
+private:
+	friend class Minter;
+	Challenge () = default;
+
+	std::uint32_t timestamp_ = 0;
+	Params params_ = {};
+	Digest x_ = {};
+};
+
+/* A solution of the optimized scheme. The values of z_i lie back to back
+ * in a single buffer allocated with the solution, so moving one is
+ * cheap and solving into an existing one allocates nothing. */
+class Solution {
+public:
+	/* a zeroed solution with room for k values of zlen bytes */
+	Solution (std::uint16_t k, std::uint16_t zlen);
+
+	Solution (Solution &&other) noexcept;
+	Solution &operator= (Solution &&other) noexcept;
+	Solution (const Solution &) = delete;
+	Solution &operator= (const Solution &) = delete;
+
+	std::uint32_t timestamp () const { return view_.timestamp; }
+	std::uint16_t k () const { return view_.num_subsolutions; }
+	std::uint16_t zlen () const { return view_.zlen; }
+
+	/* the value z_i of sub puzzle i */
+	bytes z (std::size_t i) const { return bytes (view_.zi + i * zlen (), zlen ()); }
+	mutable_bytes z (std::size_t i) { return mutable_bytes (view_.zi + i * zlen (), zlen ()); }
+
+	/* the solution as a flat solution of the C interface, it points into
+	 * this object and lives as long as it does */
+	const SHA256OptFlatSolution &native () const { return view_; }
+
+	/* encode the WIRE_OPT_SOLUTION packet, see Challenge::encode */
+	std::size_t encode (mutable_bytes buf) const;
+
+	/* read a WIRE_OPT_SOLUTION packet, nullopt if it is not one */
+	static std::optional<Solution> decode (bytes pkt);
+
+private:
+	std::unique_ptr<unsigned char[]> zi_;
+	SHA256OptFlatSolution view_;
+
+	friend bool solve_into (const Challenge &challenge, Solution &sol);
+};
+
+/* solve a challenge into a solution of the right size, the solution's
+ * buffer is reused and nothing is allocated
+ *
+ * returns true if solved, false if the solution has no room for it or no
+ * solution was found
+ */
+bool
+solve_into 	(const Challenge &challenge, Solution &sol);
+
+/* solve a challenge, the solution is sized for it
+ *
+ * returns the solution, nullopt if none was found
+ */
+std::optional<Solution>
+solve 		(const Challenge &challenge);
+
+
+/*-----------------------------------------------------------------------------
+ *  The server's side
+ *-----------------------------------------------------------------------------*/
+
+/* A replay cache, freed with the object */
+class ReplayCache {
+public:
+	/* create a cache, see create_replay_cache. nullopt on failure. */
+	static std::optional<ReplayCache> create (std::size_t max_bytes,
+			std::uint32_t window, const char *shm_name = nullptr);
+
+	SHA256OptReplayCache *get () const { return cache_.get (); }
+
+private:
+	struct Free {
+		void operator() (SHA256OptReplayCache *cache) const { free_replay_cache (cache); }
+	};
+
+	explicit ReplayCache (SHA256OptReplayCache *cache) : cache_ (cache) {}
+	std::unique_ptr<SHA256OptReplayCache, Free> cache_;
+};
+
+/* A challenge minter for a key epoch. The key is absorbed once when it is
+ * created and the state is wiped when it goes away. Minting and verifying
+ * allocate nothing, and any number of threads may share a minter. */
+class Minter {
+public:
+	/* set up a minter, nullopt if the parameters are unusable, see
+	 * init_minter */
+	static std::optional<Minter> create (bytes key, const Params &params,
+			std::uint32_t epoch = 0);
+
+	Minter (Minter &&other) noexcept;
+	Minter &operator= (Minter &&other) noexcept;
+	Minter (const Minter &) = delete;
+	Minter &operator= (const Minter &) = delete;
+	~Minter ();
+
+	Params params () const { return { minter_.k, minter_.m, minter_.l }; }
+	std::uint32_t epoch () const { return minter_.epoch; }
+
+	/* the minter of the C interface */
+	const SHA256OptMinter &native () const { return minter_; }
+
+	/* mint the challenge of a connection */
+	Challenge mint (bytes data, std::uint32_t timestamp) const;
+
+	/* mint straight into a WIRE_OPT_CHALLENGE packet
+	 *
+	 * returns the length written, 0 if the packet does not fit
+	 */
+	std::size_t mint_packet (bytes data, std::uint32_t timestamp, mutable_bytes pkt) const;
+
+	/* verify a solution, see verify_solution_ex */
+	Status verify (const Solution &sol, bytes data, const Policy &policy = {}) const;
+
+	/* verify a WIRE_OPT_SOLUTION packet where it lies */
+	Status verify_packet (bytes pkt, bytes data, const Policy &policy = {}) const;
+
+private:
+	Minter () = default;
+	SHA256OptMinter minter_;
+	bool live_ = false;			/* Whether minter_ holds a key state */
+};
+
+} /* namespace plutus */
+
+#endif /* plutus.h */
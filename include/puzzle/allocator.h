@@ -0,0 +1,131 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  allocator.h
+ *
+ *    Description:  Pluggable allocators for the puzzle objects, a per-thread slab
+ *    				pool and an arena that is released in one go
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 06:24:50 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __ALLOCATOR_H
+#define __ALLOCATOR_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Struct definitions */
+
+typedef struct PuzzleAllocator {
+	void *(*alloc) 		(void *ctx, size_t size);	/* Get size bytes, NULL on failure */
+	void (*release) 	(void *ctx, void *ptr);		/* Give back a block of alloc */
+	void *ctx;										/* The state of the allocator */
+} PuzzleAllocator;
+
+/* An arena, everything allocated from it is released by free_arena */
+typedef struct PuzzleArena PuzzleArena;
+
+
+/*-----------------------------------------------------------------------------
+ *  Allocating through an allocator, a NULL allocator means malloc and free
+ *-----------------------------------------------------------------------------*/
+
+/* allocate a block through an allocator
+ *
+ * arguments are:
+ *
+ *  allocator		-- The allocator to use, NULL for malloc
+ *  size			-- The size of the block in bytes
+ *
+ * returns the block, NULL on failure
+ */
+void *
+puzzle_alloc 		(const PuzzleAllocator *allocator, size_t size);
+
+/* release a block through the allocator that gave it out
+ *
+ * arguments are:
+ *
+ *  allocator		-- The allocator of the block, NULL for free
+ *  ptr				-- The block to release, NULL is ignored
+ */
+void
+puzzle_release 		(const PuzzleAllocator *allocator, void *ptr);
+
+
+/*-----------------------------------------------------------------------------
+ *  The available allocators
+ *-----------------------------------------------------------------------------*/
+
+/* get the allocator that uses malloc and free
+ *
+ * returns a static allocator
+ */
+const PuzzleAllocator *
+malloc_allocator 	(void);
+
+/* get the slab pool allocator. Every thread keeps its own free lists of
+ * small blocks carved out of 64KB slabs, so allocating and releasing
+ * mostly takes no lock. Blocks may be released by any thread. A thread
+ * keeps up to two slabs worth of released blocks of a size, the rest and
+ * the free lists of an exiting thread are handed over to the next threads
+ * that run out. Slabs are kept for the lifetime of the process.
+ *
+ * returns a static allocator
+ */
+const PuzzleAllocator *
+pool_allocator 		(void);
+
+/* create an arena. Allocations bump a pointer in chunks of chunk_size
+ * bytes, releasing a single block does nothing. An arena is meant for the
+ * objects of a single handshake and is not thread safe.
+ *
+ * arguments are:
+ *
+ *  chunk_size		-- The size of the chunks to carve from, 0 for the default
+ *
+ * returns a new arena, NULL on failure
+ */
+PuzzleArena *
+create_arena 		(size_t chunk_size);
+
+/* get the allocator of an arena. It lives as long as the arena does.
+ *
+ * arguments are:
+ *
+ *  arena			-- The arena
+ *
+ * returns the allocator of the arena
+ */
+const PuzzleAllocator *
+arena_allocator 	(PuzzleArena *arena);
+
+/* release everything allocated from an arena at once, the chunks are kept
+ * for the next handshake
+ *
+ * arguments are:
+ *
+ *  arena			-- The arena to reset
+ */
+void
+reset_arena 		(PuzzleArena *arena);
+
+/* free an arena and all of its chunks
+ *
+ * arguments are:
+ *
+ *  arena			-- The arena to free
+ */
+void
+free_arena 			(PuzzleArena *arena);
+
+#endif /* allocator.h */
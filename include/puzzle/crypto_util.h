@@ -16,11 +16,21 @@
  * =====================================================================================
  */
 
+#ifndef __CRYPTO_UTIL_H
+#define __CRYPTO_UTIL_H
+
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <openssl/evp.h>
+#include "puzzle/sha256.h"
+
+/* The backends available to digest_message */
+typedef enum {
+	HASH_BACKEND_EVP = 0,		/* The generic OpenSSL EVP interface */
+	HASH_BACKEND_SHANI			/* Direct SHA256 on the x86 SHA extensions */
+} hash_backend_t;
 
 /* digest a message by creating a SHA256 hash
  *
@@ -36,6 +46,21 @@ unsigned char *
 digest_message (const unsigned char *message, size_t message_len,
         unsigned int *digest_len);
 
+/* digest a message into a caller provided buffer. Nothing is allocated,
+ * the EVP backend reuses a digest context kept per thread.
+ *
+ * arguments are:
+ *
+ *  message         -- The message to digest
+ *  message_len     -- The length of the message
+ *  digest          -- The output buffer of SHA256_DIGEST_LEN bytes (return variable)
+ *
+ * returns 0 on success, -1 on failure
+ */
+int
+digest_message_into (const unsigned char *message, size_t message_len,
+        unsigned char *digest);
+
 /* print a digest to the std output
  *
  * arguments are:
@@ -82,4 +107,36 @@ append_buffer (unsigned char *dest, unsigned char *src, size_t n);
  * returns true if the first len bits of x and y are equal
  */
 bool
-compare_bits (unsigned char *x, unsigned char *y, unsigned int len);
+compare_bits (const unsigned char *x, const unsigned char *y, unsigned int len);
+
+/* get the backend used by digest_message. SHA-NI is picked at startup when
+ * the CPU supports it, EVP otherwise.
+ *
+ * returns the active backend
+ */
+hash_backend_t
+get_hash_backend (void);
+
+/* select the backend used by digest_message
+ *
+ * arguments are:
+ *
+ *  backend		-- The backend to use
+ *
+ * returns 0 on success, -1 if the CPU does not support the backend
+ */
+int
+set_hash_backend (hash_backend_t backend);
+
+/* get the printable name of a hashing backend
+ *
+ * arguments are:
+ *
+ *  backend		-- The backend
+ *
+ * returns the name of the backend
+ */
+const char *
+hash_backend_name (hash_backend_t backend);
+
+#endif /* crypto_util.h */
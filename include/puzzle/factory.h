@@ -3,6 +3,7 @@
 
 #include <puzzle/puzzle.h>
 #include <puzzle/optpuzzle.h>
+#include <puzzle/allocator.h>
 
 /* Factory create functions for ease of use */
 
@@ -21,4 +22,16 @@ SHA256OptChallenge * 	create_optchallenge ();
 SHA256OptSolution 		*create_optsolution ();
 SHA256OptSubSolution 	*create_optsubsolution ();
 
+/* The same functions getting their memory from an allocator. The objects
+ * are released with the free routines taking the same allocator. */
+SHA256SubPuzzle 	*createSubPuzzle 	(const PuzzleAllocator *allocator);
+SHA256Challenge 	*createChallenge 	(const PuzzleAllocator *allocator);
+
+SHA256SubSolution 	*createSubSolution 	(const PuzzleAllocator *allocator);
+SHA256Solution 		*createSolution 	(const PuzzleAllocator *allocator);
+
+SHA256OptChallenge 		*create_optchallenge 	(const PuzzleAllocator *allocator);
+SHA256OptSolution 		*create_optsolution 	(const PuzzleAllocator *allocator);
+SHA256OptSubSolution 	*create_optsubsolution 	(const PuzzleAllocator *allocator);
+
 #endif /* factory.h */
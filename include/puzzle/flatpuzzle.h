@@ -0,0 +1,210 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  flatpuzzle.h
+ *
+ *    Description:  Contiguous (structure of arrays) layouts of the challenges and
+ *    				solutions, with converters to and from the linked list layouts
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 05:41:09 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __FLATPUZZLE_H
+#define __FLATPUZZLE_H
+
+#include "puzzle/puzzle.h"
+#include "puzzle/optpuzzle.h"
+#include "puzzle/sha256.h"
+
+/* Struct definitions. Every flat object is a single allocation, the arrays
+ * are stored right after the struct and are released with it. */
+
+typedef struct SHA256FlatChallenge {
+	uint32_t timestamp;			/* The timestamp that the client must return */
+	uint16_t num_subpuzzles;	/* The number of sub puzzles */
+	uint16_t difficulty;		/* The bits of difficulty per sub puzzle */
+
+	unsigned char *preimages;	/* num_subpuzzles preimages of SHA256_DIGEST_LEN bytes */
+	unsigned char *images;		/* num_subpuzzles images of SHA256_DIGEST_LEN bytes */
+} SHA256FlatChallenge;
+
+typedef struct SHA256FlatSolution {
+	uint32_t timestamp;			/* The timestamp to return to the server */
+	uint16_t num_subsolutions;	/* The number of sub solutions */
+
+	unsigned char *solutions;	/* num_subsolutions solutions of SHA256_DIGEST_LEN bytes */
+} SHA256FlatSolution;
+
+typedef struct SHA256OptFlatSolution {
+	uint32_t timestamp;			/* The timestamp provided by the server */
+	uint16_t num_subsolutions;	/* The number of sub solutions */
+	uint16_t zlen;				/* The length of each z_i in bytes */
+
+	unsigned char *zi;			/* num_subsolutions values of zlen bytes */
+} SHA256OptFlatSolution;
+
+
+/*-----------------------------------------------------------------------------
+ *  Accessors
+ *-----------------------------------------------------------------------------*/
+
+/* get the preimage of sub puzzle i */
+static inline unsigned char *
+flat_preimage (SHA256FlatChallenge *challenge, unsigned int i)
+{
+	return challenge->preimages + i * SHA256_DIGEST_LEN;
+}
+
+/* get the image of sub puzzle i */
+static inline unsigned char *
+flat_image (SHA256FlatChallenge *challenge, unsigned int i)
+{
+	return challenge->images + i * SHA256_DIGEST_LEN;
+}
+
+/* get the solution of sub puzzle i */
+static inline unsigned char *
+flat_solution (SHA256FlatSolution *sol, unsigned int i)
+{
+	return sol->solutions + i * SHA256_DIGEST_LEN;
+}
+
+/* get z_i of sub puzzle i */
+static inline unsigned char *
+flat_zi (SHA256OptFlatSolution *sol, unsigned int i)
+{
+	return sol->zi + i * sol->zlen;
+}
+
+
+/*-----------------------------------------------------------------------------
+ *  Creating and freeing flat objects
+ *-----------------------------------------------------------------------------*/
+
+/* create a zeroed flat challenge with room for k sub puzzles
+ *
+ * arguments are:
+ *
+ *  k				-- The number of sub puzzles
+ *
+ * returns the new challenge, NULL on failure. Release it with free_flatchallenge
+ */
+SHA256FlatChallenge *
+create_flatchallenge 	(uint16_t k);
+
+/* create a zeroed flat solution with room for k sub solutions
+ *
+ * arguments are:
+ *
+ *  k				-- The number of sub solutions
+ *
+ * returns the new solution, NULL on failure. Release it with free_flatsolution
+ */
+SHA256FlatSolution *
+create_flatsolution 	(uint16_t k);
+
+/* create a zeroed flat optimized solution with room for k values of z_i
+ *
+ * arguments are:
+ *
+ *  k				-- The number of sub solutions
+ *  zlen			-- The length of each z_i in bytes
+ *
+ * returns the new solution, NULL on failure. Release it with free_optflatsolution
+ */
+SHA256OptFlatSolution *
+create_optflatsolution 	(uint16_t k, uint16_t zlen);
+
+/* free the flat objects, the arrays go with them */
+void free_flatchallenge 	(SHA256FlatChallenge *challenge);
+void free_flatsolution 		(SHA256FlatSolution *sol);
+void free_optflatsolution 	(SHA256OptFlatSolution *sol);
+
+
+/*-----------------------------------------------------------------------------
+ *  Converters from and to the linked list layouts
+ *-----------------------------------------------------------------------------*/
+
+/* flatten a challenge. Missing preimages and images are left zeroed.
+ *
+ * arguments are:
+ *
+ *  challenge		-- The challenge to flatten
+ *
+ * returns a new flat challenge, NULL on failure
+ */
+SHA256FlatChallenge *
+flatten_challenge 		(const SHA256Challenge *challenge);
+
+/* rebuild a linked list challenge from a flat one. The result is freed the
+ * usual way with free_challenge_mem and free.
+ *
+ * arguments are:
+ *
+ *  flat			-- The flat challenge
+ *
+ * returns a new challenge, NULL on failure
+ */
+SHA256Challenge *
+unflatten_challenge 	(const SHA256FlatChallenge *flat);
+
+/* flatten a solution of k sub solutions
+ *
+ * arguments are:
+ *
+ *  sol				-- The solution to flatten
+ *  k				-- The number of sub solutions to copy
+ *
+ * returns a new flat solution, NULL on failure or if the list is shorter
+ * than k
+ */
+SHA256FlatSolution *
+flatten_solution 		(const SHA256Solution *sol, uint16_t k);
+
+/* rebuild a linked list solution from a flat one. The result is freed the
+ * usual way with free_solution_mem and free.
+ *
+ * arguments are:
+ *
+ *  flat			-- The flat solution
+ *
+ * returns a new solution, NULL on failure
+ */
+SHA256Solution *
+unflatten_solution 		(const SHA256FlatSolution *flat);
+
+/* flatten an optimized solution of k sub solutions
+ *
+ * arguments are:
+ *
+ *  sol				-- The solution to flatten
+ *  len				-- The length of x + z of the challenge, z_i is len/16 bytes
+ *  k				-- The number of sub solutions to copy
+ *
+ * returns a new flat solution, NULL on failure or if the list is shorter
+ * than k
+ */
+SHA256OptFlatSolution *
+flatten_optsolution 	(const SHA256OptSolution *sol, uint16_t len, uint16_t k);
+
+/* rebuild a linked list optimized solution from a flat one. The result is
+ * freed with free_solution_mem.
+ *
+ * arguments are:
+ *
+ *  flat			-- The flat solution
+ *
+ * returns a new solution, NULL on failure
+ */
+SHA256OptSolution *
+unflatten_optsolution 	(const SHA256OptFlatSolution *flat);
+
+#endif /* flatpuzzle.h */
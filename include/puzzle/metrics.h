@@ -0,0 +1,199 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  metrics.h
+ *
+ *    Description:  Low overhead counters and latency histograms of the puzzle
+ *    				operations, with snapshots and a Prometheus text dump
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 09:02:18 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* The counters. The verification outcomes follow the order of the
+ * verify_status_t values so the opt verifiers can index them directly. */
+typedef enum {
+	METRIC_CHALLENGES_MINTED = 0,	/* Optimized challenges handed out */
+	METRIC_PUZZLES_GENERATED,		/* Naive puzzles handed out */
+
+	METRIC_VERIFY_OK,				/* Solutions that verified */
+	METRIC_VERIFY_EMPTY,			/* Rejected, no solution or empty sub solution */
+	METRIC_VERIFY_SHORT,			/* Rejected, fewer than k sub solutions */
+	METRIC_VERIFY_STALE,			/* Rejected, timestamp out of range */
+	METRIC_VERIFY_BAD_PARAMS,		/* Rejected, unusable server parameters */
+	METRIC_VERIFY_FAILED,			/* Rejected, a sub solution does not solve */
+	METRIC_VERIFY_REPLAY,			/* Rejected, already accepted once */
+	METRIC_VERIFY_MALFORMED,		/* Rejected, the packet is not well formed */
+	METRIC_VERIFY_SHED,				/* Dropped unverified under overload */
+	METRIC_REPLAY_FULL,				/* Accepted without room to remember them */
+
+	METRIC_HASHES,					/* SHA256 hashes computed */
+	METRIC_SOLUTIONS_FOUND,			/* Challenges solved by the clients */
+
+	METRIC_NUM_COUNTERS
+} metric_counter_t;
+
+/* The latency histograms */
+typedef enum {
+	METRIC_LAT_GENERATE_CHALLENGE = 0,
+	METRIC_LAT_GENERATE_PUZZLE,
+	METRIC_LAT_VERIFY_OPT,
+	METRIC_LAT_VERIFY_NAIVE,
+	METRIC_LAT_VERIFY_BATCH,
+	METRIC_LAT_SOLVE_OPT,
+	METRIC_LAT_SOLVE_NAIVE,
+
+	METRIC_NUM_HISTOGRAMS
+} metric_histogram_t;
+
+/* Bucket b of a histogram counts latencies below 2^b nanoseconds, the last
+ * one takes everything above 2^38ns (about 4.5 minutes) */
+#define METRIC_NUM_BUCKETS 40
+
+/* The metrics of one thread, every thread writes its own block so there
+ * is no sharing on the hot path */
+typedef struct alignas (64) metrics_block {
+	uint64_t counters[METRIC_NUM_COUNTERS];
+	uint64_t buckets[METRIC_NUM_HISTOGRAMS][METRIC_NUM_BUCKETS];
+	uint64_t sum_ns[METRIC_NUM_HISTOGRAMS];
+
+	struct metrics_block *next;		/* The next registered block */
+} metrics_block_t;
+
+/* A consistent copy of all the metrics, summed over the threads */
+typedef struct metrics_snapshot {
+	uint64_t counters[METRIC_NUM_COUNTERS];
+	uint64_t buckets[METRIC_NUM_HISTOGRAMS][METRIC_NUM_BUCKETS];
+	uint64_t count[METRIC_NUM_HISTOGRAMS];
+	uint64_t sum_ns[METRIC_NUM_HISTOGRAMS];
+} metrics_snapshot_t;
+
+
+/*-----------------------------------------------------------------------------
+ *  Recording, inline so that the hot paths pay a TLS load and an add
+ *-----------------------------------------------------------------------------*/
+
+#ifndef PLUTUS_NO_METRICS
+
+/* The block of the calling thread, NULL until its first metric */
+extern thread_local metrics_block_t *metrics_thread_block
+	__attribute__ ((tls_model ("initial-exec")));
+
+/* register a block for the calling thread
+ *
+ * returns the block of the calling thread
+ */
+metrics_block_t *
+metrics_register_thread 	(void);
+
+/* get the block of the calling thread */
+static inline metrics_block_t *
+metrics_block ()
+{
+	metrics_block_t *block = metrics_thread_block;
+	if (__builtin_expect (block == NULL, 0))
+		block = metrics_register_thread ();
+
+	return block;
+} /* metrics_block */
+
+/* add to a counter. Only the owning thread writes a block, the relaxed
+ * atomics keep the snapshots from reading torn values. */
+static inline void
+metrics_add (metric_counter_t counter, uint64_t n)
+{
+	uint64_t *c = &metrics_block ()->counters[counter];
+	__atomic_store_n (c, __atomic_load_n (c, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+} /* metrics_add */
+
+/* get the current time of the latency clock in nanoseconds */
+static inline uint64_t
+metrics_now ()
+{
+	timespec t;
+	clock_gettime (CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000000ULL + t.tv_nsec;
+} /* metrics_now */
+
+/* record the latency of an operation that started at start */
+static inline void
+metrics_observe (metric_histogram_t hist, uint64_t start)
+{
+	uint64_t ns = metrics_now () - start;
+	unsigned int b = ns ? 64 - __builtin_clzll (ns) : 0;
+	if (b >= METRIC_NUM_BUCKETS)
+		b = METRIC_NUM_BUCKETS - 1;
+
+	metrics_block_t *block = metrics_block ();
+	uint64_t *c = &block->buckets[hist][b];
+	uint64_t *s = &block->sum_ns[hist];
+	__atomic_store_n (c, __atomic_load_n (c, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+	__atomic_store_n (s, __atomic_load_n (s, __ATOMIC_RELAXED) + ns, __ATOMIC_RELAXED);
+} /* metrics_observe */
+
+#else /* PLUTUS_NO_METRICS */
+
+/* compiled out, everything folds away */
+static inline void metrics_add (metric_counter_t, uint64_t) {}
+static inline uint64_t metrics_now () { return 0; }
+static inline void metrics_observe (metric_histogram_t, uint64_t) {}
+
+#endif /* PLUTUS_NO_METRICS */
+
+
+/*-----------------------------------------------------------------------------
+ *  Reading
+ *-----------------------------------------------------------------------------*/
+
+/* sum the metrics of all the threads, past and present
+ *
+ * arguments are:
+ *
+ *  snap		-- The snapshot to fill
+ */
+void
+metrics_snapshot 	(metrics_snapshot_t *snap);
+
+/* get the name of a counter or a histogram */
+const char *metrics_counter_name 	(metric_counter_t counter);
+const char *metrics_histogram_name 	(metric_histogram_t hist);
+
+/* format a snapshot in the Prometheus text exposition format
+ *
+ * arguments are:
+ *
+ *  snap		-- The snapshot to format
+ *  buf			-- The output buffer, may be NULL if buf_len is 0
+ *  buf_len		-- The size of the output buffer in bytes
+ *
+ * returns the length of the full text like snprintf, the output is cut
+ * short if it is not smaller than buf_len
+ */
+size_t
+metrics_format_prometheus 	(const metrics_snapshot_t *snap,
+		char *buf, size_t buf_len);
+
+/* take a snapshot and write it in the Prometheus text format
+ *
+ * arguments are:
+ *
+ *  out			-- The stream to write to
+ */
+void
+metrics_write_prometheus 	(FILE *out);
+
+#endif /* metrics.h */
@@ -24,6 +24,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include "puzzle/allocator.h"
+
 /* Struct definitions */
 typedef struct SHA256OptChallenge {
 	unsigned char *preimage;	/* The preimage x to be sent to the client */
@@ -121,5 +123,16 @@ insert_subsolution 		(SHA256OptSubSolution *head,
  */
 void
 free_solution_mem 		(SHA256OptSolution *sol);
+/* free the memory occupied by a solution created through an allocator, the
+ * values of z_i must come from the same allocator
+ *
+ * arguments are:
+ *
+ *  sol				-- The solution to free
+ *  allocator		-- The allocator it came from
+ */
+void
+free_solution_mem 		(SHA256OptSolution *sol,
+		const PuzzleAllocator *allocator);
 
 #endif /* optpuzzle.h */
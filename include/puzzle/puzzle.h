@@ -5,6 +5,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include "puzzle/allocator.h"
+
 /* Struct defintions */
 
 typedef struct SHA256SubPuzzle {
@@ -151,5 +153,22 @@ void free_solution_mem 		(SHA256Solution *sol);
  */
 void free_solution_list 	(SHA256SubSolution *head);
 
+/* free the memory of a challenge, a sub puzzle list, a solution or a sub
+ * solution list created through an allocator. The preimages, images and
+ * solutions must come from the same allocator.
+ *
+ * arguments are:
+ *
+ *  challenge, head, sol	-- The object to free
+ *  allocator				-- The allocator it came from
+ */
+void free_challenge_mem 	(SHA256Challenge *challenge,
+		const PuzzleAllocator *allocator);
+void free_list				(SHA256SubPuzzle *head,
+		const PuzzleAllocator *allocator);
+void free_solution_mem 		(SHA256Solution *sol,
+		const PuzzleAllocator *allocator);
+void free_solution_list 	(SHA256SubSolution *head,
+		const PuzzleAllocator *allocator);
 
 #endif /* puzzle.h */
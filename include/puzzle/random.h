@@ -0,0 +1,92 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  random.h
+ *
+ *    Description:  A ChaCha20 random generator per thread, refilled in bulk and
+ *    				seeded from the system, or from a fixed seed for runs that
+ *    				must repeat
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 11:58:06 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __RANDOM_H
+#define __RANDOM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* The length of a ChaCha20 key, nonce and block in bytes */
+#define CHACHA20_KEY_LEN 	32
+#define CHACHA20_NONCE_LEN 	12
+#define CHACHA20_BLOCK_LEN 	64
+
+/* The blocks a thread generates at once. The first key and nonce worth of
+ * every refill becomes the next key, so what was handed out cannot be
+ * rebuilt from the state left behind. */
+#ifndef RANDOM_REFILL_BLOCKS
+#define RANDOM_REFILL_BLOCKS 16
+#endif
+
+/* compute one ChaCha20 block, as in RFC 8439
+ *
+ * arguments are:
+ *
+ *  key			-- The CHACHA20_KEY_LEN bytes of the key
+ *  counter		-- The block counter
+ *  nonce		-- The CHACHA20_NONCE_LEN bytes of the nonce
+ *  out			-- The CHACHA20_BLOCK_LEN bytes of the block (return variable)
+ */
+void
+chacha20_block 		(const unsigned char *key, uint32_t counter,
+		const unsigned char *nonce, unsigned char *out);
+
+/* fill a buffer with random bytes from the generator of the calling
+ * thread. It takes no lock, and draws from the system only to seed a
+ * thread on first use or in a new process.
+ *
+ * arguments are:
+ *
+ *  buf			-- The buffer to fill (return variable)
+ *  len			-- The length of the buffer in bytes
+ *
+ * returns 0 on success, -1 if the system could not seed the generator
+ */
+int
+random_bytes 		(unsigned char *buf, size_t len);
+
+/* get a random 64 bit value from the generator of the calling thread
+ *
+ * returns the value, 0 if the generator could not be seeded
+ */
+uint64_t
+random_u64 			(void);
+
+/* seed the generator of the calling thread with a fixed value. What it
+ * produces from there on is the same on every run, and it stays that way
+ * across a fork. Other threads are not affected.
+ *
+ * arguments are:
+ *
+ *  seed		-- The seed
+ */
+void
+random_seed 		(uint64_t seed);
+
+/* seed the generator of the calling thread from the system again, which
+ * ends a fixed seed
+ *
+ * returns 0 on success, -1 if the system could not seed it
+ */
+int
+random_reseed 		(void);
+
+#endif /* random.h */
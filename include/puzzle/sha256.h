@@ -0,0 +1,196 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256.h
+ *
+ *    Description:  Low level SHA256 routines with support for precomputed midstates
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 09:12:40 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __SHA256_H
+#define __SHA256_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SHA256_BLOCK_LEN 	64	/* The size of a compression block in bytes */
+#define SHA256_DIGEST_LEN 	32	/* The size of a digest in bytes */
+
+/* The largest number of trailing blocks a midstate can hold */
+#define SHA256_MIDSTATE_MAX_BLOCKS 	4
+
+/* Struct definitions */
+
+typedef struct SHA256Ctx {
+	uint32_t h[8];							/* The current chaining value */
+	uint64_t total_len;						/* The number of bytes absorbed so far */
+	unsigned char buf[SHA256_BLOCK_LEN];	/* The partially filled block */
+	unsigned int buf_len;					/* The number of bytes in buf */
+} SHA256Ctx;
+
+typedef struct SHA256Midstate {
+	uint32_t h[8];			/* The chaining value after the fixed full blocks */
+
+	/* The padded trailing blocks. They hold the rest of the fixed prefix,
+	 * the variable tail and the SHA256 padding and length. */
+	unsigned char block[SHA256_MIDSTATE_MAX_BLOCKS * SHA256_BLOCK_LEN];
+
+	unsigned int nblocks;	/* The number of trailing blocks to compress */
+	unsigned int tail_off;	/* The offset of the variable tail in block */
+	unsigned int tail_len;	/* The length of the variable tail in bytes */
+} SHA256Midstate;
+
+
+/*-----------------------------------------------------------------------------
+ *  Streaming interface
+ *-----------------------------------------------------------------------------*/
+
+/* initialize a streaming SHA256 context
+ *
+ * arguments are:
+ *
+ *  ctx			-- The context to initialize
+ */
+void
+sha256_init 		(SHA256Ctx *ctx);
+
+/* absorb a message into a streaming context
+ *
+ * arguments are:
+ *
+ *  ctx			-- The context to update
+ *  msg			-- The message bytes to absorb
+ *  len			-- The number of bytes to absorb
+ */
+void
+sha256_update 		(SHA256Ctx *ctx, const unsigned char *msg, size_t len);
+
+/* pad and finish a streaming context. The context can be copied before
+ * calling this function to reuse the absorbed prefix.
+ *
+ * arguments are:
+ *
+ *  ctx			-- The context to finish
+ *  digest		-- The output buffer of SHA256_DIGEST_LEN bytes
+ */
+void
+sha256_final 		(SHA256Ctx *ctx, unsigned char *digest);
+
+/* compute sha256(msg) in one go
+ *
+ * arguments are:
+ *
+ *  msg			-- The message to digest
+ *  len			-- The length of the message in bytes
+ *  digest		-- The output buffer of SHA256_DIGEST_LEN bytes
+ */
+void
+sha256_digest 		(const unsigned char *msg, size_t len, unsigned char *digest);
+
+/* run the SHA256 compression function over a number of full blocks
+ *
+ * arguments are:
+ *
+ *  state		-- The chaining value to update
+ *  blocks		-- The blocks to compress
+ *  nblocks		-- The number of blocks
+ */
+void
+sha256_compress 	(uint32_t state[8], const unsigned char *blocks, size_t nblocks);
+
+/* check whether the CPU supports the x86 SHA extensions (SHA-NI)
+ *
+ * returns true if sha256_set_shani can turn them on
+ */
+bool
+sha256_shani_supported 	(void);
+
+/* check whether sha256_compress currently runs on the SHA extensions. They
+ * are turned on at startup when the CPU supports them.
+ *
+ * returns true if the SHA extensions are in use
+ */
+bool
+sha256_shani_enabled 	(void);
+
+/* switch the compression function between the SHA extensions and the
+ * portable implementation
+ *
+ * arguments are:
+ *
+ *  enable		-- Whether to use the SHA extensions
+ *
+ * returns 0 on success, -1 if the CPU does not support them
+ */
+int
+sha256_set_shani 		(bool enable);
+
+
+/*-----------------------------------------------------------------------------
+ *  Midstate interface for hashing prefix || tail with a fixed prefix
+ *-----------------------------------------------------------------------------*/
+
+/* absorb a fixed prefix and lay out the padded trailing blocks for messages
+ * of the form prefix || tail, where tail always has the same length.
+ *
+ * arguments are:
+ *
+ *  ms			-- The midstate to initialize
+ *  prefix		-- The fixed prefix of the message
+ *  prefix_len	-- The length of the prefix in bytes
+ *  tail_len	-- The length of the variable tail in bytes
+ *
+ * returns 0 on success, -1 if the tail does not fit in the trailing blocks
+ */
+int
+sha256_midstate_init 	(SHA256Midstate *ms, const unsigned char *prefix,
+		size_t prefix_len, size_t tail_len);
+
+/* lay out the padded trailing blocks for messages prefix || tail from a
+ * streaming context that already absorbed the prefix. This is the way to
+ * go when the prefix is assembled from several pieces.
+ *
+ * arguments are:
+ *
+ *  ms			-- The midstate to initialize
+ *  ctx			-- The context holding the prefix, left as it is
+ *  tail_len	-- The length of the variable tail in bytes
+ *
+ * returns 0 on success, -1 if the tail does not fit in the trailing blocks
+ */
+int
+sha256_midstate_from_ctx 	(SHA256Midstate *ms, const SHA256Ctx *ctx,
+		size_t tail_len);
+
+/* get the location of the variable tail inside the midstate. Candidates
+ * can be written there in place before calling sha256_midstate_digest.
+ *
+ * arguments are:
+ *
+ *  ms			-- The midstate
+ *
+ * returns a pointer to the tail_len bytes of the tail
+ */
+unsigned char *
+sha256_midstate_tail 	(SHA256Midstate *ms);
+
+/* finish the hash of prefix || tail using the tail currently in the midstate
+ *
+ * arguments are:
+ *
+ *  ms			-- The midstate
+ *  digest		-- The output buffer of SHA256_DIGEST_LEN bytes
+ */
+void
+sha256_midstate_digest 	(const SHA256Midstate *ms, unsigned char *digest);
+
+#endif /* sha256.h */
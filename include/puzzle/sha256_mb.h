@@ -0,0 +1,86 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256_mb.h
+ *
+ *    Description:  Multi-buffer SHA256 hashing of many same length messages at once
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 01:02:19 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __SHA256_MB_H
+#define __SHA256_MB_H
+
+#include "puzzle/sha256.h"
+
+/* The largest number of messages hashed in lockstep by any backend */
+#define SHA256_MB_MAX_LANES 16
+
+/* The available multi-buffer backends */
+typedef enum {
+	SHA256_MB_SCALAR = 0,		/* One message at a time, always available */
+	SHA256_MB_AVX2,				/* 8 messages per AVX2 register */
+	SHA256_MB_AVX512			/* 16 messages per AVX-512 register */
+} sha256_mb_backend_t;
+
+/* hash n messages prefix || tail_j that share the prefix absorbed in a
+ * midstate. The tails are laid out back to back, ms->tail_len bytes each.
+ * The tail currently stored in the midstate is ignored.
+ *
+ * arguments are:
+ *
+ *  ms			-- The midstate holding the shared prefix
+ *  tails		-- The n tails of the messages
+ *  n			-- The number of messages, any value is fine
+ *  digests		-- The n digests, SHA256_DIGEST_LEN bytes each (return variable)
+ */
+void
+sha256_mb_digest 		(const SHA256Midstate *ms, const unsigned char *tails,
+		unsigned int n, unsigned char *digests);
+
+/* get the number of messages the active backend hashes in lockstep. Callers
+ * should hand in batches of (a multiple of) this size.
+ *
+ * returns the number of lanes of the active backend
+ */
+unsigned int
+sha256_mb_lanes 		(void);
+
+/* get the backend picked for this CPU at startup, or set by the caller
+ *
+ * returns the active backend
+ */
+sha256_mb_backend_t
+sha256_mb_get_backend 	(void);
+
+/* switch to another backend
+ *
+ * arguments are:
+ *
+ *  backend		-- The backend to use
+ *
+ * returns 0 on success, -1 if the CPU or the build does not support it
+ */
+int
+sha256_mb_set_backend 	(sha256_mb_backend_t backend);
+
+/* get the printable name of a backend
+ *
+ * arguments are:
+ *
+ *  backend		-- The backend
+ *
+ * returns the name of the backend
+ */
+const char *
+sha256_mb_backend_name 	(sha256_mb_backend_t backend);
+
+#endif /* sha256_mb.h */
@@ -0,0 +1,209 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  wire.h
+ *
+ *    Description:  A versioned binary encoding of the challenges and solutions,
+ *    				with packets validated and read in place
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 12:48:05 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __WIRE_H
+#define __WIRE_H
+
+#include <stddef.h>
+
+#include "puzzle/puzzle.h"
+#include "puzzle/optpuzzle.h"
+#include "puzzle/flatpuzzle.h"
+
+/* Every packet starts with a fixed header of 16 bytes, all the integers
+ * are little endian:
+ *
+ *   offset  size  field
+ *   0       2     magic, "PZ"
+ *   2       1     version
+ *   3       1     type
+ *   4       4     timestamp
+ *   8       2     k, the number of sub puzzles
+ *   10      2     m, the bits of difficulty, 0 in solutions
+ *   12      2     the length of one element of the body in bytes
+ *   14      2     reserved, 0
+ *
+ * and the body follows right after:
+ *
+ *   WIRE_CHALLENGE		k preimages, then k images, of 32 bytes each
+ *   WIRE_SOLUTION		k solutions of 32 bytes
+ *   WIRE_OPT_CHALLENGE	x, of one element
+ *   WIRE_OPT_SOLUTION	k values of z_i of one element each
+ *   WIRE_HELLO			one element of zeros, a request for a challenge
+ *   					padded by the client so that the challenge is
+ *   					never larger than the request for it
+ *   WIRE_VERDICT		the outcome of a solution, of one byte, with the
+ *   					timestamp of the solution
+ */
+#define WIRE_MAGIC 			0x5a50	/* "PZ" on the wire */
+#define WIRE_VERSION 		1
+#define WIRE_HEADER_LEN 	16
+
+typedef enum {
+	WIRE_CHALLENGE = 1,		/* A SHA256Challenge */
+	WIRE_SOLUTION,			/* A SHA256Solution */
+	WIRE_OPT_CHALLENGE,		/* A SHA256OptChallenge */
+	WIRE_OPT_SOLUTION,		/* A SHA256OptSolution */
+	WIRE_HELLO,				/* A request for a challenge, over datagrams */
+	WIRE_VERDICT			/* The answer to a solution, over datagrams */
+} wire_type_t;
+
+/* The outcome of validating a packet */
+typedef enum {
+	WIRE_OK = 0,			/* A well formed packet */
+	WIRE_TRUNCATED,			/* Shorter than its header says */
+	WIRE_BAD_MAGIC,			/* Not one of ours */
+	WIRE_BAD_VERSION,		/* A version we do not speak */
+	WIRE_BAD_TYPE,			/* An unknown or unexpected type */
+	WIRE_BAD_LENGTH			/* Element lengths out of range, or trailing bytes */
+} wire_status_t;
+
+/* A validated packet. It points into the received buffer, nothing is
+ * copied, and it lives as long as the buffer does. */
+typedef struct WirePacket {
+	wire_type_t type;			/* The type of the packet */
+	uint32_t timestamp;			/* The timestamp of the challenge */
+	uint16_t k;					/* The number of sub puzzles */
+	uint16_t m;					/* The bits of difficulty */
+	uint16_t elem_len;			/* The length of one element of the body */
+
+	const unsigned char *body;	/* The body, inside the buffer */
+	size_t body_len;			/* The length of the body in bytes */
+} WirePacket;
+
+
+/*-----------------------------------------------------------------------------
+ *  Validating in place
+ *-----------------------------------------------------------------------------*/
+
+/* validate a packet without copying or allocating anything
+ *
+ * arguments are:
+ *
+ *  buf				-- The received bytes
+ *  buf_len			-- The number of received bytes
+ *  pkt				-- The view of the packet (return variable)
+ *
+ * returns WIRE_OK if the packet is well formed, the reason otherwise
+ */
+wire_status_t
+wire_parse 			(const unsigned char *buf, size_t buf_len, WirePacket *pkt);
+
+/* read the timestamp of a packet without validating the rest, for picking
+ * the key to verify it with
+ *
+ * arguments are:
+ *
+ *  buf				-- The received bytes
+ *  buf_len			-- The number of received bytes
+ *  timestamp		-- The timestamp in the header (return variable)
+ *
+ * returns 0 on success, -1 if there is no whole header
+ */
+int
+wire_peek_timestamp (const unsigned char *buf, size_t buf_len, uint32_t *timestamp);
+
+/* get a printable name of a validation status
+ *
+ * returns a constant string
+ */
+const char *
+wire_status_name 	(wire_status_t status);
+
+/* look at an optimized solution packet as a flat solution. The view points
+ * into the packet's buffer and must not be freed or written to.
+ *
+ * arguments are:
+ *
+ *  pkt				-- A validated WIRE_OPT_SOLUTION packet
+ *  view			-- The flat solution (return variable)
+ *
+ * returns 0 on success, -1 if the packet has another type
+ */
+int
+wire_view_optsolution 	(const WirePacket *pkt, SHA256OptFlatSolution *view);
+
+/* look at a solution packet as a flat solution, see wire_view_optsolution
+ *
+ * returns 0 on success, -1 if the packet has another type
+ */
+int
+wire_view_solution 		(const WirePacket *pkt, SHA256FlatSolution *view);
+
+
+/*-----------------------------------------------------------------------------
+ *  Encoding. Every encoder returns the length of the full packet and only
+ *  writes it if it fits in buf_len bytes, so a first call with a NULL
+ *  buffer gets the size. 0 means the object cannot be encoded.
+ *-----------------------------------------------------------------------------*/
+
+/* encode a challenge of the naive scheme */
+size_t
+encode_challenge 	(const SHA256Challenge *challenge, unsigned char *buf, size_t buf_len);
+
+/* encode a challenge of the optimized scheme */
+size_t
+encode_challenge 	(const SHA256OptChallenge *challenge, unsigned char *buf, size_t buf_len);
+
+/* encode a solution of the naive scheme, the first k sub solutions are
+ * encoded, the list must hold at least k */
+size_t
+encode_solution 	(const SHA256Solution *sol, uint16_t k,
+		unsigned char *buf, size_t buf_len);
+
+/* encode a solution of the optimized scheme. l is the length of x + z in
+ * bits, as minted, not the length in bytes a SHA256OptChallenge holds.
+ * Each z_i takes l/16 bytes, and the first k sub solutions are encoded,
+ * the list must hold at least k */
+size_t
+encode_solution 	(const SHA256OptSolution *sol, uint16_t l, uint16_t k,
+		unsigned char *buf, size_t buf_len);
+
+/* encode a flat solution of the optimized scheme, all of its values of z_i */
+size_t
+encode_solution 	(const SHA256OptFlatSolution *sol, unsigned char *buf, size_t buf_len);
+
+/* encode a request for a challenge padded to pad bytes of body */
+size_t
+encode_hello 		(uint16_t pad, unsigned char *buf, size_t buf_len);
+
+/* encode the verdict on the solution of a given timestamp */
+size_t
+encode_verdict 		(uint32_t timestamp, uint8_t verdict,
+		unsigned char *buf, size_t buf_len);
+
+
+/*-----------------------------------------------------------------------------
+ *  Decoding into the linked list layouts, freed the usual way
+ *-----------------------------------------------------------------------------*/
+
+/* decode a validated packet of the matching type
+ *
+ * arguments are:
+ *
+ *  pkt				-- The validated packet
+ *
+ * returns a new object, NULL on failure or if the packet has another type
+ */
+SHA256Challenge 	*decode_challenge 		(const WirePacket *pkt);
+SHA256Solution 		*decode_solution 		(const WirePacket *pkt);
+SHA256OptChallenge 	*decode_optchallenge 	(const WirePacket *pkt);
+SHA256OptSolution 	*decode_optsolution 	(const WirePacket *pkt);
+
+#endif /* wire.h */
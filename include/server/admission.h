@@ -0,0 +1,187 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  admission.h
+ *
+ *    Description:  The admission queue in front of verification. Pending solutions
+ *    				are taken by priority and deadline, and shed by the same order
+ *    				from the other end when there is no room left.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 10:41:19 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __ADMISSION_H
+#define __ADMISSION_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "server/verifier.h"
+
+/* The priority levels, a request of a higher level is always taken first */
+#define ADMISSION_LEVELS 	4
+
+/* The levels given by a client's record, see admission_level */
+#define ADMISSION_SUSPECT 	0		/* Mostly failed solutions */
+#define ADMISSION_UNKNOWN 	1		/* Too little history */
+#define ADMISSION_GOOD 		2		/* Mostly verified solutions */
+#define ADMISSION_TRUSTED 	3		/* A long run of verified solutions */
+
+typedef struct AdmissionQueue AdmissionQueue;	/* The pending requests */
+typedef struct AdmissionScores AdmissionScores;	/* The records of the clients */
+
+/* The counters of a queue */
+typedef struct AdmissionStats {
+	uint64_t admitted;				/* Requests queued */
+	uint64_t taken;					/* Requests taken for verification */
+	uint64_t shed;					/* Requests pushed out for room, or refused */
+	uint64_t expired;				/* Requests past their deadline when reached */
+	uint64_t depth;					/* Requests waiting right now */
+	uint64_t level_depth[ADMISSION_LEVELS];	/* Of those, the ones of each level */
+} AdmissionStats;
+
+/* get the clock of the deadlines, CLOCK_MONOTONIC in nanoseconds
+ *
+ * returns the current time
+ */
+uint64_t
+admission_clock 		(void);
+
+/* create an admission queue
+ *
+ * arguments are:
+ *
+ *  capacity		-- The most requests waiting at once
+ *
+ * returns the new queue, NULL on failure
+ */
+AdmissionQueue *
+create_admission_queue 	(unsigned int capacity);
+
+/* free an admission queue, what is still waiting is forgotten
+ *
+ * arguments are:
+ *
+ *  q				-- The queue to free
+ */
+void
+free_admission_queue 	(AdmissionQueue *q);
+
+/* queue a request by its priority and deadline. On a full queue the lowest
+ * level loses its request with the earliest deadline, which is the one
+ * that has waited the longest, and that may be the new request itself.
+ *
+ * arguments are:
+ *
+ *  q				-- The queue
+ *  req				-- The request, its priority and deadline are read
+ *  shed			-- The request pushed out to make room, NULL if there was
+ *  					room (return variable)
+ *
+ * returns 0 if req was queued, -1 if it was shed itself or the queue is closed
+ */
+int
+admission_push 			(AdmissionQueue *q, VerifyRequest *req, VerifyRequest **shed);
+
+/* take the most urgent requests, waiting until there is one. The highest
+ * level goes first, and the earliest deadline within a level. The requests
+ * that are past their deadline by the time they are reached are handed back
+ * apart, to be completed unverified.
+ *
+ * arguments are:
+ *
+ *  q				-- The queue
+ *  reqs			-- The requests to verify (return variable)
+ *  max				-- The room in reqs, and in expired
+ *  expired			-- The requests past their deadline (return variable)
+ *  nexpired		-- The number of those (return variable)
+ *
+ * returns the number of requests to verify. It returns 0 with no expired
+ * request only once the queue is closed and empty.
+ */
+unsigned int
+admission_take 			(AdmissionQueue *q, VerifyRequest **reqs, unsigned int max,
+		VerifyRequest **expired, unsigned int *nexpired);
+
+/* close a queue, nothing more is queued and the takers drain what is left
+ *
+ * arguments are:
+ *
+ *  q				-- The queue
+ */
+void
+admission_close 		(AdmissionQueue *q);
+
+/* read the counters of a queue
+ *
+ * arguments are:
+ *
+ *  q				-- The queue
+ *  stats			-- The counters (return variable)
+ */
+void
+admission_stats 		(AdmissionQueue *q, AdmissionStats *stats);
+
+
+/*-----------------------------------------------------------------------------
+ *  The records of the clients
+ *-----------------------------------------------------------------------------*/
+
+/* create a table of client records. A record is two small counters that
+ * are halved as they fill up, so old behaviour fades, kept in slots
+ * indexed by a hash of the connection data. Any thread may use it.
+ *
+ * arguments are:
+ *
+ *  slots			-- The number of records, rounded up to a power of two
+ *
+ * returns the new table, NULL on failure
+ */
+AdmissionScores *
+create_admission_scores (unsigned int slots);
+
+/* free a table of client records
+ *
+ * arguments are:
+ *
+ *  scores			-- The table to free
+ */
+void
+free_admission_scores 	(AdmissionScores *scores);
+
+/* record the outcome of a client's solution
+ *
+ * arguments are:
+ *
+ *  scores			-- The table
+ *  data			-- The data of the client's connection
+ *  data_len		-- The length of the data in bytes
+ *  ok				-- Whether the solution verified
+ */
+void
+admission_record 		(AdmissionScores *scores, const unsigned char *data,
+		unsigned int data_len, bool ok);
+
+/* get the priority level a client has earned
+ *
+ * arguments are:
+ *
+ *  scores			-- The table
+ *  data			-- The data of the client's connection
+ *  data_len		-- The length of the data in bytes
+ *
+ * returns one of the ADMISSION_ levels
+ */
+unsigned int
+admission_level 		(const AdmissionScores *scores, const unsigned char *data,
+		unsigned int data_len);
+
+#endif /* admission.h */
@@ -0,0 +1,125 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  difficulty.h
+ *
+ *    Description:  A controller that picks the number of sub puzzles and the
+ *    				difficulty bits of new challenges from the server's load
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:24:52 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __DIFFICULTY_H
+#define __DIFFICULTY_H
+
+#include <stdint.h>
+
+#include "puzzle/metrics.h"
+
+/* The load of the server over one sampling period */
+typedef struct DifficultySignals {
+	double queue_depth;			/* The verifications waiting to run */
+	double cpu_util;			/* The busy fraction of the verifier CPUs, 0 to 1 */
+	uint64_t verified;			/* The solutions accepted during the period */
+	uint64_t failed;			/* The solutions rejected during the period */
+} DifficultySignals;
+
+/* The control law. Each signal is divided by its target and the largest
+ * ratio, smoothed over the periods, is the load. A load above raise_above
+ * doubles the client work at least once, a load below lower_below halves
+ * it, and anything in between keeps it. After a change the controller
+ * holds still for cooldown periods. */
+typedef struct DifficultyConfig {
+	uint16_t k_min, k_max;		/* The range of sub puzzles */
+	uint16_t m_min, m_max;		/* The range of difficulty bits */
+
+	double queue_target;		/* The queue depth that counts as full load, 0 to ignore */
+	double cpu_target;			/* The utilization that counts as full load, 0 to ignore */
+	double fail_target;			/* The rejected fraction that counts as full load, 0 to ignore */
+
+	double smoothing;			/* The weight of a new sample in the load, 0 to 1 */
+	double raise_above;			/* The load above which the work goes up */
+	double lower_below;			/* The load below which the work goes down */
+	unsigned int cooldown;		/* The periods to wait after a change */
+} DifficultyConfig;
+
+/* A difficulty controller. The work asked of a client, k * 2^m hashes,
+ * moves on a ladder of doublings: m goes up first, one bit per level, and
+ * once it reaches m_max the number of sub puzzles doubles up to k_max. */
+typedef struct DifficultyController {
+	DifficultyConfig config;	/* The control law */
+
+	double load;				/* The smoothed load */
+	unsigned int level;			/* The current step on the ladder */
+	unsigned int max_level;		/* The top of the ladder */
+	unsigned int hold;			/* The periods left before the next change */
+
+	uint16_t k;					/* The number of sub puzzles of new challenges */
+	uint16_t m;					/* The difficulty bits of new challenges */
+} DifficultyController;
+
+/* fill a configuration with the defaults
+ *
+ * arguments are:
+ *
+ *  config			-- The configuration to fill
+ */
+void
+difficulty_default_config 	(DifficultyConfig *config);
+
+/* set up a controller at the bottom of its ladder
+ *
+ * arguments are:
+ *
+ *  ctl				-- The controller to initialize
+ *  config			-- The control law, NULL for the defaults
+ *
+ * returns 0 on success, -1 if the configuration makes no sense
+ */
+int
+init_difficulty 			(DifficultyController *ctl, const DifficultyConfig *config);
+
+/* feed a controller the signals of one period
+ *
+ * arguments are:
+ *
+ *  ctl				-- The controller
+ *  signals			-- The load of the period
+ *
+ * returns the number of levels the work moved, negative if it went down
+ */
+int
+difficulty_update 			(DifficultyController *ctl, const DifficultySignals *signals);
+
+/* get the parameters of new challenges
+ *
+ * arguments are:
+ *
+ *  ctl				-- The controller
+ *  k				-- The number of sub puzzles (return variable)
+ *  m				-- The difficulty bits (return variable)
+ */
+void
+difficulty_params 			(const DifficultyController *ctl, uint16_t *k, uint16_t *m);
+
+/* fill the verification counts of the signals from two metrics snapshots
+ *
+ * arguments are:
+ *
+ *  signals			-- The signals to fill
+ *  before			-- The snapshot at the start of the period
+ *  after			-- The snapshot at the end of the period
+ */
+void
+difficulty_signals_from_metrics 	(DifficultySignals *signals,
+		const metrics_snapshot_t *before, const metrics_snapshot_t *after);
+
+#endif /* difficulty.h */
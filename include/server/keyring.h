@@ -0,0 +1,174 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  keyring.h
+ *
+ *    Description:  The server's keys by epoch. The current and the previous key
+ *    				are kept as minters, readers never take a lock and a rotation
+ *    				frees the key it drops once no reader can still see it.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 01:04:27 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __KEYRING_H
+#define __KEYRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "server/optserver.h"
+
+typedef struct PlutusKeyring PlutusKeyring;
+
+/* The keys a reader sees, never changed once published. A key covers the
+ * timestamps from its since on, up to the since of the key after it. */
+typedef struct KeyringSnapshot {
+	SHA256OptMinter current;		/* The minter of the newest key */
+	uint32_t since;					/* The first timestamp of the newest key */
+
+	SHA256OptMinter previous;		/* The minter of the key before it */
+	uint32_t previous_since;		/* The first timestamp of that key */
+	bool has_previous;				/* Whether there was a key before */
+} KeyringSnapshot;
+
+/* create a keyring holding a first key, epoch 0, for every timestamp
+ *
+ * arguments are:
+ *
+ *  key				-- The server's secret key
+ *  key_len			-- The length of the key in bytes
+ *  k				-- The number of subpuzzles in the challenges
+ *  m				-- The number of bits of difficulty
+ *  l				-- The number of bits of x + z
+ *
+ * returns the new keyring, NULL if the parameters are unusable, see
+ * init_minter
+ */
+PlutusKeyring *
+create_keyring 			(const unsigned char *key, unsigned int key_len,
+		uint16_t k, uint16_t m, unsigned int l);
+
+/* wipe and free a keyring, no thread may be reading it
+ *
+ * arguments are:
+ *
+ *  ring			-- The keyring to free
+ */
+void
+free_keyring 			(PlutusKeyring *ring);
+
+/* make a new key current. The current key becomes the previous one and
+ * keeps verifying the challenges it minted, the previous key is dropped.
+ * Challenges are minted and verified with the key of their timestamp, so
+ * a key taking over from the next second on leaves every handshake in
+ * flight alone. Rotating again before max_age has passed fails those of
+ * the dropped key.
+ *
+ * Rotations are serialized, and one returns once no reader can still see
+ * the dropped key, which is then wiped. It must not be called from inside
+ * a read section.
+ *
+ * arguments are:
+ *
+ *  ring			-- The keyring
+ *  key				-- The new secret key
+ *  key_len			-- The length of the key in bytes
+ *  since			-- The first timestamp of the new key, after the first
+ *  					timestamp of the current one
+ *
+ * returns the epoch of the new key, -1 if since is not after the current
+ * key's
+ */
+int64_t
+keyring_rotate 			(PlutusKeyring *ring, const unsigned char *key,
+		unsigned int key_len, uint32_t since);
+
+/* get the epoch of the current key
+ *
+ * arguments are:
+ *
+ *  ring			-- The keyring
+ *
+ * returns the epoch
+ */
+uint32_t
+keyring_epoch 			(const PlutusKeyring *ring);
+
+
+/*-----------------------------------------------------------------------------
+ *  Reading, without a lock
+ *-----------------------------------------------------------------------------*/
+
+/* start a read section and take the keys of the moment. They stay valid
+ * until keyring_exit, even across a rotation. A thread has one section
+ * open at a time, and its first one registers the thread under a lock.
+ *
+ * arguments are:
+ *
+ *  ring			-- The keyring
+ *
+ * returns the keys
+ */
+const KeyringSnapshot *
+keyring_enter 			(PlutusKeyring *ring);
+
+/* end the read section of the calling thread
+ *
+ * arguments are:
+ *
+ *  ring			-- The keyring
+ */
+void
+keyring_exit 			(PlutusKeyring *ring);
+
+/* get the minter of a timestamp
+ *
+ * arguments are:
+ *
+ *  keys			-- The keys of a read section
+ *  timestamp		-- The timestamp of a challenge
+ *
+ * returns the minter, NULL if the timestamp is older than every key
+ */
+const SHA256OptMinter *
+keyring_select 			(const KeyringSnapshot *keys, uint32_t timestamp);
+
+/* mint a batch of challenges with the key of their timestamp, see
+ * minter_mint_packets. A timestamp older than every key mints nothing and
+ * sets the length of every item to 0.
+ *
+ * returns the number of challenges minted
+ */
+unsigned int
+keyring_mint_packets 	(PlutusKeyring *ring, SHA256OptPacketItem *items,
+		unsigned int n, uint32_t timestamp);
+
+/* verify a packet with the key of its timestamp, see minter_verify_packet
+ *
+ * returns VERIFY_OK if verified, VERIFY_STALE if no key covers the
+ * timestamp, the reason of the rejection otherwise
+ */
+verify_status_t
+keyring_verify_packet 	(PlutusKeyring *ring, const unsigned char *pkt, size_t pkt_len,
+		const unsigned char *data, unsigned int data_len,
+		const SHA256OptVerifyParams *params);
+
+/* verify a batch of packets, each with the key of its timestamp. The
+ * runs of packets of the same key are verified together, see
+ * minter_verify_packets.
+ *
+ * returns the number of verified packets
+ */
+unsigned int
+keyring_verify_packets 	(PlutusKeyring *ring, const SHA256OptPacketItem *items,
+		unsigned int n, const SHA256OptVerifyParams *params, verify_status_t *statuses);
+
+#endif /* keyring.h */
@@ -20,6 +20,58 @@
 #define __OPTSERVER_H
 
 #include "puzzle/optpuzzle.h"
+#include "puzzle/flatpuzzle.h"
+#include "puzzle/sha256.h"
+#include "server/replay.h"
+
+/* The outcome of verifying a solution, cheap rejections come first */
+typedef enum {
+	VERIFY_OK = 0,			/* The solution is valid */
+	VERIFY_EMPTY,			/* No solution or an empty sub solution */
+	VERIFY_SHORT,			/* Fewer than k sub solutions */
+	VERIFY_STALE,			/* The timestamp is too old or in the future */
+	VERIFY_BAD_PARAMS,		/* The server's parameters are unusable */
+	VERIFY_FAILED,			/* A sub solution does not solve its sub puzzle */
+	VERIFY_REPLAY,			/* The solution was already accepted once */
+	VERIFY_MALFORMED,		/* The packet of the solution is not well formed */
+	VERIFY_SHED				/* Dropped unverified, the verifier is overloaded */
+} verify_status_t;
+
+/* Server side policy applied before any hashing */
+typedef struct SHA256OptVerifyParams {
+	uint32_t now;				/* The server's current timestamp */
+	uint32_t max_age;			/* The largest accepted age of a timestamp, 0 for any */
+	SHA256OptReplayCache *replay;	/* The cache of accepted solutions, NULL for none */
+} SHA256OptVerifyParams;
+
+/* A challenge minter, it holds the hash state after absorbing the server's
+ * key so that minting and verifying only hash the connection's data and
+ * timestamp. The construction is still x = h (key || data || timestamp),
+ * the state is as secret as the key itself. */
+typedef struct SHA256OptMinter {
+	SHA256Ctx keyed;			/* The hash state after absorbing the key */
+	uint32_t epoch;				/* The key epoch the state belongs to */
+
+	uint16_t k;					/* The number of subpuzzles in the challenge */
+	uint16_t m;					/* The number of bits of difficulty */
+	unsigned int l;				/* The number of bits of x + z */
+} SHA256OptMinter;
+
+/* One client solution in a verification batch */
+typedef struct SHA256OptVerifyItem {
+	SHA256OptSolution *sol;		/* The solution provided by the client */
+	unsigned char *data;		/* The data of the client's connection */
+	unsigned int data_len;		/* The length of the data in bytes */
+} SHA256OptVerifyItem;
+
+/* One packet of a batch, read or written where it lies */
+typedef struct SHA256OptPacketItem {
+	unsigned char *pkt;			/* The packet */
+	size_t pkt_len;				/* The length of the packet in bytes. When minting,
+								   the room in pkt and then the length written */
+	const unsigned char *data;	/* The data of the client's connection */
+	unsigned int data_len;		/* The length of the data in bytes */
+} SHA256OptPacketItem;
 
 /* generate a challenge using the optimized implementation
  *
@@ -37,6 +89,83 @@ generate_challenge 		(unsigned char *data,	/* The data to use for the hash */
 		);
 
 
+/*-----------------------------------------------------------------------------
+ *  Minting challenges with a key absorbed once per epoch
+ *-----------------------------------------------------------------------------*/
+
+/* set up a minter for a key epoch
+ *
+ * arguments are:
+ *
+ *  minter			-- The minter to initialize
+ *  key				-- The server's secret key of the epoch
+ *  key_len			-- The length of the key in bytes
+ *  epoch			-- The key epoch
+ *  k				-- The number of subpuzzles in the challenges
+ *  m				-- The number of bits of difficulty
+ *  l				-- The number of bits of x + z
+ *
+ * returns 0 on success, -1 if (l/2) is not a non zero multiple of 8 of at
+ * most 256 bits, or if m is more than (l/2)
+ */
+int
+init_minter 		(SHA256OptMinter *minter, const unsigned char *key,
+		unsigned int key_len, uint32_t epoch,
+		uint16_t k, uint16_t m, unsigned int l);
+
+/* wipe the key state of a minter
+ *
+ * arguments are:
+ *
+ *  minter			-- The minter to clear
+ */
+void
+clear_minter 		(SHA256OptMinter *minter);
+
+/* derive x = the first (l/2) bits of h (key || data || timestamp)
+ *
+ * arguments are:
+ *
+ *  minter			-- The minter of the key
+ *  data			-- The data of the connection
+ *  data_len		-- The length of the data in bytes
+ *  timestamp		-- The timestamp of the challenge
+ *  x				-- The output buffer of (l/2)/8 bytes
+ */
+void
+minter_derive 		(const SHA256OptMinter *minter, const unsigned char *data,
+		unsigned int data_len, uint32_t timestamp, unsigned char *x);
+
+/* mint a challenge, the same as generate_challenge with the minter's key
+ * and parameters
+ *
+ * arguments are:
+ *
+ *  minter			-- The minter of the key
+ *  data			-- The data of the connection
+ *  data_len		-- The length of the data in bytes
+ *  timestamp		-- The server's current timestamp
+ *
+ * returns a new challenge, NULL on failure
+ */
+SHA256OptChallenge *
+mint_challenge 		(const SHA256OptMinter *minter, const unsigned char *data,
+		unsigned int data_len, uint32_t timestamp);
+
+/* verify the solution of a challenge minted by a minter, see
+ * verify_solution_ex
+ *
+ * returns VERIFY_OK if verified, the reason of the rejection otherwise
+ */
+verify_status_t
+minter_verify 		(const SHA256OptMinter *minter,	/* The minter of the challenge */
+		SHA256OptSolution *sol,					/* The solution provided by the client */
+		unsigned char *data,					/* The data used for generating the hash */
+		unsigned int data_len,					/* The length of the data in bytes */
+		const SHA256OptVerifyParams *params		/* The timestamp policy, NULL for none */
+		);
+
+
 /* verify the solution of a given client's solution
  *
  * returns true if verified, false otherwise
@@ -52,6 +181,166 @@ verify_solution 	(SHA256OptSolution *sol,	/* The solution provided by the client
 		uint16_t m								/* The number of bits of difficulty */
 		);
 
+/* verify a client's solution in two stages. The first stage does not hash
+ * anything, it rejects empty, short and stale solutions and bad parameters,
+ * and replays if the params carry a replay cache. The second stage rebuilds
+ * x and stops at the first failing sub solution. Solutions that pass are
+ * remembered in the replay cache.
+ *
+ * returns VERIFY_OK if verified, the reason of the rejection otherwise
+ */
+verify_status_t
+verify_solution_ex 	(SHA256OptSolution *sol,	/* The solution provided by the client */
+		unsigned char *data,					/* The data used for generating the hash */
+		unsigned int data_len, 					/* The length of the data in bytes */
+		unsigned char *key,						/* The server's private key */
+		unsigned int key_len,					/* The length of the key in bytes */
+		uint16_t len,							/* The length of x + z_i in bytes */
+		uint16_t k,								/* The number of subpuzzles in the challenge */
+		uint16_t m,								/* The number of bits of difficulty */
+		const SHA256OptVerifyParams *params		/* The timestamp policy, NULL for none */
+		);
+
+/* verify a client's solution straight from the packet it came in, see
+ * puzzle/wire.h. The packet is validated where it lies and nothing is
+ * allocated or copied, the stages are those of verify_solution_ex.
+ *
+ * returns VERIFY_OK if verified, the reason of the rejection otherwise
+ */
+verify_status_t
+verify_solution_packet 	(const unsigned char *pkt,	/* The WIRE_OPT_SOLUTION packet */
+		size_t pkt_len,							/* The length of the packet in bytes */
+		const unsigned char *data,				/* The data used for generating the hash */
+		unsigned int data_len, 					/* The length of the data in bytes */
+		const unsigned char *key,				/* The server's private key */
+		unsigned int key_len,					/* The length of the key in bytes */
+		uint16_t len,							/* The length of x + z_i in bytes */
+		uint16_t k,								/* The number of subpuzzles in the challenge */
+		uint16_t m,								/* The number of bits of difficulty */
+		const SHA256OptVerifyParams *params		/* The timestamp policy, NULL for none */
+		);
+
+/* verify a packet holding the solution of a challenge minted by a minter,
+ * see verify_solution_packet
+ *
+ * returns VERIFY_OK if verified, the reason of the rejection otherwise
+ */
+verify_status_t
+minter_verify_packet 	(const SHA256OptMinter *minter,	/* The minter of the challenge */
+		const unsigned char *pkt,				/* The WIRE_OPT_SOLUTION packet */
+		size_t pkt_len,							/* The length of the packet in bytes */
+		const unsigned char *data,				/* The data used for generating the hash */
+		unsigned int data_len,					/* The length of the data in bytes */
+		const SHA256OptVerifyParams *params		/* The timestamp policy, NULL for none */
+		);
+
+/* verify a flat solution of a challenge minted by a minter, with the
+ * stages of verify_solution_ex. The values of z_i are read where they lie.
+ *
+ * returns VERIFY_OK if verified, the reason of the rejection otherwise
+ */
+verify_status_t
+minter_verify_flat 		(const SHA256OptMinter *minter,	/* The minter of the challenge */
+		const SHA256OptFlatSolution *sol,		/* The solution provided by the client */
+		const unsigned char *data,				/* The data used for generating the hash */
+		unsigned int data_len,					/* The length of the data in bytes */
+		const SHA256OptVerifyParams *params		/* The timestamp policy, NULL for none */
+		);
+
+/* get a printable name of a verification status
+ *
+ * returns a constant string
+ */
+const char *
+verify_status_name 	(verify_status_t status);
+
 
+/* verify a batch of client solutions at once. The key is absorbed once for
+ * the whole batch, the scratch space is shared, and the sub puzzle hashes
+ * of all the solutions are interleaved through the multi-buffer kernel.
+ * Solutions that fail the checks of verify_solution_ex's first stage are
+ * never hashed, the others stop at their first failing sub puzzle.
+ *
+ * returns the number of verified solutions, bit j of results is set if
+ * items[j] verified
+ */
+unsigned int
+verify_solutions_batch 	(SHA256OptVerifyItem *items,	/* The solutions and their connection data */
+		unsigned int n,							/* The number of items */
+		unsigned char *key,						/* The server's private key */
+		unsigned int key_len,					/* The length of the key in bytes */
+		uint16_t len,							/* The length of x + z_i in bytes */
+		uint16_t k,								/* The number of subpuzzles in the challenge */
+		uint16_t m,								/* The number of bits of difficulty */
+		uint64_t *results						/* A bitmap of (n+63)/64 words (return variable) */
+		);
+
+/* verify a batch of solutions to challenges minted by a minter, see
+ * verify_solutions_batch
+ *
+ * returns the number of verified solutions, bit j of results is set if
+ * items[j] verified
+ */
+unsigned int
+minter_verify_batch 	(const SHA256OptMinter *minter,	/* The minter of the challenges */
+		SHA256OptVerifyItem *items,				/* The solutions and their connection data */
+		unsigned int n,							/* The number of items */
+		uint64_t *results						/* A bitmap of (n+63)/64 words (return variable) */
+		);
+
+/* verify a batch of solutions to challenges minted by a minter with a
+ * timestamp policy and a replay cache, see verify_solution_ex. Solutions
+ * appearing twice in the same batch are accepted once.
+ *
+ * returns the number of verified solutions, bit j of results is set if
+ * items[j] verified
+ */
+unsigned int
+minter_verify_batch_ex 	(const SHA256OptMinter *minter,	/* The minter of the challenges */
+		SHA256OptVerifyItem *items,				/* The solutions and their connection data */
+		unsigned int n,							/* The number of items */
+		const SHA256OptVerifyParams *params,	/* The timestamp policy, NULL for none */
+		uint64_t *results						/* A bitmap of (n+63)/64 words (return variable) */
+		);
+
+
+/*-----------------------------------------------------------------------------
+ *  Batches of packets, nothing is allocated
+ *-----------------------------------------------------------------------------*/
+
+/* mint a batch of challenges straight into their WIRE_OPT_CHALLENGE
+ * packets, each the same as mint_challenge's for its data
+ *
+ * arguments are:
+ *
+ *  minter			-- The minter of the key
+ *  items			-- The connection data and the packet buffers, pkt_len
+ *  					is set to the length written, 0 if it did not fit
+ *  n				-- The number of items
+ *  timestamp		-- The server's current timestamp
+ *
+ * returns the number of challenges minted
+ */
+unsigned int
+minter_mint_packets 	(const SHA256OptMinter *minter, SHA256OptPacketItem *items,
+		unsigned int n, uint32_t timestamp);
+
+/* verify a batch of WIRE_OPT_SOLUTION packets where they lie. The stages
+ * are those of minter_verify_packet and the sub puzzle hashes of the
+ * packets are interleaved like minter_verify_batch_ex's.
+ *
+ * arguments are:
+ *
+ *  minter			-- The minter of the challenges
+ *  items			-- The packets and their connection data
+ *  n				-- The number of items
+ *  params			-- The timestamp policy and replay cache, NULL for none
+ *  statuses		-- The outcome of each item (return variable)
+ *
+ * returns the number of verified packets
+ */
+unsigned int
+minter_verify_packets 	(const SHA256OptMinter *minter, const SHA256OptPacketItem *items,
+		unsigned int n, const SHA256OptVerifyParams *params, verify_status_t *statuses);
 
 #endif /* optserver.h */
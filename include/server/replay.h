@@ -0,0 +1,154 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  replay.h
+ *
+ *    Description:  A bounded cache of verified solutions that rejects replays
+ *    				before any hashing, optionally shared between processes
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 10:04:37 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __REPLAY_H
+#define __REPLAY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "puzzle/optpuzzle.h"
+#include "puzzle/flatpuzzle.h"
+
+/* The outcome of remembering a solution */
+typedef enum {
+	REPLAY_FRESH = 0,		/* Never seen, it is remembered now */
+	REPLAY_SEEN,			/* Already remembered, or older than the cache remembers */
+	REPLAY_FULL				/* Never seen, but its bucket has no room left */
+} replay_status_t;
+
+/* A replay cache. The solutions are remembered by a 64 bit keyed SipHash
+ * fingerprint, in buckets of one cache line each. Every entry is tagged
+ * with the window of its timestamp (timestamp / window) and only the
+ * newest two windows are live, older entries are overwritten in place so
+ * the cache rotates without ever being cleared or locked. */
+typedef struct SHA256OptReplayCache SHA256OptReplayCache;
+
+/* create a replay cache
+ *
+ * arguments are:
+ *
+ *  max_bytes		-- The most memory the cache may use, header included
+ *  window			-- The length of a timestamp window, at least the
+ *  					max_age of the verifiers so that no accepted
+ *  					timestamp outlives its entries
+ *  shm_name		-- The POSIX shared memory object to create or attach
+ *  					to, NULL for a cache private to the process
+ *
+ * returns a new replay cache, NULL on failure. The processes sharing a
+ * cache must pass the same max_bytes and window.
+ */
+SHA256OptReplayCache *
+create_replay_cache 	(size_t max_bytes, uint32_t window, const char *shm_name);
+
+/* unmap a replay cache, a shared one stays around for the other processes
+ *
+ * arguments are:
+ *
+ *  cache			-- The cache to free
+ */
+void
+free_replay_cache 		(SHA256OptReplayCache *cache);
+
+/* remove a shared replay cache, the processes still attached keep it
+ * until they free it
+ *
+ * arguments are:
+ *
+ *  shm_name		-- The name of the shared memory object
+ *
+ * returns 0 on success, -1 otherwise
+ */
+int
+unlink_replay_cache 	(const char *shm_name);
+
+/* get the number of solutions a cache can hold
+ *
+ * arguments are:
+ *
+ *  cache			-- The cache
+ */
+size_t
+replay_cache_capacity 	(const SHA256OptReplayCache *cache);
+
+/* compute the fingerprint of (timestamp, data, solution)
+ *
+ * arguments are:
+ *
+ *  cache			-- The cache holding the SipHash key
+ *  sol				-- The solution, with at least k sub solutions
+ *  zlen			-- The length of each zi in bytes
+ *  k				-- The number of sub solutions
+ *  data			-- The data of the client's connection
+ *  data_len		-- The length of the data in bytes
+ *
+ * returns the fingerprint
+ */
+uint64_t
+replay_fingerprint 		(const SHA256OptReplayCache *cache,
+		const SHA256OptSolution *sol, unsigned int zlen, uint16_t k,
+		const unsigned char *data, unsigned int data_len);
+
+/* compute the fingerprint of a flat solution, the same as the one of the
+ * linked list solution with the same values
+ *
+ * arguments are:
+ *
+ *  cache			-- The cache holding the SipHash key
+ *  sol				-- The flat solution, all its sub solutions count
+ *  data			-- The data of the client's connection
+ *  data_len		-- The length of the data in bytes
+ *
+ * returns the fingerprint
+ */
+uint64_t
+replay_fingerprint 		(const SHA256OptReplayCache *cache,
+		const SHA256OptFlatSolution *sol,
+		const unsigned char *data, unsigned int data_len);
+
+/* check whether a solution was remembered, without remembering it
+ *
+ * arguments are:
+ *
+ *  cache			-- The cache
+ *  timestamp		-- The timestamp of the solution
+ *  fp				-- The fingerprint of the solution
+ *
+ * returns true if it is a replay, or too old for the cache to tell
+ */
+bool
+replay_seen 			(const SHA256OptReplayCache *cache, uint32_t timestamp,
+		uint64_t fp);
+
+/* remember a verified solution. Of many threads or processes remembering
+ * the same solution at once exactly one gets REPLAY_FRESH.
+ *
+ * arguments are:
+ *
+ *  cache			-- The cache
+ *  timestamp		-- The timestamp of the solution
+ *  fp				-- The fingerprint of the solution
+ *
+ * returns the outcome
+ */
+replay_status_t
+replay_remember 		(SHA256OptReplayCache *cache, uint32_t timestamp,
+		uint64_t fp);
+
+#endif /* replay.h */
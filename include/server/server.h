@@ -62,18 +62,46 @@ bool verify_solution 		(SHA256Solution *sol, 		/* the solution to verify */
 		uint8_t k		/* The number of subpuzzles */
 		);
 
+/* verify a solution straight from the packet it came in, see
+ * puzzle/wire.h. The packet is validated where it lies and nothing is
+ * allocated or copied.
+ *
+ * arguments are:
+ *
+ *  pkt				-- The WIRE_SOLUTION packet
+ *  pkt_len			-- The length of the packet in bytes
+ *  data			-- The data used to generate the puzzles
+ *  data_len		-- The length of the data in bytes
+ *  key				-- The server's private key
+ *  key_len			-- The length of the key in bytes
+ *  k				-- The number of subpuzzles (by the server)
+ *
+ * returns true if verified, false otherwise.
+ */
+bool verify_solution_packet 	(const unsigned char *pkt,	/* The received packet */
+		size_t pkt_len,				/* The length of the packet in bytes */
+		const unsigned char *data,	/* The data used to generate the puzzles */
+		unsigned int data_len,		/* The length of the data in bytes */
+		const unsigned char *key,	/* The server's key */
+		unsigned int key_len,		/* The length of the key in bytes */
+		uint8_t k					/* The number of subpuzzles */
+		);
+
 /*-----------------------------------------------------------------------------
  *  Utility functions needed to generate puzzles
  *-----------------------------------------------------------------------------*/
 
-/* scramble the bits of a buffer
+/* replace the first bits of a buffer with random ones from the generator
+ * of the calling thread, see puzzle/random.h. The bits run from the top
+ * of the first byte, the rest of the buffer is left alone.
  *
  * arguments are:
  *
  *  buf		-- The buffer to scramble
  *  bits	-- The number of bits to scramble
  *
- * returns the buffer with scrambled bits
+ * returns the buffer with scrambled bits, NULL if the generator could not
+ * be seeded
  */
 unsigned char *
 scramble_bits		(unsigned char *buf, unsigned int bits);
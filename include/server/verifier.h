@@ -0,0 +1,235 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  verifier.h
+ *
+ *    Description:  An asynchronous verification service, a pool of pinned workers
+ *    				fed by a bounded lock free queue of solution packets
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 09:05:41 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __VERIFIER_H
+#define __VERIFIER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "server/optserver.h"
+#include "server/replay.h"
+#include "server/keyring.h"
+
+/* The most requests a worker takes off the queue and verifies together */
+#ifndef VERIFIER_BATCH
+#define VERIFIER_BATCH 16
+#endif
+
+typedef struct PlutusVerifier PlutusVerifier;	/* A running verification service */
+typedef struct VerifierQueue VerifierQueue;		/* A queue of completed requests */
+typedef struct VerifyRequest VerifyRequest;
+
+/* Called on the worker that verified a request. It must not block for
+ * long, the worker's other requests wait.
+ *
+ * arguments are:
+ *
+ *  req				-- The completed request, its status is set
+ */
+typedef void (*verify_done_fn) (VerifyRequest *req);
+
+/* A solution to verify. The request and what it points to belong to the
+ * caller, and must stay put until the request completes. */
+struct VerifyRequest {
+	const unsigned char *pkt;	/* The WIRE_OPT_SOLUTION packet */
+	size_t pkt_len;				/* The length of the packet in bytes */
+	const unsigned char *data;	/* The data of the connection */
+	unsigned int data_len;		/* The length of the data in bytes */
+
+	VerifierQueue *cq;			/* Where the request completes, NULL to call done */
+	verify_done_fn done;		/* Called when the request completes without a cq */
+	void *user;					/* Left alone for the caller */
+
+	uint64_t deadline;			/* When the verdict stops mattering, on the
+								   admission_clock, 0 for the service's default */
+	unsigned int priority;		/* The ADMISSION_ level, higher goes first */
+
+	verify_status_t status;		/* The outcome (return variable) */
+};
+
+typedef struct VerifierConfig {
+	const SHA256OptMinter *minter;	/* The minter of the challenges, shared */
+	PlutusKeyring *keyring;			/* The keys by epoch in place of the minter,
+									   NULL to use the minter */
+	uint32_t max_age;				/* The largest accepted age, 0 for any */
+	SHA256OptReplayCache *replay;	/* The cache of accepted solutions, NULL for none */
+
+	unsigned int nthreads;			/* The workers, 0 for one per usable CPU */
+	unsigned int capacity;			/* The requests in flight at most, rounded up
+									   to a power of two */
+	int numa_node;					/* Keep the workers on the CPUs of this node, -1
+									   for the CPUs we are allowed to run on */
+	bool pin;						/* Pin every worker to a CPU of its own */
+
+	unsigned int admission;			/* The room of an admission queue ordering the
+									   requests by priority and deadline, see
+									   server/admission.h, 0 to take them in order */
+	uint32_t deadline_ms;			/* The deadline of a request that sets none */
+} VerifierConfig;
+
+/* The counters of a service */
+typedef struct VerifierStats {
+	uint64_t submitted;				/* Requests taken */
+	uint64_t refused;				/* Requests turned away on a full queue */
+	uint64_t shed;					/* Requests pushed out of the admission queue */
+	uint64_t expired;				/* Requests past their deadline when reached */
+	uint64_t completed;				/* Requests verified */
+	uint64_t verified;				/* Of those, the ones that came out VERIFY_OK */
+	uint64_t batches;				/* Batches the workers verified */
+	uint64_t depth;					/* Requests in flight right now */
+} VerifierStats;
+
+/* fill a configuration with the defaults, the minter or the keyring is left
+ * for the caller
+ *
+ * arguments are:
+ *
+ *  config			-- The configuration to fill
+ */
+void
+verifier_default_config 	(VerifierConfig *config);
+
+/* start the workers. The CPUs are those of config->numa_node, or the ones
+ * the calling thread may run on, and every worker allocates its own
+ * scratch space once it is placed so that it lies on its node.
+ *
+ * arguments are:
+ *
+ *  config			-- The configuration, copied. The minter or the keyring,
+ *  					and the replay cache must outlive the service
+ *
+ * returns the running service, NULL on failure
+ */
+PlutusVerifier *
+create_verifier 			(const VerifierConfig *config);
+
+/* verify what is still queued, stop the workers and free the service
+ *
+ * arguments are:
+ *
+ *  v				-- The service to free
+ */
+void
+free_verifier 				(PlutusVerifier *v);
+
+/* hand a request to the workers. Any thread may submit. In order, it
+ * never blocks and never allocates. With an admission queue it takes the
+ * queue's lock, and a full queue sheds its least urgent request, which
+ * completes with VERIFY_SHED on the submitting thread. A request still
+ * waiting at its deadline also completes with VERIFY_SHED.
+ *
+ * arguments are:
+ *
+ *  v				-- The service
+ *  req				-- The request, with either a cq or a done callback
+ *
+ * returns 0 if taken, -1 if the service has capacity requests in flight
+ * already, the request itself was shed or it is malformed
+ */
+int
+verifier_submit 			(PlutusVerifier *v, VerifyRequest *req);
+
+/* get the number of requests in flight, taken but not completed yet. The
+ * submitters use it to slow down before they are refused.
+ *
+ * arguments are:
+ *
+ *  v				-- The service
+ *
+ * returns the depth of the queue
+ */
+unsigned int
+verifier_depth 				(const PlutusVerifier *v);
+
+/* get the number of workers of a service
+ *
+ * arguments are:
+ *
+ *  v				-- The service
+ *
+ * returns the number of worker threads
+ */
+unsigned int
+verifier_size 				(const PlutusVerifier *v);
+
+/* read the counters of a service, any thread may call it at any time
+ *
+ * arguments are:
+ *
+ *  v				-- The service
+ *  stats			-- The counters (return variable)
+ */
+void
+verifier_stats 				(const PlutusVerifier *v, VerifierStats *stats);
+
+
+/*-----------------------------------------------------------------------------
+ *  Completion queues
+ *-----------------------------------------------------------------------------*/
+
+/* create a completion queue, usually one per event loop
+ *
+ * arguments are:
+ *
+ *  capacity		-- The requests its owner has in flight at most, rounded
+ *  					up to a power of two. A worker waits for room when
+ *  					the owner keeps more than that outstanding.
+ *
+ * returns the new queue, NULL on failure
+ */
+VerifierQueue *
+create_verifier_queue 		(unsigned int capacity);
+
+/* free a completion queue, no request may be on its way to it
+ *
+ * arguments are:
+ *
+ *  cq				-- The queue to free
+ */
+void
+free_verifier_queue 		(VerifierQueue *cq);
+
+/* get the eventfd of a completion queue. It is readable when completions
+ * are waiting, so it goes in the owner's epoll set.
+ *
+ * arguments are:
+ *
+ *  cq				-- The queue
+ *
+ * returns the non blocking descriptor, owned by the queue
+ */
+int
+verifier_queue_fd 			(const VerifierQueue *cq);
+
+/* take the completed requests off a queue without blocking. Only the owner
+ * of the queue polls it.
+ *
+ * arguments are:
+ *
+ *  cq				-- The queue
+ *  reqs			-- The completed requests (return variable)
+ *  max				-- The room in reqs
+ *
+ * returns the number of requests taken
+ */
+unsigned int
+verifier_queue_poll 		(VerifierQueue *cq, VerifyRequest **reqs, unsigned int max);
+
+#endif /* verifier.h */
@@ -19,6 +19,8 @@
 #include "client/client.h"
 #include "puzzle/factory.h"
 #include "puzzle/crypto_util.h"
+#include "puzzle/sha256_mb.h"
+#include "puzzle/metrics.h"
 
 #include <assert.h>
 #include <math.h>
@@ -29,6 +31,113 @@
 #define IMAGE_LEN 32
 #endif
 
+/* The widest difficulty the 64 bit candidate counter can enumerate */
+#define MAX_SOLVE_DIFFICULTY 63
+
+/* write candidate itr in the first diff bits of x, most significant bit
+ * first. The rest of x is left as it is, and nothing is allocated. */
+static void
+set_candidate (unsigned char *x, uint64_t itr, uint16_t diff)
+{
+    unsigned int full = diff / 8;
+    unsigned int rem  = diff % 8;
+
+    if (rem) { /* the low bits of itr end on the top of a partial byte */
+        x[full] = (x[full] & (0xFF >> rem)) | (unsigned char) (itr << (8 - rem));
+        itr >>= rem;
+    }
+
+    for (unsigned int b = full; b > 0; b--) {
+        x[b-1] = (unsigned char) itr;
+        itr >>= 8;
+    }
+}
+
+/* get the number of candidates for diff bits of difficulty, 0 if the
+ * counter cannot enumerate them */
+static uint64_t
+candidate_space (uint16_t diff)
+{
+    if (diff > MAX_SOLVE_DIFFICULTY || diff > 8 * IMAGE_LEN) {
+        printf ("[ERROR]: Cannot solve %u bits of difficulty!\n", diff);
+        return 0;
+    }
+
+    return (uint64_t) 0x01 << diff;
+}
+
+/* search the candidates [start, end) for the preimage of y. The candidates
+ * are hashed in batches with the multi-buffer kernel, and the winner is
+ * written in place in x.
+ *
+ * returns true if found, with the winning candidate in winner
+ */
+static bool
+search_subpuzzle (unsigned char *x, unsigned char *y, uint16_t diff,
+        uint64_t start, uint64_t end,
+        SolverJob *job, unsigned int sub, uint64_t *winner)
+{
+    unsigned char tails[SHA256_MB_MAX_LANES * IMAGE_LEN];
+    unsigned char digests[SHA256_MB_MAX_LANES * SHA256_DIGEST_LEN];
+
+    /* the candidates are whole messages, there is no shared prefix */
+    SHA256Midstate ms;
+    sha256_midstate_init (&ms, NULL, 0, IMAGE_LEN);
+
+    /* every lane starts from x, only the first diff bits change after */
+    for (unsigned int j = 0; j < SHA256_MB_MAX_LANES; j++)
+        memcpy (tails + j*IMAGE_LEN, x, IMAGE_LEN);
+
+    for (uint64_t base = start; base < end; base += SHA256_MB_MAX_LANES) { /* currenlty, iterate in order */
+        /* stop early if a sibling range already won */
+        if (solver_job_cancelled (job, sub))
+            return false;
+
+        unsigned int n = (end - base < SHA256_MB_MAX_LANES)?
+            end - base : SHA256_MB_MAX_LANES;
+
+        /* lay out a batch of candidates */
+        for (unsigned int j = 0; j < n; j++)
+            set_candidate (tails + j*IMAGE_LEN, base + j, diff);
+
+        /* compute the message digests of the whole batch */
+        sha256_mb_digest (&ms, tails, n, digests);
+        metrics_add (METRIC_HASHES, n);
+
+        for (unsigned int j = 0; j < n; j++) {
+            if (compare_digests (digests + j*SHA256_DIGEST_LEN, y, IMAGE_LEN) == 0) {
+                /* found the solution for this subpuzzle */
+                *winner = base + j;
+                set_candidate (x, *winner, diff);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/* append a copy of a solved preimage to the list of subsolutions */
+static SHA256SubSolution *
+append_subsolution (SHA256SubSolution *sol_head, unsigned char *x)
+{
+    /* copy correct preimage */
+    unsigned char *sol = (unsigned char *)
+        malloc (IMAGE_LEN * sizeof(unsigned char));
+    memcpy (sol, x, IMAGE_LEN);
+
+    SHA256SubSolution *sol_item = createSubSolution();
+    sol_item->solution = sol;
+    sol_item->next = NULL;
+
+    /* add it to the list of subsolutions */
+    if (sol_head == NULL) /* empty list */
+        return sol_item;
+
+    insert_subsolution (sol_head, sol_item);
+    return sol_head;
+}
+
 /* solvePuzzle */
 SHA256Solution *
 solvePuzzle (SHA256Challenge *challenge)
@@ -43,7 +152,10 @@ solvePuzzle (SHA256Challenge *challenge)
     uint32_t ts = challenge->timestamp;
     // uint8_t ns = challenge->num_subpuzzles;
     uint16_t diff = challenge->difficulty;
-    
+    uint64_t max_possible = candidate_space (diff);
+    if (max_possible == 0)
+        return NULL;
+
     SHA256SubPuzzle *head = challenge->puzzle;
     if (! head) { /* error checking */
         printf ("[ERROR}: Empty challenge!\n");
@@ -53,8 +165,7 @@ solvePuzzle (SHA256Challenge *challenge)
     /* create needed structures */
     SHA256SubSolution *sol_head = NULL;
 
-	timespec start, end;
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &start);
+    uint64_t start = metrics_now ();
     while (head) 
     { /* Iterate until reaching the tail */
 
@@ -62,82 +173,22 @@ solvePuzzle (SHA256Challenge *challenge)
         unsigned char *x = head->preimage;
         unsigned char *y = head->image;
 
-        unsigned int max_possible = 0x01 << diff;
-        unsigned int itr = 0;
-
-        while (itr < max_possible) { /* currenlty, iterate in order */
-            unsigned int mask_len;
-            unsigned char *mask = get_puzzle_mask (itr, diff, &mask_len);    
-
-            /* WARNING: THIS WILL OVERWRITE THE ORIGINAL PUZZLE */
-            x = clear_bits (x, diff);
-            if (mask_len == 1) {/* replace the left most byte */
-                x[0] = x[0] | mask[0];
-            } else {/* replace two left most bytes */
-                x[0] = mask[0];
-                x[1] = x[1] | mask[1];
-            }
-
-			/* somve verbose debugging */
-			// puts ("Now trying:");
-			// print_digest (x, IMAGE_LEN);
-
-            /* compute the message digest */
-            unsigned int digest_len;
-            unsigned char * digest = digest_message (x, IMAGE_LEN, &digest_len);
-
-            /* sanity checking */
-            assert (digest_len == IMAGE_LEN);
-
-            int n = compare_digests (digest, y, digest_len);
-            if (n == 0) {/* found the solution for this subpuzzle */
-                /* copy correct preimage */
-                unsigned char *sol = (unsigned char *)
-                    malloc (IMAGE_LEN * sizeof(unsigned char));
-                memcpy (sol, x, IMAGE_LEN);
-
-                /* add it to the list of subsolutions */
-                if (sol_head == NULL) { /* empty list */
-                    sol_head = createSubSolution();
-                    sol_head->solution = sol;
-                    sol_head->next = NULL;
-                } else { /* non-empty list */
-                    SHA256SubSolution *sol_item = createSubSolution();
-                    sol_item->solution = sol;
-                    sol_item->next = NULL;
-
-                    insert_subsolution (sol_head, sol_item);
-                }
-
-                /* free some stuff and break */
-                free (mask);
-                OPENSSL_free (digest);
-
-                break;
-            }
-
+        uint64_t itr;
 
-            /* increment counter */
-			// print_digest (digest, digest_len);
-            free (mask);
-            OPENSSL_free (digest);
-            itr++;
-        }
-
-		if (itr == max_possible) { /* couldn't find a solution */
+        if (! search_subpuzzle (x, y, diff, 0, max_possible, NULL, 0, &itr)) {
 			printf("[ERROR]: Could not find a solution!\n");
+			free_solution_list (sol_head);
 			return NULL;
 		}
-		printf ("[Log]: Obtained solution in %d trials.\n", (itr+1));
 
+        sol_head = append_subsolution (sol_head, x);
 
         /* Move through the list */
         head = head->next;
     }
 
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &end);
-	double difftime = time_diff (start, end);
-	printf ("Time needed to find solution is %lf seconds.\n", difftime);
+    metrics_add (METRIC_SOLUTIONS_FOUND, 1);
+    metrics_observe (METRIC_LAT_SOLVE_NAIVE, start);
 
 	/* some sanity checking */
 	assert (sol_head != NULL);
@@ -151,6 +202,210 @@ solvePuzzle (SHA256Challenge *challenge)
     return chall_sol;
 }
 
+/* The sub puzzles of a challenge being solved on a pool */
+typedef struct {
+    SHA256SubPuzzle **subs;     /* The sub puzzles in list order */
+    uint16_t diff;              /* The bits of difficulty */
+} parallel_arg_t;
+
+/* search a range of candidates of one sub puzzle on a pool worker */
+static bool
+search_parallel_task (SolverJob *job, unsigned int sub,
+        uint64_t start, uint64_t end, uint64_t *winner)
+{
+    parallel_arg_t *arg = (parallel_arg_t *) solver_job_arg (job);
+
+    /* work on a private copy of the preimage */
+    unsigned char x[IMAGE_LEN];
+    memcpy (x, arg->subs[sub]->preimage, IMAGE_LEN);
+
+    return search_subpuzzle (x, arg->subs[sub]->image, arg->diff,
+            start, end, job, sub, winner);
+}
+
+/* solvePuzzleParallel */
+SHA256Solution *
+solvePuzzleParallel (SHA256Challenge *challenge, SolverPool *pool)
+{
+    /* Error checking */
+    if (! challenge || ! pool) {
+        printf ("[ERROR]: Cannot find challenge to solve!\n");
+        return NULL;
+    }
+
+    uint16_t diff = challenge->difficulty;
+    uint64_t space = candidate_space (diff);
+    if (space == 0)
+        return NULL;
+
+    /* lay out the sub puzzles so the workers can index them */
+    unsigned int ns = 0;
+    for (SHA256SubPuzzle *it = challenge->puzzle; it; it = it->next)
+        ns++;
+
+    if (ns == 0) { /* error checking */
+        printf ("[ERROR}: Empty challenge!\n");
+        return NULL;
+    }
+
+    parallel_arg_t arg;
+    arg.subs = (SHA256SubPuzzle **) malloc (ns * sizeof (SHA256SubPuzzle *));
+    arg.diff = diff;
+
+    unsigned int i = 0;
+    for (SHA256SubPuzzle *it = challenge->puzzle; it; it = it->next)
+        arg.subs[i++] = it;
+
+    uint64_t *winners = (uint64_t *) malloc (ns * sizeof (uint64_t));
+
+    uint64_t start = metrics_now ();
+
+    unsigned int solved = solver_pool_run (pool, ns, space,
+            search_parallel_task, &arg, winners);
+
+    SHA256SubSolution *sol_head = NULL;
+    if (solved == ns) {
+        /* rebuild the winning preimages in list order */
+        for (i = 0; i < ns; i++) {
+            unsigned char x[IMAGE_LEN];
+            memcpy (x, arg.subs[i]->preimage, IMAGE_LEN);
+            set_candidate (x, winners[i], diff);
+
+            sol_head = append_subsolution (sol_head, x);
+        }
+
+        metrics_add (METRIC_SOLUTIONS_FOUND, 1);
+        metrics_observe (METRIC_LAT_SOLVE_NAIVE, start);
+    } else {
+        printf("[ERROR]: Could not find a solution!\n");
+    }
+
+    free (winners);
+    free (arg.subs);
+
+    if (! sol_head)
+        return NULL;
+
+    /* done. create a challenge solution and return it */
+    SHA256Solution *chall_sol = createSolution();
+    chall_sol->timestamp = challenge->timestamp;
+    chall_sol->solution  = sol_head;
+
+    return chall_sol;
+}
+
+
+/* The sub puzzles of a challenge being solved a step at a time */
+typedef struct {
+    unsigned char *x;           /* A copy of the preimages, back to back */
+    unsigned char *y;           /* A copy of the images, back to back */
+    uint16_t diff;              /* The bits of difficulty */
+    uint32_t timestamp;         /* The timestamp of the challenge */
+} step_arg_t;
+
+/* free the copy of a challenge held by a step solver */
+static void
+free_step_arg (void *varg)
+{
+    step_arg_t *arg = (step_arg_t *) varg;
+
+    free (arg->x);
+    free (arg->y);
+    free (arg);
+}
+
+/* search a slice of candidates of one sub puzzle. The winner is written
+ * in place in the copy of its preimage. */
+static bool
+search_step_task (void *varg, unsigned int sub,
+        uint64_t start, uint64_t end, uint64_t *winner)
+{
+    step_arg_t *arg = (step_arg_t *) varg;
+
+    return search_subpuzzle (arg->x + sub*IMAGE_LEN, arg->y + sub*IMAGE_LEN,
+            arg->diff, start, end, NULL, sub, winner);
+}
+
+/* solvePuzzleStart */
+StepSolver *
+solvePuzzleStart (const SHA256Challenge *challenge, uint32_t timeout_ms)
+{
+    /* Error checking */
+    if (! challenge) {
+        printf ("[ERROR]: Cannot find challenge to solve!\n");
+        return NULL;
+    }
+
+    uint64_t space = candidate_space (challenge->difficulty);
+    if (space == 0)
+        return NULL;
+
+    unsigned int ns = 0;
+    for (SHA256SubPuzzle *it = challenge->puzzle; it; it = it->next)
+        ns++;
+
+    if (ns == 0) { /* error checking */
+        printf ("[ERROR}: Empty challenge!\n");
+        return NULL;
+    }
+
+    /* copy the sub puzzles, the challenge may go away while stepping */
+    step_arg_t *arg = (step_arg_t *) malloc (sizeof (step_arg_t));
+    arg->x = (unsigned char *) malloc (ns * IMAGE_LEN);
+    arg->y = (unsigned char *) malloc (ns * IMAGE_LEN);
+    arg->diff = challenge->difficulty;
+    arg->timestamp = challenge->timestamp;
+
+    unsigned int i = 0;
+    for (SHA256SubPuzzle *it = challenge->puzzle; it; it = it->next, i++) {
+        memcpy (arg->x + i*IMAGE_LEN, it->preimage, IMAGE_LEN);
+        memcpy (arg->y + i*IMAGE_LEN, it->image, IMAGE_LEN);
+    }
+
+    /* the one preimage lies anywhere in the space, half of it on average */
+    StepSolver *solver = create_step_solver (ns, space, (space > 1)? space / 2 : 1,
+            search_step_task, arg, free_step_arg, timeout_ms);
+    if (! solver)
+        free_step_arg (arg);
+
+    return solver;
+}
+
+/* solvePuzzleFinish */
+SHA256Solution *
+solvePuzzleFinish (StepSolver *solver)
+{
+    if (! solver)
+        return NULL;
+
+    step_arg_t *arg = (step_arg_t *) step_solver_arg (solver);
+
+    SHA256SubSolution *sol_head = NULL;
+    if (step_solver_winners (solver)) {
+        /* every winner is already in place in its preimage */
+        StepProgress progress;
+        step_solver_progress (solver, &progress);
+
+        for (unsigned int i = 0; i < progress.total; i++)
+            sol_head = append_subsolution (sol_head, arg->x + i*IMAGE_LEN);
+
+        metrics_add (METRIC_SOLUTIONS_FOUND, 1);
+    }
+
+    uint32_t ts = arg->timestamp;
+    free_step_solver (solver);
+
+    if (! sol_head)
+        return NULL;
+
+    /* done. create a challenge solution and return it */
+    SHA256Solution *chall_sol = createSolution();
+    chall_sol->timestamp = ts;
+    chall_sol->solution  = sol_head;
+
+    return chall_sol;
+}
+
 
 /*-----------------------------------------------------------------------------
  *  Utility functions
@@ -158,35 +413,21 @@ solvePuzzle (SHA256Challenge *challenge)
 
 /* get_puzzle_mask */
 unsigned char *
-get_puzzle_mask (unsigned int itr, 
+get_puzzle_mask (uint64_t itr,
         unsigned int diff, unsigned int *mask_len)
 {
-    /* currently not supporting more than 16 bits of difficulty */
-    assert (diff <= 16);
+    if (diff > 64)
+        return NULL; /* more than the iteration number holds */
 
-    /* get how many bytes do we need */
-    // if less than 8 bits of difficulty then need 1 byte,
-    // else we need 2 bytes
-    size_t byte_len = (diff <= 8)? 1:2;
+    /* one byte per started 8 bits of difficulty */
+    size_t byte_len = (diff + 7) / 8;
 
     /* allocate the return byte array */
     unsigned char * mask = (unsigned char *)
-        calloc (byte_len,  sizeof (unsigned char));
-
-
-    if (byte_len == 1) { /* only one byte mask */
-        /* align msb of itr with the start of the mask (to the byte) */
-        itr = itr << (8 - diff);
+        calloc ((byte_len > 0)? byte_len : 1,  sizeof (unsigned char));
 
-        /* extract least byte of itr */
-        mask[0] = 0xFF & itr;
-    } else {/* two byte mask */
-        /* align msb of itr with the start of the mask (to the byte) */
-        itr = itr << (16-diff);
-
-        mask[1] = 0xFF & itr;
-        mask[0] = 0xFF & (itr >> 8);
-    }
+    /* align msb of itr with the start of the mask (to the byte) */
+    set_candidate (mask, itr, diff);
 
     /* return the required things */
     *mask_len = byte_len;
@@ -197,17 +438,12 @@ get_puzzle_mask (unsigned int itr,
 unsigned char *
 clear_bits (unsigned char *msg, uint8_t len)
 {
-    /* currently not supporting more than 16 bits of difficulty */
-    assert (len <= 16);
-
-    if (len <= 8) {/* clear left most len bits */
-        // kill off len leading bits
-        msg[0] = msg[0] & (0xFF >> len);
-    } else {/* clean left most 8 + (len - 8) bits */
-        msg[0] = 0;
-        // kill of (len-8) leading bits of msg[1]
-        msg[1] = msg[1] & (0xFF >> (len-8));
-    }
+	/* kill off the whole leading bytes */
+	memset (msg, 0, len / 8);
+
+	/* and the leading bits of the next one */
+	if (len % 8)
+		msg[len / 8] = msg[len / 8] & (0xFF >> (len % 8));
 
 	return msg;
 }
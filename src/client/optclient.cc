@@ -20,110 +20,449 @@
 #include "client/optclient.h"
 #include "puzzle/factory.h"
 #include "puzzle/crypto_util.h"
+#include "puzzle/sha256.h"
+#include "puzzle/sha256_mb.h"
+#include "puzzle/metrics.h"
 
 #include <assert.h>
 #include <time.h>
 #include <string.h>
 
+/* prepare the midstate of sub puzzle i
+ *
+ * The prefix x || i is the same for every candidate zi of a sub puzzle, so
+ * it is absorbed once here and zi becomes the variable tail of the midstate.
+ *
+ * returns 0 on success, -1 if the challenge is too large for a midstate
+ */
+static int
+prepare_subpuzzle (SHA256Midstate *ms, const unsigned char *x,
+		uint16_t len, uint16_t i)
+{
+	/* absorb the substring x || i */
+	SHA256Ctx ctx;
+	sha256_init (&ctx);
+	sha256_update (&ctx, x, len);
+	sha256_update (&ctx, (unsigned char *)(&i), sizeof (uint16_t));
+
+	return sha256_midstate_from_ctx (ms, &ctx, len);
+} /* prepare_subpuzzle */
+
+/* get the bytes at the end of zi taken by the candidate counter */
+static inline unsigned int
+counter_len (uint16_t len)
+{
+	return (len < sizeof (uint64_t))? len : sizeof (uint64_t);
+} /* counter_len */
+
+/* get the number of candidates zi that can be tried per sub puzzle. A zi
+ * of 8 bytes or more holds the whole counter, which never runs out. */
+static inline uint64_t
+candidate_space (uint16_t len)
+{
+	return (len < sizeof (uint64_t))? (uint64_t) 0x01 << (8 * len) : UINT64_MAX;
+} /* candidate_space */
+
+/* write candidate itr as zi = 0 ... 0 || itr, big endian. Only the counter
+ * bytes are written, the leading zeros are laid out once by the caller. */
+static inline void
+set_candidate (unsigned char *zi, uint16_t len, uint64_t itr)
+{
+	for (unsigned int b = len; b > len - counter_len (len); b--)
+	{
+		zi[b-1] = (unsigned char) itr;
+		itr >>= 8;
+	}
+} /* set_candidate */
+
+/* search the candidates [start, end) for a zi such that the first m bits of
+ * h(x || i || zi) match the first m bits of x. The candidates are hashed in
+ * batches with the multi-buffer kernel, so nothing is allocated while
+ * searching.
+ *
+ * returns true if found, with the winning candidate in winner and left in
+ * the tail of the midstate
+ */
+static bool
+search_subpuzzle (SHA256Midstate *ms, const unsigned char *x,
+		uint16_t len, uint16_t m, uint64_t start, uint64_t end,
+		SolverJob *job, unsigned int sub, uint64_t *winner)
+{
+	unsigned char tails[SHA256_MB_MAX_LANES * SHA256_MIDSTATE_MAX_BLOCKS * SHA256_BLOCK_LEN];
+	unsigned char digests[SHA256_MB_MAX_LANES * SHA256_DIGEST_LEN];
+
+	/* the lanes are reused for every batch, only their counters change */
+	memset (tails, 0, SHA256_MB_MAX_LANES * len);
+
+	for (uint64_t base = start; base < end; base += SHA256_MB_MAX_LANES)
+	{ /* keep iterating until you find something */
+		/* stop early if a sibling range already won */
+		if (solver_job_cancelled (job, sub))
+			return false;
+
+		unsigned int n = (end - base < SHA256_MB_MAX_LANES)?
+			end - base : SHA256_MB_MAX_LANES;
+
+		/* lay out a batch of zi's */
+		for (unsigned int j = 0; j < n; j++)
+			set_candidate (tails + j*len, len, base + j);
+
+		/* finish h(x || i || zi) of the whole batch from the absorbed prefix */
+		sha256_mb_digest (ms, tails, n, digests);
+		metrics_add (METRIC_HASHES, n);
+
+		for (unsigned int j = 0; j < n; j++)
+		{ /* compare the first m bits, in candidate order */
+			if (compare_bits (x, digests + j*SHA256_DIGEST_LEN, m))
+			{
+				*winner = base + j;
+				memcpy (sha256_midstate_tail (ms), tails + j*len, len);
+				return true;
+			}
+		}
+	}
+
+	return false;
+} /* search_subpuzzle */
+
+/* check that the parameters of a challenge can be solved
+ *
+ * returns the length of x in bytes, 0 if the challenge is malformed
+ */
+static uint16_t
+check_challenge (const SHA256OptChallenge *challenge)
+{
+	if (!challenge)
+	{
+		printf ("[ERROR]: Cannot find challenge to solve!\n");
+		return 0;
+	}
+
+	/* quick error checking */
+	if (!challenge->preimage)
+	{
+		printf ("[ERROR]: Empty challenge to solve. Nothing to do!\n");
+		return 0;
+	}
+
+	/* the difficult bits are taken from x, and zi holds the low bytes of
+	 * the iteration counter */
+	uint16_t len = challenge->len/2;
+	if (challenge->difficulty > 8*len || len == 0)
+	{
+		printf ("[ERROR]: Malformed challenge parameters!\n");
+		return 0;
+	}
+
+	return len;
+} /* check_challenge */
+
+/* build a solution out of its sub solution list */
+static SHA256OptSolution *
+build_solution (uint32_t timestamp, SHA256OptSubSolution *head)
+{
+	SHA256OptSolution *sol = create_optsolution();
+	initOptSolution (sol, timestamp, head);
+
+	return sol;
+} /* build_solution */
+
+/* append a copy of zi to the list of sub solutions */
+static SHA256OptSubSolution *
+append_subsolution (SHA256OptSubSolution *head, unsigned char *zi,
+		uint16_t len)
+{
+	/* create a subsolution */
+	SHA256OptSubSolution *sub = create_optsubsolution();
+
+	/* copy the solution to save it */
+	unsigned char * zic = (unsigned char *) malloc (len);
+	memcpy (zic, zi, len);
+	initOptSubSolution (sub, zic, NULL);
+
+	/* insert the sub solution into the list */
+	return insert_subsolution (head, sub);
+} /* append_subsolution */
+
 /* solveChallenge */
 SHA256OptSolution *
 solveChallenge (SHA256OptChallenge *challenge)
 {	
-	if (!challenge) 
-	{
-		printf ("[ERROR]: Cannot find challenge to solve!\n");
+	uint16_t len = check_challenge (challenge);
+	if (len == 0)
 		return NULL;
-	}
 
 	/* get the puzzle information */
 	uint32_t timestamp = challenge->timestamp;
-	uint16_t l = challenge->len;
 	uint16_t k = challenge->num_subpuzzles;
 	uint16_t m = challenge->difficulty;
 
-	uint16_t len = l/2;
-
 	unsigned char *preimage = challenge->preimage;
 
-	/* quick error checking */
-	if  (!preimage)
-	{
-		printf ("[ERROR]: Empty challenge to solve. Nothing to do!\n");
-		return NULL;
-	}
-
 	SHA256OptSubSolution *head = NULL;
 
 	/* get starting time */
-	timespec start, end;
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &start);
+	uint64_t start = metrics_now ();
 
 	for (uint16_t i = 0; i < k; i++)
 	{ /* iteratore over all the subpuzzles */
-		/* allocated a buffer big enough to hold what we need to concatenate */
-		unsigned int buf_len = l + sizeof (uint16_t);
-		unsigned char *buf = (unsigned char *)
-			malloc (buf_len * sizeof (unsigned char));
+		SHA256Midstate ms;
+		uint64_t itr;
 
-		/* create the substring x || i */
-		unsigned char *cbuf = append_buffer (buf, preimage, len);
-		cbuf = append_buffer (cbuf, (unsigned char *)(&i), sizeof (uint16_t));
+		if (prepare_subpuzzle (&ms, preimage, len, i) != 0)
+		{
+			printf ("[ERROR]: Challenge is too large to solve!\n");
+			free_solution_mem (build_solution (timestamp, head));
+			return NULL;
+		}
 
 		/* start trying the z's */
-		bool found = false;
-		uint16_t itr = 0;
-		while (!found)
-		{ /* keep iterating until you find something */
-			unsigned char *zi = (unsigned char*) calloc (len, sizeof(unsigned char));
-			memcpy (zi + len - sizeof(uint16_t), 
-					(unsigned char *)&itr, sizeof(uint16_t));
-
-			/* form x || i || zi */
-			append_buffer (cbuf, zi, len);
-
-			/* get the hash of the full buffer */
-			unsigned int dlen;
-			unsigned char *digest = 
-				digest_message (buf, buf_len, &dlen);
-
-			/* compare the first m bits */
-			found = compare_bits (buf, digest, m);
-			itr++;
-
-			/* check if found and create a sub solution */
-			if (found)
-			{
-				/* create a subsolution */
-				SHA256OptSubSolution *sub = create_optsubsolution();
+		if (!search_subpuzzle (&ms, preimage, len, m,
+					0, candidate_space (len), NULL, 0, &itr))
+		{
+			printf ("[ERROR]: Could not find a solution!\n");
+			free_solution_mem (build_solution (timestamp, head));
+			return NULL;
+		}
 
-				/* copy the solution to save it */
-				unsigned char * zic = (unsigned char *) malloc (len);
-				memcpy (zic, zi, len);
-				initOptSubSolution (sub, zic, NULL);
+		head = append_subsolution (head, sha256_midstate_tail (&ms), len);
+	}
 
-				/* insert the sub solution into the list */
-				head = insert_subsolution (head, sub);
-			}
+	metrics_add (METRIC_SOLUTIONS_FOUND, 1);
+	metrics_observe (METRIC_LAT_SOLVE_OPT, start);
+
+	return build_solution (timestamp, head);
+
+} /* solveChallenge */
+
+/* solveChallengeFlat */
+int
+solveChallengeFlat (const SHA256OptChallenge *challenge, SHA256OptFlatSolution *sol)
+{
+	uint16_t len = check_challenge (challenge);
+	if (len == 0 || !sol || !sol->zi)
+		return -1;
 
-			/* free the digest */
-			free (zi);
-			OPENSSL_free (digest);
+	uint16_t k = challenge->num_subpuzzles;
+	uint64_t start = metrics_now ();
+
+	for (uint16_t i = 0; i < k; i++)
+	{ /* the winner of each sub puzzle lands in its slot */
+		SHA256Midstate ms;
+		uint64_t itr;
+
+		if (prepare_subpuzzle (&ms, challenge->preimage, len, i) != 0
+				|| !search_subpuzzle (&ms, challenge->preimage, len,
+					challenge->difficulty, 0, candidate_space (len), NULL, 0, &itr))
+		{
+			printf ("[ERROR]: Could not find a solution!\n");
+			return -1;
 		}
 
-		/* just print how many iterations it took */
-		printf ( "[Log]: Found solution in %d iterations.\n", (itr-1) );
+		memcpy (sol->zi + i*len, sha256_midstate_tail (&ms), len);
+	}
+
+	sol->timestamp = challenge->timestamp;
+	sol->num_subsolutions = k;
+	sol->zlen = len;
+
+	metrics_add (METRIC_SOLUTIONS_FOUND, 1);
+	metrics_observe (METRIC_LAT_SOLVE_OPT, start);
+
+	return 0;
+} /* solveChallengeFlat */
+
+/* The sub puzzles of a challenge being solved on a pool */
+typedef struct {
+	SHA256Midstate *ms;		/* The prepared midstate of each sub puzzle */
+	unsigned char *x;		/* The preimage x of the challenge */
+	uint16_t len;			/* The length of x in bytes */
+	uint16_t m;				/* The number of bits of difficulty */
+} parallel_arg_t;
 
-		/* free the allocated buffer */
-		free (buf);
+/* search a range of candidates of one sub puzzle on a pool worker */
+static bool
+search_parallel_task (SolverJob *job, unsigned int sub,
+		uint64_t start, uint64_t end, uint64_t *winner)
+{
+	parallel_arg_t *arg = (parallel_arg_t *) solver_job_arg (job);
+
+	/* work on a private copy, the winner is written in its tail */
+	SHA256Midstate ms = arg->ms[sub];
+
+	return search_subpuzzle (&ms, arg->x, arg->len, arg->m,
+			start, end, job, sub, winner);
+} /* search_parallel_task */
+
+/* solveChallengeParallel */
+SHA256OptSolution *
+solveChallengeParallel (SHA256OptChallenge *challenge, SolverPool *pool)
+{
+	uint16_t len = check_challenge (challenge);
+	if (len == 0 || !pool)
+		return NULL;
+
+	uint32_t timestamp = challenge->timestamp;
+	uint16_t k = challenge->num_subpuzzles;
+
+	if (k == 0)
+		return build_solution (timestamp, NULL); /* nothing to solve */
+
+	parallel_arg_t arg;
+	arg.ms  = (SHA256Midstate *) malloc (k * sizeof (SHA256Midstate));
+	arg.x   = challenge->preimage;
+	arg.len = len;
+	arg.m   = challenge->difficulty;
+
+	/* absorb every x || i up front, the workers only copy them */
+	for (uint16_t i = 0; i < k; i++)
+	{
+		if (prepare_subpuzzle (&arg.ms[i], arg.x, len, i) != 0)
+		{
+			printf ("[ERROR]: Challenge is too large to solve!\n");
+			free (arg.ms);
+			return NULL;
+		}
 	}
 
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &end);
-	double difftime = time_diff (start, end);
-	printf ( "[Log]: Time need to find solution if %lf seconds.\n", difftime);
+	uint64_t *winners = (uint64_t *) malloc (k * sizeof (uint64_t));
 
-	SHA256OptSolution *sol = create_optsolution();
-	initOptSolution (sol, timestamp, head);
+	uint64_t start = metrics_now ();
+
+	unsigned int solved = solver_pool_run (pool, k, candidate_space (len),
+			search_parallel_task, &arg, winners);
+
+	SHA256OptSolution *sol = NULL;
+	if (solved == k)
+	{ /* rebuild the winning zi's in order */
+		SHA256OptSubSolution *head = NULL;
+		unsigned char *zi = (unsigned char *) calloc (len, sizeof (unsigned char));
+
+		for (uint16_t i = 0; i < k; i++)
+		{
+			set_candidate (zi, len, winners[i]);
+			head = append_subsolution (head, zi, len);
+		}
+		free (zi);
+
+		metrics_add (METRIC_SOLUTIONS_FOUND, 1);
+		metrics_observe (METRIC_LAT_SOLVE_OPT, start);
+
+		sol = build_solution (timestamp, head);
+	} else
+	{
+		printf ("[ERROR]: Could not find a solution!\n");
+	}
+
+	free (winners);
+	free (arg.ms);
 
 	return sol;
+} /* solveChallengeParallel */
 
-} /* solveChallenge */
+/* The sub puzzles of a challenge being solved a step at a time */
+typedef struct {
+	SHA256Midstate *ms;		/* The prepared midstate of each sub puzzle */
+	unsigned char *x;		/* A copy of the preimage x of the challenge */
+	uint16_t len;			/* The length of x in bytes */
+	uint16_t m;				/* The number of bits of difficulty */
+	uint32_t timestamp;		/* The timestamp of the challenge */
+} step_arg_t;
+
+/* free the copy of a challenge held by a step solver */
+static void
+free_step_arg (void *varg)
+{
+	step_arg_t *arg = (step_arg_t *) varg;
+
+	free (arg->ms);
+	free (arg->x);
+	free (arg);
+} /* free_step_arg */
+
+/* search a slice of candidates of one sub puzzle. Each midstate is only
+ * searched until it wins, so the winner may land in its tail. */
+static bool
+search_step_task (void *varg, unsigned int sub,
+		uint64_t start, uint64_t end, uint64_t *winner)
+{
+	step_arg_t *arg = (step_arg_t *) varg;
+
+	return search_subpuzzle (&arg->ms[sub], arg->x, arg->len, arg->m,
+			start, end, NULL, sub, winner);
+} /* search_step_task */
+
+/* solveChallengeStart */
+StepSolver *
+solveChallengeStart (const SHA256OptChallenge *challenge, uint32_t timeout_ms)
+{
+	uint16_t len = check_challenge (challenge);
+	if (len == 0)
+		return NULL;
+
+	uint16_t k = challenge->num_subpuzzles;
+
+	step_arg_t *arg = (step_arg_t *) malloc (sizeof (step_arg_t));
+	arg->ms  = (SHA256Midstate *) malloc ((k ? k : 1) * sizeof (SHA256Midstate));
+	arg->x   = (unsigned char *) malloc (len);
+	arg->len = len;
+	arg->m   = challenge->difficulty;
+	arg->timestamp = challenge->timestamp;
+	memcpy (arg->x, challenge->preimage, len);
+
+	/* absorb every x || i up front, the steps only hash candidates */
+	for (uint16_t i = 0; i < k; i++)
+	{
+		if (prepare_subpuzzle (&arg->ms[i], arg->x, len, i) != 0)
+		{
+			printf ("[ERROR]: Challenge is too large to solve!\n");
+			free_step_arg (arg);
+			return NULL;
+		}
+	}
+
+	/* every candidate wins with probability 2^-m */
+	uint64_t expected = (arg->m < 64)? (uint64_t) 0x01 << arg->m : UINT64_MAX;
+
+	StepSolver *solver = create_step_solver (k, candidate_space (len), expected,
+			search_step_task, arg, free_step_arg, timeout_ms);
+	if (!solver)
+		free_step_arg (arg);
+
+	return solver;
+} /* solveChallengeStart */
+
+/* solveChallengeFinish */
+SHA256OptSolution *
+solveChallengeFinish (StepSolver *solver)
+{
+	if (!solver)
+		return NULL;
+
+	const uint64_t *winners = step_solver_winners (solver);
+	step_arg_t *arg = (step_arg_t *) step_solver_arg (solver);
+
+	SHA256OptSolution *sol = NULL;
+	if (winners)
+	{ /* rebuild the winning zi's in order */
+		StepProgress progress;
+		step_solver_progress (solver, &progress);
+
+		SHA256OptSubSolution *head = NULL;
+		unsigned char *zi = (unsigned char *) calloc (arg->len, sizeof (unsigned char));
+
+		for (unsigned int i = 0; i < progress.total; i++)
+		{
+			set_candidate (zi, arg->len, winners[i]);
+			head = append_subsolution (head, zi, arg->len);
+		}
+		free (zi);
+
+		metrics_add (METRIC_SOLUTIONS_FOUND, 1);
+		sol = build_solution (arg->timestamp, head);
+	}
+
+	free_step_solver (solver);
+
+	return sol;
+} /* solveChallengeFinish */
@@ -0,0 +1,315 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  solver_pool.cc
+ *
+ *    Description:  Implementation of the work stealing solver pool
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:20:48 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "client/solver_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* A range of candidates of one sub puzzle */
+typedef struct SolverTask {
+	unsigned int sub;	/* The index of the sub puzzle */
+	uint64_t start;		/* The first candidate in the range */
+	uint64_t end;		/* One past the last candidate in the range */
+} SolverTask;
+
+/* A worker with its own deque of tasks. The owner works from the back
+ * and thieves steal from the front. */
+typedef struct SolverWorker {
+	std::mutex lock;
+	std::deque<SolverTask> tasks;
+	std::thread thread;
+} SolverWorker;
+
+struct SolverJob {
+	solver_search_fn search;			/* The search routine */
+	void *arg;							/* The argument of the search routine */
+	unsigned int num_subs;				/* The number of sub puzzles */
+	uint64_t *winners;					/* The winner of each sub puzzle */
+	std::atomic<int> *found;			/* Whether each sub puzzle is solved */
+	std::atomic<long> outstanding;		/* The number of tasks not done yet */
+};
+
+struct SolverPool {
+	std::vector<SolverWorker *> workers;
+	uint64_t chunk;						/* The candidates searched per task */
+
+	std::mutex run_lock;				/* Serializes the jobs on the pool */
+
+	std::mutex lock;					/* Protects the fields below */
+	std::condition_variable wake;		/* Signals a new job or shutdown */
+	std::condition_variable done;		/* Signals the end of a job */
+	SolverJob *job;						/* The running job, if any */
+	unsigned long generation;			/* Bumped for every new job */
+	unsigned int active;				/* The workers inside the job */
+	bool shutdown;
+};
+
+/* mark a task as done and wake up the caller on the last one */
+static void
+finish_task (SolverPool *pool, SolverJob *job)
+{
+	if (job->outstanding.fetch_sub (1) == 1)
+	{
+		std::lock_guard<std::mutex> guard (pool->lock);
+		pool->done.notify_all ();
+	}
+} /* finish_task */
+
+/* take a task from the back of our own deque */
+static bool
+pop_task (SolverWorker *self, SolverTask *task)
+{
+	std::lock_guard<std::mutex> guard (self->lock);
+	if (self->tasks.empty ())
+		return false;
+
+	*task = self->tasks.back ();
+	self->tasks.pop_back ();
+	return true;
+} /* pop_task */
+
+/* steal a task from the front of another worker's deque. Large ranges are
+ * split in half so the victim keeps working on the lower part. */
+static bool
+steal_task (SolverPool *pool, SolverJob *job, unsigned int self, SolverTask *task)
+{
+	unsigned int n = pool->workers.size ();
+
+	for (unsigned int off = 1; off < n; off++)
+	{ /* go around the other workers */
+		SolverWorker *victim = pool->workers[(self + off) % n];
+		std::lock_guard<std::mutex> guard (victim->lock);
+		if (victim->tasks.empty ())
+			continue;
+
+		SolverTask *front = &victim->tasks.front ();
+		if (front->end - front->start > 2 * pool->chunk)
+		{ /* split, the victim keeps [start, mid) */
+			uint64_t mid = front->start + (front->end - front->start) / 2;
+			task->sub   = front->sub;
+			task->start = mid;
+			task->end   = front->end;
+			front->end  = mid;
+			job->outstanding.fetch_add (1);
+		} else
+		{
+			*task = *front;
+			victim->tasks.pop_front ();
+		}
+		return true;
+	}
+
+	return false;
+} /* steal_task */
+
+/* work on a job until all of its tasks are done */
+static void
+run_job (SolverPool *pool, SolverJob *job, unsigned int self)
+{
+	SolverWorker *worker = pool->workers[self];
+	SolverTask task;
+
+	while (job->outstanding.load () > 0)
+	{
+		if (!pop_task (worker, &task) && !steal_task (pool, job, self, &task))
+		{ /* nothing to do, others are still searching */
+			std::this_thread::yield ();
+			continue;
+		}
+
+		if (job->found[task.sub].load (std::memory_order_relaxed))
+		{ /* a sibling range already won */
+			finish_task (pool, job);
+			continue;
+		}
+
+		if (task.end - task.start > pool->chunk)
+		{ /* keep one chunk and put the rest back up for grabs */
+			SolverTask rest = { task.sub, task.start + pool->chunk, task.end };
+			task.end = rest.start;
+
+			job->outstanding.fetch_add (1);
+			std::lock_guard<std::mutex> guard (worker->lock);
+			worker->tasks.push_back (rest);
+		}
+
+		uint64_t winner;
+		if (job->search (job, task.sub, task.start, task.end, &winner))
+		{
+			int expected = 0;
+			if (job->found[task.sub].compare_exchange_strong (expected, 1))
+				job->winners[task.sub] = winner;
+		}
+
+		finish_task (pool, job);
+	}
+} /* run_job */
+
+/* the main loop of a worker thread */
+static void
+worker_main (SolverPool *pool, unsigned int self)
+{
+	unsigned long seen = 0;
+
+	while (true)
+	{
+		SolverJob *job;
+		{
+			std::unique_lock<std::mutex> guard (pool->lock);
+			pool->wake.wait (guard, [&] {
+					return pool->shutdown || (pool->job && pool->generation != seen);
+					});
+			if (pool->shutdown)
+				return;
+
+			job = pool->job;
+			seen = pool->generation;
+			pool->active++;
+		}
+
+		run_job (pool, job, self);
+
+		std::lock_guard<std::mutex> guard (pool->lock);
+		pool->active--;
+		pool->done.notify_all ();
+	}
+} /* worker_main */
+
+/* create_solver_pool */
+SolverPool *
+create_solver_pool (unsigned int nthreads, uint64_t chunk)
+{
+	if (nthreads == 0)
+		nthreads = std::thread::hardware_concurrency ();
+	if (nthreads == 0)
+		nthreads = 1; /* could not tell, use one */
+
+	SolverPool *pool = new SolverPool;
+	pool->chunk      = (chunk > 0)? chunk : SOLVER_POOL_CHUNK;
+	pool->job        = NULL;
+	pool->generation = 0;
+	pool->active     = 0;
+	pool->shutdown   = false;
+
+	for (unsigned int i = 0; i < nthreads; i++)
+		pool->workers.push_back (new SolverWorker);
+
+	for (unsigned int i = 0; i < nthreads; i++)
+		pool->workers[i]->thread = std::thread (worker_main, pool, i);
+
+	return pool;
+} /* create_solver_pool */
+
+/* free_solver_pool */
+void
+free_solver_pool (SolverPool *pool)
+{
+	if (!pool)
+		return; /* nothing to do */
+
+	{
+		std::lock_guard<std::mutex> guard (pool->lock);
+		pool->shutdown = true;
+		pool->wake.notify_all ();
+	}
+
+	for (SolverWorker *worker : pool->workers)
+	{
+		worker->thread.join ();
+		delete worker;
+	}
+
+	delete pool;
+} /* free_solver_pool */
+
+/* solver_pool_size */
+unsigned int
+solver_pool_size (SolverPool *pool)
+{
+	return pool? pool->workers.size () : 0;
+} /* solver_pool_size */
+
+/* solver_pool_run */
+unsigned int
+solver_pool_run (SolverPool *pool, unsigned int num_subs, uint64_t space,
+		solver_search_fn search, void *arg, uint64_t *winners)
+{
+	if (!pool || !search || !winners || num_subs == 0 || space == 0)
+		return 0; /* nothing to do */
+
+	std::lock_guard<std::mutex> run_guard (pool->run_lock);
+
+	SolverJob job;
+	job.search   = search;
+	job.arg      = arg;
+	job.num_subs = num_subs;
+	job.winners  = winners;
+	job.found    = new std::atomic<int>[num_subs];
+	job.outstanding.store (num_subs);
+
+	/* deal one full range per sub puzzle, the workers split them up */
+	unsigned int n = pool->workers.size ();
+	for (unsigned int i = 0; i < num_subs; i++)
+	{
+		job.found[i].store (0);
+
+		SolverTask task = { i, 0, space };
+		SolverWorker *worker = pool->workers[i % n];
+		std::lock_guard<std::mutex> guard (worker->lock);
+		worker->tasks.push_back (task);
+	}
+
+	/* start the job and wait until every task is done and every worker left */
+	std::unique_lock<std::mutex> guard (pool->lock);
+	pool->job = &job;
+	pool->generation++;
+	pool->wake.notify_all ();
+
+	pool->done.wait (guard, [&] { return job.outstanding.load () == 0; });
+	pool->job = NULL;
+	pool->done.wait (guard, [&] { return pool->active == 0; });
+
+	unsigned int solved = 0;
+	for (unsigned int i = 0; i < num_subs; i++)
+		solved += job.found[i].load ();
+
+	delete[] job.found;
+	return solved;
+} /* solver_pool_run */
+
+/* solver_job_arg */
+void *
+solver_job_arg (SolverJob *job)
+{
+	return job->arg;
+} /* solver_job_arg */
+
+/* solver_job_cancelled */
+bool
+solver_job_cancelled (SolverJob *job, unsigned int sub)
+{
+	if (!job)
+		return false; /* serial search, never cancelled */
+
+	return job->found[sub].load (std::memory_order_relaxed) != 0;
+} /* solver_job_cancelled */
@@ -0,0 +1,232 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  step_solver.cc
+ *
+ *    Description:  Implementation of the resumable step solver
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 08:02:14 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "client/step_solver.h"
+
+#include <time.h>
+
+#include <atomic>
+
+struct StepSolver {
+	step_search_fn search;			/* The search routine */
+	void *arg;						/* The argument of the search routine */
+	void (*free_arg) (void *);		/* Frees arg, may be NULL */
+
+	unsigned int num_subs;			/* The number of sub puzzles */
+	uint64_t space;					/* The candidates of each sub puzzle */
+	uint64_t expected;				/* The hashes a sub puzzle is expected to take */
+	uint64_t *winners;				/* The winner of each sub puzzle */
+
+	unsigned int sub;				/* The sub puzzle being searched */
+	uint64_t next;					/* Its next candidate */
+
+	uint64_t tried;					/* The candidates hashed so far */
+	uint64_t busy_ns;				/* The time spent stepping */
+	uint64_t deadline;				/* When the search expires, 0 for never */
+
+	std::atomic<bool> cancelled;	/* Set by step_solver_cancel */
+	step_status_t status;
+};
+
+/* the monotonic clock in nanoseconds. The metrics clock is compiled out
+ * with the metrics, and the deadline must not be. */
+static inline uint64_t
+step_now ()
+{
+	timespec t;
+	clock_gettime (CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000000ULL + t.tv_nsec;
+} /* step_now */
+
+/* create_step_solver */
+StepSolver *
+create_step_solver (unsigned int num_subs, uint64_t space, uint64_t expected,
+		step_search_fn search, void *arg, void (*free_arg) (void *),
+		uint32_t timeout_ms)
+{
+	if (!search || space == 0)
+		return NULL;
+
+	StepSolver *solver = new StepSolver;
+	solver->search = search;
+	solver->arg = arg;
+	solver->free_arg = free_arg;
+
+	solver->num_subs = num_subs;
+	solver->space = space;
+	solver->expected = expected;
+	solver->winners = (uint64_t *) calloc (num_subs ? num_subs : 1, sizeof (uint64_t));
+
+	solver->sub = 0;
+	solver->next = 0;
+	solver->tried = 0;
+	solver->busy_ns = 0;
+	solver->deadline = timeout_ms ? step_now () + (uint64_t) timeout_ms * 1000000ULL : 0;
+
+	solver->cancelled = false;
+	solver->status = (num_subs == 0)? STEP_SOLVED : STEP_RUNNING;
+
+	return solver;
+} /* create_step_solver */
+
+/* free_step_solver */
+void
+free_step_solver (StepSolver *solver)
+{
+	if (!solver)
+		return;
+
+	if (solver->free_arg)
+		solver->free_arg (solver->arg);
+
+	free (solver->winners);
+	delete solver;
+} /* free_step_solver */
+
+/* step_solver_run */
+step_status_t
+step_solver_run (StepSolver *solver, uint64_t max_tries, uint32_t max_us)
+{
+	if (!solver)
+		return STEP_FAILED;
+
+	if (solver->status != STEP_RUNNING)
+		return solver->status;
+
+	uint64_t start = step_now ();
+	uint64_t stop_at = max_us ? start + (uint64_t) max_us * 1000ULL : 0;
+	uint64_t budget = max_tries ? max_tries : UINT64_MAX;
+
+	if (solver->deadline && start >= solver->deadline)
+	{
+		solver->status = STEP_EXPIRED;
+		budget = 0;
+	}
+
+	while (budget > 0)
+	{ /* one slice at a time, the position survives between steps */
+		if (solver->cancelled.load (std::memory_order_acquire))
+		{
+			solver->status = STEP_CANCELLED;
+			break;
+		}
+
+		uint64_t n = solver->space - solver->next;
+		if (n > STEP_SOLVER_SLICE)
+			n = STEP_SOLVER_SLICE;
+		if (n > budget)
+			n = budget;
+
+		uint64_t winner;
+		if (solver->search (solver->arg, solver->sub, solver->next, solver->next + n, &winner))
+		{ /* only the candidates up to the winner count */
+			n = winner - solver->next + 1;
+			solver->winners[solver->sub] = winner;
+			solver->sub++;
+			solver->next = 0;
+		} else
+		{
+			solver->next += n;
+		}
+
+		solver->tried += n;
+		budget -= n;
+
+		if (solver->sub == solver->num_subs)
+		{
+			solver->status = STEP_SOLVED;
+			break;
+		}
+
+		if (solver->next == solver->space)
+		{ /* the whole space of this sub puzzle came up empty */
+			solver->status = STEP_FAILED;
+			break;
+		}
+
+		uint64_t now = step_now ();
+		if (solver->deadline && now >= solver->deadline)
+		{
+			solver->status = STEP_EXPIRED;
+			break;
+		}
+
+		if (stop_at && now >= stop_at)
+			break;
+	}
+
+	solver->busy_ns += step_now () - start;
+
+	return solver->status;
+} /* step_solver_run */
+
+/* step_solver_cancel */
+void
+step_solver_cancel (StepSolver *solver)
+{
+	if (solver)
+		solver->cancelled.store (true, std::memory_order_release);
+} /* step_solver_cancel */
+
+/* step_solver_status */
+step_status_t
+step_solver_status (const StepSolver *solver)
+{
+	return solver ? solver->status : STEP_FAILED;
+} /* step_solver_status */
+
+/* step_solver_progress */
+void
+step_solver_progress (const StepSolver *solver, StepProgress *progress)
+{
+	progress->solved = solver->sub;
+	progress->total = solver->num_subs;
+	progress->tried = solver->tried;
+	progress->busy_us = solver->busy_ns / 1000;
+
+	/* what the current sub puzzle has tried is left out. That is exact when
+	 * every candidate wins independently, as in the optimized scheme, and
+	 * errs on the long side for the naive one. */
+	uint64_t left = (solver->status == STEP_SOLVED)? 0 : solver->num_subs - solver->sub;
+	progress->expected_left = (left && solver->expected > UINT64_MAX / left)?
+		UINT64_MAX : left * solver->expected;
+
+	progress->hashes_per_sec = solver->busy_ns ?
+		1e9 * solver->tried / solver->busy_ns : 0;
+
+	if (progress->expected_left == 0)
+		progress->eta_us = 0;
+	else if (progress->hashes_per_sec > 0)
+		progress->eta_us = (uint64_t) (1e6 * progress->expected_left / progress->hashes_per_sec);
+	else
+		progress->eta_us = UINT64_MAX;
+} /* step_solver_progress */
+
+/* step_solver_winners */
+const uint64_t *
+step_solver_winners (const StepSolver *solver)
+{
+	return (solver && solver->status == STEP_SOLVED)? solver->winners : NULL;
+} /* step_solver_winners */
+
+/* step_solver_arg */
+void *
+step_solver_arg (const StepSolver *solver)
+{
+	return solver->arg;
+} /* step_solver_arg */
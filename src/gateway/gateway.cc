@@ -0,0 +1,958 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  gateway.cc
+ *
+ *    Description:  Implementation of the epoll puzzle gateway
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 02:58:12 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "gateway/gateway.h"
+#include "server/optserver.h"
+#include "server/verifier.h"
+#include "server/admission.h"
+#include "server/keyring.h"
+#include "puzzle/wire.h"
+#include "gateway_internal.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/* The events taken from epoll per wake up */
+#ifndef GATEWAY_EVENTS
+#define GATEWAY_EVENTS 256
+#endif
+
+/* The wait before accepting again once out of descriptors, in ms */
+#ifndef GATEWAY_RETRY_MS
+#define GATEWAY_RETRY_MS 100
+#endif
+
+/* The records of the clients that order the verifier's queue, by address */
+#ifndef GATEWAY_SCORES
+#define GATEWAY_SCORES (1 << 16)
+#endif
+
+/* The epoll tags of the descriptors that are not connections, and the end
+ * of the connection lists. A connection's tag is its slot, with the
+ * generation of the slot in the high half. */
+#define GW_LISTEN 	UINT32_MAX
+#define GW_WAKE 	(UINT32_MAX - 1)
+#define GW_DONE 	(UINT32_MAX - 2)
+#define GW_NONE 	UINT32_MAX
+
+/* A connection in its handshake. The connections of a worker live in one
+ * array, the free slots are chained through next and the busy ones are
+ * doubly linked in the order they were accepted, which is also the order
+ * of their deadlines. */
+typedef struct GatewayConn {
+	int fd;									/* The connection, -1 if the slot is free */
+	uint32_t gen;							/* Bumped whenever the slot is taken */
+	uint32_t prev;							/* The connection accepted before */
+	uint32_t next;							/* The one accepted after, or the next free slot */
+	uint64_t deadline;						/* The time its solution is due, in ms */
+	unsigned int have;						/* The bytes of the solution received */
+	unsigned int data_len;					/* The length of the connection data */
+	unsigned char data[GATEWAY_DATA_LEN];	/* The connection data */
+	unsigned char *buf;						/* The solution, in the worker's buffers */
+	bool verifying;							/* Off the accept order, with the verifier */
+	VerifyRequest req;						/* The solution on its way to the verifier */
+} GatewayConn;
+
+/* The counters of a worker, written by the worker only */
+typedef struct alignas(64) GatewayCounters {
+	std::atomic<uint64_t> accepted;
+	std::atomic<uint64_t> admitted;
+	std::atomic<uint64_t> rejected;
+	std::atomic<uint64_t> timed_out;
+	std::atomic<uint64_t> dropped;
+	std::atomic<uint64_t> shed;
+	std::atomic<uint64_t> paused;
+	std::atomic<uint64_t> pending;
+} GatewayCounters;
+
+typedef struct GatewayWorker {
+	PlutusGateway *gw;
+	int listen_fd;							/* Our own SO_REUSEPORT socket */
+	int epoll_fd;
+	int wake_fd;							/* An eventfd to stop the loop */
+	int handoff_fd;							/* The handoff socket, -1 for none */
+	VerifierQueue *done;					/* The verified solutions, NULL to verify inline */
+	bool accepting;							/* Whether listen_fd is in the epoll set */
+	bool starved;							/* Paused for want of descriptors */
+	uint64_t retry_at;						/* When a starved worker tries again, in ms */
+
+	std::vector<GatewayConn> conns;			/* max_pending slots */
+	unsigned char *bufs;					/* The solution buffers of the slots */
+	uint32_t free_head;						/* The first free slot */
+	uint32_t oldest;						/* The first connection accepted */
+	uint32_t newest;						/* The last connection accepted */
+	unsigned int pending;					/* The connections in their handshake */
+
+	GatewayCounters counters;
+	std::thread thread;
+} GatewayWorker;
+
+struct PlutusGateway {
+	GatewayConfig config;					/* The key and the path are not kept */
+	PlutusKeyring *keys;					/* Shared, read without a lock */
+	SHA256OptReplayCache *replay;			/* Shared, lock free */
+	PlutusVerifier *verifier;				/* NULL to verify on the workers */
+	AdmissionScores *scores;				/* The records of the clients, NULL for
+											   a verifier taking them in order */
+	size_t need;							/* The length of a solution packet */
+	uint16_t port;
+	std::vector<GatewayWorker *> workers;
+};
+
+/* the monotonic clock in ms */
+static inline uint64_t
+now_ms ()
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+} /* now_ms */
+
+
+
+/*-----------------------------------------------------------------------------
+ *  The connection slots
+ *-----------------------------------------------------------------------------*/
+
+/* take a free slot and put it last in the accept order */
+static uint32_t
+take_slot (GatewayWorker *w, int fd, uint64_t deadline)
+{
+	uint32_t s = w->free_head;
+	GatewayConn *c = &w->conns[s];
+	w->free_head = c->next;
+
+	c->fd = fd;
+	c->gen++;
+	c->deadline = deadline;
+	c->have = 0;
+	c->prev = w->newest;
+	c->next = GW_NONE;
+	if (w->newest != GW_NONE)
+		w->conns[w->newest].next = s;
+	else
+		w->oldest = s;
+	w->newest = s;
+
+	w->pending++;
+	bump (w->counters.pending);
+	return s;
+} /* take_slot */
+
+/* the epoll tag of the connection in a slot, an event of an earlier
+ * connection in the slot does not match it */
+static inline uint64_t
+slot_tag (const GatewayWorker *w, uint32_t s)
+{
+	return ((uint64_t) w->conns[s].gen << 32) | s;
+} /* slot_tag */
+
+/* take a slot out of the accept order */
+static void
+unlink_slot (GatewayWorker *w, uint32_t s)
+{
+	GatewayConn *c = &w->conns[s];
+
+	if (c->prev != GW_NONE)
+		w->conns[c->prev].next = c->next;
+	else
+		w->oldest = c->next;
+	if (c->next != GW_NONE)
+		w->conns[c->next].prev = c->prev;
+	else
+		w->newest = c->prev;
+} /* unlink_slot */
+
+/* unlink a slot from the accept order and free it, the caller owns the fd */
+static int
+release_slot (GatewayWorker *w, uint32_t s)
+{
+	GatewayConn *c = &w->conns[s];
+	int fd = c->fd;
+
+	if (c->verifying)
+	{ /* already out of the accept order and the epoll set */
+		c->verifying = false;
+	} else
+	{
+		epoll_ctl (w->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+		unlink_slot (w, s);
+	}
+
+	c->fd = -1;
+	c->next = w->free_head;
+	w->free_head = s;
+
+	/* a descriptor goes with the slot, there may be room for a new one */
+	w->starved = false;
+
+	w->pending--;
+	bump (w->counters.pending, -1);
+	return fd;
+} /* release_slot */
+
+/* close a connection in its handshake and count why */
+static void
+close_slot (GatewayWorker *w, uint32_t s, std::atomic<uint64_t> &reason)
+{
+	close (release_slot (w, s));
+	bump (reason);
+} /* close_slot */
+
+
+/*-----------------------------------------------------------------------------
+ *  Backpressure
+ *-----------------------------------------------------------------------------*/
+
+/* stop or resume taking connections off our listening socket. The ones
+ * the kernel hashes to us meanwhile wait in the backlog, and once that is
+ * full their SYNs are dropped and the clients back off. */
+static void
+set_accepting (GatewayWorker *w, bool on)
+{
+	if (w->accepting == on)
+		return; /* nothing to do */
+
+	struct epoll_event ev;
+	ev.events = on ? (uint32_t) EPOLLIN : 0u;
+	ev.data.u64 = GW_LISTEN;
+	epoll_ctl (w->epoll_fd, EPOLL_CTL_MOD, w->listen_fd, &ev);
+
+	w->accepting = on;
+	if (!on)
+		bump (w->counters.paused);
+} /* set_accepting */
+
+
+/*-----------------------------------------------------------------------------
+ *  The handshake
+ *-----------------------------------------------------------------------------*/
+
+/* mint the challenge of a new connection and send it */
+static bool
+send_challenge (GatewayWorker *w, GatewayConn *c, uint32_t timestamp)
+{
+	unsigned char pkt[WIRE_HEADER_LEN + SHA256_DIGEST_LEN];
+	SHA256OptPacketItem item = { pkt, sizeof (pkt), c->data, c->data_len };
+	if (keyring_mint_packets (w->gw->keys, &item, 1, timestamp) != 1)
+		return false;
+
+	/* a fresh connection always has room for a packet this small */
+	return send (c->fd, pkt, item.pkt_len, MSG_NOSIGNAL) == (ssize_t) item.pkt_len;
+} /* send_challenge */
+
+/* take new connections off the listening socket */
+static void
+accept_ready (GatewayWorker *w)
+{
+	const GatewayConfig *config = &w->gw->config;
+	uint64_t deadline = now_ms () + config->handshake_ms;
+	uint32_t timestamp = (uint32_t) time (NULL);
+
+	for (unsigned int i = 0; i < config->accept_batch; i++)
+	{
+		if (w->pending >= config->max_pending)
+		{
+			set_accepting (w, false);
+			return;
+		}
+
+		struct sockaddr_in peer;
+		socklen_t peer_len = sizeof (peer);
+		int fd = accept4 (w->listen_fd, (struct sockaddr *) &peer, &peer_len,
+				SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0)
+		{
+			/* the connection stays in the backlog and the listening socket
+			 * readable, stop watching it until a descriptor is freed */
+			if (errno == EMFILE || errno == ENFILE)
+			{
+				w->starved = true;
+				w->retry_at = now_ms () + GATEWAY_RETRY_MS;
+				set_accepting (w, false);
+			}
+			return; /* drained otherwise */
+		}
+
+		bump (w->counters.accepted);
+
+		uint32_t s = take_slot (w, fd, deadline);
+		GatewayConn *c = &w->conns[s];
+		c->data_len = gateway_peer_data (&peer, c->data);
+
+		struct epoll_event ev;
+		ev.events = EPOLLIN | EPOLLRDHUP;
+		ev.data.u64 = slot_tag (w, s);
+		if (epoll_ctl (w->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0
+				|| !send_challenge (w, c, timestamp))
+			close_slot (w, s, w->counters.dropped);
+	}
+} /* accept_ready */
+
+/* pass a verified connection on over the handoff socket */
+static bool
+hand_off (GatewayWorker *w, int fd, const unsigned char *data, unsigned int data_len)
+{
+	struct iovec iov;
+	iov.iov_base = (void *) data;
+	iov.iov_len = data_len;
+
+	union {
+		struct cmsghdr align;
+		char buf[CMSG_SPACE (sizeof (int))];
+	} control;
+	memset (&control, 0, sizeof (control));
+
+	struct msghdr msg;
+	memset (&msg, 0, sizeof (msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof (control.buf);
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+	memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+
+	/* a receiver that falls behind loses connections, it does not stall us */
+	return sendmsg (w->handoff_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t) data_len;
+} /* hand_off */
+
+/* admit or close a connection once its solution is verified */
+static void
+admit_slot (GatewayWorker *w, uint32_t s, verify_status_t status)
+{
+	PlutusGateway *gw = w->gw;
+	GatewayConn *c = &w->conns[s];
+
+	if (status == VERIFY_SHED)
+	{ /* says nothing of the client, its record stays as it is */
+		close_slot (w, s, w->counters.shed);
+		return;
+	}
+
+	/* only the address, a client picks a new port for every connection */
+	admission_record (gw->scores, c->data, 4, status == VERIFY_OK);
+
+	if (status != VERIFY_OK)
+	{
+		close_slot (w, s, w->counters.rejected);
+		return;
+	}
+
+	/* the slot goes back before the connection leaves, the data with it */
+	unsigned char data[GATEWAY_DATA_LEN];
+	unsigned int data_len = c->data_len;
+	memcpy (data, c->data, data_len);
+	int fd = release_slot (w, s);
+
+	if (gw->config.admit)
+	{
+		gw->config.admit (fd, data, data_len, gw->config.admit_arg);
+		bump (w->counters.admitted);
+		return;
+	}
+
+	bump (hand_off (w, fd, data, data_len)? w->counters.admitted : w->counters.dropped);
+	close (fd);
+} /* admit_slot */
+
+/* pass a complete solution to the verifier. The connection leaves the
+ * accept order, a solution that is in cannot time out, and it is not read
+ * from until the verdict is back. Behind an admission queue, a solution
+ * the verifier turns away is shed along with its connection.
+ *
+ * returns true if the connection was taken care of
+ */
+static bool
+defer_handshake (GatewayWorker *w, uint32_t s)
+{
+	PlutusGateway *gw = w->gw;
+	GatewayConn *c = &w->conns[s];
+
+	c->req.pkt = c->buf;
+	c->req.pkt_len = w->gw->need;
+	c->req.data = c->data;
+	c->req.data_len = c->data_len;
+	c->req.cq = w->done;
+	c->req.done = NULL;
+	c->req.user = (void *) (uintptr_t) s;
+	c->req.deadline = 0;
+	c->req.priority = admission_level (gw->scores, c->data, 4);
+	if (verifier_submit (gw->verifier, &c->req) != 0)
+	{
+		if (!gw->scores)
+			return false;
+
+		close_slot (w, s, w->counters.shed);
+		return true;
+	}
+
+	/* a hang up would still be reported with no events asked for */
+	epoll_ctl (w->epoll_fd, EPOLL_CTL_DEL, c->fd, NULL);
+
+	unlink_slot (w, s);
+	c->verifying = true;
+	return true;
+} /* defer_handshake */
+
+/* verify a complete solution and admit or close its connection */
+static void
+finish_handshake (GatewayWorker *w, uint32_t s)
+{
+	PlutusGateway *gw = w->gw;
+	GatewayConn *c = &w->conns[s];
+
+	/* the verifier has room for every slot, inline is only a fallback */
+	if (gw->verifier && defer_handshake (w, s))
+		return;
+
+	SHA256OptVerifyParams params = { (uint32_t) time (NULL), gw->config.max_age, gw->replay };
+	admit_slot (w, s, keyring_verify_packet (gw->keys, c->buf, gw->need,
+				c->data, c->data_len, &params));
+} /* finish_handshake */
+
+/* admit or close the connections whose verdicts are back */
+static void
+verdicts_ready (GatewayWorker *w)
+{
+	VerifyRequest *reqs[GATEWAY_EVENTS];
+	unsigned int n = verifier_queue_poll (w->done, reqs, GATEWAY_EVENTS);
+
+	for (unsigned int i = 0; i < n; i++)
+		admit_slot (w, (uint32_t) (uintptr_t) reqs[i]->user, reqs[i]->status);
+} /* verdicts_ready */
+
+/* read what a client sent towards its solution */
+static void
+conn_ready (GatewayWorker *w, uint32_t s, uint32_t events)
+{
+	GatewayConn *c = &w->conns[s];
+	size_t need = w->gw->need;
+
+	/* only the solution is read, anything after it is the application's */
+	ssize_t n = recv (c->fd, c->buf + c->have, need - c->have, 0);
+	if (n > 0)
+	{
+		c->have += n;
+		if (c->have == need)
+			finish_handshake (w, s);
+		return;
+	}
+
+	if (n < 0 && (errno == EAGAIN || errno == EINTR) && !(events & (EPOLLERR | EPOLLHUP)))
+		return; /* spurious */
+
+	close_slot (w, s, w->counters.dropped);
+} /* conn_ready */
+
+/* close the connections whose time is up, the oldest ones come first */
+static void
+expire (GatewayWorker *w, uint64_t now)
+{
+	while (w->oldest != GW_NONE && w->conns[w->oldest].deadline <= now)
+		close_slot (w, w->oldest, w->counters.timed_out);
+} /* expire */
+
+/* the event loop of a worker */
+static void
+worker_main (GatewayWorker *w)
+{
+	const GatewayConfig *config = &w->gw->config;
+	struct epoll_event events[GATEWAY_EVENTS];
+
+	while (true)
+	{
+		/* sleep until the next deadline at the latest, or until a starved
+		 * worker tries again */
+		uint64_t deadline = UINT64_MAX;
+		if (w->oldest != GW_NONE)
+			deadline = w->conns[w->oldest].deadline;
+		if (w->starved && w->retry_at < deadline)
+			deadline = w->retry_at;
+
+		int timeout = -1;
+		if (deadline != UINT64_MAX)
+		{
+			uint64_t now = now_ms ();
+			timeout = (deadline > now)? (int) (deadline - now) : 0;
+		}
+
+		int n = epoll_wait (w->epoll_fd, events, GATEWAY_EVENTS, timeout);
+		if (n < 0 && errno != EINTR)
+		{
+			perror ("[ERROR]: epoll_wait");
+			break;
+		}
+
+		/* a slot closed earlier in the batch may be taken again by then,
+		 * the generation in the tag keeps its old events away */
+		bool stop = false;
+		for (int i = 0; i < n; i++)
+		{
+			uint64_t tag = events[i].data.u64;
+			uint32_t s = (uint32_t) tag;
+			if (tag == GW_WAKE)
+				stop = true;
+			else if (tag == GW_LISTEN)
+				accept_ready (w);
+			else if (tag == GW_DONE)
+				verdicts_ready (w);
+			else if (w->conns[s].fd >= 0 && !w->conns[s].verifying
+					&& slot_tag (w, s) == tag)
+				conn_ready (w, s, events[i].events);
+		}
+		if (stop)
+			break;
+
+		uint64_t now = now_ms ();
+		expire (w, now);
+		if (w->starved && now >= w->retry_at)
+			w->starved = false; /* descriptors freed elsewhere count too */
+		if (w->pending <= config->resume_pending && !w->starved)
+			set_accepting (w, true);
+	}
+
+	/* the handshakes in flight die with the gateway, the ones with the
+	 * verifier once it is drained */
+	while (w->oldest != GW_NONE)
+		close_slot (w, w->oldest, w->counters.dropped);
+} /* worker_main */
+
+
+/*-----------------------------------------------------------------------------
+ *  Setting up
+ *-----------------------------------------------------------------------------*/
+
+/* gateway_default_config */
+void
+gateway_default_config (GatewayConfig *config)
+{
+	if (!config)
+		return; /* nothing to do */
+
+	memset (config, 0, sizeof (*config));
+	config->host = NULL;
+	config->port = 0;
+	config->nthreads = 0;
+	config->backlog = 1024;
+
+	config->k = 4;
+	config->m = 12;
+	config->l = 128;
+	config->max_age = 30;
+	config->replay_bytes = 1 << 20;
+
+	config->max_pending = 4096;
+	config->resume_pending = 3072;
+	config->accept_batch = 64;
+	config->handshake_ms = 10000;
+
+	config->verify_threads = 0;
+	config->verify_node = -1;
+	config->verify_queue = 0;
+	config->verify_ms = 100;
+} /* gateway_default_config */
+
+/* gateway_open_socket */
+int
+gateway_open_socket (const char *host, uint16_t port, int type, int backlog)
+{
+	int fd = socket (AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+
+	int one = 1;
+	setsockopt (fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one));
+	if (setsockopt (fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof (one)) != 0)
+	{
+		close (fd);
+		return -1;
+	}
+
+	struct sockaddr_in addr;
+	memset (&addr, 0, sizeof (addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons (port);
+	addr.sin_addr.s_addr = htonl (INADDR_ANY);
+	if (host && inet_pton (AF_INET, host, &addr.sin_addr) != 1)
+	{
+		fprintf (stderr, "[ERROR]: %s is not an IPv4 address!\n", host);
+		close (fd);
+		return -1;
+	}
+
+	if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0
+			|| (type == SOCK_STREAM && listen (fd, backlog) != 0))
+	{
+		close (fd);
+		return -1;
+	}
+
+	return fd;
+} /* gateway_open_socket */
+
+/* gateway_bound_port */
+uint16_t
+gateway_bound_port (int fd)
+{
+	struct sockaddr_in addr;
+	socklen_t addr_len = sizeof (addr);
+	if (getsockname (fd, (struct sockaddr *) &addr, &addr_len) != 0)
+		return 0;
+
+	return ntohs (addr.sin_port);
+} /* gateway_bound_port */
+
+/* gateway_peer_data */
+unsigned int
+gateway_peer_data (const struct sockaddr_in *peer, unsigned char *data)
+{
+	memcpy (data, &peer->sin_addr, 4);
+	memcpy (data + 4, &peer->sin_port, 2);
+	return 6;
+} /* gateway_peer_data */
+
+/* connect to the receiver of the admitted connections */
+static int
+open_handoff (const char *path)
+{
+	struct sockaddr_un addr;
+	if (strlen (path) >= sizeof (addr.sun_path))
+		return -1;
+
+	int fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+
+	memset (&addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+	strcpy (addr.sun_path, path);
+	if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0)
+	{
+		close (fd);
+		return -1;
+	}
+
+	return fd;
+} /* open_handoff */
+
+/* close the descriptors of a worker and free it */
+static void
+free_worker (GatewayWorker *w)
+{
+	if (w->listen_fd >= 0)
+		close (w->listen_fd);
+	if (w->epoll_fd >= 0)
+		close (w->epoll_fd);
+	if (w->wake_fd >= 0)
+		close (w->wake_fd);
+	if (w->handoff_fd >= 0)
+		close (w->handoff_fd);
+	free_verifier_queue (w->done);
+
+	free (w->bufs);
+	delete w;
+} /* free_worker */
+
+/* set up a worker listening on a port, a port of 0 is picked by the kernel */
+static GatewayWorker *
+create_worker (PlutusGateway *gw, uint16_t port)
+{
+	const GatewayConfig *config = &gw->config;
+
+	GatewayWorker *w = new GatewayWorker ();
+	w->gw = gw;
+	w->epoll_fd = w->wake_fd = w->handoff_fd = -1;
+	w->done = NULL;
+	w->accepting = true;
+	w->starved = false;
+	w->retry_at = 0;
+	w->free_head = 0;
+	w->oldest = w->newest = GW_NONE;
+	w->pending = 0;
+	w->bufs = (unsigned char *) malloc (config->max_pending * gw->need);
+
+	w->listen_fd = gateway_open_socket (config->host, port, SOCK_STREAM, config->backlog);
+	w->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+	w->wake_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (gw->verifier)
+		w->done = create_verifier_queue (config->max_pending);
+	if (!w->bufs || w->listen_fd < 0 || w->epoll_fd < 0 || w->wake_fd < 0
+			|| (gw->verifier && !w->done))
+	{
+		free_worker (w);
+		return NULL;
+	}
+
+	/* every slot gets its buffer up front, the handshake never allocates */
+	w->conns.resize (config->max_pending);
+	for (uint32_t s = 0; s < config->max_pending; s++)
+	{
+		w->conns[s].fd = -1;
+		w->conns[s].gen = 0;
+		w->conns[s].verifying = false;
+		w->conns[s].next = (s + 1 < config->max_pending)? s + 1 : GW_NONE;
+		w->conns[s].buf = w->bufs + (size_t) s * gw->need;
+	}
+
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u64 = GW_LISTEN;
+	epoll_ctl (w->epoll_fd, EPOLL_CTL_ADD, w->listen_fd, &ev);
+	ev.data.u64 = GW_WAKE;
+	epoll_ctl (w->epoll_fd, EPOLL_CTL_ADD, w->wake_fd, &ev);
+	if (w->done)
+	{
+		ev.data.u64 = GW_DONE;
+		epoll_ctl (w->epoll_fd, EPOLL_CTL_ADD, verifier_queue_fd (w->done), &ev);
+	}
+
+	return w;
+} /* create_worker */
+
+/* create_gateway */
+PlutusGateway *
+create_gateway (const GatewayConfig *config)
+{
+	if (!config || !config->key || config->max_pending == 0 || config->max_age == 0
+			|| config->accept_batch == 0 || config->resume_pending >= config->max_pending
+			|| (!config->admit && !config->handoff_path))
+		return NULL;
+
+	PlutusGateway *gw = new PlutusGateway;
+	gw->config = *config;
+	gw->config.key = NULL;
+	gw->config.handoff_path = NULL;
+	gw->replay = NULL;
+	gw->verifier = NULL;
+	gw->scores = NULL;
+
+	if (!(gw->keys = create_keyring (config->key, config->key_len,
+				config->k, config->m, config->l)))
+	{
+		fprintf (stderr, "[ERROR]: k = %u, m = %u, l = %u are not valid puzzle parameters!\n",
+				config->k, config->m, config->l);
+		delete gw;
+		return NULL;
+	}
+	gw->need = WIRE_HEADER_LEN + (size_t) config->k * (config->l / 16);
+
+	/* a window of max_age keeps every accepted timestamp in the cache */
+	if (config->replay_bytes > 0)
+		gw->replay = create_replay_cache (config->replay_bytes, config->max_age, NULL);
+
+	unsigned int nthreads = config->nthreads;
+	if (nthreads == 0)
+		nthreads = std::thread::hardware_concurrency ();
+	if (nthreads == 0)
+		nthreads = 1; /* could not tell, use one */
+	gw->config.nthreads = nthreads;
+
+	/* room for every slot of every worker, so a submission is never refused */
+	bool failed = (config->replay_bytes > 0 && !gw->replay);
+	if (config->verify_threads > 0 && !failed)
+	{
+		VerifierConfig vconfig;
+		verifier_default_config (&vconfig);
+		vconfig.keyring = gw->keys;
+		vconfig.max_age = config->max_age;
+		vconfig.replay = gw->replay;
+		vconfig.nthreads = config->verify_threads;
+		vconfig.capacity = nthreads * config->max_pending;
+		vconfig.numa_node = config->verify_node;
+		vconfig.admission = config->verify_queue;
+		vconfig.deadline_ms = config->verify_ms;
+
+		gw->verifier = create_verifier (&vconfig);
+		if (gw->verifier && config->verify_queue > 0)
+			gw->scores = create_admission_scores (GATEWAY_SCORES);
+		failed = !gw->verifier || (config->verify_queue > 0 && !gw->scores);
+	}
+
+	/* the first worker fixes the port the others share */
+	gw->port = config->port;
+	for (unsigned int i = 0; i < nthreads && !failed; i++)
+	{
+		GatewayWorker *w = create_worker (gw, gw->port);
+		if (!w)
+		{
+			perror ("[ERROR]: could not set up a gateway worker");
+			failed = true;
+			break;
+		}
+		gw->workers.push_back (w);
+
+		if (config->handoff_path
+				&& (w->handoff_fd = open_handoff (config->handoff_path)) < 0)
+		{
+			fprintf (stderr, "[ERROR]: could not connect to %s!\n", config->handoff_path);
+			failed = true;
+		}
+
+		if (i == 0)
+			gw->port = gateway_bound_port (w->listen_fd);
+	}
+
+	if (failed)
+	{
+		for (GatewayWorker *w : gw->workers)
+			free_worker (w);
+		free_verifier (gw->verifier);
+		free_admission_scores (gw->scores);
+		free_replay_cache (gw->replay);
+		free_keyring (gw->keys);
+		delete gw;
+		return NULL;
+	}
+
+	for (GatewayWorker *w : gw->workers)
+		w->thread = std::thread (worker_main, w);
+
+	return gw;
+} /* create_gateway */
+
+/* free_gateway */
+void
+free_gateway (PlutusGateway *gw)
+{
+	if (!gw)
+		return; /* nothing to do */
+
+	uint64_t one = 1;
+	for (GatewayWorker *w : gw->workers)
+		if (write (w->wake_fd, &one, sizeof (one)) != sizeof (one))
+			perror ("[ERROR]: could not stop a gateway worker");
+
+	for (GatewayWorker *w : gw->workers)
+		w->thread.join ();
+
+	/* the last verdicts come back to stopped workers, nobody is admitted */
+	free_verifier (gw->verifier);
+	for (GatewayWorker *w : gw->workers)
+	{
+		for (GatewayConn &c : w->conns)
+			if (c.fd >= 0)
+				close_slot (w, &c - &w->conns[0], w->counters.dropped);
+		free_worker (w);
+	}
+
+	free_admission_scores (gw->scores);
+	free_replay_cache (gw->replay);
+	free_keyring (gw->keys);
+	delete gw;
+} /* free_gateway */
+
+/* gateway_rotate_key */
+int64_t
+gateway_rotate_key (PlutusGateway *gw, const unsigned char *key, unsigned int key_len)
+{
+	if (!gw || !key)
+		return -1;
+
+	/* the second under way is still the old key's, it may have minted in it */
+	return keyring_rotate (gw->keys, key, key_len, (uint32_t) time (NULL) + 1);
+} /* gateway_rotate_key */
+
+/* gateway_port */
+uint16_t
+gateway_port (const PlutusGateway *gw)
+{
+	return gw? gw->port : 0;
+} /* gateway_port */
+
+/* gateway_stats */
+void
+gateway_stats (const PlutusGateway *gw, GatewayStats *stats)
+{
+	if (!stats)
+		return; /* nothing to do */
+
+	memset (stats, 0, sizeof (*stats));
+	if (!gw)
+		return;
+
+	for (const GatewayWorker *w : gw->workers)
+	{
+		const GatewayCounters *c = &w->counters;
+		stats->accepted  += c->accepted.load (std::memory_order_relaxed);
+		stats->admitted  += c->admitted.load (std::memory_order_relaxed);
+		stats->rejected  += c->rejected.load (std::memory_order_relaxed);
+		stats->timed_out += c->timed_out.load (std::memory_order_relaxed);
+		stats->dropped   += c->dropped.load (std::memory_order_relaxed);
+		stats->shed      += c->shed.load (std::memory_order_relaxed);
+		stats->paused    += c->paused.load (std::memory_order_relaxed);
+		stats->pending   += c->pending.load (std::memory_order_relaxed);
+	}
+} /* gateway_stats */
+
+/* gateway_recv_handoff */
+int
+gateway_recv_handoff (int sock, unsigned char *data, unsigned int *data_len)
+{
+	unsigned char buf[GATEWAY_DATA_LEN];
+	struct iovec iov;
+	iov.iov_base = buf;
+	iov.iov_len = sizeof (buf);
+
+	union {
+		struct cmsghdr align;
+		char buf[CMSG_SPACE (sizeof (int))];
+	} control;
+
+	struct msghdr msg;
+	memset (&msg, 0, sizeof (msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof (control.buf);
+
+	ssize_t n = recvmsg (sock, &msg, MSG_CMSG_CLOEXEC);
+	if (n < 0)
+		return -1;
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+	if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+		return -1; /* the gateway went away */
+
+	int fd;
+	memcpy (&fd, CMSG_DATA (cmsg), sizeof (int));
+
+	if (data)
+		memcpy (data, buf, n);
+	if (data_len)
+		*data_len = n;
+
+	return fd;
+} /* gateway_recv_handoff */
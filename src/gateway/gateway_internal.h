@@ -0,0 +1,60 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  gateway_internal.h
+ *
+ *    Description:  Helpers shared by the stream and the datagram gateways
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 05:02:51 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __GATEWAY_INTERNAL_H
+#define __GATEWAY_INTERNAL_H
+
+#include <netinet/in.h>
+#include <stdint.h>
+
+#include <atomic>
+
+/* count an event of a worker, only the worker writes its counters */
+static inline void
+bump (std::atomic<uint64_t> &counter, int64_t by = 1)
+{
+	counter.store (counter.load (std::memory_order_relaxed) + by,
+			std::memory_order_relaxed);
+} /* bump */
+
+/* open a non blocking SO_REUSEPORT socket bound to host and port
+ *
+ * arguments are:
+ *
+ *  host			-- The IPv4 address, NULL for any
+ *  port			-- The port, 0 for one picked by the kernel
+ *  type			-- SOCK_STREAM or SOCK_DGRAM
+ *  backlog			-- The listen backlog of a stream socket
+ *
+ * returns the socket, -1 on failure
+ */
+int
+gateway_open_socket 	(const char *host, uint16_t port, int type, int backlog);
+
+/* get the port a socket is bound to, in host order */
+uint16_t
+gateway_bound_port 		(int fd);
+
+/* the connection data of a peer, its address and port as on the wire
+ *
+ * returns the length of the data, at most GATEWAY_DATA_LEN
+ */
+unsigned int
+gateway_peer_data 		(const struct sockaddr_in *peer, unsigned char *data);
+
+#endif /* gateway_internal.h */
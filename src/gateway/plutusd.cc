@@ -0,0 +1,363 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  plutusd.cc
+ *
+ *    Description:  The puzzle gateway daemon, admitted connections are handed
+ *    				off to a Unix socket or counted and closed, or datagrams
+ *    				are answered in batches
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 03:41:09 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "gateway/gateway.h"
+#include "gateway/udp_gateway.h"
+#include "puzzle/metrics.h"
+
+#include <ctype.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <openssl/rand.h>
+
+#ifndef KEY_LEN
+#define KEY_LEN 32 /* in bytes */
+#endif
+
+/* struct to hold the arguments for the program */
+typedef struct {
+	GatewayConfig config;
+	const char *key_file;	/* the file holding the key, NULL for a random one */
+	bool udp;				/* serve datagrams instead of connections */
+	unsigned int batch;		/* the datagrams per system call */
+	bool verbose;
+} arguments_t;
+
+/* read command line arguments */
+int
+read_cmd_args (int argc, char **argv, arguments_t *args);
+
+/* read the key from a file or draw a random one */
+static int
+load_key (const char *key_file, unsigned char *key, unsigned int *key_len);
+
+/* read the key again, or draw a new one, and hand it to a gateway
+ *
+ * returns the epoch of the new key, -1 on failure
+ */
+template <typename Gateway>
+static int64_t
+rotate_key (const char *key_file, Gateway *gw,
+		int64_t (*rotate) (Gateway *, const unsigned char *, unsigned int))
+{
+	unsigned char key[KEY_LEN];
+	unsigned int key_len = sizeof (key);
+	int64_t epoch = -1;
+	if (load_key (key_file, key, &key_len) == 0)
+		epoch = rotate (gw, key, key_len);
+	memset (key, 0, sizeof (key));
+
+	if (epoch < 0)
+		printf ("[ERROR]: Could not rotate the key!\n");
+	else
+		printf ("[Log]: key epoch %ld from the next second on\n", epoch);
+	fflush (stdout);
+
+	return epoch;
+} /* rotate_key */
+
+/* without a handoff socket the admitted connections are only counted */
+static void
+close_admitted (int fd, const unsigned char *, unsigned int, void *)
+{
+	close (fd);
+} /* close_admitted */
+
+/* print the counters of the datagram gateway */
+static void
+print_udp_stats (const PlutusUdpGateway *gw)
+{
+	UdpGatewayStats stats;
+	udp_gateway_stats (gw, &stats);
+	printf ("[Log]: received %lu in %lu batches minted %lu admitted %lu rejected %lu ignored %lu send failed %lu\n",
+			stats.received, stats.batches, stats.minted, stats.admitted,
+			stats.rejected, stats.ignored, stats.send_failed);
+	fflush (stdout);
+} /* print_udp_stats */
+
+/* run the datagram mode until we are told to stop */
+static int
+run_udp (const arguments_t *args, sigset_t *stop)
+{
+	const GatewayConfig *c = &args->config;
+
+	UdpGatewayConfig config;
+	udp_gateway_default_config (&config);
+	config.host = c->host;
+	config.port = c->port;
+	config.nthreads = c->nthreads;
+	config.batch = args->batch;
+	config.key = c->key;
+	config.key_len = c->key_len;
+	config.k = c->k;
+	config.m = c->m;
+	config.l = c->l;
+	config.max_age = c->max_age;
+	config.replay_bytes = c->replay_bytes;
+
+	PlutusUdpGateway *gw = create_udp_gateway (&config);
+	if (!gw)
+	{
+		printf ("[ERROR]: Could not start the datagram gateway!\n");
+		return -1;
+	}
+
+	printf ("[Log]: plutusd serving datagrams on port %u, k = %u m = %u l = %u\n",
+			udp_gateway_port (gw), config.k, config.m, config.l);
+	fflush (stdout);
+
+	struct timespec period = { 1, 0 };
+	while (true)
+	{
+		int sig = sigtimedwait (stop, NULL, args->verbose? &period : NULL);
+		if (sig == SIGINT || sig == SIGTERM)
+			break;
+		if (sig == SIGHUP)
+			rotate_key (args->key_file, gw, udp_gateway_rotate_key);
+		else if (args->verbose)
+			print_udp_stats (gw);
+	}
+
+	print_udp_stats (gw);
+	free_udp_gateway (gw);
+	return 0;
+} /* run_udp */
+
+/* print the counters of the gateway */
+static void
+print_stats (const PlutusGateway *gw)
+{
+	GatewayStats stats;
+	gateway_stats (gw, &stats);
+	printf ("[Log]: accepted %lu admitted %lu rejected %lu timed out %lu dropped %lu shed %lu paused %lu pending %lu\n",
+			stats.accepted, stats.admitted, stats.rejected, stats.timed_out,
+			stats.dropped, stats.shed, stats.paused, stats.pending);
+	fflush (stdout);
+} /* print_stats */
+
+int
+main (int argc, char **argv)
+{
+	/* try to read cmd line arguments */
+	arguments_t args;
+	if ( read_cmd_args (argc, argv, &args) != 0 )
+	{
+		exit(-1);
+	}
+
+	unsigned char key[KEY_LEN];
+	unsigned int key_len = sizeof (key);
+	if (load_key (args.key_file, key, &key_len) != 0)
+		exit (-1);
+	args.config.key = key;
+	args.config.key_len = key_len;
+	if (!args.config.handoff_path)
+		args.config.admit = close_admitted;
+
+	/* the workers inherit the mask, the signals are only taken here. A
+	 * SIGHUP rotates the key, read again from the key file */
+	sigset_t stop;
+	sigemptyset (&stop);
+	sigaddset (&stop, SIGINT);
+	sigaddset (&stop, SIGTERM);
+	sigaddset (&stop, SIGHUP);
+	pthread_sigmask (SIG_BLOCK, &stop, NULL);
+	signal (SIGPIPE, SIG_IGN);
+
+	if (args.udp)
+	{
+		int ret = run_udp (&args, &stop);
+		memset (key, 0, sizeof (key));
+		if (ret == 0 && args.verbose)
+			metrics_write_prometheus (stdout);
+		return ret;
+	}
+
+	PlutusGateway *gw = create_gateway (&args.config);
+	memset (key, 0, sizeof (key));
+	if (!gw)
+	{
+		printf ("[ERROR]: Could not start the gateway!\n");
+		exit (-1);
+	}
+
+	printf ("[Log]: plutusd listening on port %u, k = %u m = %u l = %u\n",
+			gateway_port (gw), args.config.k, args.config.m, args.config.l);
+	fflush (stdout);
+
+	/* report every second when verbose, until we are told to stop */
+	struct timespec period = { 1, 0 };
+	while (true)
+	{
+		int sig = sigtimedwait (&stop, NULL, args.verbose? &period : NULL);
+		if (sig == SIGINT || sig == SIGTERM)
+			break;
+		if (sig == SIGHUP)
+			rotate_key (args.key_file, gw, gateway_rotate_key);
+		else if (args.verbose)
+			print_stats (gw);
+	}
+
+	print_stats (gw);
+	free_gateway (gw);
+	if (args.verbose)
+		metrics_write_prometheus (stdout);
+
+	return 0;
+} /* main */
+
+/* load_key */
+static int
+load_key (const char *key_file, unsigned char *key, unsigned int *key_len)
+{
+	if (!key_file)
+	{
+		if (RAND_bytes (key, *key_len) != 1)
+		{
+			printf ("[ERROR]: Could not draw a random key!\n");
+			return -1;
+		}
+		return 0;
+	}
+
+	FILE *in = fopen (key_file, "rb");
+	if (!in)
+	{
+		printf ("[ERROR]: Could not open the key file %s!\n", key_file);
+		return -1;
+	}
+
+	size_t n = fread (key, 1, *key_len, in);
+	fclose (in);
+	if (n == 0)
+	{
+		printf ("[ERROR]: The key file %s is empty!\n", key_file);
+		return -1;
+	}
+
+	*key_len = n;
+	return 0;
+} /* load_key */
+
+int
+read_cmd_args (int argc, char **argv, arguments_t *args)
+{
+	int c;
+	gateway_default_config (&args->config);
+	args->key_file = NULL; /* default value */
+	args->verbose = false; /* default value */
+	args->udp = false; /* default value */
+	args->batch = UDP_GATEWAY_MAX_BATCH; /* default value */
+
+	while ( (c = getopt (argc, argv, "H:p:t:k:m:l:a:P:R:T:u:K:V:N:Q:D:Ub:hv")) != -1)
+	{
+		switch (c)
+		{
+			case 'H':
+				args->config.host = optarg;
+				break;
+			case 'p':
+				args->config.port = atoi(optarg);
+				break;
+			case 't':
+				args->config.nthreads = atoi(optarg);
+				break;
+			case 'k':
+				args->config.k = atoi(optarg);
+				break;
+			case 'm':
+				args->config.m = atoi(optarg);
+				break;
+			case 'l':
+				args->config.l = atoi(optarg);
+				break;
+			case 'a':
+				args->config.max_age = atoi(optarg);
+				break;
+			case 'P':
+				args->config.max_pending = atoi(optarg);
+				args->config.resume_pending = args->config.max_pending * 3 / 4;
+				break;
+			case 'R':
+				args->config.resume_pending = atoi(optarg);
+				break;
+			case 'T':
+				args->config.handshake_ms = atoi(optarg);
+				break;
+			case 'u':
+				args->config.handoff_path = optarg;
+				break;
+			case 'K':
+				args->key_file = optarg;
+				break;
+			case 'V':
+				args->config.verify_threads = atoi(optarg);
+				break;
+			case 'N':
+				args->config.verify_node = atoi(optarg);
+				break;
+			case 'Q':
+				args->config.verify_queue = atoi(optarg);
+				break;
+			case 'D':
+				args->config.verify_ms = atoi(optarg);
+				break;
+			case 'U':
+				args->udp = true;
+				break;
+			case 'b':
+				args->batch = atoi(optarg);
+				break;
+			case 'v':
+				args->verbose = true;
+				break;
+			case 'h':
+				printf ("Usage: %s [-H host] [-p port] [-t threads] [-k num_subpuzzle]\
+						[-m bits_difficulty] [-l prefix_len] [-a max_age]\
+						[-P max_pending] [-R resume_pending] [-T handshake_ms]\
+						[-u handoff_socket] [-K key_file] [-V verify_threads [-N numa_node] [-Q verify_queue [-D verify_ms]]]\
+						[-U [-b batch]] [-vh?]\n",
+						argv[0]);
+				return -1;
+			case '?':
+				if (isprint (optopt))
+					printf ("[ERROR]: Unknow option `-%c' or missing argument.\n", optopt);
+				else
+					printf ("[ERROR]: Unknow option character `\\x%x'.\n",
+							optopt);
+				return -1;
+			default:
+				return -1;
+		}
+	}
+
+	for (int index=optind; index < argc; index++)
+	{
+		printf ("[ERROR]: Non-optim argument %s\n", argv[index]);
+		return -1;
+	}
+
+	return 0;
+} /* read_cmd_args */
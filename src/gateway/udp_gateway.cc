@@ -0,0 +1,486 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  udp_gateway.cc
+ *
+ *    Description:  Implementation of the datagram mode of the gateway
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 05:34:18 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "gateway/udp_gateway.h"
+#include "server/optserver.h"
+#include "server/keyring.h"
+#include "puzzle/wire.h"
+#include "gateway_internal.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/* The room for one received datagram, a whole Ethernet frame or a
+ * solution, whichever is larger */
+#ifndef UDP_GATEWAY_MTU
+#define UDP_GATEWAY_MTU 1500
+#endif
+
+/* The batches served before looking at the wake up descriptor again */
+#define UDP_GATEWAY_ROUNDS 64
+
+/* The counters of a worker, written by the worker only */
+typedef struct alignas(64) UdpCounters {
+	std::atomic<uint64_t> received;
+	std::atomic<uint64_t> batches;
+	std::atomic<uint64_t> minted;
+	std::atomic<uint64_t> admitted;
+	std::atomic<uint64_t> rejected;
+	std::atomic<uint64_t> ignored;
+	std::atomic<uint64_t> send_failed;
+} UdpCounters;
+
+typedef struct UdpWorker {
+	PlutusUdpGateway *gw;
+	int fd;									/* Our own SO_REUSEPORT socket */
+	int epoll_fd;
+	int wake_fd;							/* An eventfd to stop the loop */
+
+	/* The datagrams received, and where they came from */
+	struct mmsghdr in[UDP_GATEWAY_MAX_BATCH];
+	struct iovec in_iov[UDP_GATEWAY_MAX_BATCH];
+	struct sockaddr_in peers[UDP_GATEWAY_MAX_BATCH];
+	unsigned char *in_bufs;
+
+	/* The answers, the one to datagram j is written in out buffer j */
+	struct mmsghdr out[UDP_GATEWAY_MAX_BATCH];
+	struct iovec out_iov[UDP_GATEWAY_MAX_BATCH];
+	unsigned char *out_bufs;
+
+	/* The batches minted and verified, and the datagram of each item */
+	SHA256OptPacketItem mint[UDP_GATEWAY_MAX_BATCH];
+	SHA256OptPacketItem verify[UDP_GATEWAY_MAX_BATCH];
+	unsigned int mint_of[UDP_GATEWAY_MAX_BATCH];
+	unsigned int verify_of[UDP_GATEWAY_MAX_BATCH];
+	verify_status_t statuses[UDP_GATEWAY_MAX_BATCH];
+	unsigned char data[UDP_GATEWAY_MAX_BATCH][GATEWAY_DATA_LEN];
+
+	UdpCounters counters;
+	std::thread thread;
+} UdpWorker;
+
+struct PlutusUdpGateway {
+	UdpGatewayConfig config;				/* The key is not kept */
+	PlutusKeyring *keys;					/* Shared, read without a lock */
+	SHA256OptReplayCache *replay;			/* Shared, lock free */
+	size_t in_len;							/* The room for a received datagram */
+	size_t out_len;							/* The room for an answer */
+	size_t challenge_len;					/* The length of a challenge packet */
+	uint16_t port;
+	std::vector<UdpWorker *> workers;
+};
+
+
+/*-----------------------------------------------------------------------------
+ *  Serving
+ *-----------------------------------------------------------------------------*/
+
+/* queue the answer to datagram j if it is no larger than the datagram */
+static void
+answer (UdpWorker *w, unsigned int *nout, unsigned int j, size_t len)
+{
+	if (len == 0 || len > w->in[j].msg_len)
+	{
+		bump (w->counters.ignored);
+		return;
+	}
+
+	struct mmsghdr *msg = &w->out[*nout];
+	w->out_iov[*nout].iov_base = w->out_bufs + j * w->gw->out_len;
+	w->out_iov[*nout].iov_len = len;
+	msg->msg_hdr.msg_iov = &w->out_iov[*nout];
+	msg->msg_hdr.msg_name = &w->peers[j];
+	msg->msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+	(*nout)++;
+} /* answer */
+
+/* send the queued answers, what the kernel does not take is lost */
+static void
+send_answers (UdpWorker *w, unsigned int nout)
+{
+	unsigned int sent = 0;
+	while (sent < nout)
+	{
+		int r = sendmmsg (w->fd, w->out + sent, nout - sent, MSG_DONTWAIT);
+		if (r < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			/* skip the one that failed, the rest may still go */
+			bump (w->counters.send_failed);
+			sent++;
+			continue;
+		}
+		sent += r;
+	}
+} /* send_answers */
+
+/* take one batch of datagrams and answer it
+ *
+ * returns false once the socket is drained
+ */
+static bool
+serve_batch (UdpWorker *w)
+{
+	PlutusUdpGateway *gw = w->gw;
+	unsigned int batch = gw->config.batch;
+
+	for (unsigned int j = 0; j < batch; j++)
+	{
+		w->in[j].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+		w->in[j].msg_hdr.msg_flags = 0;
+	}
+
+	int n = recvmmsg (w->fd, w->in, batch, MSG_DONTWAIT, NULL);
+	if (n <= 0)
+		return false;
+
+	bump (w->counters.received, n);
+	bump (w->counters.batches);
+
+	/* sort the datagrams into requests for challenges and solutions */
+	unsigned int nmint = 0, nverify = 0;
+	for (unsigned int j = 0; j < (unsigned int) n; j++)
+	{
+		const unsigned char *buf = w->in_bufs + j * gw->in_len;
+		size_t len = w->in[j].msg_len;
+		if ((w->in[j].msg_hdr.msg_flags & MSG_TRUNC) || len < WIRE_HEADER_LEN)
+			continue;
+
+		WirePacket wire;
+		if (buf[3] == WIRE_HELLO && wire_parse (buf, len, &wire) == WIRE_OK)
+		{
+			SHA256OptPacketItem *item = &w->mint[nmint];
+			item->pkt = w->out_bufs + j * gw->out_len;
+			item->pkt_len = gw->out_len;
+			item->data = w->data[j];
+			item->data_len = gateway_peer_data (&w->peers[j], w->data[j]);
+			w->mint_of[nmint++] = j;
+		} else if (buf[3] == WIRE_OPT_SOLUTION)
+		{ /* fully checked by the verifier */
+			SHA256OptPacketItem *item = &w->verify[nverify];
+			item->pkt = (unsigned char *) buf;
+			item->pkt_len = len;
+			item->data = w->data[j];
+			item->data_len = gateway_peer_data (&w->peers[j], w->data[j]);
+			w->verify_of[nverify++] = j;
+		}
+	}
+
+	uint32_t now = (uint32_t) time (NULL);
+	unsigned int nout = 0;
+
+	/* the challenges, a hello too short to pay for its answer gets none */
+	keyring_mint_packets (gw->keys, w->mint, nmint, now);
+	for (unsigned int i = 0; i < nmint; i++)
+		answer (w, &nout, w->mint_of[i], w->mint[i].pkt_len);
+	bump (w->counters.minted, nout);
+
+	/* the solutions */
+	SHA256OptVerifyParams params = { now, gw->config.max_age, gw->replay };
+	keyring_verify_packets (gw->keys, w->verify, nverify, &params, w->statuses);
+	for (unsigned int i = 0; i < nverify; i++)
+	{
+		unsigned int j = w->verify_of[i];
+		const SHA256OptPacketItem *item = &w->verify[i];
+
+		if (w->statuses[i] == VERIFY_OK)
+		{
+			bump (w->counters.admitted);
+			if (gw->config.admit)
+				gw->config.admit (&w->peers[j], item->data, item->data_len,
+						gw->config.admit_arg);
+		} else
+		{
+			bump (w->counters.rejected);
+		}
+
+		WirePacket wire;
+		uint32_t timestamp = (wire_parse (item->pkt, item->pkt_len, &wire) == WIRE_OK)?
+			wire.timestamp : 0;
+		answer (w, &nout, j, encode_verdict (timestamp, (uint8_t) w->statuses[i],
+					w->out_bufs + j * gw->out_len, gw->out_len));
+	}
+
+	bump (w->counters.ignored, n - nmint - nverify);
+	send_answers (w, nout);
+
+	return n == (int) batch;
+} /* serve_batch */
+
+/* the loop of a worker */
+static void
+worker_main (UdpWorker *w)
+{
+	struct epoll_event events[2];
+
+	while (true)
+	{
+		int n = epoll_wait (w->epoll_fd, events, 2, -1);
+		if (n < 0 && errno != EINTR)
+		{
+			perror ("[ERROR]: epoll_wait");
+			return;
+		}
+
+		for (int i = 0; i < n; i++)
+			if (events[i].data.fd == w->wake_fd)
+				return;
+
+		/* drain the socket, a flood still lets us look for the wake up */
+		for (unsigned int r = 0; r < UDP_GATEWAY_ROUNDS; r++)
+			if (!serve_batch (w))
+				break;
+	}
+} /* worker_main */
+
+
+/*-----------------------------------------------------------------------------
+ *  Setting up
+ *-----------------------------------------------------------------------------*/
+
+/* udp_gateway_default_config */
+void
+udp_gateway_default_config (UdpGatewayConfig *config)
+{
+	if (!config)
+		return; /* nothing to do */
+
+	memset (config, 0, sizeof (*config));
+	config->host = NULL;
+	config->port = 0;
+	config->nthreads = 0;
+	config->batch = UDP_GATEWAY_MAX_BATCH;
+	config->rcvbuf = 0;
+
+	config->k = 4;
+	config->m = 12;
+	config->l = 128;
+	config->max_age = 30;
+	config->replay_bytes = 1 << 20;
+} /* udp_gateway_default_config */
+
+/* close the descriptors of a worker and free it */
+static void
+free_worker (UdpWorker *w)
+{
+	if (w->fd >= 0)
+		close (w->fd);
+	if (w->epoll_fd >= 0)
+		close (w->epoll_fd);
+	if (w->wake_fd >= 0)
+		close (w->wake_fd);
+
+	free (w->in_bufs);
+	free (w->out_bufs);
+	delete w;
+} /* free_worker */
+
+/* set up a worker bound to a port, a port of 0 is picked by the kernel */
+static UdpWorker *
+create_worker (PlutusUdpGateway *gw, uint16_t port)
+{
+	const UdpGatewayConfig *config = &gw->config;
+
+	UdpWorker *w = new UdpWorker ();
+	w->gw = gw;
+	w->fd = gateway_open_socket (config->host, port, SOCK_DGRAM, 0);
+	w->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+	w->wake_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+	w->in_bufs = (unsigned char *) malloc (config->batch * gw->in_len);
+	w->out_bufs = (unsigned char *) malloc (config->batch * gw->out_len);
+	if (w->fd < 0 || w->epoll_fd < 0 || w->wake_fd < 0 || !w->in_bufs || !w->out_bufs)
+	{
+		free_worker (w);
+		return NULL;
+	}
+
+	if (config->rcvbuf > 0)
+		setsockopt (w->fd, SOL_SOCKET, SO_RCVBUF, &config->rcvbuf, sizeof (config->rcvbuf));
+
+	/* the headers point at their buffers once and for all */
+	memset (w->in, 0, sizeof (w->in));
+	memset (w->out, 0, sizeof (w->out));
+	for (unsigned int j = 0; j < config->batch; j++)
+	{
+		w->in_iov[j].iov_base = w->in_bufs + j * gw->in_len;
+		w->in_iov[j].iov_len = gw->in_len;
+		w->in[j].msg_hdr.msg_iov = &w->in_iov[j];
+		w->in[j].msg_hdr.msg_iovlen = 1;
+		w->in[j].msg_hdr.msg_name = &w->peers[j];
+		w->out[j].msg_hdr.msg_iovlen = 1;
+	}
+
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.fd = w->fd;
+	epoll_ctl (w->epoll_fd, EPOLL_CTL_ADD, w->fd, &ev);
+	ev.data.fd = w->wake_fd;
+	epoll_ctl (w->epoll_fd, EPOLL_CTL_ADD, w->wake_fd, &ev);
+
+	return w;
+} /* create_worker */
+
+/* create_udp_gateway */
+PlutusUdpGateway *
+create_udp_gateway (const UdpGatewayConfig *config)
+{
+	if (!config || !config->key || config->max_age == 0
+			|| config->batch == 0 || config->batch > UDP_GATEWAY_MAX_BATCH)
+		return NULL;
+
+	PlutusUdpGateway *gw = new PlutusUdpGateway;
+	gw->config = *config;
+	gw->config.key = NULL;
+	gw->replay = NULL;
+
+	if (!(gw->keys = create_keyring (config->key, config->key_len,
+				config->k, config->m, config->l)))
+	{
+		fprintf (stderr, "[ERROR]: k = %u, m = %u, l = %u are not valid puzzle parameters!\n",
+				config->k, config->m, config->l);
+		delete gw;
+		return NULL;
+	}
+
+	/* a verdict is shorter than any challenge */
+	gw->challenge_len = WIRE_HEADER_LEN + config->l / 16;
+	gw->out_len = gw->challenge_len;
+	gw->in_len = WIRE_HEADER_LEN + (size_t) config->k * (config->l / 16);
+	if (gw->in_len < UDP_GATEWAY_MTU)
+		gw->in_len = UDP_GATEWAY_MTU;
+
+	if (config->replay_bytes > 0)
+		gw->replay = create_replay_cache (config->replay_bytes, config->max_age, NULL);
+
+	unsigned int nthreads = config->nthreads;
+	if (nthreads == 0)
+		nthreads = std::thread::hardware_concurrency ();
+	if (nthreads == 0)
+		nthreads = 1; /* could not tell, use one */
+	gw->config.nthreads = nthreads;
+
+	/* the first worker fixes the port the others share */
+	bool failed = (config->replay_bytes > 0 && !gw->replay);
+	gw->port = config->port;
+	for (unsigned int i = 0; i < nthreads && !failed; i++)
+	{
+		UdpWorker *w = create_worker (gw, gw->port);
+		if (!w)
+		{
+			perror ("[ERROR]: could not set up a datagram gateway worker");
+			failed = true;
+			break;
+		}
+		gw->workers.push_back (w);
+
+		if (i == 0)
+			gw->port = gateway_bound_port (w->fd);
+	}
+
+	if (failed)
+	{
+		for (UdpWorker *w : gw->workers)
+			free_worker (w);
+		free_replay_cache (gw->replay);
+		free_keyring (gw->keys);
+		delete gw;
+		return NULL;
+	}
+
+	for (UdpWorker *w : gw->workers)
+		w->thread = std::thread (worker_main, w);
+
+	return gw;
+} /* create_udp_gateway */
+
+/* free_udp_gateway */
+void
+free_udp_gateway (PlutusUdpGateway *gw)
+{
+	if (!gw)
+		return; /* nothing to do */
+
+	uint64_t one = 1;
+	for (UdpWorker *w : gw->workers)
+		if (write (w->wake_fd, &one, sizeof (one)) != sizeof (one))
+			perror ("[ERROR]: could not stop a datagram gateway worker");
+
+	for (UdpWorker *w : gw->workers)
+	{
+		w->thread.join ();
+		free_worker (w);
+	}
+
+	free_replay_cache (gw->replay);
+	free_keyring (gw->keys);
+	delete gw;
+} /* free_udp_gateway */
+
+/* udp_gateway_rotate_key */
+int64_t
+udp_gateway_rotate_key (PlutusUdpGateway *gw, const unsigned char *key, unsigned int key_len)
+{
+	if (!gw || !key)
+		return -1;
+
+	/* the second under way is still the old key's, it may have minted in it */
+	return keyring_rotate (gw->keys, key, key_len, (uint32_t) time (NULL) + 1);
+} /* udp_gateway_rotate_key */
+
+/* udp_gateway_port */
+uint16_t
+udp_gateway_port (const PlutusUdpGateway *gw)
+{
+	return gw? gw->port : 0;
+} /* udp_gateway_port */
+
+/* udp_gateway_stats */
+void
+udp_gateway_stats (const PlutusUdpGateway *gw, UdpGatewayStats *stats)
+{
+	if (!stats)
+		return; /* nothing to do */
+
+	memset (stats, 0, sizeof (*stats));
+	if (!gw)
+		return;
+
+	for (const UdpWorker *w : gw->workers)
+	{
+		const UdpCounters *c = &w->counters;
+		stats->received    += c->received.load (std::memory_order_relaxed);
+		stats->batches     += c->batches.load (std::memory_order_relaxed);
+		stats->minted      += c->minted.load (std::memory_order_relaxed);
+		stats->admitted    += c->admitted.load (std::memory_order_relaxed);
+		stats->rejected    += c->rejected.load (std::memory_order_relaxed);
+		stats->ignored     += c->ignored.load (std::memory_order_relaxed);
+		stats->send_failed += c->send_failed.load (std::memory_order_relaxed);
+	}
+} /* udp_gateway_stats */
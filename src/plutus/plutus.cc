@@ -0,0 +1,274 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  plutus.cc
+ *
+ *    Description:  Implementation of the C++ interface of the optimized puzzles,
+ *    				on top of the flat layouts, the minter and the wire format
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 06:58:02 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "plutus/plutus.h"
+#include "puzzle/crypto_util.h"
+#include "puzzle/metrics.h"
+#include "puzzle/wire.h"
+#include "client/optclient.h"
+
+#include <string.h>
+#include <utility>
+
+namespace plutus {
+
+/* the C policy of a verification */
+static inline SHA256OptVerifyParams
+native_policy (const Policy &policy)
+{
+	return { policy.now, policy.max_age, policy.replay };
+} /* native_policy */
+
+
+/*-----------------------------------------------------------------------------
+ *  Challenges
+ *-----------------------------------------------------------------------------*/
+
+/* Challenge::native */
+SHA256OptChallenge
+Challenge::native () const
+{
+	SHA256OptChallenge challenge;
+	challenge.timestamp = timestamp_;
+	challenge.num_subpuzzles = params_.k;
+	challenge.difficulty = params_.m;
+	challenge.len = 2 * params_.x_len ();
+
+	/* the C solvers only read the preimage */
+	challenge.preimage = const_cast<unsigned char *> (x_.data ());
+
+	return challenge;
+} /* Challenge::native */
+
+/* Challenge::encode */
+std::size_t
+Challenge::encode (mutable_bytes buf) const
+{
+	SHA256OptChallenge challenge = native ();
+	return encode_challenge (&challenge, buf.data (), buf.size ());
+} /* Challenge::encode */
+
+/* Challenge::decode */
+std::optional<Challenge>
+Challenge::decode (bytes pkt)
+{
+	WirePacket wire;
+	if (wire_parse (pkt.data (), pkt.size (), &wire) != WIRE_OK
+			|| wire.type != WIRE_OPT_CHALLENGE)
+		return std::nullopt;
+
+	Challenge challenge;
+	challenge.timestamp_ = wire.timestamp;
+	challenge.params_ = { wire.k, wire.m, 16u * wire.elem_len };
+	memcpy (challenge.x_.data (), wire.body, wire.elem_len);
+
+	return challenge;
+} /* Challenge::decode */
+
+
+/*-----------------------------------------------------------------------------
+ *  Solutions
+ *-----------------------------------------------------------------------------*/
+
+/* Solution::Solution */
+Solution::Solution (std::uint16_t k, std::uint16_t zlen)
+	: zi_ (new unsigned char[(std::size_t) k * zlen] ())
+{
+	view_.timestamp = 0;
+	view_.num_subsolutions = k;
+	view_.zlen = zlen;
+	view_.zi = zi_.get ();
+} /* Solution::Solution */
+
+/* Solution::Solution */
+Solution::Solution (Solution &&other) noexcept
+	: zi_ (std::move (other.zi_)), view_ (other.view_)
+{
+	other.view_ = {};
+} /* Solution::Solution */
+
+/* Solution::operator= */
+Solution &
+Solution::operator= (Solution &&other) noexcept
+{
+	zi_ = std::move (other.zi_);
+	view_ = other.view_;
+	other.view_ = {};
+
+	return *this;
+} /* Solution::operator= */
+
+/* Solution::encode */
+std::size_t
+Solution::encode (mutable_bytes buf) const
+{
+	return encode_solution (&view_, buf.data (), buf.size ());
+} /* Solution::encode */
+
+/* Solution::decode */
+std::optional<Solution>
+Solution::decode (bytes pkt)
+{
+	WirePacket wire;
+	SHA256OptFlatSolution view;
+	if (wire_parse (pkt.data (), pkt.size (), &wire) != WIRE_OK
+			|| wire_view_optsolution (&wire, &view) != 0)
+		return std::nullopt;
+
+	/* one copy of the body, laid out the same way */
+	Solution sol (view.num_subsolutions, view.zlen);
+	sol.view_.timestamp = view.timestamp;
+	memcpy (sol.zi_.get (), view.zi, (std::size_t) view.num_subsolutions * view.zlen);
+
+	return sol;
+} /* Solution::decode */
+
+/* solve_into */
+bool
+solve_into (const Challenge &challenge, Solution &sol)
+{
+	const Params &params = challenge.params ();
+	if (!sol.zi_ || sol.k () != params.k || sol.zlen () != params.x_len ())
+		return false;
+
+	SHA256OptChallenge native = challenge.native ();
+	return solveChallengeFlat (&native, &sol.view_) == 0;
+} /* solve_into */
+
+/* solve */
+std::optional<Solution>
+solve (const Challenge &challenge)
+{
+	const Params &params = challenge.params ();
+	Solution sol (params.k, params.x_len ());
+
+	if (!solve_into (challenge, sol))
+		return std::nullopt;
+
+	return sol;
+} /* solve */
+
+
+/*-----------------------------------------------------------------------------
+ *  Replay caches and minters
+ *-----------------------------------------------------------------------------*/
+
+/* ReplayCache::create */
+std::optional<ReplayCache>
+ReplayCache::create (std::size_t max_bytes, std::uint32_t window, const char *shm_name)
+{
+	SHA256OptReplayCache *cache = create_replay_cache (max_bytes, window, shm_name);
+	if (!cache)
+		return std::nullopt;
+
+	return ReplayCache (cache);
+} /* ReplayCache::create */
+
+/* Minter::create */
+std::optional<Minter>
+Minter::create (bytes key, const Params &params, std::uint32_t epoch)
+{
+	Minter minter;
+	if (init_minter (&minter.minter_, key.data (), key.size (), epoch,
+				params.k, params.m, params.l) != 0)
+		return std::nullopt;
+
+	minter.live_ = true;
+	return minter;
+} /* Minter::create */
+
+/* Minter::Minter */
+Minter::Minter (Minter &&other) noexcept
+	: minter_ (other.minter_), live_ (other.live_)
+{
+	/* only one copy of the key state survives a move */
+	clear_minter (&other.minter_);
+	other.live_ = false;
+} /* Minter::Minter */
+
+/* Minter::operator= */
+Minter &
+Minter::operator= (Minter &&other) noexcept
+{
+	if (this != &other)
+	{
+		clear_minter (&minter_);
+		minter_ = other.minter_;
+		live_ = other.live_;
+
+		clear_minter (&other.minter_);
+		other.live_ = false;
+	}
+
+	return *this;
+} /* Minter::operator= */
+
+/* Minter::~Minter */
+Minter::~Minter ()
+{
+	if (live_)
+		clear_minter (&minter_);
+} /* Minter::~Minter */
+
+/* Minter::mint */
+Challenge
+Minter::mint (bytes data, std::uint32_t timestamp) const
+{
+	uint64_t start = metrics_now ();
+
+	Challenge challenge;
+	challenge.timestamp_ = timestamp;
+	challenge.params_ = params ();
+	minter_derive (&minter_, data.data (), data.size (), timestamp, challenge.x_.data ());
+
+	metrics_add (METRIC_CHALLENGES_MINTED, 1);
+	metrics_add (METRIC_HASHES, 1);
+	metrics_observe (METRIC_LAT_GENERATE_CHALLENGE, start);
+
+	return challenge;
+} /* Minter::mint */
+
+/* Minter::mint_packet */
+std::size_t
+Minter::mint_packet (bytes data, std::uint32_t timestamp, mutable_bytes pkt) const
+{
+	SHA256OptPacketItem item = { pkt.data (), pkt.size (), data.data (),
+		(unsigned int) data.size () };
+
+	return minter_mint_packets (&minter_, &item, 1, timestamp) == 1 ? item.pkt_len : 0;
+} /* Minter::mint_packet */
+
+/* Minter::verify */
+Status
+Minter::verify (const Solution &sol, bytes data, const Policy &policy) const
+{
+	SHA256OptVerifyParams params = native_policy (policy);
+	return minter_verify_flat (&minter_, &sol.native (), data.data (), data.size (), &params);
+} /* Minter::verify */
+
+/* Minter::verify_packet */
+Status
+Minter::verify_packet (bytes pkt, bytes data, const Policy &policy) const
+{
+	SHA256OptVerifyParams params = native_policy (policy);
+	return minter_verify_packet (&minter_, pkt.data (), pkt.size (),
+			data.data (), data.size (), &params);
+} /* Minter::verify_packet */
+
+} /* namespace plutus */
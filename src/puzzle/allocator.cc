@@ -0,0 +1,475 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  allocator.cc
+ *
+ *    Description:  Implementation of the slab pool and arena allocators
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 06:40:13 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/allocator.h"
+
+#include <mutex>
+#include <string.h>
+
+#define SLAB_SIZE 			65536	/* The size and alignment of a slab */
+#define SLAB_HEADER_SIZE 	64		/* The blocks start after a cache line */
+#define POOL_NUM_CLASSES 	5		/* Blocks of 16, 32, 64, 128 and 256 bytes */
+#define POOL_MIN_BLOCK 		16
+#define POOL_MAX_FREE 		(2 * SLAB_SIZE)	/* The released bytes a thread keeps of a class */
+
+#define ARENA_DEFAULT_CHUNK 4096
+#define ARENA_ALIGN 		16
+
+static void *pool_alloc (void *, size_t size);
+static void pool_release (void *, void *ptr);
+
+/*-----------------------------------------------------------------------------
+ *  malloc
+ *-----------------------------------------------------------------------------*/
+
+static void *
+malloc_alloc (void *, size_t size)
+{
+	return malloc (size);
+} /* malloc_alloc */
+
+static void
+malloc_release (void *, void *ptr)
+{
+	free (ptr);
+} /* malloc_release */
+
+static const PuzzleAllocator malloc_alloc_instance = { malloc_alloc, malloc_release, NULL };
+
+/* malloc_allocator */
+const PuzzleAllocator *
+malloc_allocator ()
+{
+	return &malloc_alloc_instance;
+} /* malloc_allocator */
+
+
+/*-----------------------------------------------------------------------------
+ *  Slab pool
+ *-----------------------------------------------------------------------------*/
+
+/* The header at the start of every slab, blocks find it by masking their
+ * address. Blocks larger than the largest class get a slab of their own
+ * with a block size of 0. */
+typedef struct {
+	uint32_t block_size;	/* The size of the blocks in the slab */
+} slab_header_t;
+
+/* A free block, the link is stored in the block itself */
+typedef struct free_block {
+	struct free_block *next;
+} free_block_t;
+
+/* The free lists of a thread. This is trivially destructible so that it
+ * can still be used after the reaper below ran. It uses the initial exec
+ * TLS model like the malloc replacements do, so reaching it from the
+ * shared library does not cost a call to __tls_get_addr. */
+typedef struct {
+	free_block_t *free[POOL_NUM_CLASSES];	/* The released blocks */
+	size_t nfree[POOL_NUM_CLASSES];			/* The number of blocks in free */
+	char *bump[POOL_NUM_CLASSES];			/* The untouched part of the last slab */
+	char *bump_end[POOL_NUM_CLASSES];
+	bool registered;						/* The reaper of the thread is set up */
+	bool exiting;							/* The thread handed its lists over */
+} thread_pool_t;
+
+static thread_local thread_pool_t thread_pool
+	__attribute__ ((tls_model ("initial-exec")));
+
+/* The free lists left behind by threads that exited, or that released
+ * more than they keep */
+static std::mutex orphan_lock;
+static free_block_t *orphans[POOL_NUM_CLASSES];
+static size_t orphan_count[POOL_NUM_CLASSES];
+
+/* get the size class of a block size, POOL_NUM_CLASSES if too large */
+static inline unsigned int
+size_class (size_t size)
+{
+	if (size <= POOL_MIN_BLOCK)
+		return 0;
+
+	/* log2 of the next power of two, relative to the smallest block */
+	unsigned int c = 64 - __builtin_clzll ((unsigned long long) size - 1) - 4;
+	return c < POOL_NUM_CLASSES ? c : POOL_NUM_CLASSES;
+} /* size_class */
+
+/* give a free list to the orphans */
+static void
+adopt_orphans (unsigned int c, free_block_t *head)
+{
+	if (!head)
+		return;
+
+	size_t count = 1;
+	free_block_t *tail = head;
+	while (tail->next)
+	{
+		tail = tail->next;
+		count++;
+	}
+
+	std::lock_guard<std::mutex> lock (orphan_lock);
+	tail->next = orphans[c];
+	orphans[c] = head;
+	orphan_count[c] += count;
+} /* adopt_orphans */
+
+/* hands the free lists of an exiting thread over to the orphans */
+typedef struct thread_pool_reaper {
+	~thread_pool_reaper ()
+	{
+		thread_pool_t *pool = &thread_pool;
+
+		for (unsigned int c = 0; c < POOL_NUM_CLASSES; c++)
+		{
+			size_t block = (size_t) POOL_MIN_BLOCK << c;
+
+			/* the rest of the last slab goes too */
+			while (pool->bump[c] && pool->bump[c] + block <= pool->bump_end[c])
+			{
+				free_block_t *b = (free_block_t *) pool->bump[c];
+				b->next = pool->free[c];
+				pool->free[c] = b;
+				pool->bump[c] += block;
+			}
+
+			adopt_orphans (c, pool->free[c]);
+			pool->free[c] = NULL;
+			pool->nfree[c] = 0;
+			pool->bump[c] = pool->bump_end[c] = NULL;
+		}
+
+		pool->exiting = true;
+	}
+} thread_pool_reaper;
+
+static thread_local thread_pool_reaper thread_reaper;
+
+/* get the lists of the calling thread, making sure they are handed over
+ * when it exits */
+static inline thread_pool_t *
+get_thread_pool ()
+{
+	thread_pool_t *pool = &thread_pool;
+
+	if (__builtin_expect (!pool->registered, 0))
+	{ /* the first touch constructs the reaper */
+		(void) &thread_reaper;
+		pool->registered = true;
+	}
+
+	return pool;
+} /* get_thread_pool */
+
+/* get a new slab of blocks of a given size */
+static slab_header_t *
+new_slab (size_t size, uint32_t block_size)
+{
+	size = (size + SLAB_SIZE - 1) & ~((size_t) SLAB_SIZE - 1);
+
+	slab_header_t *slab = (slab_header_t *) aligned_alloc (SLAB_SIZE, size);
+	if (slab)
+		slab->block_size = block_size;
+
+	return slab;
+} /* new_slab */
+
+static void *
+pool_alloc (void *, size_t size)
+{
+	unsigned int c = size_class (size);
+
+	if (c == POOL_NUM_CLASSES)
+	{ /* too large, on a slab of its own */
+		slab_header_t *slab = new_slab (SLAB_HEADER_SIZE + size, 0);
+		return slab ? (char *) slab + SLAB_HEADER_SIZE : NULL;
+	}
+
+	thread_pool_t *pool = get_thread_pool ();
+
+	size_t block = (size_t) POOL_MIN_BLOCK << c;
+
+	if (!pool->free[c] && !(pool->bump[c] && pool->bump[c] + block <= pool->bump_end[c]))
+	{ /* nothing left, try the orphans before a new slab */
+		{
+			std::lock_guard<std::mutex> lock (orphan_lock);
+			pool->free[c] = orphans[c];
+			pool->nfree[c] = orphan_count[c];
+			orphans[c] = NULL;
+			orphan_count[c] = 0;
+		}
+
+		if (!pool->free[c])
+		{
+			slab_header_t *slab = new_slab (SLAB_SIZE, block);
+			if (!slab)
+				return NULL;
+
+			pool->bump[c] = (char *) slab + SLAB_HEADER_SIZE;
+			pool->bump_end[c] = (char *) slab + SLAB_SIZE;
+		}
+	}
+
+	if (pool->free[c])
+	{
+		free_block_t *b = pool->free[c];
+		pool->free[c] = b->next;
+		pool->nfree[c]--;
+		return b;
+	}
+
+	void *b = pool->bump[c];
+	pool->bump[c] += block;
+	return b;
+} /* pool_alloc */
+
+static void
+pool_release (void *, void *ptr)
+{
+	slab_header_t *slab = (slab_header_t *)
+		((uintptr_t) ptr & ~((uintptr_t) SLAB_SIZE - 1));
+
+	if (slab->block_size == 0)
+	{ /* a large block */
+		free (slab);
+		return;
+	}
+
+	unsigned int c = size_class (slab->block_size);
+	free_block_t *b = (free_block_t *) ptr;
+	b->next = NULL;
+
+	thread_pool_t *pool = get_thread_pool ();
+	if (pool->exiting)
+	{ /* too late for this thread's lists */
+		adopt_orphans (c, b);
+		return;
+	}
+
+	b->next = pool->free[c];
+	pool->free[c] = b;
+
+	/* a thread that releases what another one allocates would keep it
+	 * all, keep half of the most and give the rest to the orphans, where
+	 * the allocating thread looks before carving a new slab */
+	size_t keep = POOL_MAX_FREE / slab->block_size;
+	if (++pool->nfree[c] > keep)
+	{
+		free_block_t *last = pool->free[c];
+		for (size_t j = 1; j < keep / 2; j++)
+			last = last->next;
+
+		adopt_orphans (c, last->next);
+		last->next = NULL;
+		pool->nfree[c] = keep / 2;
+	}
+} /* pool_release */
+
+static const PuzzleAllocator pool_alloc_instance = { pool_alloc, pool_release, NULL };
+
+/* pool_allocator */
+const PuzzleAllocator *
+pool_allocator ()
+{
+	return &pool_alloc_instance;
+} /* pool_allocator */
+
+
+/*-----------------------------------------------------------------------------
+ *  Arena
+ *-----------------------------------------------------------------------------*/
+
+/* A chunk of an arena, the memory follows the header */
+typedef struct arena_chunk {
+	struct arena_chunk *next;	/* The next chunk in the arena */
+	size_t size;				/* The usable size of the chunk */
+	size_t used;				/* The number of bytes handed out */
+} arena_chunk_t;
+
+struct PuzzleArena {
+	PuzzleAllocator allocator;	/* The allocator handed out for this arena */
+	size_t chunk_size;			/* The usable size of a regular chunk */
+
+	arena_chunk_t *head;		/* The first chunk */
+	arena_chunk_t *cur;			/* The chunk being carved */
+};
+
+/* The chunk header rounded up to keep the data aligned */
+#define CHUNK_HEADER_SIZE 	((sizeof (arena_chunk_t) + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1))
+#define CHUNK_DATA(c) 		((char *) (c) + CHUNK_HEADER_SIZE)
+
+/* allocate a chunk with at least size usable bytes */
+static arena_chunk_t *
+new_chunk (size_t size)
+{
+	arena_chunk_t *chunk = (arena_chunk_t *)
+		malloc (CHUNK_HEADER_SIZE + size);
+	if (!chunk)
+		return NULL;
+
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+
+	return chunk;
+} /* new_chunk */
+
+static void *
+arena_alloc (void *ctx, size_t size)
+{
+	PuzzleArena *arena = (PuzzleArena *) ctx;
+	size = (size + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+
+	/* move along the kept chunks until one fits */
+	while (arena->cur->used + size > arena->cur->size)
+	{
+		arena_chunk_t *next = arena->cur->next;
+
+		if (!next || next->size < size)
+		{ /* add a chunk after the current one */
+			arena_chunk_t *chunk = new_chunk (size > arena->chunk_size ?
+					size : arena->chunk_size);
+			if (!chunk)
+				return NULL;
+
+			chunk->next = next;
+			arena->cur->next = chunk;
+			next = chunk;
+		}
+
+		arena->cur = next;
+	}
+
+	void *ptr = CHUNK_DATA (arena->cur) + arena->cur->used;
+	arena->cur->used += size;
+
+	return ptr;
+} /* arena_alloc */
+
+static void
+arena_release (void *, void *)
+{
+	/* everything goes at once in reset_arena or free_arena */
+} /* arena_release */
+
+/* create_arena */
+PuzzleArena *
+create_arena (size_t chunk_size)
+{
+	if (chunk_size == 0)
+		chunk_size = ARENA_DEFAULT_CHUNK;
+
+	PuzzleArena *arena = (PuzzleArena *) malloc (sizeof (PuzzleArena));
+	if (!arena)
+		return NULL;
+
+	arena->head = new_chunk (chunk_size);
+	if (!arena->head)
+	{
+		free (arena);
+		return NULL;
+	}
+
+	arena->allocator.alloc   = arena_alloc;
+	arena->allocator.release = arena_release;
+	arena->allocator.ctx     = arena;
+	arena->chunk_size = chunk_size;
+	arena->cur = arena->head;
+
+	return arena;
+} /* create_arena */
+
+/* arena_allocator */
+const PuzzleAllocator *
+arena_allocator (PuzzleArena *arena)
+{
+	return arena ? &arena->allocator : NULL;
+} /* arena_allocator */
+
+/* reset_arena */
+void
+reset_arena (PuzzleArena *arena)
+{
+	if (!arena)
+		return; /* nothing to do */
+
+	for (arena_chunk_t *chunk = arena->head; chunk; chunk = chunk->next)
+		chunk->used = 0;
+
+	arena->cur = arena->head;
+} /* reset_arena */
+
+/* free_arena */
+void
+free_arena (PuzzleArena *arena)
+{
+	if (!arena)
+		return; /* nothing to do */
+
+	arena_chunk_t *chunk = arena->head;
+	while (chunk)
+	{
+		arena_chunk_t *next = chunk->next;
+		free (chunk);
+		chunk = next;
+	}
+
+	free (arena);
+} /* free_arena */
+
+
+/*-----------------------------------------------------------------------------
+ *  Allocating through an allocator
+ *-----------------------------------------------------------------------------*/
+
+/* puzzle_alloc */
+void *
+puzzle_alloc (const PuzzleAllocator *allocator, size_t size)
+{
+	if (!allocator)
+		return malloc (size);
+
+	/* the pool is the hot one, skip the indirect call */
+	if (allocator == &pool_alloc_instance)
+		return pool_alloc (NULL, size);
+
+	return allocator->alloc (allocator->ctx, size);
+} /* puzzle_alloc */
+
+/* puzzle_release */
+void
+puzzle_release (const PuzzleAllocator *allocator, void *ptr)
+{
+	if (!ptr)
+		return; /* nothing to do */
+
+	if (!allocator)
+	{
+		free (ptr);
+		return;
+	}
+
+	if (allocator == &pool_alloc_instance)
+	{
+		pool_release (NULL, ptr);
+		return;
+	}
+
+	allocator->release (allocator->ctx, ptr);
+} /* puzzle_release */
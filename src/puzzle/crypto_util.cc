@@ -17,58 +17,138 @@
  */
 
 #include "puzzle/crypto_util.h"
+#include "puzzle/sha256.h"
 #include <string.h>
 #include <math.h>
 
-/* digest_message */
-unsigned char *
-digest_message (const unsigned char *message, size_t message_len,
-        unsigned int *digest_len)
-{
+/* The backend of digest_message, switched to SHA-NI at load time whenever
+ * the CPU has it */
+static hash_backend_t active_backend = HASH_BACKEND_EVP;
+static int backend_startup = set_hash_backend (HASH_BACKEND_SHANI);
+
+/* A digest context kept per thread and reused by every EVP digest */
+typedef struct thread_digest_ctx {
     EVP_MD_CTX *mdctx;
 
-    /* create a message digest context */
-    mdctx = EVP_MD_CTX_create();
-    if (mdctx == NULL) {
-        printf ("[ERROR]: Failed to create digest context!\n");
-        return NULL;
+    thread_digest_ctx () : mdctx (NULL) {}
+    ~thread_digest_ctx () { if (mdctx) EVP_MD_CTX_destroy (mdctx); }
+} thread_digest_ctx;
+
+static thread_local thread_digest_ctx thread_ctx;
+
+/* digest_message_into */
+int
+digest_message_into (const unsigned char *message, size_t message_len,
+        unsigned char *digest)
+{
+    if (! digest || (! message && message_len > 0))
+        return -1; /* nothing to do */
+
+    if (active_backend == HASH_BACKEND_SHANI) {
+        /* skip the EVP dispatch and hash directly */
+        sha256_digest (message, message_len, digest);
+        return 0;
     }
 
-    /* initialize the digest context */
+    /* create the message digest context of this thread on first use */
+    if (thread_ctx.mdctx == NULL) {
+        thread_ctx.mdctx = EVP_MD_CTX_create();
+        if (thread_ctx.mdctx == NULL) {
+            printf ("[ERROR]: Failed to create digest context!\n");
+            return -1;
+        }
+    }
+
+    EVP_MD_CTX *mdctx = thread_ctx.mdctx;
+
+    /* (re)initialize the digest context */
     int err = EVP_DigestInit_ex (mdctx, EVP_sha256(), NULL);
     if (err != 1) {
         printf ("[ERROR]: Failed to initialized digest context!\n");
-        return NULL;
+        return -1;
     }
 
     /* update the digest context with the message */
     err = EVP_DigestUpdate (mdctx, message, message_len);
     if (err != 1) {
         printf ("[ERROR]: Failed to update digest context!\n");
-        return NULL;
+        return -1;
     }
 
+    /* finalize the operation */
+    unsigned int digest_len;
+    err = EVP_DigestFinal_ex (mdctx, digest, &digest_len);
+    if (err != 1) {
+        printf ("[ERROR]: Failed to perform sha256 digest!\n");
+        return -1;
+    }
+
+    return 0;
+} /* digest_message_into */
+
+/* digest_message */
+unsigned char *
+digest_message (const unsigned char *message, size_t message_len,
+        unsigned int *digest_len)
+{
     /* allocate the digest  */
     unsigned char *digest = (unsigned char *)
-        OPENSSL_malloc (EVP_MD_size(EVP_sha256()));
+        OPENSSL_malloc (SHA256_DIGEST_LEN);
     if (! digest) {
         printf ("[ERROR]: Failed to allocate digest!\n");
         return NULL;
     }
 
-    /* finalize the operation */
-    err = EVP_DigestFinal_ex (mdctx, digest, digest_len);
-    if (err != 1) {
-        printf ("[ERROR]: Failed to perform sha256 digest!\n");
+    if (digest_message_into (message, message_len, digest) != 0) {
+        OPENSSL_free (digest);
         return NULL;
     }
 
-    /* done. destory the context */
-    EVP_MD_CTX_destroy (mdctx);
-
+    if (digest_len)
+        *digest_len = SHA256_DIGEST_LEN;
     return digest;
 }
 
+/* get_hash_backend */
+hash_backend_t
+get_hash_backend ()
+{
+	return active_backend;
+} /* get_hash_backend */
+
+/* set_hash_backend */
+int
+set_hash_backend (hash_backend_t backend)
+{
+	if (backend == HASH_BACKEND_SHANI)
+	{
+		/* make sure the compression function runs on the extensions */
+		if (sha256_set_shani (true) != 0)
+			return -1;
+	} else if (backend != HASH_BACKEND_EVP)
+	{
+		return -1; /* unknown backend */
+	}
+
+	active_backend = backend;
+	return 0;
+} /* set_hash_backend */
+
+/* hash_backend_name */
+const char *
+hash_backend_name (hash_backend_t backend)
+{
+	switch (backend)
+	{
+		case HASH_BACKEND_EVP:
+			return "evp";
+		case HASH_BACKEND_SHANI:
+			return "sha-ni";
+		default:
+			return "unknown";
+	}
+} /* hash_backend_name */
+
 /* print a digest */
 void
 print_digest (unsigned char *digest, unsigned int len)
@@ -119,7 +199,7 @@ append_buffer (unsigned char *dest, unsigned char *src, size_t n)
 
 /* compare_bits */
 bool
-compare_bits (unsigned char *x, unsigned char *y, unsigned int len)
+compare_bits (const unsigned char *x, const unsigned char *y, unsigned int len)
 {
 	/* sanity checks */
 	if (!x || !y)
@@ -54,8 +54,53 @@ SHA256OptSolution *create_optsolution ()
 	return solution;
 }
 
+/* create_optsubsolution */
 SHA256OptSubSolution *create_optsubsolution ()
 {
 	SHA256OptSubSolution *subsol = 
 		(SHA256OptSubSolution *) malloc ( sizeof (SHA256OptSubSolution) );
+
+	return subsol;
+}
+
+/* createSubPuzzle */
+SHA256SubPuzzle *createSubPuzzle (const PuzzleAllocator *allocator)
+{
+	return (SHA256SubPuzzle *) puzzle_alloc (allocator, sizeof (SHA256SubPuzzle));
+}
+
+/* createChallenge */
+SHA256Challenge *createChallenge (const PuzzleAllocator *allocator)
+{
+	return (SHA256Challenge *) puzzle_alloc (allocator, sizeof (SHA256Challenge));
+}
+
+/* createSubSolution */
+SHA256SubSolution *createSubSolution (const PuzzleAllocator *allocator)
+{
+	return (SHA256SubSolution *) puzzle_alloc (allocator, sizeof (SHA256SubSolution));
+}
+
+/* createSolution */
+SHA256Solution *createSolution (const PuzzleAllocator *allocator)
+{
+	return (SHA256Solution *) puzzle_alloc (allocator, sizeof (SHA256Solution));
+}
+
+/* create_optchallenge */
+SHA256OptChallenge *create_optchallenge (const PuzzleAllocator *allocator)
+{
+	return (SHA256OptChallenge *) puzzle_alloc (allocator, sizeof (SHA256OptChallenge));
 }
+
+/* create_optsolution */
+SHA256OptSolution *create_optsolution (const PuzzleAllocator *allocator)
+{
+	return (SHA256OptSolution *) puzzle_alloc (allocator, sizeof (SHA256OptSolution));
+}
+
+/* create_optsubsolution */
+SHA256OptSubSolution *create_optsubsolution (const PuzzleAllocator *allocator)
+{
+	return (SHA256OptSubSolution *) puzzle_alloc (allocator, sizeof (SHA256OptSubSolution));
+} /* create_optsubsolution */
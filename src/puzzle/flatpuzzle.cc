@@ -0,0 +1,308 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  flatpuzzle.cc
+ *
+ *    Description:  Implementation of the contiguous challenge and solution layouts
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 05:58:32 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/flatpuzzle.h"
+#include "puzzle/factory.h"
+
+#include <openssl/evp.h>
+#include <string.h>
+
+/* copy a buffer into a new OPENSSL_malloc'd one, like the list nodes expect */
+static unsigned char *
+dup_openssl (const unsigned char *src, size_t n)
+{
+	unsigned char *dst = (unsigned char *) OPENSSL_malloc (n);
+	if (dst)
+		memcpy (dst, src, n);
+
+	return dst;
+} /* dup_openssl */
+
+/* create_flatchallenge */
+SHA256FlatChallenge *
+create_flatchallenge (uint16_t k)
+{
+	/* the struct and both arrays in one go */
+	size_t arr = (size_t) k * SHA256_DIGEST_LEN;
+	SHA256FlatChallenge *challenge = (SHA256FlatChallenge *)
+		calloc (1, sizeof (SHA256FlatChallenge) + 2 * arr);
+	if (!challenge)
+		return NULL;
+
+	challenge->num_subpuzzles = k;
+	challenge->preimages = (unsigned char *) (challenge + 1);
+	challenge->images    = challenge->preimages + arr;
+
+	return challenge;
+} /* create_flatchallenge */
+
+/* create_flatsolution */
+SHA256FlatSolution *
+create_flatsolution (uint16_t k)
+{
+	SHA256FlatSolution *sol = (SHA256FlatSolution *)
+		calloc (1, sizeof (SHA256FlatSolution) + (size_t) k * SHA256_DIGEST_LEN);
+	if (!sol)
+		return NULL;
+
+	sol->num_subsolutions = k;
+	sol->solutions = (unsigned char *) (sol + 1);
+
+	return sol;
+} /* create_flatsolution */
+
+/* create_optflatsolution */
+SHA256OptFlatSolution *
+create_optflatsolution (uint16_t k, uint16_t zlen)
+{
+	SHA256OptFlatSolution *sol = (SHA256OptFlatSolution *)
+		calloc (1, sizeof (SHA256OptFlatSolution) + (size_t) k * zlen);
+	if (!sol)
+		return NULL;
+
+	sol->num_subsolutions = k;
+	sol->zlen = zlen;
+	sol->zi = (unsigned char *) (sol + 1);
+
+	return sol;
+} /* create_optflatsolution */
+
+/* free_flatchallenge */
+void
+free_flatchallenge (SHA256FlatChallenge *challenge)
+{
+	free (challenge);
+} /* free_flatchallenge */
+
+/* free_flatsolution */
+void
+free_flatsolution (SHA256FlatSolution *sol)
+{
+	free (sol);
+} /* free_flatsolution */
+
+/* free_optflatsolution */
+void
+free_optflatsolution (SHA256OptFlatSolution *sol)
+{
+	free (sol);
+} /* free_optflatsolution */
+
+/* flatten_challenge */
+SHA256FlatChallenge *
+flatten_challenge (const SHA256Challenge *challenge)
+{
+	if (!challenge)
+		return NULL; /* nothing to do */
+
+	SHA256FlatChallenge *flat = create_flatchallenge (challenge->num_subpuzzles);
+	if (!flat)
+		return NULL;
+
+	flat->timestamp  = challenge->timestamp;
+	flat->difficulty = challenge->difficulty;
+
+	SHA256SubPuzzle *item = challenge->puzzle;
+	for (unsigned int i = 0; i < flat->num_subpuzzles && item; i++)
+	{
+		if (item->preimage)
+			memcpy (flat_preimage (flat, i), item->preimage, SHA256_DIGEST_LEN);
+		if (item->image)
+			memcpy (flat_image (flat, i), item->image, SHA256_DIGEST_LEN);
+
+		item = item->next;
+	}
+
+	return flat;
+} /* flatten_challenge */
+
+/* unflatten_challenge */
+SHA256Challenge *
+unflatten_challenge (const SHA256FlatChallenge *flat)
+{
+	if (!flat)
+		return NULL; /* nothing to do */
+
+	SHA256Challenge *challenge = createChallenge ();
+	if (!challenge)
+		return NULL;
+	initChallenge (challenge, flat->timestamp, flat->num_subpuzzles,
+			flat->difficulty, NULL);
+
+	/* keep the tail around instead of walking the list on every insert */
+	SHA256SubPuzzle *tail = NULL;
+	for (unsigned int i = 0; i < flat->num_subpuzzles; i++)
+	{
+		SHA256SubPuzzle *item = createSubPuzzle ();
+		if (!item)
+		{
+			free_challenge_mem (challenge);
+			free (challenge);
+			return NULL;
+		}
+
+		initSubPuzzle (item,
+				dup_openssl (flat->preimages + i * SHA256_DIGEST_LEN, SHA256_DIGEST_LEN),
+				dup_openssl (flat->images + i * SHA256_DIGEST_LEN, SHA256_DIGEST_LEN));
+
+		if (tail)
+			tail->next = item;
+		else
+			challenge->puzzle = item;
+		tail = item;
+	}
+
+	return challenge;
+} /* unflatten_challenge */
+
+/* flatten_solution */
+SHA256FlatSolution *
+flatten_solution (const SHA256Solution *sol, uint16_t k)
+{
+	if (!sol)
+		return NULL; /* nothing to do */
+
+	SHA256FlatSolution *flat = create_flatsolution (k);
+	if (!flat)
+		return NULL;
+
+	flat->timestamp = sol->timestamp;
+
+	SHA256SubSolution *item = sol->solution;
+	for (unsigned int i = 0; i < k; i++)
+	{
+		if (!item)
+		{ /* the list is too short */
+			free_flatsolution (flat);
+			return NULL;
+		}
+
+		if (item->solution)
+			memcpy (flat_solution (flat, i), item->solution, SHA256_DIGEST_LEN);
+
+		item = item->next;
+	}
+
+	return flat;
+} /* flatten_solution */
+
+/* unflatten_solution */
+SHA256Solution *
+unflatten_solution (const SHA256FlatSolution *flat)
+{
+	if (!flat)
+		return NULL; /* nothing to do */
+
+	SHA256Solution *sol = createSolution ();
+	if (!sol)
+		return NULL;
+	initSolution (sol, flat->timestamp, NULL);
+
+	SHA256SubSolution *tail = NULL;
+	for (unsigned int i = 0; i < flat->num_subsolutions; i++)
+	{
+		SHA256SubSolution *item = createSubSolution ();
+		if (!item)
+		{
+			free_solution_mem (sol);
+			free (sol);
+			return NULL;
+		}
+
+		initSubSolution (item);
+		item->solution = dup_openssl (flat->solutions + i * SHA256_DIGEST_LEN,
+				SHA256_DIGEST_LEN);
+
+		if (tail)
+			tail->next = item;
+		else
+			sol->solution = item;
+		tail = item;
+	}
+
+	return sol;
+} /* unflatten_solution */
+
+/* flatten_optsolution */
+SHA256OptFlatSolution *
+flatten_optsolution (const SHA256OptSolution *sol, uint16_t len, uint16_t k)
+{
+	if (!sol)
+		return NULL; /* nothing to do */
+
+	/* z_i is the (l/2) bits after x */
+	uint16_t zlen = len / 16;
+
+	SHA256OptFlatSolution *flat = create_optflatsolution (k, zlen);
+	if (!flat)
+		return NULL;
+
+	flat->timestamp = sol->timestamp;
+
+	SHA256OptSubSolution *item = sol->head;
+	for (unsigned int i = 0; i < k; i++)
+	{
+		if (!item)
+		{ /* the list is too short */
+			free_optflatsolution (flat);
+			return NULL;
+		}
+
+		if (item->zi)
+			memcpy (flat_zi (flat, i), item->zi, zlen);
+
+		item = item->next;
+	}
+
+	return flat;
+} /* flatten_optsolution */
+
+/* unflatten_optsolution */
+SHA256OptSolution *
+unflatten_optsolution (const SHA256OptFlatSolution *flat)
+{
+	if (!flat)
+		return NULL; /* nothing to do */
+
+	SHA256OptSolution *sol = create_optsolution ();
+	if (!sol)
+		return NULL;
+	initOptSolution (sol, flat->timestamp, NULL);
+
+	SHA256OptSubSolution *tail = NULL;
+	for (unsigned int i = 0; i < flat->num_subsolutions; i++)
+	{
+		SHA256OptSubSolution *item = create_optsubsolution ();
+		if (!item)
+		{
+			free_solution_mem (sol);
+			return NULL;
+		}
+
+		initOptSubSolution (item,
+				dup_openssl (flat->zi + i * flat->zlen, flat->zlen), NULL);
+
+		if (tail)
+			tail->next = item;
+		else
+			sol->head = item;
+		tail = item;
+	}
+
+	return sol;
+} /* unflatten_optsolution */
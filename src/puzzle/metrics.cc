@@ -0,0 +1,285 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  metrics.cc
+ *
+ *    Description:  Registration, snapshots and the Prometheus text dump of the
+ *    				per-thread metrics
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 09:20:51 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/metrics.h"
+
+#include <mutex>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The Prometheus family and label of each counter */
+static const struct {
+	const char *family;
+	const char *label;
+} counter_names[METRIC_NUM_COUNTERS] = {
+	{ "plutus_challenges_minted_total", NULL },
+	{ "plutus_puzzles_generated_total", NULL },
+	{ "plutus_verifications_total", "result=\"ok\"" },
+	{ "plutus_verifications_total", "result=\"empty\"" },
+	{ "plutus_verifications_total", "result=\"short\"" },
+	{ "plutus_verifications_total", "result=\"stale\"" },
+	{ "plutus_verifications_total", "result=\"bad_params\"" },
+	{ "plutus_verifications_total", "result=\"failed\"" },
+	{ "plutus_verifications_total", "result=\"replay\"" },
+	{ "plutus_verifications_total", "result=\"malformed\"" },
+	{ "plutus_verifications_total", "result=\"shed\"" },
+	{ "plutus_replay_cache_full_total", NULL },
+	{ "plutus_hashes_total", NULL },
+	{ "plutus_solutions_found_total", NULL },
+};
+
+static const char *histogram_names[METRIC_NUM_HISTOGRAMS] = {
+	"generate_challenge",
+	"generate_puzzle",
+	"verify_opt",
+	"verify_naive",
+	"verify_batch",
+	"solve_opt",
+	"solve_naive",
+};
+
+/* metrics_counter_name */
+const char *
+metrics_counter_name (metric_counter_t counter)
+{
+	if (counter >= METRIC_NUM_COUNTERS)
+		return "unknown";
+
+	return counter_names[counter].label ?
+		counter_names[counter].label : counter_names[counter].family;
+} /* metrics_counter_name */
+
+/* metrics_histogram_name */
+const char *
+metrics_histogram_name (metric_histogram_t hist)
+{
+	if (hist >= METRIC_NUM_HISTOGRAMS)
+		return "unknown";
+
+	return histogram_names[hist];
+} /* metrics_histogram_name */
+
+
+#ifndef PLUTUS_NO_METRICS
+
+/* The registered blocks of the live threads, and what the dead ones left */
+static std::mutex registry_lock;
+static metrics_block_t *registry = NULL;
+static metrics_block_t retired;
+
+thread_local metrics_block_t *metrics_thread_block
+	__attribute__ ((tls_model ("initial-exec"))) = NULL;
+
+/* add the values of a block into another one */
+static void
+fold_block (metrics_block_t *into, const metrics_block_t *from)
+{
+	for (unsigned int c = 0; c < METRIC_NUM_COUNTERS; c++)
+		into->counters[c] += __atomic_load_n (&from->counters[c], __ATOMIC_RELAXED);
+
+	for (unsigned int h = 0; h < METRIC_NUM_HISTOGRAMS; h++)
+	{
+		for (unsigned int b = 0; b < METRIC_NUM_BUCKETS; b++)
+			into->buckets[h][b] += __atomic_load_n (&from->buckets[h][b], __ATOMIC_RELAXED);
+
+		into->sum_ns[h] += __atomic_load_n (&from->sum_ns[h], __ATOMIC_RELAXED);
+	}
+} /* fold_block */
+
+/* retires the block of an exiting thread */
+typedef struct metrics_reaper {
+	~metrics_reaper ()
+	{
+		metrics_block_t *block = metrics_thread_block;
+		if (!block)
+			return;
+
+		std::lock_guard<std::mutex> lock (registry_lock);
+		fold_block (&retired, block);
+
+		for (metrics_block_t **it = &registry; *it; it = &(*it)->next)
+		{
+			if (*it == block)
+			{
+				*it = block->next;
+				break;
+			}
+		}
+
+		metrics_thread_block = NULL;
+		free (block);
+	}
+} metrics_reaper;
+
+static thread_local metrics_reaper thread_reaper;
+
+/* metrics_register_thread */
+metrics_block_t *
+metrics_register_thread ()
+{
+	metrics_block_t *block = (metrics_block_t *)
+		aligned_alloc (alignof (metrics_block_t), sizeof (metrics_block_t));
+	if (!block)
+		abort (); /* cannot go on without somewhere to count */
+	memset (block, 0, sizeof (metrics_block_t));
+
+	/* the first touch sets up the reaper of this thread */
+	(void) &thread_reaper;
+
+	{
+		std::lock_guard<std::mutex> lock (registry_lock);
+		block->next = registry;
+		registry = block;
+	}
+
+	metrics_thread_block = block;
+	return block;
+} /* metrics_register_thread */
+
+/* metrics_snapshot */
+void
+metrics_snapshot (metrics_snapshot_t *snap)
+{
+	if (!snap)
+		return; /* nothing to do */
+
+	metrics_block_t sum;
+	memset (&sum, 0, sizeof (sum));
+
+	{
+		std::lock_guard<std::mutex> lock (registry_lock);
+		fold_block (&sum, &retired);
+
+		for (metrics_block_t *it = registry; it; it = it->next)
+			fold_block (&sum, it);
+	}
+
+	memcpy (snap->counters, sum.counters, sizeof (snap->counters));
+	memcpy (snap->buckets, sum.buckets, sizeof (snap->buckets));
+	memcpy (snap->sum_ns, sum.sum_ns, sizeof (snap->sum_ns));
+
+	for (unsigned int h = 0; h < METRIC_NUM_HISTOGRAMS; h++)
+	{
+		snap->count[h] = 0;
+		for (unsigned int b = 0; b < METRIC_NUM_BUCKETS; b++)
+			snap->count[h] += sum.buckets[h][b];
+	}
+} /* metrics_snapshot */
+
+#else /* PLUTUS_NO_METRICS */
+
+/* metrics_snapshot */
+void
+metrics_snapshot (metrics_snapshot_t *snap)
+{
+	if (snap)
+		memset (snap, 0, sizeof (metrics_snapshot_t));
+} /* metrics_snapshot */
+
+#endif /* PLUTUS_NO_METRICS */
+
+
+/* An output buffer that keeps counting past its end like snprintf */
+typedef struct {
+	char *buf;
+	size_t buf_len;
+	size_t len;
+} text_t;
+
+static void
+text_printf (text_t *text, const char *fmt, ...)
+{
+	va_list ap;
+	va_start (ap, fmt);
+
+	size_t room = text->len < text->buf_len ? text->buf_len - text->len : 0;
+	int n = vsnprintf (room ? text->buf + text->len : NULL, room, fmt, ap);
+	if (n > 0)
+		text->len += n;
+
+	va_end (ap);
+} /* text_printf */
+
+/* metrics_format_prometheus */
+size_t
+metrics_format_prometheus (const metrics_snapshot_t *snap, char *buf, size_t buf_len)
+{
+	text_t text = { buf, buf_len, 0 };
+	if (buf_len > 0)
+		buf[0] = '\0';
+
+	if (!snap)
+		return 0;
+
+	const char *family = NULL;
+	for (unsigned int c = 0; c < METRIC_NUM_COUNTERS; c++)
+	{
+		if (!family || strcmp (family, counter_names[c].family) != 0)
+		{ /* a new family */
+			family = counter_names[c].family;
+			text_printf (&text, "# TYPE %s counter\n", family);
+		}
+
+		if (counter_names[c].label)
+			text_printf (&text, "%s{%s} %lu\n", family, counter_names[c].label,
+					(unsigned long) snap->counters[c]);
+		else
+			text_printf (&text, "%s %lu\n", family, (unsigned long) snap->counters[c]);
+	}
+
+	text_printf (&text, "# TYPE plutus_latency_seconds histogram\n");
+	for (unsigned int h = 0; h < METRIC_NUM_HISTOGRAMS; h++)
+	{
+		uint64_t cumulative = 0;
+		for (unsigned int b = 0; b + 1 < METRIC_NUM_BUCKETS; b++)
+		{
+			cumulative += snap->buckets[h][b];
+			text_printf (&text, "plutus_latency_seconds_bucket{op=\"%s\",le=\"%.9g\"} %lu\n",
+					histogram_names[h], (double) (1ULL << b) * 1e-9,
+					(unsigned long) cumulative);
+		}
+
+		text_printf (&text, "plutus_latency_seconds_bucket{op=\"%s\",le=\"+Inf\"} %lu\n",
+				histogram_names[h], (unsigned long) snap->count[h]);
+		text_printf (&text, "plutus_latency_seconds_sum{op=\"%s\"} %.9g\n",
+				histogram_names[h], (double) snap->sum_ns[h] * 1e-9);
+		text_printf (&text, "plutus_latency_seconds_count{op=\"%s\"} %lu\n",
+				histogram_names[h], (unsigned long) snap->count[h]);
+	}
+
+	return text.len;
+} /* metrics_format_prometheus */
+
+/* metrics_write_prometheus */
+void
+metrics_write_prometheus (FILE *out)
+{
+	metrics_snapshot_t snap;
+	metrics_snapshot (&snap);
+
+	size_t len = metrics_format_prometheus (&snap, NULL, 0);
+	char *buf = (char *) malloc (len + 1);
+	if (!buf)
+		return;
+
+	metrics_format_prometheus (&snap, buf, len + 1);
+	fputs (buf, out);
+	free (buf);
+} /* metrics_write_prometheus */
@@ -113,3 +113,24 @@ free_solution_mem (SHA256OptSolution *sol)
 	/* done free the actual solution memory */
 	free (sol);
 } /* free_solution_mem */
+
+/* free_solution_mem */
+void
+free_solution_mem (SHA256OptSolution *sol, const PuzzleAllocator *allocator)
+{
+	if (! sol)
+		return; /* nothing to do */
+
+	SHA256OptSubSolution *head = sol->head;
+	while (head)
+	{
+		SHA256OptSubSolution *next = head;
+		head = head->next;
+
+		puzzle_release (allocator, next->zi);
+		puzzle_release (allocator, next);
+	}
+
+	/* done free the actual solution memory */
+	puzzle_release (allocator, sol);
+} /* free_solution_mem */
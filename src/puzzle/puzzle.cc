@@ -167,3 +167,50 @@ free_solution_list (SHA256SubSolution *head)
 	}
 }
 
+
+/* free_challenge_mem */
+void
+free_challenge_mem (SHA256Challenge *challenge, const PuzzleAllocator *allocator)
+{
+	if (challenge == NULL) return;
+
+	free_list (challenge->puzzle, allocator);
+}
+
+/* free_list */
+void
+free_list (SHA256SubPuzzle *head, const PuzzleAllocator *allocator)
+{
+	while (head)
+	{/* iterate until all elements are free */
+		SHA256SubPuzzle *next = head;
+		head = head->next;
+
+		puzzle_release (allocator, next->preimage);
+		puzzle_release (allocator, next->image);
+		puzzle_release (allocator, next);
+	}
+}
+
+/* free_solution_mem */
+void
+free_solution_mem (SHA256Solution *sol, const PuzzleAllocator *allocator)
+{
+	if (sol == NULL) return;
+
+	free_solution_list (sol->solution, allocator);
+}
+
+/* free_solution_list */
+void
+free_solution_list (SHA256SubSolution *head, const PuzzleAllocator *allocator)
+{
+	while (head)
+	{/* iterate over all the list */
+		SHA256SubSolution *next = head;
+		head = head->next;
+
+		puzzle_release (allocator, next->solution);
+		puzzle_release (allocator, next);
+	}
+}
@@ -0,0 +1,208 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  random.cc
+ *
+ *    Description:  Implementation of the random generator of every thread
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 12:09:44 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/random.h"
+
+#include <openssl/rand.h>
+#include <pthread.h>
+#include <string.h>
+
+#include <atomic>
+
+/* The bytes of a refill that become the next key and nonce */
+#define RANDOM_REKEY_LEN 	(CHACHA20_KEY_LEN + CHACHA20_NONCE_LEN)
+#define RANDOM_BUFFER_LEN 	(RANDOM_REFILL_BLOCKS * CHACHA20_BLOCK_LEN)
+
+/* The state of the generator of a thread. It is all zero until the thread
+ * first draws, which reads as unseeded. */
+typedef struct thread_random_t {
+	unsigned char key[CHACHA20_KEY_LEN];
+	unsigned char nonce[CHACHA20_NONCE_LEN];
+	unsigned char buf[RANDOM_BUFFER_LEN];	/* The output of the last refill */
+	size_t used;							/* The bytes of buf already gone */
+	unsigned int generation;				/* The fork generation it was seeded in,
+											   0 for unseeded */
+	bool fixed;								/* Seeded by random_seed */
+} thread_random_t;
+
+static thread_local thread_random_t thread_random;
+
+/* Bumped in every child, a thread of the child seeded before the fork
+ * would otherwise repeat what its parent draws */
+static std::atomic<unsigned int> fork_generation (1);
+
+static void
+after_fork ()
+{
+	fork_generation.fetch_add (1, std::memory_order_relaxed);
+} /* after_fork */
+
+static int fork_startup = pthread_atfork (NULL, NULL, after_fork);
+
+/* the words of a block, little endian */
+static inline uint32_t
+load32 (const unsigned char *p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8)
+		| ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+} /* load32 */
+
+static inline void
+store32 (unsigned char *p, uint32_t v)
+{
+	p[0] = (unsigned char) v;
+	p[1] = (unsigned char) (v >> 8);
+	p[2] = (unsigned char) (v >> 16);
+	p[3] = (unsigned char) (v >> 24);
+} /* store32 */
+
+#define ROTL32(v, n) 	(((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTER_ROUND(a, b, c, d) \
+	a += b; d ^= a; d = ROTL32 (d, 16); \
+	c += d; b ^= c; b = ROTL32 (b, 12); \
+	a += b; d ^= a; d = ROTL32 (d, 8); \
+	c += d; b ^= c; b = ROTL32 (b, 7);
+
+/* chacha20_block */
+void
+chacha20_block (const unsigned char *key, uint32_t counter,
+		const unsigned char *nonce, unsigned char *out)
+{
+	uint32_t in[16];
+	in[0] = 0x61707865; /* "expand 32-byte k" */
+	in[1] = 0x3320646e;
+	in[2] = 0x79622d32;
+	in[3] = 0x6b206574;
+	for (unsigned int i = 0; i < 8; i++)
+		in[4 + i] = load32 (key + 4*i);
+	in[12] = counter;
+	for (unsigned int i = 0; i < 3; i++)
+		in[13 + i] = load32 (nonce + 4*i);
+
+	uint32_t x[16];
+	memcpy (x, in, sizeof (x));
+	for (unsigned int r = 0; r < 10; r++)
+	{ /* a column round and a diagonal round */
+		QUARTER_ROUND (x[0], x[4], x[8],  x[12]);
+		QUARTER_ROUND (x[1], x[5], x[9],  x[13]);
+		QUARTER_ROUND (x[2], x[6], x[10], x[14]);
+		QUARTER_ROUND (x[3], x[7], x[11], x[15]);
+		QUARTER_ROUND (x[0], x[5], x[10], x[15]);
+		QUARTER_ROUND (x[1], x[6], x[11], x[12]);
+		QUARTER_ROUND (x[2], x[7], x[8],  x[13]);
+		QUARTER_ROUND (x[3], x[4], x[9],  x[14]);
+	}
+
+	for (unsigned int i = 0; i < 16; i++)
+		store32 (out + 4*i, x[i] + in[i]);
+} /* chacha20_block */
+
+/* generate the next buffer, and take the next key out of it */
+static void
+refill (thread_random_t *r)
+{
+	for (uint32_t b = 0; b < RANDOM_REFILL_BLOCKS; b++)
+		chacha20_block (r->key, b, r->nonce, r->buf + b*CHACHA20_BLOCK_LEN);
+
+	memcpy (r->key, r->buf, CHACHA20_KEY_LEN);
+	memcpy (r->nonce, r->buf + CHACHA20_KEY_LEN, CHACHA20_NONCE_LEN);
+	memset (r->buf, 0, RANDOM_REKEY_LEN);
+	r->used = RANDOM_REKEY_LEN;
+} /* refill */
+
+/* random_reseed */
+int
+random_reseed ()
+{
+	thread_random_t *r = &thread_random;
+
+	unsigned char seed[RANDOM_REKEY_LEN];
+	if (RAND_bytes (seed, sizeof (seed)) != 1)
+	{
+		r->generation = 0;
+		return -1;
+	}
+
+	memcpy (r->key, seed, CHACHA20_KEY_LEN);
+	memcpy (r->nonce, seed + CHACHA20_KEY_LEN, CHACHA20_NONCE_LEN);
+	memset (seed, 0, sizeof (seed));
+
+	r->fixed = false;
+	r->generation = fork_generation.load (std::memory_order_relaxed);
+	refill (r);
+	return 0;
+} /* random_reseed */
+
+/* random_seed */
+void
+random_seed (uint64_t seed)
+{
+	thread_random_t *r = &thread_random;
+
+	memset (r->key, 0, sizeof (r->key));
+	memset (r->nonce, 0, sizeof (r->nonce));
+	for (unsigned int i = 0; i < sizeof (seed); i++)
+		r->key[i] = (unsigned char) (seed >> (8*i));
+
+	r->fixed = true;
+	r->generation = fork_generation.load (std::memory_order_relaxed);
+	refill (r);
+} /* random_seed */
+
+/* random_bytes */
+int
+random_bytes (unsigned char *buf, size_t len)
+{
+	thread_random_t *r = &thread_random;
+
+	/* first use, or a seed inherited across a fork */
+	if (!r->fixed && r->generation != fork_generation.load (std::memory_order_relaxed)
+			&& random_reseed () != 0)
+		return -1;
+
+	while (len > 0)
+	{
+		if (r->used == RANDOM_BUFFER_LEN)
+			refill (r);
+
+		size_t n = RANDOM_BUFFER_LEN - r->used;
+		if (n > len)
+			n = len;
+
+		/* what is handed out is not kept */
+		memcpy (buf, r->buf + r->used, n);
+		memset (r->buf + r->used, 0, n);
+		r->used += n;
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+} /* random_bytes */
+
+/* random_u64 */
+uint64_t
+random_u64 ()
+{
+	uint64_t v;
+	if (random_bytes ((unsigned char *) &v, sizeof (v)) != 0)
+		return 0;
+
+	return v;
+} /* random_u64 */
@@ -0,0 +1,298 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256.cc
+ *
+ *    Description:  Implementation of the low level SHA256 routines
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 09:30:02 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/sha256.h"
+#include "sha256_internal.h"
+
+#include <string.h>
+
+#ifdef SHA256_MB_X86
+#include <cpuid.h>
+#endif
+
+/* The initial chaining value of SHA256 */
+const uint32_t sha256_iv[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/* The round constants of SHA256 */
+const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* the portable compression function */
+static void
+sha256_compress_generic (uint32_t state[8], const unsigned char *blocks, size_t nblocks)
+{
+	uint32_t w[64];
+
+	while (nblocks--)
+	{ /* one block at a time */
+		for (unsigned int t = 0; t < 16; t++)
+			w[t] = load_be32 (blocks + 4*t);
+		for (unsigned int t = 16; t < 64; t++)
+			w[t] = SSIG1(w[t-2]) + w[t-7] + SSIG0(w[t-15]) + w[t-16];
+
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+		uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+		for (unsigned int t = 0; t < 64; t++)
+		{
+			uint32_t t1 = h + BSIG1(e) + CH(e,f,g) + sha256_k[t] + w[t];
+			uint32_t t2 = BSIG0(a) + MAJ(a,b,c);
+			h = g; g = f; f = e;
+			e = d + t1;
+			d = c; c = b; b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+		state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+
+		blocks += SHA256_BLOCK_LEN;
+	}
+} /* sha256_compress_generic */
+
+typedef void (*sha256_compress_fn) (uint32_t state[8],
+		const unsigned char *blocks, size_t nblocks);
+
+/* check whether the CPU has the SHA extensions and the SSE4.1 they rely on */
+static bool
+detect_shani ()
+{
+#ifdef SHA256_MB_X86
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1))
+		return false;
+	if (!__get_cpuid_count (7, 0, &eax, &ebx, &ecx, &edx))
+		return false;
+
+	return (ebx & bit_SHA) != 0;
+#else
+	return false;
+#endif
+} /* detect_shani */
+
+/* The compression function in use, upgraded to SHA-NI at load time */
+static sha256_compress_fn active_compress = sha256_compress_generic;
+static int shani_startup = sha256_set_shani (true);
+
+/* sha256_compress */
+void
+sha256_compress (uint32_t state[8], const unsigned char *blocks, size_t nblocks)
+{
+	active_compress (state, blocks, nblocks);
+} /* sha256_compress */
+
+/* sha256_shani_supported */
+bool
+sha256_shani_supported ()
+{
+	static bool supported = detect_shani ();
+
+	return supported;
+} /* sha256_shani_supported */
+
+/* sha256_shani_enabled */
+bool
+sha256_shani_enabled ()
+{
+	return active_compress != sha256_compress_generic;
+} /* sha256_shani_enabled */
+
+/* sha256_set_shani */
+int
+sha256_set_shani (bool enable)
+{
+	if (!enable)
+	{
+		active_compress = sha256_compress_generic;
+		return 0;
+	}
+
+#ifdef SHA256_MB_X86
+	if (sha256_shani_supported ())
+	{
+		active_compress = sha256_compress_shani;
+		return 0;
+	}
+#endif
+
+	return -1; /* no SHA extensions on this CPU */
+} /* sha256_set_shani */
+
+/* sha256_init */
+void
+sha256_init (SHA256Ctx *ctx)
+{
+	memcpy (ctx->h, sha256_iv, sizeof (sha256_iv));
+	ctx->total_len = 0;
+	ctx->buf_len = 0;
+} /* sha256_init */
+
+/* sha256_update */
+void
+sha256_update (SHA256Ctx *ctx, const unsigned char *msg, size_t len)
+{
+	ctx->total_len += len;
+
+	if (ctx->buf_len > 0)
+	{ /* top up the partial block first */
+		size_t n = SHA256_BLOCK_LEN - ctx->buf_len;
+		if (n > len)
+			n = len;
+
+		memcpy (ctx->buf + ctx->buf_len, msg, n);
+		ctx->buf_len += n;
+		msg += n;
+		len -= n;
+
+		if (ctx->buf_len < SHA256_BLOCK_LEN)
+			return; /* still not a full block */
+
+		sha256_compress (ctx->h, ctx->buf, 1);
+		ctx->buf_len = 0;
+	}
+
+	/* compress the full blocks straight from the message */
+	size_t nblocks = len / SHA256_BLOCK_LEN;
+	if (nblocks > 0)
+	{
+		sha256_compress (ctx->h, msg, nblocks);
+		msg += nblocks * SHA256_BLOCK_LEN;
+		len -= nblocks * SHA256_BLOCK_LEN;
+	}
+
+	/* keep what is left for later */
+	memcpy (ctx->buf, msg, len);
+	ctx->buf_len = len;
+} /* sha256_update */
+
+/* sha256_final */
+void
+sha256_final (SHA256Ctx *ctx, unsigned char *digest)
+{
+	uint64_t bits = ctx->total_len * 8;
+	unsigned int n = ctx->buf_len;
+
+	/* append the 1 bit and pad with zeros up to the length field */
+	ctx->buf[n++] = 0x80;
+	if (n > SHA256_BLOCK_LEN - 8)
+	{ /* no room for the length in this block */
+		memset (ctx->buf + n, 0, SHA256_BLOCK_LEN - n);
+		sha256_compress (ctx->h, ctx->buf, 1);
+		n = 0;
+	}
+	memset (ctx->buf + n, 0, SHA256_BLOCK_LEN - 8 - n);
+
+	store_be32 (ctx->buf + SHA256_BLOCK_LEN - 8, (uint32_t) (bits >> 32));
+	store_be32 (ctx->buf + SHA256_BLOCK_LEN - 4, (uint32_t) bits);
+	sha256_compress (ctx->h, ctx->buf, 1);
+
+	store_digest (ctx->h, digest);
+} /* sha256_final */
+
+/* sha256_digest */
+void
+sha256_digest (const unsigned char *msg, size_t len, unsigned char *digest)
+{
+	SHA256Ctx ctx;
+
+	sha256_init (&ctx);
+	sha256_update (&ctx, msg, len);
+	sha256_final (&ctx, digest);
+} /* sha256_digest */
+
+/* sha256_midstate_init */
+int
+sha256_midstate_init (SHA256Midstate *ms, const unsigned char *prefix,
+		size_t prefix_len, size_t tail_len)
+{
+	if (!ms || (!prefix && prefix_len > 0))
+		return -1; /* nothing to do */
+
+	/* absorb the full blocks of the prefix once and for all */
+	SHA256Ctx ctx;
+	sha256_init (&ctx);
+	sha256_update (&ctx, prefix, prefix_len);
+
+	return sha256_midstate_from_ctx (ms, &ctx, tail_len);
+} /* sha256_midstate_init */
+
+/* sha256_midstate_from_ctx */
+int
+sha256_midstate_from_ctx (SHA256Midstate *ms, const SHA256Ctx *ctx,
+		size_t tail_len)
+{
+	if (!ms || !ctx)
+		return -1; /* nothing to do */
+
+	size_t rem = ctx->buf_len;
+
+	/* the rest of the prefix, the tail, the 1 bit and the 64 bit length
+	 * must all fit in the trailing blocks */
+	size_t nblocks = (rem + tail_len + 9 + SHA256_BLOCK_LEN - 1) / SHA256_BLOCK_LEN;
+	if (nblocks > SHA256_MIDSTATE_MAX_BLOCKS)
+		return -1;
+
+	memcpy (ms->h, ctx->h, sizeof (ms->h));
+
+	/* lay out the trailing blocks: rest || tail || 0x80 || 0 ... || bitlen */
+	unsigned int end = nblocks * SHA256_BLOCK_LEN;
+	memset (ms->block, 0, end);
+	memcpy (ms->block, ctx->buf, rem);
+	ms->block[rem + tail_len] = 0x80;
+
+	uint64_t bits = (uint64_t) (ctx->total_len + tail_len) * 8;
+	store_be32 (ms->block + end - 8, (uint32_t) (bits >> 32));
+	store_be32 (ms->block + end - 4, (uint32_t) bits);
+
+	ms->nblocks  = nblocks;
+	ms->tail_off = rem;
+	ms->tail_len = tail_len;
+
+	return 0;
+} /* sha256_midstate_from_ctx */
+
+/* sha256_midstate_tail */
+unsigned char *
+sha256_midstate_tail (SHA256Midstate *ms)
+{
+	return ms->block + ms->tail_off;
+} /* sha256_midstate_tail */
+
+/* sha256_midstate_digest */
+void
+sha256_midstate_digest (const SHA256Midstate *ms, unsigned char *digest)
+{
+	uint32_t h[8];
+
+	memcpy (h, ms->h, sizeof (h));
+	sha256_compress (h, ms->block, ms->nblocks);
+
+	store_digest (h, digest);
+} /* sha256_midstate_digest */
@@ -0,0 +1,27 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256_avx2.cc
+ *
+ *    Description:  AVX2 multi-buffer SHA256, hashing 8 messages in lockstep
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 01:40:12 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+/* only built with the AVX2 flags on x86, see CMakeLists.txt */
+#ifdef __AVX2__
+
+#define SHA256_MB_LANES 	8
+#define SHA256_MB_FN 		sha256_mb_digest_avx2
+
+#include "sha256_mb_lanes.h"
+
+#endif /* __AVX2__ */
@@ -0,0 +1,27 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256_avx512.cc
+ *
+ *    Description:  AVX-512 multi-buffer SHA256, hashing 16 messages in lockstep
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 01:40:12 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+/* only built with the AVX-512 flags on x86, see CMakeLists.txt */
+#ifdef __AVX512F__
+
+#define SHA256_MB_LANES 	16
+#define SHA256_MB_FN 		sha256_mb_digest_avx512
+
+#include "sha256_mb_lanes.h"
+
+#endif /* __AVX512F__ */
@@ -0,0 +1,78 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256_internal.h
+ *
+ *    Description:  Constants and helpers shared by the SHA256 implementations
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 01:10:33 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __SHA256_INTERNAL_H
+#define __SHA256_INTERNAL_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* The initial chaining value of SHA256 */
+extern const uint32_t sha256_iv[8];
+
+/* The round constants of SHA256 */
+extern const uint32_t sha256_k[64];
+
+#ifdef SHA256_MB_X86
+/* The instruction set specific multi-buffer kernels, see sha256_mb.h */
+void sha256_mb_digest_avx2 		(const struct SHA256Midstate *ms,
+		const unsigned char *tails, unsigned int n, unsigned char *digests);
+void sha256_mb_digest_avx512 	(const struct SHA256Midstate *ms,
+		const unsigned char *tails, unsigned int n, unsigned char *digests);
+
+/* The compression function on the SHA extensions, see sha256_shani.cc */
+void sha256_compress_shani 		(uint32_t state[8],
+		const unsigned char *blocks, size_t nblocks);
+#endif
+
+/* The SHA256 functions. They work on scalars as well as on GCC vectors. */
+#define ROTR(x, n) 	(((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x,y,z) 	(((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x,y,z) 	(((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define BSIG0(x) 	(ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define BSIG1(x) 	(ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SSIG0(x) 	(ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define SSIG1(x) 	(ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+/* load a big endian 32 bit word */
+static inline uint32_t
+load_be32 (const unsigned char *p)
+{
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16)
+		| ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+} /* load_be32 */
+
+/* store a big endian 32 bit word */
+static inline void
+store_be32 (unsigned char *p, uint32_t v)
+{
+	p[0] = (unsigned char) (v >> 24);
+	p[1] = (unsigned char) (v >> 16);
+	p[2] = (unsigned char) (v >> 8);
+	p[3] = (unsigned char) v;
+} /* store_be32 */
+
+/* store the chaining value as a digest */
+static inline void
+store_digest (const uint32_t h[8], unsigned char *digest)
+{
+	for (unsigned int i = 0; i < 8; i++)
+		store_be32 (digest + 4*i, h[i]);
+} /* store_digest */
+
+#endif /* sha256_internal.h */
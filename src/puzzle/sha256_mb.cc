@@ -0,0 +1,171 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256_mb.cc
+ *
+ *    Description:  Runtime dispatch of the multi-buffer SHA256 backends and the
+ *    				scalar fallback
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 01:55:37 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/sha256_mb.h"
+#include "sha256_internal.h"
+
+#include <string.h>
+
+typedef void (*sha256_mb_fn) (const SHA256Midstate *ms,
+		const unsigned char *tails, unsigned int n, unsigned char *digests);
+
+/* the scalar fallback, one message at a time through sha256_compress, so
+ * it runs on SHA-NI when the CPU has it */
+static void
+sha256_mb_digest_scalar (const SHA256Midstate *ms, const unsigned char *tails,
+		unsigned int n, unsigned char *digests)
+{
+	/* a private copy of the trailing blocks to drop the tails in */
+	unsigned char block[SHA256_MIDSTATE_MAX_BLOCKS * SHA256_BLOCK_LEN];
+	memcpy (block, ms->block, ms->nblocks * SHA256_BLOCK_LEN);
+
+	for (unsigned int j = 0; j < n; j++)
+	{
+		uint32_t h[8];
+
+		memcpy (block + ms->tail_off, tails + j * ms->tail_len, ms->tail_len);
+		memcpy (h, ms->h, sizeof (h));
+		sha256_compress (h, block, ms->nblocks);
+
+		store_digest (h, digests + j * SHA256_DIGEST_LEN);
+	}
+} /* sha256_mb_digest_scalar */
+
+/* check whether the CPU and the build support a backend */
+static bool
+backend_supported (sha256_mb_backend_t backend)
+{
+	switch (backend)
+	{
+		case SHA256_MB_SCALAR:
+			return true;
+#ifdef SHA256_MB_X86
+		case SHA256_MB_AVX2:
+			return __builtin_cpu_supports ("avx2");
+		case SHA256_MB_AVX512:
+			return __builtin_cpu_supports ("avx512f");
+#endif
+		default:
+			return false;
+	}
+} /* backend_supported */
+
+/* get the kernel of a supported backend */
+static sha256_mb_fn
+backend_kernel (sha256_mb_backend_t backend)
+{
+	switch (backend)
+	{
+#ifdef SHA256_MB_X86
+		case SHA256_MB_AVX2:
+			return sha256_mb_digest_avx2;
+		case SHA256_MB_AVX512:
+			return sha256_mb_digest_avx512;
+#endif
+		default:
+			return sha256_mb_digest_scalar;
+	}
+} /* backend_kernel */
+
+/* pick the fastest backend the CPU supports */
+static sha256_mb_backend_t
+detect_backend ()
+{
+	__builtin_cpu_init ();
+
+	if (backend_supported (SHA256_MB_AVX512))
+		return SHA256_MB_AVX512;
+
+	/* one message at a time on SHA-NI beats 8 lanes of AVX2 */
+	if (sha256_shani_supported ())
+		return SHA256_MB_SCALAR;
+
+	if (backend_supported (SHA256_MB_AVX2))
+		return SHA256_MB_AVX2;
+
+	return SHA256_MB_SCALAR;
+} /* detect_backend */
+
+/* The active backend, the fastest one is picked at load time */
+static sha256_mb_backend_t active_backend = SHA256_MB_SCALAR;
+static sha256_mb_fn active_kernel = sha256_mb_digest_scalar;
+static int backend_startup = sha256_mb_set_backend (detect_backend ());
+
+/* sha256_mb_digest */
+void
+sha256_mb_digest (const SHA256Midstate *ms, const unsigned char *tails,
+		unsigned int n, unsigned char *digests)
+{
+	if (!ms || n == 0)
+		return; /* nothing to do */
+
+	active_kernel (ms, tails, n, digests);
+} /* sha256_mb_digest */
+
+/* sha256_mb_lanes */
+unsigned int
+sha256_mb_lanes ()
+{
+	switch (active_backend)
+	{
+		case SHA256_MB_AVX2:
+			return 8;
+		case SHA256_MB_AVX512:
+			return 16;
+		default:
+			return 1;
+	}
+} /* sha256_mb_lanes */
+
+/* sha256_mb_get_backend */
+sha256_mb_backend_t
+sha256_mb_get_backend ()
+{
+	return active_backend;
+} /* sha256_mb_get_backend */
+
+/* sha256_mb_set_backend */
+int
+sha256_mb_set_backend (sha256_mb_backend_t backend)
+{
+	if (!backend_supported (backend))
+		return -1;
+
+	active_backend = backend;
+	active_kernel  = backend_kernel (backend);
+
+	return 0;
+} /* sha256_mb_set_backend */
+
+/* sha256_mb_backend_name */
+const char *
+sha256_mb_backend_name (sha256_mb_backend_t backend)
+{
+	switch (backend)
+	{
+		case SHA256_MB_SCALAR:
+			return "scalar";
+		case SHA256_MB_AVX2:
+			return "avx2";
+		case SHA256_MB_AVX512:
+			return "avx512";
+		default:
+			return "unknown";
+	}
+} /* sha256_mb_backend_name */
@@ -0,0 +1,107 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256_mb_lanes.h
+ *
+ *    Description:  Generic multi-buffer SHA256 over GCC vectors. Each instruction set
+ *    				specific file defines SHA256_MB_LANES and SHA256_MB_FN, and is
+ *    				compiled with the matching target flags before including this.
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 01:24:50 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/sha256.h"
+#include "sha256_internal.h"
+
+#include <string.h>
+
+/* Everything in here must stay static: the same code is built for several
+ * instruction sets and the linker must never merge the copies. */
+
+typedef uint32_t mb_vec __attribute__ ((vector_size (4 * SHA256_MB_LANES)));
+
+/* compress nblocks of every lane, lane j reads its blocks from lanes[j] */
+static void
+mb_compress (mb_vec state[8], unsigned char (*lanes)[SHA256_MIDSTATE_MAX_BLOCKS * SHA256_BLOCK_LEN],
+		unsigned int nblocks)
+{
+	mb_vec w[64];
+
+	for (unsigned int blk = 0; blk < nblocks; blk++)
+	{
+		/* transpose the message words of the lanes */
+		for (unsigned int t = 0; t < 16; t++)
+			for (unsigned int j = 0; j < SHA256_MB_LANES; j++)
+				w[t][j] = load_be32 (lanes[j] + blk * SHA256_BLOCK_LEN + 4*t);
+
+		for (unsigned int t = 16; t < 64; t++)
+			w[t] = SSIG1(w[t-2]) + w[t-7] + SSIG0(w[t-15]) + w[t-16];
+
+		mb_vec a = state[0], b = state[1], c = state[2], d = state[3];
+		mb_vec e = state[4], f = state[5], g = state[6], h = state[7];
+
+		for (unsigned int t = 0; t < 64; t++)
+		{
+			mb_vec t1 = h + BSIG1(e) + CH(e,f,g) + sha256_k[t] + w[t];
+			mb_vec t2 = BSIG0(a) + MAJ(a,b,c);
+			h = g; g = f; f = e;
+			e = d + t1;
+			d = c; c = b; b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+		state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+	}
+} /* mb_compress */
+
+/* hash the messages in groups of SHA256_MB_LANES */
+void
+SHA256_MB_FN (const SHA256Midstate *ms, const unsigned char *tails,
+		unsigned int n, unsigned char *digests)
+{
+	unsigned char lanes[SHA256_MB_LANES][SHA256_MIDSTATE_MAX_BLOCKS * SHA256_BLOCK_LEN];
+	unsigned int len = ms->nblocks * SHA256_BLOCK_LEN;
+
+	/* every lane starts from the padded trailing blocks */
+	for (unsigned int j = 0; j < SHA256_MB_LANES; j++)
+		memcpy (lanes[j], ms->block, len);
+
+	for (unsigned int base = 0; base < n; base += SHA256_MB_LANES)
+	{
+		unsigned int count = n - base;
+		if (count > SHA256_MB_LANES)
+			count = SHA256_MB_LANES;
+
+		/* drop the tails in place, idle lanes just redo the last message */
+		for (unsigned int j = 0; j < SHA256_MB_LANES; j++)
+		{
+			unsigned int src = base + ((j < count)? j : count - 1);
+			memcpy (lanes[j] + ms->tail_off, tails + src * ms->tail_len,
+					ms->tail_len);
+		}
+
+		mb_vec state[8];
+		for (unsigned int i = 0; i < 8; i++)
+			for (unsigned int j = 0; j < SHA256_MB_LANES; j++)
+				state[i][j] = ms->h[i];
+
+		mb_compress (state, lanes, ms->nblocks);
+
+		/* transpose the chaining values back into digests */
+		for (unsigned int j = 0; j < count; j++)
+		{
+			unsigned char *digest = digests + (base + j) * SHA256_DIGEST_LEN;
+			for (unsigned int i = 0; i < 8; i++)
+				store_be32 (digest + 4*i, state[i][j]);
+		}
+	}
+} /* SHA256_MB_FN */
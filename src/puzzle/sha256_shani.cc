@@ -0,0 +1,89 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256_shani.cc
+ *
+ *    Description:  SHA256 compression on the x86 SHA extensions (SHA-NI)
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 03:02:45 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+/* only built with the SHA extension flags on x86, see CMakeLists.txt */
+#ifdef __SHA__
+
+#include "puzzle/sha256.h"
+#include "sha256_internal.h"
+
+#include <immintrin.h>
+
+/* sha256_compress_shani */
+void
+sha256_compress_shani (uint32_t state[8], const unsigned char *blocks, size_t nblocks)
+{
+	const __m128i mask = _mm_set_epi64x (0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i state0, state1, msg, tmp;
+	__m128i w[4];
+
+	/* the instructions want the state as ABEF and CDGH */
+	tmp    = _mm_loadu_si128 ((const __m128i *) &state[0]);
+	state1 = _mm_loadu_si128 ((const __m128i *) &state[4]);
+
+	tmp    = _mm_shuffle_epi32 (tmp, 0xB1);				/* CDAB */
+	state1 = _mm_shuffle_epi32 (state1, 0x1B);			/* EFGH */
+	state0 = _mm_alignr_epi8 (tmp, state1, 8);			/* ABEF */
+	state1 = _mm_blend_epi16 (state1, tmp, 0xF0);		/* CDGH */
+
+	while (nblocks--)
+	{
+		__m128i abef = state0, cdgh = state1;
+
+#pragma GCC unroll 16
+		for (unsigned int g = 0; g < 16; g++)
+		{ /* four rounds at a time */
+			if (g < 4)
+				w[g] = _mm_shuffle_epi8 (
+						_mm_loadu_si128 ((const __m128i *) (blocks + 16*g)), mask);
+
+			msg = _mm_add_epi32 (w[g%4],
+					_mm_loadu_si128 ((const __m128i *) &sha256_k[4*g]));
+			state1 = _mm_sha256rnds2_epu32 (state1, state0, msg);
+
+			if (g >= 3 && g <= 14)
+			{ /* finish the schedule of the next four words */
+				tmp = _mm_alignr_epi8 (w[g%4], w[(g+3)%4], 4);
+				w[(g+1)%4] = _mm_add_epi32 (w[(g+1)%4], tmp);
+				w[(g+1)%4] = _mm_sha256msg2_epu32 (w[(g+1)%4], w[g%4]);
+			}
+
+			msg = _mm_shuffle_epi32 (msg, 0x0E);
+			state0 = _mm_sha256rnds2_epu32 (state0, state1, msg);
+
+			if (g >= 1 && g <= 12)
+				w[(g+3)%4] = _mm_sha256msg1_epu32 (w[(g+3)%4], w[g%4]);
+		}
+
+		state0 = _mm_add_epi32 (state0, abef);
+		state1 = _mm_add_epi32 (state1, cdgh);
+
+		blocks += SHA256_BLOCK_LEN;
+	}
+
+	/* back to ABCD and EFGH */
+	tmp    = _mm_shuffle_epi32 (state0, 0x1B);			/* FEBA */
+	state1 = _mm_shuffle_epi32 (state1, 0xB1);			/* DCHG */
+	state0 = _mm_blend_epi16 (tmp, state1, 0xF0);		/* DCBA */
+	state1 = _mm_alignr_epi8 (state1, tmp, 8);			/* ABEF */
+
+	_mm_storeu_si128 ((__m128i *) &state[0], state0);
+	_mm_storeu_si128 ((__m128i *) &state[4], state1);
+} /* sha256_compress_shani */
+
+#endif /* __SHA__ */
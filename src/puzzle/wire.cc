@@ -0,0 +1,444 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  wire.cc
+ *
+ *    Description:  Implementation of the binary encoding of the challenges and
+ *    				solutions
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 01:10:27 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/wire.h"
+#include "puzzle/factory.h"
+
+#include <openssl/evp.h>
+#include <string.h>
+
+/* little endian reads and writes, whatever the host is */
+static inline void
+put_u16 (unsigned char *p, uint16_t v)
+{
+	p[0] = (unsigned char) v;
+	p[1] = (unsigned char) (v >> 8);
+} /* put_u16 */
+
+static inline void
+put_u32 (unsigned char *p, uint32_t v)
+{
+	put_u16 (p, (uint16_t) v);
+	put_u16 (p + 2, (uint16_t) (v >> 16));
+} /* put_u32 */
+
+static inline uint16_t
+get_u16 (const unsigned char *p)
+{
+	return (uint16_t) (p[0] | (p[1] << 8));
+} /* get_u16 */
+
+static inline uint32_t
+get_u32 (const unsigned char *p)
+{
+	return get_u16 (p) | ((uint32_t) get_u16 (p + 2) << 16);
+} /* get_u32 */
+
+/* write the header of a packet */
+static unsigned char *
+put_header (unsigned char *buf, wire_type_t type, uint32_t timestamp,
+		uint16_t k, uint16_t m, uint16_t elem_len)
+{
+	put_u16 (buf, WIRE_MAGIC);
+	buf[2] = WIRE_VERSION;
+	buf[3] = (unsigned char) type;
+	put_u32 (buf + 4, timestamp);
+	put_u16 (buf + 8, k);
+	put_u16 (buf + 10, m);
+	put_u16 (buf + 12, elem_len);
+	put_u16 (buf + 14, 0);
+
+	return buf + WIRE_HEADER_LEN;
+} /* put_header */
+
+/* copy a buffer into a new OPENSSL_malloc'd one, like the list nodes expect */
+static unsigned char *
+dup_openssl (const unsigned char *src, size_t n)
+{
+	unsigned char *dst = (unsigned char *) OPENSSL_malloc (n);
+	if (dst)
+		memcpy (dst, src, n);
+
+	return dst;
+} /* dup_openssl */
+
+
+/*-----------------------------------------------------------------------------
+ *  Validating
+ *-----------------------------------------------------------------------------*/
+
+/* wire_parse */
+wire_status_t
+wire_parse (const unsigned char *buf, size_t buf_len, WirePacket *pkt)
+{
+	if (!buf || !pkt || buf_len < WIRE_HEADER_LEN)
+		return WIRE_TRUNCATED;
+
+	if (get_u16 (buf) != WIRE_MAGIC)
+		return WIRE_BAD_MAGIC;
+	if (buf[2] != WIRE_VERSION)
+		return WIRE_BAD_VERSION;
+
+	pkt->type      = (wire_type_t) buf[3];
+	pkt->timestamp = get_u32 (buf + 4);
+	pkt->k         = get_u16 (buf + 8);
+	pkt->m         = get_u16 (buf + 10);
+	pkt->elem_len  = get_u16 (buf + 12);
+	pkt->body      = buf + WIRE_HEADER_LEN;
+	pkt->body_len  = buf_len - WIRE_HEADER_LEN;
+
+	/* the element lengths are fixed by the scheme, the body by the header */
+	size_t expected;
+	switch (pkt->type)
+	{
+		case WIRE_CHALLENGE:
+			if (pkt->elem_len != SHA256_DIGEST_LEN || pkt->k > UINT8_MAX)
+				return WIRE_BAD_LENGTH;
+			expected = 2 * (size_t) pkt->k * SHA256_DIGEST_LEN;
+			break;
+		case WIRE_SOLUTION:
+			if (pkt->elem_len != SHA256_DIGEST_LEN || pkt->k > UINT8_MAX)
+				return WIRE_BAD_LENGTH;
+			expected = (size_t) pkt->k * SHA256_DIGEST_LEN;
+			break;
+		case WIRE_OPT_CHALLENGE:
+			if (pkt->elem_len == 0 || pkt->elem_len > SHA256_DIGEST_LEN)
+				return WIRE_BAD_LENGTH;
+			expected = pkt->elem_len;
+			break;
+		case WIRE_OPT_SOLUTION:
+			if (pkt->elem_len == 0 || pkt->elem_len > SHA256_DIGEST_LEN)
+				return WIRE_BAD_LENGTH;
+			expected = (size_t) pkt->k * pkt->elem_len;
+			break;
+		case WIRE_HELLO:
+			if (pkt->k != 0)
+				return WIRE_BAD_LENGTH;
+			expected = pkt->elem_len;
+			break;
+		case WIRE_VERDICT:
+			if (pkt->k != 0 || pkt->elem_len != 1)
+				return WIRE_BAD_LENGTH;
+			expected = 1;
+			break;
+		default:
+			return WIRE_BAD_TYPE;
+	}
+
+	if (pkt->m > 8*SHA256_DIGEST_LEN || get_u16 (buf + 14) != 0)
+		return WIRE_BAD_LENGTH;
+	if (pkt->body_len < expected)
+		return WIRE_TRUNCATED;
+	if (pkt->body_len > expected)
+		return WIRE_BAD_LENGTH;
+
+	return WIRE_OK;
+} /* wire_parse */
+
+/* wire_peek_timestamp */
+int
+wire_peek_timestamp (const unsigned char *buf, size_t buf_len, uint32_t *timestamp)
+{
+	if (!buf || !timestamp || buf_len < WIRE_HEADER_LEN)
+		return -1;
+
+	*timestamp = get_u32 (buf + 4);
+	return 0;
+} /* wire_peek_timestamp */
+
+/* wire_status_name */
+const char *
+wire_status_name (wire_status_t status)
+{
+	switch (status)
+	{
+		case WIRE_OK:
+			return "ok";
+		case WIRE_TRUNCATED:
+			return "truncated";
+		case WIRE_BAD_MAGIC:
+			return "bad magic";
+		case WIRE_BAD_VERSION:
+			return "bad version";
+		case WIRE_BAD_TYPE:
+			return "bad type";
+		case WIRE_BAD_LENGTH:
+			return "bad length";
+		default:
+			return "unknown";
+	}
+} /* wire_status_name */
+
+/* wire_view_optsolution */
+int
+wire_view_optsolution (const WirePacket *pkt, SHA256OptFlatSolution *view)
+{
+	if (!pkt || !view || pkt->type != WIRE_OPT_SOLUTION)
+		return -1;
+
+	view->timestamp = pkt->timestamp;
+	view->num_subsolutions = pkt->k;
+	view->zlen = pkt->elem_len;
+	view->zi = (unsigned char *) pkt->body;
+
+	return 0;
+} /* wire_view_optsolution */
+
+/* wire_view_solution */
+int
+wire_view_solution (const WirePacket *pkt, SHA256FlatSolution *view)
+{
+	if (!pkt || !view || pkt->type != WIRE_SOLUTION)
+		return -1;
+
+	view->timestamp = pkt->timestamp;
+	view->num_subsolutions = pkt->k;
+	view->solutions = (unsigned char *) pkt->body;
+
+	return 0;
+} /* wire_view_solution */
+
+
+/*-----------------------------------------------------------------------------
+ *  Encoding
+ *-----------------------------------------------------------------------------*/
+
+/* encode_challenge */
+size_t
+encode_challenge (const SHA256Challenge *challenge, unsigned char *buf, size_t buf_len)
+{
+	if (!challenge)
+		return 0; /* nothing to do */
+
+	uint16_t k = challenge->num_subpuzzles;
+	size_t arr = (size_t) k * SHA256_DIGEST_LEN;
+	size_t len = WIRE_HEADER_LEN + 2 * arr;
+	if (!buf || buf_len < len)
+		return len;
+
+	unsigned char *preimages = put_header (buf, WIRE_CHALLENGE, challenge->timestamp,
+			k, challenge->difficulty, SHA256_DIGEST_LEN);
+	unsigned char *images = preimages + arr;
+
+	/* missing preimages and images are sent zeroed, like flatten_challenge */
+	memset (preimages, 0, 2 * arr);
+	SHA256SubPuzzle *head = challenge->puzzle;
+	for (uint16_t i = 0; i < k && head; i++, head = head->next)
+	{
+		if (head->preimage)
+			memcpy (preimages + i * SHA256_DIGEST_LEN, head->preimage, SHA256_DIGEST_LEN);
+		if (head->image)
+			memcpy (images + i * SHA256_DIGEST_LEN, head->image, SHA256_DIGEST_LEN);
+	}
+
+	return len;
+} /* encode_challenge */
+
+/* encode_challenge */
+size_t
+encode_challenge (const SHA256OptChallenge *challenge, unsigned char *buf, size_t buf_len)
+{
+	if (!challenge || !challenge->preimage)
+		return 0; /* nothing to do */
+
+	/* x is half of x + z */
+	uint16_t xlen = challenge->len / 2;
+	if (xlen == 0 || xlen > SHA256_DIGEST_LEN)
+		return 0;
+
+	size_t len = WIRE_HEADER_LEN + xlen;
+	if (!buf || buf_len < len)
+		return len;
+
+	unsigned char *body = put_header (buf, WIRE_OPT_CHALLENGE, challenge->timestamp,
+			challenge->num_subpuzzles, challenge->difficulty, xlen);
+	memcpy (body, challenge->preimage, xlen);
+
+	return len;
+} /* encode_challenge */
+
+/* encode_solution */
+size_t
+encode_solution (const SHA256Solution *sol, uint16_t k, unsigned char *buf, size_t buf_len)
+{
+	if (!sol || k > UINT8_MAX)
+		return 0; /* nothing to do */
+
+	size_t len = WIRE_HEADER_LEN + (size_t) k * SHA256_DIGEST_LEN;
+	if (!buf || buf_len < len)
+		return len;
+
+	unsigned char *body = put_header (buf, WIRE_SOLUTION, sol->timestamp,
+			k, 0, SHA256_DIGEST_LEN);
+
+	SHA256SubSolution *head = sol->solution;
+	for (uint16_t i = 0; i < k; i++, head = head->next)
+	{
+		if (!head || !head->solution)
+			return 0; /* shorter than k */
+
+		memcpy (body + i * SHA256_DIGEST_LEN, head->solution, SHA256_DIGEST_LEN);
+	}
+
+	return len;
+} /* encode_solution */
+
+/* encode_solution */
+size_t
+encode_solution (const SHA256OptSolution *sol, uint16_t l, uint16_t k,
+		unsigned char *buf, size_t buf_len)
+{
+	/* z_i is (l/2) bits */
+	uint16_t zlen = l / 16;
+	if (!sol || zlen == 0 || zlen > SHA256_DIGEST_LEN)
+		return 0; /* nothing to do */
+
+	size_t pkt_len = WIRE_HEADER_LEN + (size_t) k * zlen;
+	if (!buf || buf_len < pkt_len)
+		return pkt_len;
+
+	unsigned char *body = put_header (buf, WIRE_OPT_SOLUTION, sol->timestamp,
+			k, 0, zlen);
+
+	SHA256OptSubSolution *head = sol->head;
+	for (uint16_t i = 0; i < k; i++, head = head->next)
+	{
+		if (!head || !head->zi)
+			return 0; /* shorter than k */
+
+		memcpy (body + i * zlen, head->zi, zlen);
+	}
+
+	return pkt_len;
+} /* encode_solution */
+
+/* encode_solution */
+size_t
+encode_solution (const SHA256OptFlatSolution *sol, unsigned char *buf, size_t buf_len)
+{
+	if (!sol || !sol->zi || sol->zlen == 0 || sol->zlen > SHA256_DIGEST_LEN)
+		return 0; /* nothing to do */
+
+	size_t body_len = (size_t) sol->num_subsolutions * sol->zlen;
+	size_t pkt_len = WIRE_HEADER_LEN + body_len;
+	if (!buf || buf_len < pkt_len)
+		return pkt_len;
+
+	/* the values of z_i are already laid out like the body */
+	unsigned char *body = put_header (buf, WIRE_OPT_SOLUTION, sol->timestamp,
+			sol->num_subsolutions, 0, sol->zlen);
+	memcpy (body, sol->zi, body_len);
+
+	return pkt_len;
+} /* encode_solution */
+
+/* encode_hello */
+size_t
+encode_hello (uint16_t pad, unsigned char *buf, size_t buf_len)
+{
+	size_t len = WIRE_HEADER_LEN + pad;
+	if (!buf || buf_len < len)
+		return len;
+
+	unsigned char *body = put_header (buf, WIRE_HELLO, 0, 0, 0, pad);
+	memset (body, 0, pad);
+
+	return len;
+} /* encode_hello */
+
+/* encode_verdict */
+size_t
+encode_verdict (uint32_t timestamp, uint8_t verdict, unsigned char *buf, size_t buf_len)
+{
+	size_t len = WIRE_HEADER_LEN + 1;
+	if (!buf || buf_len < len)
+		return len;
+
+	unsigned char *body = put_header (buf, WIRE_VERDICT, timestamp, 0, 0, 1);
+	body[0] = verdict;
+
+	return len;
+} /* encode_verdict */
+
+
+/*-----------------------------------------------------------------------------
+ *  Decoding
+ *-----------------------------------------------------------------------------*/
+
+/* decode_challenge */
+SHA256Challenge *
+decode_challenge (const WirePacket *pkt)
+{
+	if (!pkt || pkt->type != WIRE_CHALLENGE)
+		return NULL;
+
+	/* a view of the body, the arrays are laid out like the flat challenge */
+	SHA256FlatChallenge view;
+	view.timestamp = pkt->timestamp;
+	view.num_subpuzzles = pkt->k;
+	view.difficulty = pkt->m;
+	view.preimages = (unsigned char *) pkt->body;
+	view.images = view.preimages + (size_t) pkt->k * SHA256_DIGEST_LEN;
+
+	return unflatten_challenge (&view);
+} /* decode_challenge */
+
+/* decode_solution */
+SHA256Solution *
+decode_solution (const WirePacket *pkt)
+{
+	SHA256FlatSolution view;
+	if (wire_view_solution (pkt, &view) != 0)
+		return NULL;
+
+	return unflatten_solution (&view);
+} /* decode_solution */
+
+/* decode_optchallenge */
+SHA256OptChallenge *
+decode_optchallenge (const WirePacket *pkt)
+{
+	if (!pkt || pkt->type != WIRE_OPT_CHALLENGE)
+		return NULL;
+
+	unsigned char *x = dup_openssl (pkt->body, pkt->elem_len);
+	if (!x)
+		return NULL;
+
+	SHA256OptChallenge *challenge = create_optchallenge ();
+	if (!challenge)
+	{
+		OPENSSL_free (x);
+		return NULL;
+	}
+	initOptChallenge (challenge, x, pkt->timestamp, 2 * pkt->elem_len, pkt->k, pkt->m);
+
+	return challenge;
+} /* decode_optchallenge */
+
+/* decode_optsolution */
+SHA256OptSolution *
+decode_optsolution (const WirePacket *pkt)
+{
+	SHA256OptFlatSolution view;
+	if (wire_view_optsolution (pkt, &view) != 0)
+		return NULL;
+
+	return unflatten_optsolution (&view);
+} /* decode_optsolution */
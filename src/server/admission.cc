@@ -0,0 +1,318 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  admission.cc
+ *
+ *    Description:  Implementation of the admission queue and the client records
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 10:58:40 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/admission.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+/* A waiting request, kept with the key it is ordered by */
+typedef struct AdmissionEntry {
+	uint64_t deadline;
+	VerifyRequest *req;
+} AdmissionEntry;
+
+/* the order of the heaps, the earliest deadline on top */
+static inline bool
+later (const AdmissionEntry &a, const AdmissionEntry &b)
+{
+	return a.deadline > b.deadline;
+} /* later */
+
+/* Every level is a binary heap on the deadlines, so the most urgent request
+ * of the highest level and the oldest of the lowest are both at a top. */
+struct AdmissionQueue {
+	std::mutex lock;					/* Protects everything below */
+	std::condition_variable ready;		/* Signals a new request or the close */
+	std::vector<AdmissionEntry> levels[ADMISSION_LEVELS];
+	unsigned int capacity;
+	unsigned int depth;
+	bool closed;
+
+	uint64_t admitted;
+	uint64_t taken;
+	uint64_t shed;
+	uint64_t expired;
+};
+
+/* admission_clock */
+uint64_t
+admission_clock ()
+{
+	timespec t;
+	clock_gettime (CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000000ULL + t.tv_nsec;
+} /* admission_clock */
+
+/* create_admission_queue */
+AdmissionQueue *
+create_admission_queue (unsigned int capacity)
+{
+	if (capacity == 0)
+		return NULL;
+
+	AdmissionQueue *q = new AdmissionQueue;
+	q->capacity = capacity;
+	q->depth = 0;
+	q->closed = false;
+	q->admitted = q->taken = q->shed = q->expired = 0;
+
+	/* the heaps never grow while serving */
+	for (unsigned int l = 0; l < ADMISSION_LEVELS; l++)
+		q->levels[l].reserve (capacity);
+
+	return q;
+} /* create_admission_queue */
+
+/* free_admission_queue */
+void
+free_admission_queue (AdmissionQueue *q)
+{
+	delete q;
+} /* free_admission_queue */
+
+/* take the top of a level */
+static VerifyRequest *
+pop_level (AdmissionQueue *q, unsigned int l)
+{
+	std::vector<AdmissionEntry> &heap = q->levels[l];
+	std::pop_heap (heap.begin (), heap.end (), later);
+	VerifyRequest *req = heap.back ().req;
+	heap.pop_back ();
+
+	q->depth--;
+	return req;
+} /* pop_level */
+
+/* admission_push */
+int
+admission_push (AdmissionQueue *q, VerifyRequest *req, VerifyRequest **shed)
+{
+	*shed = NULL;
+	unsigned int level = (req->priority < ADMISSION_LEVELS)?
+		req->priority : ADMISSION_LEVELS - 1;
+
+	std::lock_guard<std::mutex> guard (q->lock);
+	if (q->closed)
+		return -1;
+
+	if (q->depth == q->capacity)
+	{ /* the lowest level gives up its oldest, unless the new one ranks lower */
+		unsigned int low = 0;
+		while (q->levels[low].empty ())
+			low++;
+
+		const AdmissionEntry &oldest = q->levels[low].front ();
+		if (level < low || (level == low && req->deadline <= oldest.deadline))
+		{
+			q->shed++;
+			return -1;
+		}
+
+		*shed = pop_level (q, low);
+		q->shed++;
+	}
+
+	std::vector<AdmissionEntry> &heap = q->levels[level];
+	heap.push_back ({ req->deadline, req });
+	std::push_heap (heap.begin (), heap.end (), later);
+	q->depth++;
+	q->admitted++;
+
+	q->ready.notify_one ();
+	return 0;
+} /* admission_push */
+
+/* admission_take */
+unsigned int
+admission_take (AdmissionQueue *q, VerifyRequest **reqs, unsigned int max,
+		VerifyRequest **expired, unsigned int *nexpired)
+{
+	*nexpired = 0;
+
+	std::unique_lock<std::mutex> guard (q->lock);
+	q->ready.wait (guard, [q] () { return q->depth > 0 || q->closed; });
+
+	uint64_t now = admission_clock ();
+	unsigned int n = 0;
+	for (int l = ADMISSION_LEVELS - 1; l >= 0 && n < max && *nexpired < max; l--)
+	{
+		std::vector<AdmissionEntry> &heap = q->levels[l];
+		while (!heap.empty () && n < max && *nexpired < max)
+		{
+			/* a verdict after its deadline helps nobody, skip the work */
+			if (heap.front ().deadline < now)
+				expired[(*nexpired)++] = pop_level (q, l);
+			else
+				reqs[n++] = pop_level (q, l);
+		}
+	}
+
+	q->taken += n;
+	q->expired += *nexpired;
+
+	/* leave the rest to the other takers */
+	if (q->depth > 0)
+		q->ready.notify_one ();
+
+	return n;
+} /* admission_take */
+
+/* admission_close */
+void
+admission_close (AdmissionQueue *q)
+{
+	std::lock_guard<std::mutex> guard (q->lock);
+	q->closed = true;
+	q->ready.notify_all ();
+} /* admission_close */
+
+/* admission_stats */
+void
+admission_stats (AdmissionQueue *q, AdmissionStats *stats)
+{
+	memset (stats, 0, sizeof (*stats));
+	if (!q)
+		return; /* nothing to do */
+
+	std::lock_guard<std::mutex> guard (q->lock);
+	stats->admitted = q->admitted;
+	stats->taken = q->taken;
+	stats->shed = q->shed;
+	stats->expired = q->expired;
+	stats->depth = q->depth;
+	for (unsigned int l = 0; l < ADMISSION_LEVELS; l++)
+		stats->level_depth[l] = q->levels[l].size ();
+} /* admission_stats */
+
+
+/*-----------------------------------------------------------------------------
+ *  The records of the clients
+ *-----------------------------------------------------------------------------*/
+
+/* The verified solutions of a record are in the low half, the failed ones
+ * in the high half */
+#define SCORE_OK(r) 	((r) & 0xffff)
+#define SCORE_BAD(r) 	((r) >> 16)
+#define SCORE_MAX 		0xffff
+
+/* The verified solutions in a row that make a client trusted */
+#define SCORE_TRUSTED 	8
+
+struct AdmissionScores {
+	std::atomic<uint32_t> *records;
+	size_t mask;
+};
+
+/* the slot of the record of some connection data, FNV-1a */
+static inline size_t
+score_slot (const AdmissionScores *scores, const unsigned char *data, unsigned int data_len)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (unsigned int i = 0; i < data_len; i++)
+		h = (h ^ data[i]) * 0x100000001b3ULL;
+
+	return (h ^ (h >> 32)) & scores->mask;
+} /* score_slot */
+
+/* create_admission_scores */
+AdmissionScores *
+create_admission_scores (unsigned int slots)
+{
+	if (slots == 0)
+		return NULL;
+
+	size_t n = 1;
+	while (n < slots)
+		n <<= 1;
+
+	AdmissionScores *scores = new AdmissionScores;
+	scores->records = new std::atomic<uint32_t>[n];
+	scores->mask = n - 1;
+	for (size_t i = 0; i < n; i++)
+		scores->records[i].store (0, std::memory_order_relaxed);
+
+	return scores;
+} /* create_admission_scores */
+
+/* free_admission_scores */
+void
+free_admission_scores (AdmissionScores *scores)
+{
+	if (!scores)
+		return; /* nothing to do */
+
+	delete [] scores->records;
+	delete scores;
+} /* free_admission_scores */
+
+/* admission_record */
+void
+admission_record (AdmissionScores *scores, const unsigned char *data,
+		unsigned int data_len, bool ok)
+{
+	if (!scores)
+		return; /* nothing to do */
+
+	std::atomic<uint32_t> *record = &scores->records[score_slot (scores, data, data_len)];
+	uint32_t r = record->load (std::memory_order_relaxed);
+	uint32_t next;
+	do
+	{
+		uint32_t good = SCORE_OK (r), bad = SCORE_BAD (r);
+		if (good == SCORE_MAX || bad == SCORE_MAX)
+		{ /* halve both, the recent past weighs more */
+			good >>= 1;
+			bad >>= 1;
+		}
+
+		if (ok)
+			good++;
+		else
+			bad++;
+		next = (bad << 16) | good;
+	} while (!record->compare_exchange_weak (r, next, std::memory_order_relaxed));
+} /* admission_record */
+
+/* admission_level */
+unsigned int
+admission_level (const AdmissionScores *scores, const unsigned char *data,
+		unsigned int data_len)
+{
+	if (!scores)
+		return ADMISSION_UNKNOWN;
+
+	uint32_t r = scores->records[score_slot (scores, data, data_len)]
+		.load (std::memory_order_relaxed);
+	uint32_t good = SCORE_OK (r), bad = SCORE_BAD (r);
+
+	if (good + bad < 2)
+		return ADMISSION_UNKNOWN;
+	if (bad >= good)
+		return ADMISSION_SUSPECT;
+	if (good >= SCORE_TRUSTED && bad * 16 <= good)
+		return ADMISSION_TRUSTED;
+
+	return ADMISSION_GOOD;
+} /* admission_level */
@@ -0,0 +1,180 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  difficulty.cc
+ *
+ *    Description:  Implementation of the difficulty controller
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 11:41:16 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/difficulty.h"
+
+#include <math.h>
+#include <string.h>
+
+/* The most levels one period can raise the work by */
+#define DIFFICULTY_MAX_STEP 4
+
+/* difficulty_default_config */
+void
+difficulty_default_config (DifficultyConfig *config)
+{
+	if (!config)
+		return; /* nothing to do */
+
+	config->k_min = 4;
+	config->k_max = 64;
+	config->m_min = 8;
+	config->m_max = 20;
+
+	config->queue_target = 1024;
+	config->cpu_target = 0.8;
+	config->fail_target = 0.5;
+
+	config->smoothing = 0.5;
+	config->raise_above = 1.0;
+	config->lower_below = 0.5;
+	config->cooldown = 2;
+} /* difficulty_default_config */
+
+/* move the parameters to a level of the ladder */
+static void
+set_level (DifficultyController *ctl, unsigned int level)
+{
+	const DifficultyConfig *c = &ctl->config;
+	unsigned int m_levels = c->m_max - c->m_min;
+
+	ctl->level = level;
+	if (level <= m_levels)
+	{
+		ctl->k = c->k_min;
+		ctl->m = c->m_min + level;
+	} else
+	{
+		ctl->k = c->k_min << (level - m_levels);
+		ctl->m = c->m_max;
+	}
+} /* set_level */
+
+/* init_difficulty */
+int
+init_difficulty (DifficultyController *ctl, const DifficultyConfig *config)
+{
+	if (!ctl)
+		return -1; /* nothing to do */
+
+	if (config)
+		ctl->config = *config;
+	else
+		difficulty_default_config (&ctl->config);
+
+	const DifficultyConfig *c = &ctl->config;
+	if (c->k_min == 0 || c->k_min > c->k_max || c->m_min > c->m_max
+			|| c->smoothing <= 0 || c->smoothing > 1
+			|| c->lower_below < 0 || c->lower_below >= c->raise_above)
+		return -1;
+
+	/* the doublings of k that stay within k_max */
+	unsigned int k_levels = 0;
+	while ((uint32_t) (c->k_min << (k_levels + 1)) <= c->k_max)
+		k_levels++;
+
+	ctl->max_level = (c->m_max - c->m_min) + k_levels;
+	ctl->load = 0;
+	ctl->hold = 0;
+	set_level (ctl, 0);
+
+	return 0;
+} /* init_difficulty */
+
+/* the ratio of a signal to its target, 0 if it is ignored */
+static inline double
+ratio (double value, double target)
+{
+	return target > 0 ? value / target : 0;
+} /* ratio */
+
+/* difficulty_update */
+int
+difficulty_update (DifficultyController *ctl, const DifficultySignals *signals)
+{
+	if (!ctl || !signals)
+		return 0; /* nothing to do */
+
+	const DifficultyConfig *c = &ctl->config;
+
+	/* the busiest resource sets the load */
+	uint64_t total = signals->verified + signals->failed;
+	double fail_rate = total > 0 ? (double) signals->failed / total : 0;
+
+	double sample = ratio (signals->queue_depth, c->queue_target);
+	sample = fmax (sample, ratio (signals->cpu_util, c->cpu_target));
+	sample = fmax (sample, ratio (fail_rate, c->fail_target));
+
+	ctl->load += c->smoothing * (sample - ctl->load);
+
+	if (ctl->hold > 0)
+	{ /* let the last change take effect first */
+		ctl->hold--;
+		return 0;
+	}
+
+	int step = 0;
+	if (ctl->load > c->raise_above)
+	{ /* one doubling per doubling of the overload, an attack is met fast */
+		step = 1 + (int) floor (log2 (ctl->load / c->raise_above));
+		if (step > DIFFICULTY_MAX_STEP)
+			step = DIFFICULTY_MAX_STEP;
+		if (ctl->level + step > ctl->max_level)
+			step = ctl->max_level - ctl->level;
+	} else if (ctl->load < c->lower_below && ctl->level > 0)
+	{ /* come down one doubling at a time, the attack may be back */
+		step = -1;
+	}
+
+	if (step != 0)
+	{
+		set_level (ctl, ctl->level + step);
+		ctl->hold = c->cooldown;
+	}
+
+	return step;
+} /* difficulty_update */
+
+/* difficulty_params */
+void
+difficulty_params (const DifficultyController *ctl, uint16_t *k, uint16_t *m)
+{
+	if (!ctl)
+		return; /* nothing to do */
+
+	if (k)
+		*k = ctl->k;
+	if (m)
+		*m = ctl->m;
+} /* difficulty_params */
+
+/* difficulty_signals_from_metrics */
+void
+difficulty_signals_from_metrics (DifficultySignals *signals,
+		const metrics_snapshot_t *before, const metrics_snapshot_t *after)
+{
+	if (!signals || !before || !after)
+		return; /* nothing to do */
+
+	signals->verified = after->counters[METRIC_VERIFY_OK] - before->counters[METRIC_VERIFY_OK];
+
+	/* every other outcome is a rejection */
+	signals->failed = 0;
+	for (unsigned int c = METRIC_VERIFY_EMPTY; c <= METRIC_VERIFY_MALFORMED; c++)
+		signals->failed += after->counters[c] - before->counters[c];
+} /* difficulty_signals_from_metrics */
@@ -0,0 +1,315 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  keyring.cc
+ *
+ *    Description:  Implementation of the keys by epoch and their read sections
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 01:26:15 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/keyring.h"
+#include "puzzle/metrics.h"
+#include "puzzle/wire.h"
+
+#include <openssl/crypto.h>
+#include <sched.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+
+/* A thread that reads keyrings. Its section holds the grace period it
+ * started in, 0 outside of a section. */
+typedef struct keyring_reader_t {
+	std::atomic<uint64_t> section;
+	keyring_reader_t *next;
+} keyring_reader_t;
+
+/* The readers of the live threads, shared by every keyring */
+static std::mutex registry_lock;
+static keyring_reader_t *registry = NULL;
+
+/* Moves on with every rotation, a reader that started before a rotation
+ * holds a smaller value */
+static std::atomic<uint64_t> grace_period (1);
+
+static thread_local keyring_reader_t *thread_reader = NULL;
+
+/* unregisters the reader of an exiting thread */
+typedef struct keyring_reaper {
+	~keyring_reaper ()
+	{
+		keyring_reader_t *reader = thread_reader;
+		if (!reader)
+			return;
+
+		std::lock_guard<std::mutex> lock (registry_lock);
+		for (keyring_reader_t **it = &registry; *it; it = &(*it)->next)
+		{
+			if (*it == reader)
+			{
+				*it = reader->next;
+				break;
+			}
+		}
+
+		thread_reader = NULL;
+		delete reader;
+	}
+} keyring_reaper;
+
+static thread_local keyring_reaper thread_reaper;
+
+struct PlutusKeyring {
+	std::atomic<KeyringSnapshot *> keys;	/* What the readers see */
+	std::atomic<uint32_t> epoch;			/* The epoch of the current key */
+	std::mutex rotate_lock;					/* Serializes the rotations */
+};
+
+/* register the calling thread as a reader, once */
+static keyring_reader_t *
+register_reader ()
+{
+	keyring_reader_t *reader = new keyring_reader_t;
+	reader->section.store (0, std::memory_order_relaxed);
+
+	/* the first touch sets up the reaper of this thread */
+	(void) &thread_reaper;
+
+	std::lock_guard<std::mutex> lock (registry_lock);
+	reader->next = registry;
+	registry = reader;
+	thread_reader = reader;
+	return reader;
+} /* register_reader */
+
+/* wait until every reader that may have seen the keys replaced before
+ * this call is out of its section */
+static void
+wait_for_readers ()
+{
+	uint64_t period = grace_period.fetch_add (1, std::memory_order_seq_cst) + 1;
+
+	std::lock_guard<std::mutex> lock (registry_lock);
+	for (keyring_reader_t *reader = registry; reader; reader = reader->next)
+	{
+		uint64_t section;
+		while ((section = reader->section.load (std::memory_order_seq_cst)) != 0
+				&& section < period)
+			sched_yield ();
+	}
+} /* wait_for_readers */
+
+/* wipe and free keys no reader can see */
+static void
+free_snapshot (KeyringSnapshot *keys)
+{
+	OPENSSL_cleanse (keys, sizeof (KeyringSnapshot));
+	delete keys;
+} /* free_snapshot */
+
+/* create_keyring */
+PlutusKeyring *
+create_keyring (const unsigned char *key, unsigned int key_len,
+		uint16_t k, uint16_t m, unsigned int l)
+{
+	KeyringSnapshot *keys = new KeyringSnapshot;
+	memset (keys, 0, sizeof (KeyringSnapshot));
+	if (init_minter (&keys->current, key, key_len, 0, k, m, l) != 0)
+	{
+		delete keys;
+		return NULL;
+	}
+
+	keys->since = 0;
+	keys->has_previous = false;
+
+	PlutusKeyring *ring = new PlutusKeyring;
+	ring->keys.store (keys, std::memory_order_release);
+	ring->epoch.store (0, std::memory_order_release);
+	return ring;
+} /* create_keyring */
+
+/* free_keyring */
+void
+free_keyring (PlutusKeyring *ring)
+{
+	if (!ring)
+		return; /* nothing to do */
+
+	free_snapshot (ring->keys.load (std::memory_order_acquire));
+	delete ring;
+} /* free_keyring */
+
+/* keyring_rotate */
+int64_t
+keyring_rotate (PlutusKeyring *ring, const unsigned char *key,
+		unsigned int key_len, uint32_t since)
+{
+	std::lock_guard<std::mutex> guard (ring->rotate_lock);
+
+	/* only rotations change the keys, and they hold the lock */
+	KeyringSnapshot *old = ring->keys.load (std::memory_order_relaxed);
+	if (since <= old->since)
+		return -1;
+
+	KeyringSnapshot *keys = new KeyringSnapshot;
+	memset (keys, 0, sizeof (KeyringSnapshot));
+	uint32_t epoch = old->current.epoch + 1;
+	if (init_minter (&keys->current, key, key_len, epoch,
+				old->current.k, old->current.m, old->current.l) != 0)
+	{
+		delete keys;
+		return -1;
+	}
+
+	keys->since = since;
+	keys->previous = old->current;
+	keys->previous_since = old->since;
+	keys->has_previous = true;
+
+	ring->keys.store (keys, std::memory_order_seq_cst);
+	ring->epoch.store (epoch, std::memory_order_release);
+	wait_for_readers ();
+	free_snapshot (old);
+
+	return epoch;
+} /* keyring_rotate */
+
+/* keyring_epoch */
+uint32_t
+keyring_epoch (const PlutusKeyring *ring)
+{
+	return ring->epoch.load (std::memory_order_acquire);
+} /* keyring_epoch */
+
+/* keyring_enter */
+const KeyringSnapshot *
+keyring_enter (PlutusKeyring *ring)
+{
+	keyring_reader_t *reader = thread_reader;
+	if (!reader)
+		reader = register_reader ();
+
+	/* announce the section before looking at the keys, a rotation that
+	 * replaces them after this waits for us */
+	reader->section.store (grace_period.load (std::memory_order_seq_cst),
+			std::memory_order_seq_cst);
+	return ring->keys.load (std::memory_order_seq_cst);
+} /* keyring_enter */
+
+/* keyring_exit */
+void
+keyring_exit (PlutusKeyring *)
+{
+	thread_reader->section.store (0, std::memory_order_release);
+} /* keyring_exit */
+
+/* keyring_select */
+const SHA256OptMinter *
+keyring_select (const KeyringSnapshot *keys, uint32_t timestamp)
+{
+	if (timestamp >= keys->since)
+		return &keys->current;
+	if (keys->has_previous && timestamp >= keys->previous_since)
+		return &keys->previous;
+
+	return NULL;
+} /* keyring_select */
+
+/* the minter of the timestamp of a packet. One too short to have a
+ * timestamp goes to the current key, which finds it malformed. */
+static const SHA256OptMinter *
+select_packet (const KeyringSnapshot *keys, const unsigned char *pkt, size_t pkt_len)
+{
+	uint32_t timestamp;
+	if (wire_peek_timestamp (pkt, pkt_len, &timestamp) != 0)
+		return &keys->current;
+
+	return keyring_select (keys, timestamp);
+} /* select_packet */
+
+/* keyring_mint_packets */
+unsigned int
+keyring_mint_packets (PlutusKeyring *ring, SHA256OptPacketItem *items,
+		unsigned int n, uint32_t timestamp)
+{
+	const KeyringSnapshot *keys = keyring_enter (ring);
+	const SHA256OptMinter *minter = keyring_select (keys, timestamp);
+	unsigned int minted = 0;
+	if (minter)
+	{
+		minted = minter_mint_packets (minter, items, n, timestamp);
+	} else
+	{ /* the clock went back past every key, nothing is written */
+		for (unsigned int j = 0; j < n; j++)
+			items[j].pkt_len = 0;
+	}
+	keyring_exit (ring);
+
+	return minted;
+} /* keyring_mint_packets */
+
+/* keyring_verify_packet */
+verify_status_t
+keyring_verify_packet (PlutusKeyring *ring, const unsigned char *pkt, size_t pkt_len,
+		const unsigned char *data, unsigned int data_len,
+		const SHA256OptVerifyParams *params)
+{
+	verify_status_t status = VERIFY_STALE;
+
+	const KeyringSnapshot *keys = keyring_enter (ring);
+	const SHA256OptMinter *minter = select_packet (keys, pkt, pkt_len);
+	if (minter)
+		status = minter_verify_packet (minter, pkt, pkt_len, data, data_len, params);
+	else
+		metrics_add (METRIC_VERIFY_STALE, 1);
+	keyring_exit (ring);
+
+	return status;
+} /* keyring_verify_packet */
+
+/* keyring_verify_packets */
+unsigned int
+keyring_verify_packets (PlutusKeyring *ring, const SHA256OptPacketItem *items,
+		unsigned int n, const SHA256OptVerifyParams *params, verify_status_t *statuses)
+{
+	unsigned int ok = 0;
+	const KeyringSnapshot *keys = keyring_enter (ring);
+
+	/* a batch is almost always of one key, it only splits around a rotation */
+	unsigned int first = 0;
+	while (first < n)
+	{
+		const SHA256OptMinter *minter = select_packet (keys, items[first].pkt,
+				items[first].pkt_len);
+		unsigned int end = first + 1;
+		while (end < n && select_packet (keys, items[end].pkt, items[end].pkt_len) == minter)
+			end++;
+
+		if (minter)
+		{
+			ok += minter_verify_packets (minter, items + first, end - first,
+					params, statuses + first);
+		} else
+		{
+			for (unsigned int j = first; j < end; j++)
+				statuses[j] = VERIFY_STALE;
+			metrics_add (METRIC_VERIFY_STALE, end - first);
+		}
+
+		first = end;
+	}
+
+	keyring_exit (ring);
+	return ok;
+} /* keyring_verify_packets */
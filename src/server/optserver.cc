@@ -19,9 +19,18 @@
 #include "server/optserver.h"
 #include "puzzle/factory.h"
 #include "puzzle/crypto_util.h"
+#include "puzzle/sha256_mb.h"
+#include "puzzle/metrics.h"
+#include "puzzle/wire.h"
 
 #include <string.h>
 
+/* The number of x || i || zi messages hashed together by the batch verifier */
+#define VERIFY_BATCH_LANES (4 * SHA256_MB_MAX_LANES)
+
+/* The number of solutions of a batch that are hashed together */
+#define VERIFY_BATCH_CHUNK 64
+
 /* generate_challenge */
 SHA256OptChallenge *
 generate_challenge (unsigned char *data, unsigned int data_len,
@@ -44,62 +53,437 @@ generate_challenge (unsigned char *data, unsigned int data_len,
 		return NULL;
 	}
 
-	/* record timing information */
-	timespec start, end;
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &start);
+	/* a one off minter, servers minting many challenges keep theirs */
+	SHA256OptMinter minter;
+	if (init_minter (&minter, key, key_len, 0, k, m, l) != 0)
+	{
+		printf ("[ERROR]: (l/2) needs to be a non zero multiple of 8 of at most 256 bits, and m at most (l/2).\n");
+		return NULL;
+	}
+
+	SHA256OptChallenge *challenge = mint_challenge (&minter, data, data_len, timestamp);
+	clear_minter (&minter);
+
+	/* done here. return */
+	return challenge;
+} /* generate_challenge */
+
+/* init_minter */
+int
+init_minter (SHA256OptMinter *minter, const unsigned char *key,
+		unsigned int key_len, uint32_t epoch,
+		uint16_t k, uint16_t m, unsigned int l)
+{
+	if (!minter || (!key && key_len > 0))
+		return -1; /* nothing to do */
+
+	/* x is the first (l/2) bits of a digest */
+	unsigned int xlen = (l/2)/8;
+	if ((l/2) % 8 != 0 || xlen == 0 || xlen > SHA256_DIGEST_LEN)
+		return -1;
+
+	/* the bits of difficulty come out of x, more could never be solved */
+	if (m > 8*xlen)
+		return -1;
 
-	/* build the buffer = key || data || timestamp */
-	unsigned int buf_len = data_len + key_len + sizeof (uint32_t);
-	unsigned char *buf = (unsigned char *)
-		malloc (buf_len * sizeof (unsigned char));
+	/* absorb the key once for the whole epoch */
+	sha256_init (&minter->keyed);
+	sha256_update (&minter->keyed, key, key_len);
 
-	/* start appending the concatenation elements */
-	unsigned char *tbuf = buf;
-	tbuf = append_buffer (tbuf, key, key_len);
-	tbuf = append_buffer (tbuf, data, data_len);
-	tbuf = append_buffer (tbuf, (unsigned char*) &timestamp, 
-			sizeof (uint32_t));
+	minter->epoch = epoch;
+	minter->k = k;
+	minter->m = m;
+	minter->l = l;
 
-	/* perform the hasing operation */
-	unsigned int h_len;
-	unsigned char *h = digest_message (buf, buf_len, &h_len);
+	return 0;
+} /* init_minter */
+
+/* clear_minter */
+void
+clear_minter (SHA256OptMinter *minter)
+{
+	if (!minter)
+		return; /* nothing to do */
+
+	/* the hash state is as good as the key */
+	OPENSSL_cleanse (minter, sizeof (SHA256OptMinter));
+} /* clear_minter */
+
+/* minter_derive */
+void
+minter_derive (const SHA256OptMinter *minter, const unsigned char *data,
+		unsigned int data_len, uint32_t timestamp, unsigned char *x)
+{
+	/* x = h (key || data || timestamp), starting after the key */
+	unsigned char h[SHA256_DIGEST_LEN];
+	SHA256Ctx ctx = minter->keyed;
+
+	sha256_update (&ctx, data, data_len);
+	sha256_update (&ctx, (unsigned char *) &timestamp, sizeof(uint32_t));
+	sha256_final (&ctx, h);
+
+	memcpy (x, h, (minter->l/2)/8);
+} /* minter_derive */
+
+/* mint_challenge */
+SHA256OptChallenge *
+mint_challenge (const SHA256OptMinter *minter, const unsigned char *data,
+		unsigned int data_len, uint32_t timestamp)
+{
+	if (!minter || (!data && data_len > 0))
+		return NULL; /* nothing to do */
+
+	uint64_t start = metrics_now ();
+
+	unsigned int x_len = (minter->l/2)/8;
+	unsigned char *x = (unsigned char *)
+		OPENSSL_malloc (x_len * sizeof (unsigned char));
+	if (!x)
+		return NULL;
 
-	/* another sanity check */
-	if (!h)
+	minter_derive (minter, data, data_len, timestamp, x);
+
+	/* allocate and initialize the challenge */
+	SHA256OptChallenge *challenge = create_optchallenge ();
+	if (!challenge)
 	{
-		printf ("[ERROR]: Cannot build SHA256\n");
-		exit (-1); /* something really went wrong, just exit */
+		OPENSSL_free (x);
+		return NULL;
 	}
+	initOptChallenge (challenge, x, timestamp, 2*x_len, minter->k, minter->m);
+
+	metrics_add (METRIC_CHALLENGES_MINTED, 1);
+	metrics_add (METRIC_HASHES, 1);
+	metrics_observe (METRIC_LAT_GENERATE_CHALLENGE, start);
+
+	return challenge;
+} /* mint_challenge */
 
-	/* save the first l bits of x */
-	if (l % 8 != 0) 
+/* check the length of x and the bits of difficulty. On success xlen holds
+ * the length of x in bytes. */
+static verify_status_t
+check_params (uint16_t len, uint16_t m, unsigned int *xlen)
+{
+	/* x is the first (l/2) bits of a digest and the m bits of difficulty
+	 * are taken from x, as the client does */
+	unsigned int l = len/2;
+	if (l % 8 != 0 || l/8 == 0 || l/8 > SHA256_DIGEST_LEN)
+		return VERIFY_BAD_PARAMS;
+	if (m > l)
+		return VERIFY_BAD_PARAMS;
+
+	*xlen = l/8;
+	return VERIFY_OK;
+} /* check_params */
+
+/* reject old timestamps and the ones we never gave out */
+static inline verify_status_t
+check_timestamp (uint32_t timestamp, const SHA256OptVerifyParams *params)
+{
+	if (params && params->max_age > 0)
 	{
-		printf ("[ERROR]: (l/2) needs to be a multiple of 8.\n");
-		exit(-1);
+		if (timestamp > params->now || params->now - timestamp > params->max_age)
+			return VERIFY_STALE;
 	}
 
-	unsigned int x_len = (l/2)/8;
-	unsigned char *x = (unsigned char *)
-		malloc (x_len * sizeof (unsigned char));
-	/* copy the data from the hash output */
-	memcpy (x, h, x_len);
+	return VERIFY_OK;
+} /* check_timestamp */
 
-	/* allocate and initialize the challenge */
-	SHA256OptChallenge *challenge = create_optchallenge ();
-	initOptChallenge (challenge, x, timestamp, 2*x_len, k, m);
+/* check everything that does not need a hash, from cheapest to dearest.
+ * On success xlen holds the length of x in bytes. */
+static verify_status_t
+precheck_solution (SHA256OptSolution *sol, uint16_t len, uint16_t k,
+		uint16_t m, const SHA256OptVerifyParams *params, unsigned int *xlen)
+{
+	if (!sol)
+		return VERIFY_EMPTY; /* empty solution */
 
-	/* record the end timing */
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &end);
-	double difftime = time_diff (start, end);
-	printf ("Time needed to generate the challenge is %lf seconds.\n", difftime);
+	verify_status_t status = check_params (len, m, xlen);
+	if (status == VERIFY_OK)
+		status = check_timestamp (sol->timestamp, params);
+	if (status != VERIFY_OK)
+		return status;
 
-	/* free the created buffer */
-	OPENSSL_free (h);
-	free (buf);
+	/* walk the list once, there must be k non empty sub solutions */
+	SHA256OptSubSolution *head = sol->head;
+	for (uint16_t i = 0; i < k; i++)
+	{
+		if (!head)
+			return VERIFY_SHORT;
+		if (!head->zi)
+			return VERIFY_EMPTY;
 
-	/* done here. return */
-	return challenge;
-} /* generate_challenge */
+		head = head->next;
+	}
+
+	return VERIFY_OK;
+} /* precheck_solution */
+
+/* remember a solution that passed, only the first of its copies gets in */
+static verify_status_t
+remember_solution (SHA256OptReplayCache *replay, uint32_t timestamp, uint64_t fp)
+{
+	if (!replay)
+		return VERIFY_OK; /* no memory of the past */
+
+	switch (replay_remember (replay, timestamp, fp))
+	{
+		case REPLAY_SEEN:
+			return VERIFY_REPLAY;
+		case REPLAY_FULL:
+			/* it is valid, it only cannot be remembered */
+			metrics_add (METRIC_REPLAY_FULL, 1);
+			return VERIFY_OK;
+		default:
+			return VERIFY_OK;
+	}
+} /* remember_solution */
+
+/* The values of z_i being verified, from a list or from an array */
+typedef struct {
+	SHA256OptSubSolution *node;		/* The next node of a list */
+	const unsigned char *zi;		/* The next value of an array, NULL for a list */
+	unsigned int stride;			/* The distance between values of the array */
+} zi_cursor_t;
+
+static inline const unsigned char *
+next_zi (zi_cursor_t *cursor)
+{
+	const unsigned char *zi;
+	if (cursor->zi)
+	{
+		zi = cursor->zi;
+		cursor->zi += cursor->stride;
+	} else
+	{
+		zi = cursor->node->zi;
+		cursor->node = cursor->node->next;
+	}
+
+	return zi;
+} /* next_zi */
+
+/* the hashing stage, it rebuilds x and checks the k values of z_i from the
+ * cursor, stopping at the first one that fails */
+static verify_status_t
+hash_stage (const SHA256Ctx *keyed, uint32_t timestamp,
+		const unsigned char *data, unsigned int data_len,
+		unsigned int xlen, uint16_t k, uint16_t m,
+		zi_cursor_t *cursor, uint64_t *hashes)
+{
+	/* x = h (key || data || timestamp) */
+	unsigned char h[SHA256_DIGEST_LEN];
+
+	SHA256Ctx ctx = *keyed;
+	sha256_update (&ctx, data, data_len);
+	sha256_update (&ctx, (unsigned char *) &timestamp, sizeof(uint32_t));
+	sha256_final (&ctx, h);
+	(*hashes)++;
+
+	/* only need one place holder for doing hashes, it is
+	 * x || i || zi, with x fixed everywhere
+	 */
+	unsigned char msg[2*SHA256_DIGEST_LEN + sizeof(uint16_t)];
+	unsigned int msg_len = 2*xlen + sizeof(uint16_t);
+	unsigned char *digest = append_buffer (msg, h, xlen);
+
+	for (uint16_t i = 0; i < k; i++)
+	{ /* iterate over all subpuzzles, the caller checked there are k */
+		unsigned char *tmp = append_buffer (digest, (unsigned char *)&i,
+				sizeof(uint16_t));
+		memcpy (tmp, next_zi (cursor), xlen);
+
+		unsigned char hash[SHA256_DIGEST_LEN];
+		sha256_digest (msg, msg_len, hash);
+		(*hashes)++;
+
+		/* verify that first m bits of (x || i || zi) are the same as h(x||i||zi) */
+		if (!compare_bits (hash, msg, m))
+			return VERIFY_FAILED;
+	}
+
+	return VERIFY_OK;
+} /* hash_stage */
+
+/* run both stages of the verification given the hash state after
+ * absorbing the key, counting the hashes computed */
+static verify_status_t
+verify_stages (const SHA256Ctx *keyed, SHA256OptSolution *sol,
+		unsigned char *data, unsigned int data_len,
+		uint16_t len, uint16_t k, uint16_t m,
+		const SHA256OptVerifyParams *params, uint64_t *hashes)
+{
+	/* the zero hash stage */
+	unsigned int xlen;
+	verify_status_t status = precheck_solution (sol, len, k, m, params, &xlen);
+	if (status != VERIFY_OK)
+		return status;
+
+	/* a replay costs a fingerprint instead of k + 1 hashes */
+	SHA256OptReplayCache *replay = params ? params->replay : NULL;
+	uint64_t fp = 0;
+	if (replay)
+	{
+		fp = replay_fingerprint (replay, sol, xlen, k, data, data_len);
+		if (replay_seen (replay, sol->timestamp, fp))
+			return VERIFY_REPLAY;
+	}
+
+	zi_cursor_t cursor = { sol->head, NULL, 0 };
+	status = hash_stage (keyed, sol->timestamp, data, data_len, xlen, k, m,
+			&cursor, hashes);
+	if (status != VERIFY_OK)
+		return status;
+
+	return remember_solution (replay, sol->timestamp, fp);
+} /* verify_stages */
+
+/* check a flat solution, from cheapest to dearest */
+static inline verify_status_t
+precheck_flat (const SHA256OptFlatSolution *view, unsigned int xlen,
+		uint16_t k, const SHA256OptVerifyParams *params)
+{
+	if (view->zlen != xlen || view->num_subsolutions > k)
+		return VERIFY_MALFORMED;
+	if (view->num_subsolutions < k)
+		return VERIFY_SHORT;
+
+	return check_timestamp (view->timestamp, params);
+} /* precheck_flat */
+
+/* check a packet where it lies, from cheapest to dearest. On success view
+ * looks at its values of z_i. */
+static verify_status_t
+precheck_packet (const unsigned char *pkt, size_t pkt_len, unsigned int xlen,
+		uint16_t k, const SHA256OptVerifyParams *params, SHA256OptFlatSolution *view)
+{
+	if (!pkt)
+		return VERIFY_EMPTY;
+
+	WirePacket wire;
+	if (wire_parse (pkt, pkt_len, &wire) != WIRE_OK
+			|| wire_view_optsolution (&wire, view) != 0)
+		return VERIFY_MALFORMED;
+
+	return precheck_flat (view, xlen, k, params);
+} /* precheck_packet */
+
+/* the hashing stage of a flat solution that passed its checks, between the
+ * replay lookup and remembering it */
+static verify_status_t
+flat_stages (const SHA256Ctx *keyed, const SHA256OptFlatSolution *view,
+		const unsigned char *data, unsigned int data_len,
+		unsigned int xlen, uint16_t k, uint16_t m,
+		const SHA256OptVerifyParams *params, uint64_t *hashes)
+{
+	SHA256OptReplayCache *replay = params ? params->replay : NULL;
+	uint64_t fp = 0;
+	if (replay)
+	{
+		fp = replay_fingerprint (replay, view, data, data_len);
+		if (replay_seen (replay, view->timestamp, fp))
+			return VERIFY_REPLAY;
+	}
+
+	zi_cursor_t cursor = { NULL, view->zi, xlen };
+	verify_status_t status = hash_stage (keyed, view->timestamp, data, data_len,
+			xlen, k, m, &cursor, hashes);
+	if (status != VERIFY_OK)
+		return status;
+
+	return remember_solution (replay, view->timestamp, fp);
+} /* flat_stages */
+
+/* the same stages on a packet, read where it lies */
+static verify_status_t
+verify_packet_stages (const SHA256Ctx *keyed, const unsigned char *pkt,
+		size_t pkt_len, const unsigned char *data, unsigned int data_len,
+		uint16_t len, uint16_t k, uint16_t m,
+		const SHA256OptVerifyParams *params, uint64_t *hashes)
+{
+	/* the zero hash stage, the packet is checked in place */
+	unsigned int xlen;
+	SHA256OptFlatSolution view;
+	verify_status_t status = check_params (len, m, &xlen);
+	if (status == VERIFY_OK)
+		status = precheck_packet (pkt, pkt_len, xlen, k, params, &view);
+	if (status != VERIFY_OK)
+		return status;
+
+	return flat_stages (keyed, &view, data, data_len, xlen, k, m, params, hashes);
+} /* verify_packet_stages */
+
+/* verify a packet given the hash state after absorbing the key */
+static verify_status_t
+verify_packet_keyed (const SHA256Ctx *keyed, const unsigned char *pkt,
+		size_t pkt_len, const unsigned char *data, unsigned int data_len,
+		uint16_t len, uint16_t k, uint16_t m,
+		const SHA256OptVerifyParams *params)
+{
+	uint64_t start = metrics_now ();
+	uint64_t hashes = 0;
+
+	verify_status_t status = verify_packet_stages (keyed, pkt, pkt_len,
+			data, data_len, len, k, m, params, &hashes);
+
+	metrics_add ((metric_counter_t) (METRIC_VERIFY_OK + status), 1);
+	metrics_add (METRIC_HASHES, hashes);
+	metrics_observe (METRIC_LAT_VERIFY_OPT, start);
+
+	return status;
+} /* verify_packet_keyed */
+
+/* verify a solution given the hash state after absorbing the key */
+static verify_status_t
+verify_keyed (const SHA256Ctx *keyed, SHA256OptSolution *sol,
+		unsigned char *data, unsigned int data_len,
+		uint16_t len, uint16_t k, uint16_t m,
+		const SHA256OptVerifyParams *params)
+{
+	uint64_t start = metrics_now ();
+	uint64_t hashes = 0;
+
+	verify_status_t status = verify_stages (keyed, sol, data, data_len,
+			len, k, m, params, &hashes);
+
+	/* the counters of the outcomes follow the order of the statuses */
+	metrics_add ((metric_counter_t) (METRIC_VERIFY_OK + status), 1);
+	metrics_add (METRIC_HASHES, hashes);
+	metrics_observe (METRIC_LAT_VERIFY_OPT, start);
+
+	return status;
+} /* verify_keyed */
+
+/* verify_solution_ex */
+verify_status_t
+verify_solution_ex (SHA256OptSolution *sol,
+		unsigned char *data, unsigned int data_len,
+		unsigned char *key, unsigned int key_len,
+		uint16_t len, uint16_t k, uint16_t m,
+		const SHA256OptVerifyParams *params)
+{
+	SHA256Ctx keyed;
+	sha256_init (&keyed);
+	sha256_update (&keyed, key, key_len);
+
+	return verify_keyed (&keyed, sol, data, data_len, len, k, m, params);
+} /* verify_solution_ex */
+
+/* verify_solution_packet */
+verify_status_t
+verify_solution_packet (const unsigned char *pkt, size_t pkt_len,
+		const unsigned char *data, unsigned int data_len,
+		const unsigned char *key, unsigned int key_len,
+		uint16_t len, uint16_t k, uint16_t m,
+		const SHA256OptVerifyParams *params)
+{
+	SHA256Ctx keyed;
+	sha256_init (&keyed);
+	sha256_update (&keyed, key, key_len);
+
+	return verify_packet_keyed (&keyed, pkt, pkt_len, data, data_len,
+			len, k, m, params);
+} /* verify_solution_packet */
 
 /* verify_solution */
 bool
@@ -108,107 +492,513 @@ verify_solution (SHA256OptSolution *sol,
 		unsigned char *key, unsigned int key_len,
 		uint16_t len, uint16_t k, uint16_t m)
 {
-	if (!sol)
-		return false; /* empty solution then return false */
+	verify_status_t status = verify_solution_ex (sol, data, data_len,
+			key, key_len, len, k, m, NULL);
 
-	SHA256OptSubSolution *head = sol->head;
-	uint32_t timestamp = sol->timestamp;
-	uint16_t i = 0; /* the iterator over the k subsolutions */
-
-	/* record timing information */
-	timespec start, end;
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &start);
-
-	/* prepare the buffer for the initial hash operation */
-	unsigned int buf_len = key_len + data_len + sizeof(uint32_t);
-	unsigned char *buf = (unsigned char *)
-		malloc (buf_len * sizeof(unsigned char));
-
-	/* build the concatenation */
-	unsigned char *tbuf = buf;
-	tbuf = append_buffer (tbuf, key, key_len);
-	tbuf = append_buffer (tbuf, data, data_len);
-	tbuf = append_buffer (tbuf, (unsigned char*) &timestamp, 
-			sizeof(uint32_t));
-
-	/* get the hash of the concatenation */
-	unsigned int hlen;
-	unsigned char *h = digest_message (buf, buf_len, &hlen);
-
-	/* get the first (l/2) bits of h */
-	unsigned int l = len/2;
-	if (l % 8 != 0) 
+	if (status == VERIFY_BAD_PARAMS)
+		printf ("[ERROR]: (l/2) needs to be a non zero multiple of 8 of at most 256 bits, and m at most (l/2).\n");
+
+	return status == VERIFY_OK;
+} /* verify_solution */
+
+/* verify_status_name */
+const char *
+verify_status_name (verify_status_t status)
+{
+	switch (status)
 	{
-		printf ("[ERROR]: (l/2) needs to be a multiple of 8.\n");
-		exit(-1);
+		case VERIFY_OK:
+			return "ok";
+		case VERIFY_EMPTY:
+			return "empty";
+		case VERIFY_SHORT:
+			return "short";
+		case VERIFY_STALE:
+			return "stale";
+		case VERIFY_BAD_PARAMS:
+			return "bad parameters";
+		case VERIFY_FAILED:
+			return "failed";
+		case VERIFY_REPLAY:
+			return "replay";
+		case VERIFY_MALFORMED:
+			return "malformed";
+		case VERIFY_SHED:
+			return "shed";
+		default:
+			return "unknown";
 	}
+} /* verify_status_name */
+
+/* A solution of a batch that passed the zero hash stage */
+typedef struct {
+	zi_cursor_t zi;					/* Its values of z_i */
+	uint32_t timestamp;				/* Its timestamp */
+	const unsigned char *data;		/* The data of its connection */
+	unsigned int data_len;			/* The length of the data in bytes */
+	uint64_t fp;					/* Its fingerprint, with a replay cache */
+	unsigned int index;				/* Its place in the batch */
+	uint16_t passed;				/* The number of sub puzzles it passed */
+	verify_status_t status;			/* The outcome of the hashing stage */
+} batch_entry_t;
+
+/* The scratch space of a chunk of a batch, it lives on the stack */
+typedef struct {
+	SHA256Midstate ms;				/* The padding of a x || i || zi message */
+	bool use_mb;					/* Whether the messages fit a midstate */
+	unsigned int msg_len;			/* The length of a x || i || zi message */
+
+	/* The pending messages and the entry each one belongs to */
+	unsigned char msgs[VERIFY_BATCH_LANES * (2*SHA256_DIGEST_LEN + sizeof(uint16_t))];
+	batch_entry_t *owner[VERIFY_BATCH_LANES];
+	unsigned int count;				/* The number of pending messages */
+	uint16_t m;						/* The number of bits of difficulty */
+} verify_batch_t;
+
+/* hash the pending messages together and move their owners along */
+static void
+flush_batch (verify_batch_t *batch)
+{
+	unsigned char digests[VERIFY_BATCH_LANES * SHA256_DIGEST_LEN];
 
-	unsigned int xlen = l/8;
-	unsigned char *x = (unsigned char *)
-		malloc (xlen * sizeof (unsigned char));
-	memcpy (x, h, xlen);
+	if (batch->use_mb)
+	{
+		sha256_mb_digest (&batch->ms, batch->msgs, batch->count, digests);
+	} else
+	{ /* too long for the multi-buffer kernel, one at a time */
+		for (unsigned int j = 0; j < batch->count; j++)
+			sha256_digest (batch->msgs + j * batch->msg_len, batch->msg_len,
+					digests + j * SHA256_DIGEST_LEN);
+	}
 
-	/* free h, we no longer need it */
-	OPENSSL_free (h);
-	free (buf);
+	for (unsigned int j = 0; j < batch->count; j++)
+	{
+		unsigned char *msg = batch->msgs + j * batch->msg_len;
 
-	/* only need one place holder for doing hashes, it is
-	 * x || i || zi
-	 */
-	unsigned int digestlen = 2*xlen + sizeof(uint16_t);
-	unsigned char *digestptr = (unsigned char *)
-		malloc (digestlen * sizeof(unsigned char));
-
-	/* put in x from now since it is fixed everywhere */
-	unsigned char *digest = append_buffer (digestptr, x, xlen);
-	
-	while (i < k) 
-	{ /* iterate over all subpuzzles */
-		unsigned char *zi = head->zi;
-
-		/* sanity check */
-		if (!zi) 
+		/* verify that first m bits of (x || i || zi) are the same as h(x||i||zi)
+		 * an entry that fails is left behind at its sub puzzle */
+		if (compare_bits (digests + j * SHA256_DIGEST_LEN, msg, batch->m))
+			batch->owner[j]->passed++;
+	}
+
+	batch->count = 0;
+} /* flush_batch */
+
+/* the hashing stage of a chunk of a batch. The sub puzzle hashes of all the
+ * entries are interleaved through the multi-buffer kernel and every entry
+ * stops at its first failing sub puzzle. The ones that pass are remembered
+ * in the replay cache, in order, and every outcome is counted. */
+static void
+hash_chunk (const SHA256Ctx *keyed, batch_entry_t *entries, unsigned int count,
+		unsigned int xlen, uint16_t k, uint16_t m,
+		SHA256OptReplayCache *replay, uint64_t *hashes)
+{
+	verify_batch_t batch;
+	batch.msg_len = 2*xlen + sizeof(uint16_t);
+	batch.count   = 0;
+	batch.m       = m;
+	batch.use_mb  = (sha256_midstate_init (&batch.ms, NULL, 0, batch.msg_len) == 0);
+
+	unsigned char xs[VERIFY_BATCH_CHUNK * SHA256_DIGEST_LEN];
+	for (unsigned int e = 0; e < count; e++)
+	{ /* x = h (key || data || timestamp) of every entry */
+		unsigned char h[SHA256_DIGEST_LEN];
+		SHA256Ctx ctx = *keyed;
+		sha256_update (&ctx, entries[e].data, entries[e].data_len);
+		sha256_update (&ctx, (unsigned char *) &entries[e].timestamp, sizeof(uint32_t));
+		sha256_final (&ctx, h);
+
+		memcpy (xs + e*xlen, h, xlen);
+		entries[e].passed = 0;
+	}
+	*hashes += count;
+
+	for (uint16_t i = 0; i < k; i++)
+	{ /* interleave sub puzzle i of every entry still standing */
+		for (unsigned int e = 0; e < count; e++)
 		{
-			printf ("[ERROR]: Empty sub solution!\n");
-			exit(-1);
+			if (entries[e].passed != i)
+				continue; /* already failed */
+
+			/* build the concatenation x || i || zi */
+			unsigned char *tmp = batch.msgs + batch.count * batch.msg_len;
+			tmp = append_buffer (tmp, xs + e*xlen, xlen);
+			tmp = append_buffer (tmp, (unsigned char *)&i, sizeof(uint16_t));
+			append_buffer (tmp, (unsigned char *) next_zi (&entries[e].zi), xlen);
+
+			batch.owner[batch.count++] = &entries[e];
+			if (batch.count == VERIFY_BATCH_LANES)
+			{
+				*hashes += batch.count;
+				flush_batch (&batch);
+			}
 		}
 
-		/* build the concatenation */
-		unsigned char *tmp = append_buffer (digest, (unsigned char *)&i, 
-				sizeof(uint16_t));
-		tmp = append_buffer (tmp, zi, xlen);
+		if (batch.count > 0)
+		{
+			*hashes += batch.count;
+			flush_batch (&batch);
+		}
+	}
 
-		/* build the hash of the digest */
-		unsigned int hashlen;
-		unsigned char *hash = digest_message (digestptr, digestlen, &hashlen);
+	for (unsigned int e = 0; e < count; e++)
+	{ /* a copy earlier in the batch or on another thread may get in first */
+		entries[e].status = (entries[e].passed == k)?
+			remember_solution (replay, entries[e].timestamp, entries[e].fp) : VERIFY_FAILED;
+		metrics_add ((metric_counter_t) (METRIC_VERIFY_OK + entries[e].status), 1);
+	}
+} /* hash_chunk */
 
+/* hash a chunk and set the bits of the entries that verified
+ *
+ * returns the number of verified entries
+ */
+static unsigned int
+chunk_results (const SHA256Ctx *keyed, batch_entry_t *entries, unsigned int count,
+		unsigned int xlen, uint16_t k, uint16_t m,
+		SHA256OptReplayCache *replay, uint64_t *hashes, uint64_t *results)
+{
+	hash_chunk (keyed, entries, count, xlen, k, m, replay, hashes);
 
-		/* verify that first m bits of (x || i || zi) are the same as h(x||i||zi) */
-		bool cmp = compare_bits (hash, digestptr, m);
-
-		if (!cmp) 
-		{/* free stuff and return */
-			OPENSSL_free (hash);
-			free (digestptr);
-			free (x);
-			return false;
+	unsigned int verified = 0;
+	for (unsigned int e = 0; e < count; e++)
+	{
+		if (entries[e].status != VERIFY_OK)
+			continue;
+
+		results[entries[e].index / 64] |= (uint64_t) 1 << (entries[e].index % 64);
+		verified++;
+	}
+
+	return verified;
+} /* chunk_results */
+
+/* verify a batch given the hash state after absorbing the key */
+static unsigned int
+verify_batch_keyed (const SHA256Ctx *keyed, SHA256OptVerifyItem *items,
+		unsigned int n, uint16_t len, uint16_t k, uint16_t m,
+		const SHA256OptVerifyParams *params, uint64_t *results)
+{
+	if (!results)
+		return 0; /* nowhere to put the outcome */
+
+	memset (results, 0, ((n + 63) / 64) * sizeof (uint64_t));
+
+	if (!items || n == 0)
+		return 0; /* nothing to verify */
+
+	/* the parameters are shared, check them once */
+	unsigned int xlen;
+	if (check_params (len, m, &xlen) != VERIFY_OK)
+	{
+		printf ("[ERROR]: (l/2) needs to be a non zero multiple of 8 of at most 256 bits.\n");
+		return 0;
+	}
+
+	uint64_t start = metrics_now ();
+	uint64_t hashes = 0;
+	unsigned int verified = 0;
+
+	SHA256OptReplayCache *replay = params ? params->replay : NULL;
+	batch_entry_t entries[VERIFY_BATCH_CHUNK];
+	unsigned int count = 0;
+
+	for (unsigned int j = 0; j < n; j++)
+	{
+		SHA256OptSolution *sol = items[j].sol;
+
+		/* the zero hash stage, a replay costs a fingerprint */
+		verify_status_t status = items[j].data? VERIFY_OK : VERIFY_EMPTY;
+		if (status == VERIFY_OK)
+			status = precheck_solution (sol, len, k, m, params, &xlen);
+
+		uint64_t fp = 0;
+		if (status == VERIFY_OK && replay)
+		{
+			fp = replay_fingerprint (replay, sol, xlen, k,
+					items[j].data, items[j].data_len);
+			if (replay_seen (replay, sol->timestamp, fp))
+				status = VERIFY_REPLAY;
 		}
 
-		/* subpuzzle check passed! */
-		OPENSSL_free (hash);
+		if (status != VERIFY_OK)
+		{
+			metrics_add ((metric_counter_t) (METRIC_VERIFY_OK + status), 1);
+			continue; /* rejected without hashing */
+		}
 
-		head = head->next;
-		i++;
+		batch_entry_t *entry = &entries[count++];
+		entry->zi = (zi_cursor_t) { sol->head, NULL, 0 };
+		entry->timestamp = sol->timestamp;
+		entry->data = items[j].data;
+		entry->data_len = items[j].data_len;
+		entry->fp = fp;
+		entry->index = j;
+
+		if (count == VERIFY_BATCH_CHUNK)
+		{
+			verified += chunk_results (keyed, entries, count, xlen, k, m, replay,
+					&hashes, results);
+			count = 0;
+		}
 	}
 
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &end);
-	double difftime = time_diff (start, end);
-	printf ("[Log]: Time needed to verify the solution is %lf seconds.\n", difftime);
+	if (count > 0)
+		verified += chunk_results (keyed, entries, count, xlen, k, m, replay,
+				&hashes, results);
 
-	/* free allocated memory */
-	free (digestptr);
-	free (x);
+	metrics_add (METRIC_HASHES, hashes);
+	metrics_observe (METRIC_LAT_VERIFY_BATCH, start);
 
-	/* done here, verification passed */
-	return true;
-} /* verify_solution */
+	return verified;
+} /* verify_batch_keyed */
+
+/* hash a chunk and hand out the outcomes of its entries
+ *
+ * returns the number of verified entries
+ */
+static unsigned int
+chunk_statuses (const SHA256Ctx *keyed, batch_entry_t *entries, unsigned int count,
+		unsigned int xlen, uint16_t k, uint16_t m,
+		SHA256OptReplayCache *replay, uint64_t *hashes, verify_status_t *statuses)
+{
+	hash_chunk (keyed, entries, count, xlen, k, m, replay, hashes);
+
+	unsigned int verified = 0;
+	for (unsigned int e = 0; e < count; e++)
+	{
+		statuses[entries[e].index] = entries[e].status;
+		verified += (entries[e].status == VERIFY_OK);
+	}
+
+	return verified;
+} /* chunk_statuses */
+
+/* verify a batch of packets given the hash state after absorbing the key,
+ * nothing is allocated */
+static unsigned int
+verify_packets_keyed (const SHA256Ctx *keyed, const SHA256OptPacketItem *items,
+		unsigned int n, uint16_t len, uint16_t k, uint16_t m,
+		const SHA256OptVerifyParams *params, verify_status_t *statuses)
+{
+	if (!items || !statuses || n == 0)
+		return 0; /* nothing to verify */
+
+	unsigned int xlen;
+	if (check_params (len, m, &xlen) != VERIFY_OK)
+	{
+		for (unsigned int j = 0; j < n; j++)
+			statuses[j] = VERIFY_BAD_PARAMS;
+		return 0;
+	}
+
+	uint64_t start = metrics_now ();
+	uint64_t hashes = 0;
+	unsigned int verified = 0;
+
+	SHA256OptReplayCache *replay = params ? params->replay : NULL;
+	batch_entry_t entries[VERIFY_BATCH_CHUNK];
+	unsigned int count = 0;
+
+	for (unsigned int j = 0; j < n; j++)
+	{
+		/* the zero hash stage, a replay costs a fingerprint */
+		SHA256OptFlatSolution view;
+		verify_status_t status = items[j].data? VERIFY_OK : VERIFY_EMPTY;
+		if (status == VERIFY_OK)
+			status = precheck_packet (items[j].pkt, items[j].pkt_len, xlen, k, params, &view);
+
+		uint64_t fp = 0;
+		if (status == VERIFY_OK && replay)
+		{
+			fp = replay_fingerprint (replay, &view, items[j].data, items[j].data_len);
+			if (replay_seen (replay, view.timestamp, fp))
+				status = VERIFY_REPLAY;
+		}
+
+		statuses[j] = status;
+		if (status != VERIFY_OK)
+		{
+			metrics_add ((metric_counter_t) (METRIC_VERIFY_OK + status), 1);
+			continue; /* rejected without hashing */
+		}
+
+		batch_entry_t *entry = &entries[count++];
+		entry->zi = (zi_cursor_t) { NULL, view.zi, xlen };
+		entry->timestamp = view.timestamp;
+		entry->data = items[j].data;
+		entry->data_len = items[j].data_len;
+		entry->fp = fp;
+		entry->index = j;
+
+		if (count == VERIFY_BATCH_CHUNK)
+		{
+			verified += chunk_statuses (keyed, entries, count, xlen, k, m, replay,
+					&hashes, statuses);
+			count = 0;
+		}
+	}
+
+	if (count > 0)
+		verified += chunk_statuses (keyed, entries, count, xlen, k, m, replay,
+				&hashes, statuses);
+
+	metrics_add (METRIC_HASHES, hashes);
+	metrics_observe (METRIC_LAT_VERIFY_BATCH, start);
+
+	return verified;
+} /* verify_packets_keyed */
+
+/* verify_solutions_batch */
+unsigned int
+verify_solutions_batch (SHA256OptVerifyItem *items, unsigned int n,
+		unsigned char *key, unsigned int key_len,
+		uint16_t len, uint16_t k, uint16_t m,
+		uint64_t *results)
+{
+	if (!key)
+	{ /* nothing verifies without a key */
+		if (results)
+			memset (results, 0, ((n + 63) / 64) * sizeof (uint64_t));
+		return 0;
+	}
+
+	/* the key is the same for everyone, absorb it once */
+	SHA256Ctx keyed;
+	sha256_init (&keyed);
+	sha256_update (&keyed, key, key_len);
+
+	return verify_batch_keyed (&keyed, items, n, len, k, m, NULL, results);
+} /* verify_solutions_batch */
+
+/* minter_verify */
+verify_status_t
+minter_verify (const SHA256OptMinter *minter, SHA256OptSolution *sol,
+		unsigned char *data, unsigned int data_len,
+		const SHA256OptVerifyParams *params)
+{
+	if (!minter)
+		return VERIFY_BAD_PARAMS;
+
+	return verify_keyed (&minter->keyed, sol, data, data_len,
+			minter->l, minter->k, minter->m, params);
+} /* minter_verify */
+
+/* minter_verify_packet */
+verify_status_t
+minter_verify_packet (const SHA256OptMinter *minter,
+		const unsigned char *pkt, size_t pkt_len,
+		const unsigned char *data, unsigned int data_len,
+		const SHA256OptVerifyParams *params)
+{
+	if (!minter)
+		return VERIFY_BAD_PARAMS;
+
+	return verify_packet_keyed (&minter->keyed, pkt, pkt_len, data, data_len,
+			minter->l, minter->k, minter->m, params);
+} /* minter_verify_packet */
+
+/* minter_verify_flat */
+verify_status_t
+minter_verify_flat (const SHA256OptMinter *minter, const SHA256OptFlatSolution *sol,
+		const unsigned char *data, unsigned int data_len,
+		const SHA256OptVerifyParams *params)
+{
+	if (!minter)
+		return VERIFY_BAD_PARAMS;
+
+	uint64_t start = metrics_now ();
+	uint64_t hashes = 0;
+
+	unsigned int xlen;
+	verify_status_t status = check_params (minter->l, minter->m, &xlen);
+	if (status == VERIFY_OK)
+		status = (!sol || !sol->zi)? VERIFY_EMPTY
+			: precheck_flat (sol, xlen, minter->k, params);
+	if (status == VERIFY_OK)
+		status = flat_stages (&minter->keyed, sol, data, data_len, xlen,
+				minter->k, minter->m, params, &hashes);
+
+	metrics_add ((metric_counter_t) (METRIC_VERIFY_OK + status), 1);
+	metrics_add (METRIC_HASHES, hashes);
+	metrics_observe (METRIC_LAT_VERIFY_OPT, start);
+
+	return status;
+} /* minter_verify_flat */
+
+/* minter_verify_batch */
+unsigned int
+minter_verify_batch (const SHA256OptMinter *minter, SHA256OptVerifyItem *items,
+		unsigned int n, uint64_t *results)
+{
+	return minter_verify_batch_ex (minter, items, n, NULL, results);
+} /* minter_verify_batch */
+
+/* minter_verify_batch_ex */
+unsigned int
+minter_verify_batch_ex (const SHA256OptMinter *minter, SHA256OptVerifyItem *items,
+		unsigned int n, const SHA256OptVerifyParams *params, uint64_t *results)
+{
+	if (!minter)
+	{ /* nothing verifies without a key */
+		if (results)
+			memset (results, 0, ((n + 63) / 64) * sizeof (uint64_t));
+		return 0;
+	}
+
+	return verify_batch_keyed (&minter->keyed, items, n,
+			minter->l, minter->k, minter->m, params, results);
+} /* minter_verify_batch_ex */
+
+/* minter_verify_packets */
+unsigned int
+minter_verify_packets (const SHA256OptMinter *minter, const SHA256OptPacketItem *items,
+		unsigned int n, const SHA256OptVerifyParams *params, verify_status_t *statuses)
+{
+	if (!minter)
+	{ /* nothing verifies without a key */
+		for (unsigned int j = 0; statuses && j < n; j++)
+			statuses[j] = VERIFY_BAD_PARAMS;
+		return 0;
+	}
+
+	return verify_packets_keyed (&minter->keyed, items, n,
+			minter->l, minter->k, minter->m, params, statuses);
+} /* minter_verify_packets */
+
+/* minter_mint_packets */
+unsigned int
+minter_mint_packets (const SHA256OptMinter *minter, SHA256OptPacketItem *items,
+		unsigned int n, uint32_t timestamp)
+{
+	if (!minter || !items)
+		return 0; /* nothing to do */
+
+	unsigned char x[SHA256_DIGEST_LEN];
+	SHA256OptChallenge challenge;
+	challenge.preimage = x;
+	challenge.timestamp = timestamp;
+	challenge.len = minter->l / 8;
+	challenge.num_subpuzzles = minter->k;
+	challenge.difficulty = minter->m;
+
+	unsigned int minted = 0;
+	for (unsigned int j = 0; j < n; j++)
+	{ /* the same challenge as mint_challenge, written into the packet */
+		size_t len = encode_challenge (&challenge, NULL, 0);
+		if (!items[j].pkt || items[j].pkt_len < len || (!items[j].data && items[j].data_len > 0))
+		{
+			items[j].pkt_len = 0;
+			continue;
+		}
+
+		minter_derive (minter, items[j].data, items[j].data_len, timestamp, x);
+		items[j].pkt_len = encode_challenge (&challenge, items[j].pkt, items[j].pkt_len);
+		minted++;
+	}
+
+	metrics_add (METRIC_CHALLENGES_MINTED, minted);
+	metrics_add (METRIC_HASHES, minted);
+
+	return minted;
+} /* minter_mint_packets */
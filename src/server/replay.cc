@@ -0,0 +1,425 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  replay.cc
+ *
+ *    Description:  Implementation of the replay cache of verified solutions
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 10:21:09 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/replay.h"
+
+#include <openssl/rand.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define REPLAY_MAGIC 		0x59414c5052554c50ULL	/* "PLURPLAY" */
+#define REPLAY_BUCKET_SLOTS 8						/* One cache line of slots */
+#define REPLAY_ATTACH_TRIES 1000					/* Waits of 1ms for a creator */
+
+/* The header at the start of the mapping, shared by every process */
+typedef struct alignas (64) {
+	uint64_t magic;				/* Set last by the creator, once the rest is ready */
+	uint64_t num_buckets;		/* A power of two */
+	uint64_t sipkey[2];			/* The key of the fingerprints */
+	uint32_t window;			/* The length of a timestamp window */
+	uint32_t newest;			/* The newest window remembered */
+} replay_header_t;
+
+/* A bucket of slots. A slot holds (window << 32 | the high half of a
+ * fingerprint), 0 when empty. The low bits of the fingerprint pick the
+ * bucket. */
+typedef struct alignas (64) {
+	uint64_t slots[REPLAY_BUCKET_SLOTS];
+} replay_bucket_t;
+
+struct SHA256OptReplayCache {
+	replay_header_t *header;	/* The start of the mapping */
+	replay_bucket_t *buckets;	/* The buckets, right after the header */
+	size_t map_len;				/* The length of the mapping */
+	uint64_t mask;				/* num_buckets - 1 */
+};
+
+
+/*-----------------------------------------------------------------------------
+ *  SipHash-2-4
+ *-----------------------------------------------------------------------------*/
+
+/* An incremental SipHash state */
+typedef struct {
+	uint64_t v0, v1, v2, v3;
+	uint64_t tail;				/* The bytes not absorbed yet */
+	unsigned int ntail;			/* The number of bytes in tail */
+	uint64_t total;				/* The number of bytes so far */
+} siphash_t;
+
+#define ROTL(x, b) (uint64_t) (((x) << (b)) | ((x) >> (64 - (b))))
+
+static inline void
+sip_round (siphash_t *s)
+{
+	s->v0 += s->v1; s->v1 = ROTL (s->v1, 13); s->v1 ^= s->v0; s->v0 = ROTL (s->v0, 32);
+	s->v2 += s->v3; s->v3 = ROTL (s->v3, 16); s->v3 ^= s->v2;
+	s->v0 += s->v3; s->v3 = ROTL (s->v3, 21); s->v3 ^= s->v0;
+	s->v2 += s->v1; s->v1 = ROTL (s->v1, 17); s->v1 ^= s->v2; s->v2 = ROTL (s->v2, 32);
+} /* sip_round */
+
+static inline void
+sip_compress (siphash_t *s, uint64_t m)
+{
+	s->v3 ^= m;
+	sip_round (s);
+	sip_round (s);
+	s->v0 ^= m;
+} /* sip_compress */
+
+static void
+sip_init (siphash_t *s, const uint64_t key[2])
+{
+	s->v0 = key[0] ^ 0x736f6d6570736575ULL;
+	s->v1 = key[1] ^ 0x646f72616e646f6dULL;
+	s->v2 = key[0] ^ 0x6c7967656e657261ULL;
+	s->v3 = key[1] ^ 0x7465646279746573ULL;
+	s->tail = 0;
+	s->ntail = 0;
+	s->total = 0;
+} /* sip_init */
+
+static void
+sip_update (siphash_t *s, const unsigned char *in, size_t in_len)
+{
+	s->total += in_len;
+
+	for (size_t j = 0; j < in_len; j++)
+	{ /* the words are read little endian */
+		s->tail |= (uint64_t) in[j] << (8 * s->ntail);
+		if (++s->ntail == 8)
+		{
+			sip_compress (s, s->tail);
+			s->tail = 0;
+			s->ntail = 0;
+		}
+	}
+} /* sip_update */
+
+static uint64_t
+sip_final (siphash_t *s)
+{
+	sip_compress (s, s->tail | (s->total << 56));
+
+	s->v2 ^= 0xff;
+	for (unsigned int r = 0; r < 4; r++)
+		sip_round (s);
+
+	return s->v0 ^ s->v1 ^ s->v2 ^ s->v3;
+} /* sip_final */
+
+
+/*-----------------------------------------------------------------------------
+ *  Creating and attaching
+ *-----------------------------------------------------------------------------*/
+
+/* wait for the creator of a shared cache to fill in its header */
+static bool
+wait_for_creator (int fd, size_t map_len)
+{
+	for (unsigned int t = 0; t < REPLAY_ATTACH_TRIES; t++)
+	{
+		struct stat st;
+		if (fstat (fd, &st) == 0 && (size_t) st.st_size >= map_len)
+			return true;
+
+		usleep (1000);
+	}
+
+	return false;
+} /* wait_for_creator */
+
+/* create_replay_cache */
+SHA256OptReplayCache *
+create_replay_cache (size_t max_bytes, uint32_t window, const char *shm_name)
+{
+	if (window == 0 || max_bytes < sizeof (replay_header_t) + sizeof (replay_bucket_t))
+	{
+		printf ("[ERROR]: A replay cache needs a window and room for one bucket!\n");
+		return NULL;
+	}
+
+	/* the largest power of two of buckets that fits */
+	uint64_t num_buckets = 1;
+	while (sizeof (replay_header_t) + 2 * num_buckets * sizeof (replay_bucket_t) <= max_bytes)
+		num_buckets *= 2;
+
+	size_t map_len = sizeof (replay_header_t) + num_buckets * sizeof (replay_bucket_t);
+
+	bool creator = true;
+	void *map;
+	if (!shm_name)
+	{ /* private, anonymous pages come zeroed */
+		map = mmap (NULL, map_len, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	} else
+	{
+		int fd = shm_open (shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (fd < 0)
+		{ /* somebody else created it */
+			creator = false;
+			fd = shm_open (shm_name, O_RDWR, 0600);
+		}
+
+		if (fd < 0)
+		{
+			printf ("[ERROR]: Cannot open the shared replay cache %s!\n", shm_name);
+			return NULL;
+		}
+
+		if (creator ? ftruncate (fd, map_len) != 0 : !wait_for_creator (fd, map_len))
+		{
+			printf ("[ERROR]: Cannot size the shared replay cache %s!\n", shm_name);
+			close (fd);
+			return NULL;
+		}
+
+		map = mmap (NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close (fd);
+	}
+
+	if (map == MAP_FAILED)
+	{
+		printf ("[ERROR]: Cannot map %lu bytes for the replay cache!\n",
+				(unsigned long) map_len);
+		return NULL;
+	}
+
+	replay_header_t *header = (replay_header_t *) map;
+	if (creator)
+	{
+		header->num_buckets = num_buckets;
+		header->window = window;
+		header->newest = 0;
+		if (RAND_bytes ((unsigned char *) header->sipkey, sizeof (header->sipkey)) != 1)
+		{
+			printf ("[ERROR]: Cannot generate the key of the replay cache!\n");
+			munmap (map, map_len);
+			return NULL;
+		}
+
+		__atomic_store_n (&header->magic, REPLAY_MAGIC, __ATOMIC_RELEASE);
+	} else
+	{ /* the file is sized before the header is ready */
+		unsigned int t = 0;
+		while (__atomic_load_n (&header->magic, __ATOMIC_ACQUIRE) != REPLAY_MAGIC
+				&& t++ < REPLAY_ATTACH_TRIES)
+			usleep (1000);
+
+		if (header->magic != REPLAY_MAGIC || header->num_buckets != num_buckets
+				|| header->window != window)
+		{
+			printf ("[ERROR]: The shared replay cache %s does not match!\n", shm_name);
+			munmap (map, map_len);
+			return NULL;
+		}
+	}
+
+	SHA256OptReplayCache *cache = (SHA256OptReplayCache *)
+		malloc (sizeof (SHA256OptReplayCache));
+	if (!cache)
+	{
+		munmap (map, map_len);
+		return NULL;
+	}
+
+	cache->header = header;
+	cache->buckets = (replay_bucket_t *) (header + 1);
+	cache->map_len = map_len;
+	cache->mask = num_buckets - 1;
+
+	return cache;
+} /* create_replay_cache */
+
+/* free_replay_cache */
+void
+free_replay_cache (SHA256OptReplayCache *cache)
+{
+	if (!cache)
+		return; /* nothing to do */
+
+	munmap (cache->header, cache->map_len);
+	free (cache);
+} /* free_replay_cache */
+
+/* unlink_replay_cache */
+int
+unlink_replay_cache (const char *shm_name)
+{
+	if (!shm_name)
+		return -1;
+
+	return shm_unlink (shm_name) == 0 ? 0 : -1;
+} /* unlink_replay_cache */
+
+/* replay_cache_capacity */
+size_t
+replay_cache_capacity (const SHA256OptReplayCache *cache)
+{
+	return cache ? (cache->mask + 1) * REPLAY_BUCKET_SLOTS : 0;
+} /* replay_cache_capacity */
+
+
+/*-----------------------------------------------------------------------------
+ *  Fingerprints and lookups
+ *-----------------------------------------------------------------------------*/
+
+/* start a fingerprint, the values of z_i come next */
+static void
+fingerprint_begin (siphash_t *s, const SHA256OptReplayCache *cache,
+		uint32_t timestamp, uint16_t k,
+		const unsigned char *data, unsigned int data_len)
+{
+	sip_init (s, cache->header->sipkey);
+
+	/* the lengths keep the fields from sliding into one another */
+	sip_update (s, (const unsigned char *) &timestamp, sizeof (uint32_t));
+	sip_update (s, (const unsigned char *) &data_len, sizeof (unsigned int));
+	sip_update (s, data, data_len);
+	sip_update (s, (const unsigned char *) &k, sizeof (uint16_t));
+} /* fingerprint_begin */
+
+/* replay_fingerprint */
+uint64_t
+replay_fingerprint (const SHA256OptReplayCache *cache,
+		const SHA256OptSolution *sol, unsigned int zlen, uint16_t k,
+		const unsigned char *data, unsigned int data_len)
+{
+	siphash_t s;
+	fingerprint_begin (&s, cache, sol->timestamp, k, data, data_len);
+
+	const SHA256OptSubSolution *head = sol->head;
+	for (uint16_t i = 0; i < k && head; i++, head = head->next)
+		sip_update (&s, head->zi, zlen);
+
+	return sip_final (&s);
+} /* replay_fingerprint */
+
+/* replay_fingerprint */
+uint64_t
+replay_fingerprint (const SHA256OptReplayCache *cache,
+		const SHA256OptFlatSolution *sol,
+		const unsigned char *data, unsigned int data_len)
+{
+	siphash_t s;
+	fingerprint_begin (&s, cache, sol->timestamp, sol->num_subsolutions, data, data_len);
+
+	/* the values of z_i are contiguous, the same bytes as the list's */
+	sip_update (&s, sol->zi, (size_t) sol->num_subsolutions * sol->zlen);
+
+	return sip_final (&s);
+} /* replay_fingerprint */
+
+/* the slot of a fingerprint in a window, never 0 */
+static inline uint64_t
+make_slot (uint32_t w, uint64_t fp)
+{
+	return ((uint64_t) w << 32) | (fp >> 32) | 1;
+} /* make_slot */
+
+/* whether a window is one of the two live ones. A window after the newest
+ * one of a snapshot is live too, another thread has moved newest on since. */
+static inline bool
+window_live (uint32_t newest, uint32_t w)
+{
+	return (int32_t) (newest - w) <= 1;
+} /* window_live */
+
+/* replay_seen */
+bool
+replay_seen (const SHA256OptReplayCache *cache, uint32_t timestamp, uint64_t fp)
+{
+	uint32_t w = timestamp / cache->header->window;
+	uint32_t newest = __atomic_load_n (&cache->header->newest, __ATOMIC_ACQUIRE);
+	if (!window_live (newest, w))
+		return true; /* its entries may be gone already */
+
+	uint64_t key = make_slot (w, fp);
+	const uint64_t *slots = cache->buckets[fp & cache->mask].slots;
+	for (unsigned int s = 0; s < REPLAY_BUCKET_SLOTS; s++)
+	{
+		if (__atomic_load_n (&slots[s], __ATOMIC_ACQUIRE) == key)
+			return true;
+	}
+
+	return false;
+} /* replay_seen */
+
+/* replay_remember */
+replay_status_t
+replay_remember (SHA256OptReplayCache *cache, uint32_t timestamp, uint64_t fp)
+{
+	uint32_t w = timestamp / cache->header->window;
+
+	/* move the newest window forward, the older entries go stale */
+	uint32_t newest = __atomic_load_n (&cache->header->newest, __ATOMIC_ACQUIRE);
+	while ((int32_t) (w - newest) > 0)
+	{
+		if (__atomic_compare_exchange_n (&cache->header->newest, &newest, w,
+					true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			newest = w;
+	}
+
+	if (!window_live (newest, w))
+		return REPLAY_SEEN; /* too old to tell, so it cannot be accepted */
+
+	uint64_t key = make_slot (w, fp);
+	uint64_t *slots = cache->buckets[fp & cache->mask].slots;
+
+	for (;;)
+	{
+		/* look for the solution and for the first reusable slot */
+		int victim = -1;
+		uint64_t old = 0;
+		for (unsigned int s = 0; s < REPLAY_BUCKET_SLOTS; s++)
+		{
+			uint64_t v = __atomic_load_n (&slots[s], __ATOMIC_ACQUIRE);
+			if (v == key)
+				return REPLAY_SEEN;
+
+			if (victim < 0 && (v == 0 || !window_live (newest, (uint32_t) (v >> 32))))
+			{
+				victim = s;
+				old = v;
+			}
+		}
+
+		if (victim < 0)
+			return REPLAY_FULL;
+
+		if (!__atomic_compare_exchange_n (&slots[victim], &old, key,
+					false, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE))
+			continue; /* somebody took it, look again */
+
+		/* two writers that saw different slots free can both get here. With
+		 * sequentially consistent accesses at least one of them sees the
+		 * other, and whoever does backs off. Rarely both do, which rejects
+		 * the solution once more than needed but never accepts it twice. */
+		for (unsigned int s = 0; s < REPLAY_BUCKET_SLOTS; s++)
+		{
+			if ((int) s != victim && __atomic_load_n (&slots[s], __ATOMIC_SEQ_CST) == key)
+				return REPLAY_SEEN;
+		}
+
+		return REPLAY_FRESH;
+	}
+} /* replay_remember */
@@ -19,9 +19,60 @@
 #include "server/server.h"
 #include "puzzle/factory.h"
 #include "puzzle/crypto_util.h"
+#include "puzzle/metrics.h"
+#include "puzzle/random.h"
+#include "puzzle/wire.h"
+#include "puzzle/sha256.h"
+#include "puzzle/sha256_mb.h"
 
 #include <string.h>
 
+/* The field of i at the end of key || data || timestamp || i, only its
+ * first byte changes and the rest stays zero */
+#define INDEX_FIELD_LEN 	sizeof(unsigned int)
+
+/* absorb key || data || timestamp once, the field of i is left as the
+ * variable tail of the midstate
+ *
+ * returns 0 on success, -1 if the field does not fit in the midstate
+ */
+static int
+prefix_midstate (SHA256Midstate *ms, const unsigned char *key, unsigned int key_len,
+		const unsigned char *data, unsigned int data_len, uint32_t timestamp)
+{
+	SHA256Ctx ctx;
+	sha256_init (&ctx);
+	sha256_update (&ctx, key, key_len);
+	sha256_update (&ctx, data, data_len);
+	sha256_update (&ctx, (unsigned char *) &timestamp, sizeof(uint32_t));
+
+	return sha256_midstate_from_ctx (ms, &ctx, INDEX_FIELD_LEN);
+} /* prefix_midstate */
+
+/* finish x_i = h(key || data || timestamp || i) for the n indices from
+ * first on, in the lanes of the multi-buffer kernel
+ *
+ * arguments are:
+ *
+ *  ms			-- The midstate of the prefix
+ *  first		-- The first index
+ *  n			-- The number of indices, at most SHA256_MB_MAX_LANES
+ *  xs			-- The n digests (return variable)
+ */
+static void
+hash_indices (const SHA256Midstate *ms, unsigned int first, unsigned int n,
+		unsigned char *xs)
+{
+	unsigned char fields[SHA256_MB_MAX_LANES * INDEX_FIELD_LEN];
+	memset (fields, 0, n * INDEX_FIELD_LEN);
+
+	for (unsigned int j = 0; j < n; j++)
+		fields[j * INDEX_FIELD_LEN] = (uint8_t) (first + j);
+
+	sha256_mb_digest (ms, fields, n, xs);
+	metrics_add (METRIC_HASHES, n);
+} /* hash_indices */
+
 /* generate_puzzle */
 SHA256Challenge *generate_puzzle (unsigned char *data, unsigned int data_len,
 		unsigned char *key, unsigned int key_len, 
@@ -46,81 +97,75 @@ SHA256Challenge *generate_puzzle (unsigned char *data, unsigned int data_len,
 		return NULL;
 	}
 
-	uint8_t i = 0;
-	SHA256SubPuzzle * head = NULL;
-
-	timespec start, end;
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &start);
-
-	// first build buf = key || data || timestamp || i 
-	unsigned int buf_len = data_len + key_len + sizeof(unsigned int)
-		+ sizeof(uint32_t);
-	unsigned char *buf = (unsigned char *)
-		malloc (buf_len * sizeof(unsigned char));
-
-	/* build concatenation by a series of mem copies */
-	unsigned char *_buf = buf;
-	memcpy (_buf, key, key_len);
-
-	_buf += key_len;
-	memcpy (_buf, data, data_len);
-
-	_buf += data_len;
-	memcpy (_buf, (unsigned char*) &timestamp, sizeof(uint32_t));
+	if (m > 8 * SHA256_DIGEST_LEN)
+	{
+		printf ("[ERROR]: Cannot hide %u bits of a digest!\n", m);
+		return NULL;
+	}
 
-	/* keep the place where to insert i each time */
-	_buf = _buf + sizeof(uint32_t);
+	SHA256SubPuzzle * head = NULL;
 
-	while (i < k)
-	{/* iterate over each subpuzzle */
+	uint64_t start = metrics_now ();
 
-		/* replace the last part of the buffer */
-		memcpy (_buf, (unsigned char*) &i, sizeof(uint8_t));
+	/* absorb key || data || timestamp once, every i is finished from it.
+	 * The images y = h(x) are whole messages with no shared prefix. */
+	SHA256Midstate prefix, image;
+	if (prefix_midstate (&prefix, key, key_len, data, data_len, timestamp) != 0
+			|| sha256_midstate_init (&image, NULL, 0, SHA256_DIGEST_LEN) != 0)
+	{
+		printf ("[ERROR]: Cannot build SHA256\n");
+		exit(-1); /* exiting here, no need for returning */
+	}
 
-		/* obtain the hash of the concatenation */
-		unsigned int x_len;
-		unsigned char *x = digest_message (buf, buf_len, &x_len);
+	unsigned char xs[SHA256_MB_MAX_LANES * SHA256_DIGEST_LEN];
+	unsigned char ys[SHA256_MB_MAX_LANES * SHA256_DIGEST_LEN];
 
-		/* sanity checking */
-		if (!x) {
-			printf ("[ERROR]: Cannot build SHA256\n");
-			exit(-1); /* exiting here, no need for returning */
-		}
+	for (unsigned int first = 0; first < k; first += SHA256_MB_MAX_LANES)
+	{/* the subpuzzles, a batch of lanes at a time */
+		unsigned int n = (k - first < SHA256_MB_MAX_LANES)?
+			k - first : SHA256_MB_MAX_LANES;
 
-		/* obtain the hash of y */
-		unsigned int y_len;
-		unsigned char *y = digest_message (x, x_len, &y_len);
+		/* obtain the hashes of the concatenations, and then the hashes of x */
+		hash_indices (&prefix, first, n, xs);
+		sha256_mb_digest (&image, xs, n, ys);
+		metrics_add (METRIC_HASHES, n);
 
-		/* sanity checking */
-		if (!y) {
-			printf ("[ERROR]: Cannot build SHA256\n");
-			exit(-1); /* exiting here, no need for returning */
+		for (unsigned int j = 0; j < n; j++)
+		{
+			/* the subpuzzle keeps both hashes, so they get their own storage */
+			unsigned char *x = (unsigned char *) OPENSSL_malloc (SHA256_DIGEST_LEN);
+			unsigned char *y = (unsigned char *) OPENSSL_malloc (SHA256_DIGEST_LEN);
+			if (!x || !y)
+			{
+				printf ("[ERROR]: Cannot build SHA256\n");
+				exit(-1); /* exiting here, no need for returning */
+			}
+			memcpy (x, xs + j*SHA256_DIGEST_LEN, SHA256_DIGEST_LEN);
+			memcpy (y, ys + j*SHA256_DIGEST_LEN, SHA256_DIGEST_LEN);
+
+			/* scramble the first m bits of x */
+			unsigned char *preimage = scramble_bits (x, m);
+			if (!preimage)
+			{
+				printf ("[ERROR]: Cannot draw random bits\n");
+				exit(-1); /* exiting here, no need for returning */
+			}
+
+			/* create and insert the subpuzzle */
+			SHA256SubPuzzle *item = createSubPuzzle ();
+			initSubPuzzle (item, preimage, y);
+
+			head = insert_subpuzzle (head, item);
 		}
-
-		/* scramble the first m bits of x */
-		unsigned char *preimage = scramble_bits (x, m);
-
-		/* create and insert the subpuzzle */
-		SHA256SubPuzzle *item = createSubPuzzle ();
-		initSubPuzzle (item, preimage, y);
-
-		head = insert_subpuzzle (head, item);
-
-		/* done */
-		i++;
 	}
 
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &end);
-	double difftime = time_diff (start, end);
-	printf ("Time needed to generate the challenge is %lf seconds.\n", difftime);
-
-	/* free the buffer */
-	free (buf);
-
 	/* create the challenge */
 	SHA256Challenge *challenge = createChallenge();
 	initChallenge (challenge, timestamp, k, m, head);
 
+	metrics_add (METRIC_PUZZLES_GENERATED, 1);
+	metrics_observe (METRIC_LAT_GENERATE_PUZZLE, start);
+
 	/* done */
 	return challenge;
 } /* generate_puzzle */
@@ -133,75 +178,116 @@ verify_solution (SHA256Solution *sol,
 		uint8_t k)
 {
 	if (! sol)
-		return false; /* empty challenge or solution, not verified */
+	{ /* empty challenge or solution, not verified */
+		metrics_add (METRIC_VERIFY_EMPTY, 1);
+		return false;
+	}
 
 	SHA256SubSolution * shead = sol->solution;
-	uint32_t timestamp = sol->timestamp;
-	uint8_t i = 0;
+	unsigned int i = 0;
 
-	timespec start, end;
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &start);
+	uint64_t start = metrics_now ();
 
-	/* prepare the buffer */
-	// first build buf = key || data || timestamp || i 
-	unsigned int buf_len = data_len + key_len + sizeof(unsigned int)
-		+ sizeof(uint32_t);
-	unsigned char *buf = (unsigned char *)
-		malloc (buf_len * sizeof(unsigned char));
-
-	/* build concatenation by a series of mem copies */
-	unsigned char *_buf = buf;
-	memcpy (_buf, key, key_len);
-
-	_buf += key_len;
-	memcpy (_buf, data, data_len);
-
-	_buf += data_len;
-	memcpy (_buf, (unsigned char*) &timestamp, sizeof(uint32_t));
+	/* absorb key || data || timestamp once, only the field of i changes */
+	SHA256Midstate prefix;
+	if (prefix_midstate (&prefix, key, key_len, data, data_len, sol->timestamp) != 0)
+		return false;
 
-	/* keep the place where to insert i each time */
-	_buf = _buf + sizeof(uint32_t);
+	unsigned char xs[SHA256_MB_MAX_LANES * SHA256_DIGEST_LEN];
 
 	while (shead)
-	{/* iterate over all subpuzzles */
-		unsigned char *digest = shead->solution;
-
-		/*  prepare the buffer data */
-		memcpy (_buf, (unsigned char *)&i, sizeof (uint8_t));
-
-		/* obtain the hash of the concatenation */
-		unsigned int x_len;
-		unsigned char *x = digest_message (buf, buf_len, &x_len);
-
-		/* compare the two hashes */
-		if (memcmp (x, digest, x_len) != 0) 
-		{
-			printf ("Failing at %d\n", i);
-			OPENSSL_free (x);
-			free (buf);
-			return false; /* if one does not match that's it! */
+	{/* iterate over all subpuzzles, a batch of lanes at a time */
+		SHA256SubSolution *batch[SHA256_MB_MAX_LANES];
+		unsigned int n = 0;
+		for (; shead && n < SHA256_MB_MAX_LANES; shead = shead->next)
+			batch[n++] = shead;
+
+		/* obtain the hashes of the concatenations */
+		hash_indices (&prefix, i, n, xs);
+
+		for (unsigned int j = 0; j < n; j++)
+		{/* compare the two hashes */
+			if (memcmp (xs + j*SHA256_DIGEST_LEN, batch[j]->solution, SHA256_DIGEST_LEN) != 0)
+			{
+				metrics_add (METRIC_VERIFY_FAILED, 1);
+				metrics_observe (METRIC_LAT_VERIFY_NAIVE, start);
+				return false; /* if one does not match that's it! */
+			}
 		}
 
-		OPENSSL_free (x);
-		i++;
-		shead = shead->next;
+		i += n;
 	}
 
-	clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &end);
-	double difftime = time_diff (start, end);
-	printf ("Time needed to verify the solution is %lf seconds.\n", difftime);
-
-	free (buf);
-
 	/* check if all subpuzzles solved */
 	if (i != k) {
+		metrics_add (METRIC_VERIFY_SHORT, 1);
+		metrics_observe (METRIC_LAT_VERIFY_NAIVE, start);
 		return false;
 	}
 
 	/* no violations found, return true */
+	metrics_add (METRIC_VERIFY_OK, 1);
+	metrics_observe (METRIC_LAT_VERIFY_NAIVE, start);
 	return true;
 } /* verify_solution */
 
+/* verify_solution_packet */
+bool
+verify_solution_packet (const unsigned char *pkt, size_t pkt_len,
+		const unsigned char *data, unsigned int data_len,
+		const unsigned char *key, unsigned int key_len,
+		uint8_t k)
+{
+	uint64_t start = metrics_now ();
+
+	/* check the packet where it lies */
+	WirePacket wire;
+	SHA256FlatSolution view;
+	if (wire_parse (pkt, pkt_len, &wire) != WIRE_OK
+			|| wire_view_solution (&wire, &view) != 0)
+	{
+		metrics_add (METRIC_VERIFY_MALFORMED, 1);
+		metrics_observe (METRIC_LAT_VERIFY_NAIVE, start);
+		return false;
+	}
+
+	if (view.num_subsolutions != k)
+	{
+		metrics_add (METRIC_VERIFY_SHORT, 1);
+		metrics_observe (METRIC_LAT_VERIFY_NAIVE, start);
+		return false;
+	}
+
+	/* absorb key || data || timestamp once, only the field of i changes */
+	SHA256Midstate prefix;
+	if (prefix_midstate (&prefix, key, key_len, data, data_len, view.timestamp) != 0)
+		return false;
+
+	unsigned char xs[SHA256_MB_MAX_LANES * SHA256_DIGEST_LEN];
+	for (unsigned int first = 0; first < k; first += SHA256_MB_MAX_LANES)
+	{
+		unsigned int n = (k - first < SHA256_MB_MAX_LANES)?
+			k - first : SHA256_MB_MAX_LANES;
+
+		hash_indices (&prefix, first, n, xs);
+
+		for (unsigned int j = 0; j < n; j++)
+		{/* compare the two hashes */
+			if (memcmp (xs + j*SHA256_DIGEST_LEN, flat_solution (&view, first + j),
+						SHA256_DIGEST_LEN) != 0)
+			{
+				metrics_add (METRIC_VERIFY_FAILED, 1);
+				metrics_observe (METRIC_LAT_VERIFY_NAIVE, start);
+				return false; /* if one does not match that's it! */
+			}
+		}
+	}
+
+	metrics_add (METRIC_VERIFY_OK, 1);
+	metrics_observe (METRIC_LAT_VERIFY_NAIVE, start);
+	return true;
+} /* verify_solution_packet */
+
 /* scramble_bits */
 unsigned char *
 scramble_bits (unsigned char *buf, unsigned int bits)
@@ -209,23 +295,15 @@ scramble_bits (unsigned char *buf, unsigned int bits)
 	if (! buf)
 		return NULL;
 
-	/* scramble the first `bits' bits of buf */
-	unsigned int pos = 0;
-	while (bits)
-	{
-		unsigned char mask = (unsigned char) rand() % 255;
-		if (bits >= 8)
-		{
-			buf[pos] = 0;
-		} else 
-		{
-			/* the last (8-bits) bits of mask should be 0 */
-			mask = mask << (8 - bits);
-			buf[pos] = buf[pos] | mask;
-		}
+	/* the whole bytes first, then the top of the partial one */
+	unsigned int full = bits / 8;
+	unsigned int rem = bits % 8;
+	unsigned char last = 0;
+	if (random_bytes (buf, full) != 0 || (rem && random_bytes (&last, 1) != 0))
+		return NULL;
 
-		bits = bits >> 3;
-	}
+	if (rem)
+		buf[full] = (buf[full] & (0xFF >> rem)) | (last & (unsigned char) (0xFF << (8 - rem)));
 
 	return buf;
 }
@@ -0,0 +1,709 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  verifier.cc
+ *
+ *    Description:  Implementation of the asynchronous verification service
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 09:24:03 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/verifier.h"
+#include "server/admission.h"
+#include "puzzle/metrics.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/*-----------------------------------------------------------------------------
+ *  The bounded MPMC ring
+ *-----------------------------------------------------------------------------*/
+
+/* A cell of the ring. Its sequence number tells the producers and the
+ * consumers whose turn it is, so nobody ever takes a lock. */
+typedef struct RingCell {
+	std::atomic<size_t> seq;
+	VerifyRequest *req;
+} RingCell;
+
+/* Dmitry Vyukov's bounded multi producer, multi consumer queue. The two
+ * positions live on cache lines of their own so that the producers and the
+ * consumers do not bounce each other's. */
+typedef struct RequestRing {
+	RingCell *cells;
+	size_t mask;							/* The capacity minus one */
+	alignas(64) std::atomic<size_t> head;	/* The next cell to take */
+	alignas(64) std::atomic<size_t> tail;	/* The next cell to fill */
+} RequestRing;
+
+/* round n up to a power of two, at least 2 */
+static size_t
+round_pow2 (size_t n)
+{
+	size_t p = 2;
+	while (p < n)
+		p <<= 1;
+	return p;
+} /* round_pow2 */
+
+/* set up a ring of at least capacity cells
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int
+ring_init (RequestRing *ring, size_t capacity)
+{
+	size_t n = round_pow2 (capacity);
+	ring->cells = new (std::nothrow) RingCell[n];
+	if (!ring->cells)
+		return -1;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		ring->cells[i].seq.store (i, std::memory_order_relaxed);
+		ring->cells[i].req = NULL;
+	}
+
+	ring->mask = n - 1;
+	ring->head.store (0, std::memory_order_relaxed);
+	ring->tail.store (0, std::memory_order_relaxed);
+	return 0;
+} /* ring_init */
+
+/* push a request, false if the ring is full */
+static bool
+ring_push (RequestRing *ring, VerifyRequest *req)
+{
+	size_t pos = ring->tail.load (std::memory_order_relaxed);
+	while (true)
+	{
+		RingCell *cell = &ring->cells[pos & ring->mask];
+		size_t seq = cell->seq.load (std::memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+		if (diff == 0)
+		{ /* our turn, if nobody else claims the cell first */
+			if (ring->tail.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+			{
+				cell->req = req;
+				cell->seq.store (pos + 1, std::memory_order_release);
+				return true;
+			}
+		} else if (diff < 0)
+		{
+			return false; /* a lap behind, the ring is full */
+		} else
+		{
+			pos = ring->tail.load (std::memory_order_relaxed);
+		}
+	}
+} /* ring_push */
+
+/* pop a request, NULL if the ring is empty. A push that claimed its cell
+ * but did not publish it yet also reads as empty. */
+static VerifyRequest *
+ring_pop (RequestRing *ring)
+{
+	size_t pos = ring->head.load (std::memory_order_relaxed);
+	while (true)
+	{
+		RingCell *cell = &ring->cells[pos & ring->mask];
+		size_t seq = cell->seq.load (std::memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t) (pos + 1);
+
+		if (diff == 0)
+		{
+			if (ring->head.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+			{
+				VerifyRequest *req = cell->req;
+				cell->seq.store (pos + ring->mask + 1, std::memory_order_release);
+				return req;
+			}
+		} else if (diff < 0)
+		{
+			return NULL;
+		} else
+		{
+			pos = ring->head.load (std::memory_order_relaxed);
+		}
+	}
+} /* ring_pop */
+
+
+/*-----------------------------------------------------------------------------
+ *  The service
+ *-----------------------------------------------------------------------------*/
+
+struct VerifierQueue {
+	RequestRing ring;
+	int event_fd;
+};
+
+/* The counters of a worker, written by the worker only */
+typedef struct alignas(64) VerifierCounters {
+	std::atomic<uint64_t> completed;
+	std::atomic<uint64_t> verified;
+	std::atomic<uint64_t> batches;
+	std::atomic<uint64_t> expired;
+} VerifierCounters;
+
+typedef struct VerifierWorker {
+	PlutusVerifier *v;
+	int cpu;								/* The CPU it is pinned to, -1 for none */
+	VerifierCounters counters;
+	std::thread thread;
+} VerifierWorker;
+
+struct PlutusVerifier {
+	VerifierConfig config;
+	RequestRing ring;						/* The submitted requests */
+	sem_t ready;							/* Counts the requests in the ring */
+	AdmissionQueue *admission;				/* Takes the place of the ring, if any */
+	std::atomic<bool> stop;
+
+	cpu_set_t cpus;							/* Where the workers may run */
+	std::vector<VerifierWorker *> workers;
+
+	alignas(64) std::atomic<uint64_t> inflight;
+	std::atomic<uint64_t> submitted;
+	std::atomic<uint64_t> refused;
+	std::atomic<uint64_t> shed;
+};
+
+/* count an event of a worker, only the worker writes its counters */
+static inline void
+bump (std::atomic<uint64_t> &counter, uint64_t by = 1)
+{
+	counter.store (counter.load (std::memory_order_relaxed) + by,
+			std::memory_order_relaxed);
+} /* bump */
+
+/* read the CPUs of a NUMA node from sysfs, a list such as 0-3,8-11
+ *
+ * returns 0 on success, -1 if the node is unknown
+ */
+static int
+node_cpus (int node, cpu_set_t *set)
+{
+	char path[64];
+	snprintf (path, sizeof (path), "/sys/devices/system/node/node%d/cpulist", node);
+
+	FILE *f = fopen (path, "r");
+	if (!f)
+		return -1;
+
+	CPU_ZERO (set);
+	unsigned int lo, hi;
+	int n;
+	while ((n = fscanf (f, "%u-%u", &lo, &hi)) >= 1)
+	{
+		if (n == 1)
+			hi = lo;
+		for (unsigned int c = lo; c <= hi && c < CPU_SETSIZE; c++)
+			CPU_SET (c, set);
+		if (fgetc (f) != ',')
+			break;
+	}
+
+	fclose (f);
+	return 0;
+} /* node_cpus */
+
+/* get the index of the i-th CPU of a set */
+static int
+nth_cpu (const cpu_set_t *set, unsigned int i)
+{
+	unsigned int count = CPU_COUNT (set);
+	if (count == 0)
+		return -1;
+
+	i %= count;
+	for (int c = 0; c < CPU_SETSIZE; c++)
+		if (CPU_ISSET (c, set) && i-- == 0)
+			return c;
+
+	return -1;
+} /* nth_cpu */
+
+/* hand a completed request back to whoever waits for it */
+static void
+complete (VerifyRequest *req)
+{
+	if (!req->cq)
+	{
+		req->done (req);
+		return;
+	}
+
+	/* the owner keeps at most the queue's capacity outstanding, so this only
+	 * waits on an owner that broke that promise */
+	while (!ring_push (&req->cq->ring, req))
+		sched_yield ();
+} /* complete */
+
+/* take the next request, there is one for every post of ready */
+static VerifyRequest *
+take_request (PlutusVerifier *v)
+{
+	VerifyRequest *req;
+	while (!(req = ring_pop (&v->ring)))
+	{
+		if (v->stop.load (std::memory_order_acquire))
+			return NULL;
+		sched_yield (); /* its producer is between claiming and publishing */
+	}
+
+	return req;
+} /* take_request */
+
+/* take a batch off the ring, in the order it was submitted
+ *
+ * returns the size of the batch, 0 once stopping and drained
+ */
+static unsigned int
+take_fifo (PlutusVerifier *v, VerifyRequest **batch)
+{
+	while (sem_wait (&v->ready) != 0 && errno == EINTR)
+		;
+
+	VerifyRequest *req = take_request (v);
+	if (!req)
+		return 0; /* stopping, and the ring is drained */
+
+	/* whatever else is already queued goes in the same batch */
+	unsigned int n = 0;
+	batch[n++] = req;
+	while (n < VERIFIER_BATCH && sem_trywait (&v->ready) == 0)
+	{
+		if (!(req = take_request (v)))
+		{
+			sem_post (&v->ready); /* a stop token, leave it for the next round */
+			break;
+		}
+		batch[n++] = req;
+	}
+
+	return n;
+} /* take_fifo */
+
+/* complete requests whose status is set, and wake each of their queues
+ * once the whole lot is in */
+static void
+complete_batch (PlutusVerifier *v, VerifyRequest **reqs, unsigned int n,
+		VerifierQueue **queues)
+{
+	/* the slots free up before the completions, a callback may submit again */
+	v->inflight.fetch_sub (n, std::memory_order_release);
+
+	unsigned int nq = 0;
+	for (unsigned int j = 0; j < n; j++)
+	{
+		VerifierQueue *cq = reqs[j]->cq;
+		unsigned int q = 0;
+		while (q < nq && queues[q] != cq)
+			q++;
+		if (cq && q == nq)
+			queues[nq++] = cq;
+
+		complete (reqs[j]);
+	}
+
+	for (unsigned int q = 0; q < nq; q++)
+	{
+		uint64_t one = 1;
+		if (write (queues[q]->event_fd, &one, sizeof (one)) < 0 && errno != EAGAIN)
+			perror ("[ERROR]: write");
+	}
+} /* complete_batch */
+
+/* complete requests that were dropped unverified */
+static void
+shed_batch (PlutusVerifier *v, VerifyRequest **reqs, unsigned int n,
+		VerifierQueue **queues)
+{
+	for (unsigned int j = 0; j < n; j++)
+		reqs[j]->status = VERIFY_SHED;
+
+	metrics_add (METRIC_VERIFY_SHED, n);
+	complete_batch (v, reqs, n, queues);
+} /* shed_batch */
+
+/* the loop of a worker, it verifies what it finds in batches */
+static void
+worker_main (VerifierWorker *w)
+{
+	PlutusVerifier *v = w->v;
+
+	/* place ourselves first, so the scratch space below is touched on our node */
+	if (w->cpu >= 0)
+	{
+		cpu_set_t one;
+		CPU_ZERO (&one);
+		CPU_SET (w->cpu, &one);
+		pthread_setaffinity_np (pthread_self (), sizeof (one), &one);
+	} else
+	{
+		pthread_setaffinity_np (pthread_self (), sizeof (v->cpus), &v->cpus);
+	}
+
+	VerifyRequest **batch = new VerifyRequest *[VERIFIER_BATCH];
+	VerifyRequest **expired = new VerifyRequest *[VERIFIER_BATCH];
+	SHA256OptPacketItem *items = new SHA256OptPacketItem[VERIFIER_BATCH];
+	verify_status_t *statuses = new verify_status_t[VERIFIER_BATCH];
+	VerifierQueue **queues = new VerifierQueue *[VERIFIER_BATCH];
+	memset (items, 0, VERIFIER_BATCH * sizeof (SHA256OptPacketItem));
+
+	while (true)
+	{
+		unsigned int n, nexpired = 0;
+		if (v->admission)
+		{ /* the most urgent first, what is already late is not worth the work */
+			n = admission_take (v->admission, batch, VERIFIER_BATCH, expired, &nexpired);
+			if (nexpired)
+			{
+				bump (w->counters.expired, nexpired);
+				shed_batch (v, expired, nexpired, queues);
+			}
+		} else
+		{
+			n = take_fifo (v, batch);
+		}
+
+		if (n == 0 && nexpired == 0)
+			break; /* stopping, and drained */
+		if (n == 0)
+			continue;
+
+		for (unsigned int j = 0; j < n; j++)
+		{
+			items[j].pkt = (unsigned char *) batch[j]->pkt;
+			items[j].pkt_len = batch[j]->pkt_len;
+			items[j].data = batch[j]->data;
+			items[j].data_len = batch[j]->data_len;
+		}
+
+		SHA256OptVerifyParams params = { (uint32_t) time (NULL),
+			v->config.max_age, v->config.replay };
+		unsigned int ok = v->config.keyring?
+			keyring_verify_packets (v->config.keyring, items, n, &params, statuses)
+			: minter_verify_packets (v->config.minter, items, n, &params, statuses);
+
+		bump (w->counters.completed, n);
+		bump (w->counters.verified, ok);
+		bump (w->counters.batches);
+
+		for (unsigned int j = 0; j < n; j++)
+			batch[j]->status = statuses[j];
+		complete_batch (v, batch, n, queues);
+	}
+
+	delete [] queues;
+	delete [] statuses;
+	delete [] items;
+	delete [] expired;
+	delete [] batch;
+} /* worker_main */
+
+/* verifier_default_config */
+void
+verifier_default_config (VerifierConfig *config)
+{
+	if (!config)
+		return; /* nothing to do */
+
+	memset (config, 0, sizeof (*config));
+	config->minter = NULL;
+	config->keyring = NULL;
+	config->max_age = 30;
+	config->replay = NULL;
+	config->nthreads = 0;
+	config->capacity = 1 << 16;
+	config->numa_node = -1;
+	config->pin = true;
+	config->admission = 0;
+	config->deadline_ms = 100;
+} /* verifier_default_config */
+
+/* create_verifier */
+PlutusVerifier *
+create_verifier (const VerifierConfig *config)
+{
+	if (!config || (!config->minter && !config->keyring) || config->capacity == 0)
+	{
+		printf ("[ERROR]: The verifier needs a minter or a keyring and some capacity!\n");
+		return NULL;
+	}
+
+	PlutusVerifier *v = new PlutusVerifier;
+	v->config = *config;
+	v->stop = false;
+	v->inflight = 0;
+	v->submitted = 0;
+	v->refused = 0;
+	v->shed = 0;
+	v->admission = NULL;
+
+	/* the CPUs we may use, narrowed down to the node if one is asked for */
+	CPU_ZERO (&v->cpus);
+	sched_getaffinity (0, sizeof (v->cpus), &v->cpus);
+	if (config->numa_node >= 0)
+	{
+		cpu_set_t node;
+		if (node_cpus (config->numa_node, &node) != 0)
+		{
+			printf ("[ERROR]: Unknown NUMA node %d!\n", config->numa_node);
+			delete v;
+			return NULL;
+		}
+		CPU_AND (&v->cpus, &v->cpus, &node);
+	}
+
+	unsigned int ncpus = CPU_COUNT (&v->cpus);
+	if (ncpus == 0)
+	{
+		printf ("[ERROR]: No CPU left to run the verifier on!\n");
+		delete v;
+		return NULL;
+	}
+
+	if (ring_init (&v->ring, config->capacity) != 0)
+	{
+		delete v;
+		return NULL;
+	}
+	v->config.capacity = v->ring.mask + 1;
+	sem_init (&v->ready, 0, 0);
+
+	if (config->admission > 0 && !(v->admission = create_admission_queue (config->admission)))
+	{
+		sem_destroy (&v->ready);
+		delete [] v->ring.cells;
+		delete v;
+		return NULL;
+	}
+
+	unsigned int nthreads = config->nthreads ? config->nthreads : ncpus;
+	for (unsigned int i = 0; i < nthreads; i++)
+	{
+		VerifierWorker *w = new VerifierWorker;
+		w->v = v;
+		w->cpu = config->pin ? nth_cpu (&v->cpus, i) : -1;
+		w->counters.completed = 0;
+		w->counters.verified = 0;
+		w->counters.batches = 0;
+		w->counters.expired = 0;
+		w->thread = std::thread (worker_main, w);
+		v->workers.push_back (w);
+	}
+
+	return v;
+} /* create_verifier */
+
+/* free_verifier */
+void
+free_verifier (PlutusVerifier *v)
+{
+	if (!v)
+		return; /* nothing to do */
+
+	/* one token per worker, taken only once the ring is empty */
+	v->stop.store (true, std::memory_order_release);
+	for (size_t i = 0; i < v->workers.size (); i++)
+		sem_post (&v->ready);
+	if (v->admission)
+		admission_close (v->admission);
+
+	for (VerifierWorker *w : v->workers)
+	{
+		w->thread.join ();
+		delete w;
+	}
+
+	sem_destroy (&v->ready);
+	free_admission_queue (v->admission);
+	delete [] v->ring.cells;
+	delete v;
+} /* free_verifier */
+
+/* queue a request by its priority and deadline, a full queue sheds the
+ * least urgent request */
+static int
+submit_admission (PlutusVerifier *v, VerifyRequest *req)
+{
+	if (req->deadline == 0)
+		req->deadline = admission_clock () + (uint64_t) v->config.deadline_ms * 1000000ULL;
+
+	v->inflight.fetch_add (1, std::memory_order_acq_rel);
+
+	VerifyRequest *shed;
+	if (admission_push (v->admission, req, &shed) != 0)
+	{
+		v->inflight.fetch_sub (1, std::memory_order_relaxed);
+		v->refused.fetch_add (1, std::memory_order_relaxed);
+		return -1;
+	}
+
+	v->submitted.fetch_add (1, std::memory_order_relaxed);
+	if (shed)
+	{ /* it completes here, on the thread that pushed it out */
+		VerifierQueue *queue;
+		v->shed.fetch_add (1, std::memory_order_relaxed);
+		shed_batch (v, &shed, 1, &queue);
+	}
+
+	return 0;
+} /* submit_admission */
+
+/* verifier_submit */
+int
+verifier_submit (PlutusVerifier *v, VerifyRequest *req)
+{
+	if (!v || !req || (!req->cq && !req->done))
+		return -1;
+
+	if (v->admission)
+		return submit_admission (v, req);
+
+	/* reserve a slot first, then the push cannot find the ring full */
+	if (v->inflight.fetch_add (1, std::memory_order_acq_rel) >= v->config.capacity)
+	{
+		v->inflight.fetch_sub (1, std::memory_order_relaxed);
+		v->refused.fetch_add (1, std::memory_order_relaxed);
+		return -1;
+	}
+
+	while (!ring_push (&v->ring, req))
+		sched_yield (); /* a worker is between taking a cell and freeing it */
+
+	v->submitted.fetch_add (1, std::memory_order_relaxed);
+	sem_post (&v->ready);
+	return 0;
+} /* verifier_submit */
+
+/* verifier_depth */
+unsigned int
+verifier_depth (const PlutusVerifier *v)
+{
+	return v ? (unsigned int) v->inflight.load (std::memory_order_relaxed) : 0;
+} /* verifier_depth */
+
+/* verifier_size */
+unsigned int
+verifier_size (const PlutusVerifier *v)
+{
+	return v ? v->workers.size () : 0;
+} /* verifier_size */
+
+/* verifier_stats */
+void
+verifier_stats (const PlutusVerifier *v, VerifierStats *stats)
+{
+	memset (stats, 0, sizeof (*stats));
+	if (!v)
+		return; /* nothing to do */
+
+	stats->submitted = v->submitted.load (std::memory_order_relaxed);
+	stats->refused = v->refused.load (std::memory_order_relaxed);
+	stats->shed = v->shed.load (std::memory_order_relaxed);
+	stats->depth = v->inflight.load (std::memory_order_relaxed);
+	for (const VerifierWorker *w : v->workers)
+	{
+		stats->completed += w->counters.completed.load (std::memory_order_relaxed);
+		stats->verified += w->counters.verified.load (std::memory_order_relaxed);
+		stats->batches += w->counters.batches.load (std::memory_order_relaxed);
+		stats->expired += w->counters.expired.load (std::memory_order_relaxed);
+	}
+} /* verifier_stats */
+
+
+/*-----------------------------------------------------------------------------
+ *  Completion queues
+ *-----------------------------------------------------------------------------*/
+
+/* create_verifier_queue */
+VerifierQueue *
+create_verifier_queue (unsigned int capacity)
+{
+	VerifierQueue *cq = new VerifierQueue;
+	if (capacity == 0 || ring_init (&cq->ring, capacity) != 0)
+	{
+		delete cq;
+		return NULL;
+	}
+
+	cq->event_fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (cq->event_fd < 0)
+	{
+		delete [] cq->ring.cells;
+		delete cq;
+		return NULL;
+	}
+
+	return cq;
+} /* create_verifier_queue */
+
+/* free_verifier_queue */
+void
+free_verifier_queue (VerifierQueue *cq)
+{
+	if (!cq)
+		return; /* nothing to do */
+
+	close (cq->event_fd);
+	delete [] cq->ring.cells;
+	delete cq;
+} /* free_verifier_queue */
+
+/* verifier_queue_fd */
+int
+verifier_queue_fd (const VerifierQueue *cq)
+{
+	return cq ? cq->event_fd : -1;
+} /* verifier_queue_fd */
+
+/* verifier_queue_poll */
+unsigned int
+verifier_queue_poll (VerifierQueue *cq, VerifyRequest **reqs, unsigned int max)
+{
+	if (!cq || !reqs || max == 0)
+		return 0;
+
+	/* clear the event before draining, a completion after it sets it again */
+	uint64_t count;
+	if (read (cq->event_fd, &count, sizeof (count)) < 0 && errno != EAGAIN)
+		perror ("[ERROR]: read");
+
+	unsigned int n = 0;
+	while (n < max && (reqs[n] = ring_pop (&cq->ring)))
+		n++;
+
+	/* what we had no room for must not wait for the next completion */
+	if (n == max)
+	{
+		uint64_t one = 1;
+		if (write (cq->event_fd, &one, sizeof (one)) < 0 && errno != EAGAIN)
+			perror ("[ERROR]: write");
+	}
+
+	return n;
+} /* verifier_queue_poll */
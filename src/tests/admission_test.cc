@@ -0,0 +1,289 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  admission_test.cc
+ *
+ *    Description:  Tests of the admission queue, its order, what it sheds and
+ *    				the client records, alone and in front of the verifier
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 11:37:12 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/admission.h"
+#include "server/verifier.h"
+#include "client/optclient.h"
+#include "puzzle/wire.h"
+#include "test_util.h"
+#include "verifier_util.h"
+
+#include <openssl/crypto.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#ifndef KEY_LEN
+#define KEY_LEN 32 /* in bytes */
+#endif
+
+static unsigned char key[KEY_LEN];
+static unsigned char data[4];
+static unsigned char pkt[WIRE_HEADER_LEN + 4 * 8];
+static size_t pkt_len;
+
+/* a request of some level and deadline, numbered by user */
+static void
+level_request (VerifyRequest *req, unsigned int j, unsigned int priority, uint64_t deadline)
+{
+	fill_request (req, pkt, pkt_len, data, sizeof (data), j, priority, deadline);
+} /* level_request */
+
+/* the highest level first, the earliest deadline first within a level */
+static int
+test_order ()
+{
+	int failures = 0;
+	AdmissionQueue *q = create_admission_queue (16);
+	if (check (q != NULL && create_admission_queue (0) == NULL, "Could not create the queue"))
+		return 1;
+
+	uint64_t late = admission_clock () + 60 * 1000000000ULL;
+	const unsigned int levels[8] = { 1, 3, 0, 3, 2, 1, 9, 0 };
+	const unsigned int expect[8] = { 6, 3, 1, 4, 5, 0, 7, 2 };
+
+	/* the later a request is pushed the earlier its deadline, levels past
+	 * the last are the last one */
+	VerifyRequest reqs[8];
+	VerifyRequest *shed;
+	for (unsigned int j = 0; j < 8; j++)
+	{
+		level_request (&reqs[j], j, levels[j], late - j);
+		failures += check (admission_push (q, &reqs[j], &shed) == 0 && shed == NULL,
+				"A request was refused");
+	}
+
+	AdmissionStats stats;
+	admission_stats (q, &stats);
+	failures += check (stats.depth == 8 && stats.level_depth[0] == 2
+			&& stats.level_depth[3] == 3, "Wrong depths");
+
+	VerifyRequest *got[8], *expired[8];
+	unsigned int nexpired;
+	unsigned int n = admission_take (q, got, 8, expired, &nexpired);
+	failures += check (n == 8 && nexpired == 0, "Wrong number taken");
+	for (unsigned int i = 0; i < n; i++)
+		failures += check (got[i] == &reqs[expect[i]], "Taken out of order");
+
+	free_admission_queue (q);
+	return failures;
+} /* test_order */
+
+/* a full queue sheds from the lowest level, the oldest first, and refuses
+ * what ranks below everything it holds */
+static int
+test_shed ()
+{
+	int failures = 0;
+	AdmissionQueue *q = create_admission_queue (3);
+
+	VerifyRequest reqs[6];
+	VerifyRequest *shed;
+	level_request (&reqs[0], 0, ADMISSION_UNKNOWN, 200);
+	level_request (&reqs[1], 1, ADMISSION_GOOD, 100);
+	level_request (&reqs[2], 2, ADMISSION_UNKNOWN, 300);
+	for (unsigned int j = 0; j < 3; j++)
+		admission_push (q, &reqs[j], &shed);
+
+	level_request (&reqs[3], 3, ADMISSION_GOOD, 400);
+	failures += check (admission_push (q, &reqs[3], &shed) == 0 && shed == &reqs[0],
+			"The oldest of the lowest level was not shed");
+
+	level_request (&reqs[4], 4, ADMISSION_SUSPECT, 500);
+	failures += check (admission_push (q, &reqs[4], &shed) != 0 && shed == NULL,
+			"A lower level pushed out a higher one");
+
+	level_request (&reqs[5], 5, ADMISSION_UNKNOWN, 250);
+	failures += check (admission_push (q, &reqs[5], &shed) != 0 && shed == NULL,
+			"An older request pushed out a newer one");
+
+	AdmissionStats stats;
+	admission_stats (q, &stats);
+	failures += check (stats.admitted == 4 && stats.shed == 3 && stats.depth == 3,
+			"Wrong counters");
+
+	/* what is left is late, all of it comes back apart */
+	VerifyRequest *got[4], *expired[4];
+	unsigned int nexpired;
+	failures += check (admission_take (q, got, 4, expired, &nexpired) == 0 && nexpired == 3
+			&& expired[0] == &reqs[1] && expired[1] == &reqs[3] && expired[2] == &reqs[2],
+			"Late requests were taken");
+
+	/* a closed queue takes nothing and returns at once */
+	admission_close (q);
+	failures += check (admission_push (q, &reqs[0], &shed) != 0, "A closed queue took a request");
+	failures += check (admission_take (q, got, 4, expired, &nexpired) == 0 && nexpired == 0,
+			"A closed queue handed a request");
+
+	admission_stats (q, &stats);
+	failures += check (stats.expired == 3 && stats.taken == 0, "Wrong counters");
+
+	free_admission_queue (q);
+	return failures;
+} /* test_shed */
+
+/* the records move clients between the levels */
+static int
+test_scores ()
+{
+	int failures = 0;
+	AdmissionScores *scores = create_admission_scores (1024);
+	if (check (scores != NULL && create_admission_scores (0) == NULL,
+				"Could not create the records"))
+		return 1;
+
+	const unsigned char good[4] = { 10, 0, 0, 1 };
+	const unsigned char bad[4] = { 10, 0, 0, 2 };
+
+	failures += check (admission_level (scores, good, 4) == ADMISSION_UNKNOWN,
+			"A new client has a level");
+	failures += check (admission_level (NULL, good, 4) == ADMISSION_UNKNOWN,
+			"No records gave a level");
+
+	for (unsigned int i = 0; i < 2; i++)
+	{
+		admission_record (scores, good, 4, true);
+		admission_record (scores, bad, 4, false);
+	}
+	failures += check (admission_level (scores, good, 4) == ADMISSION_GOOD, "Not good");
+	failures += check (admission_level (scores, bad, 4) == ADMISSION_SUSPECT, "Not suspect");
+
+	for (unsigned int i = 0; i < 6; i++)
+		admission_record (scores, good, 4, true);
+	failures += check (admission_level (scores, good, 4) == ADMISSION_TRUSTED, "Not trusted");
+
+	/* a run of failures costs the trust, and a long history does not overflow */
+	admission_record (scores, good, 4, false);
+	failures += check (admission_level (scores, good, 4) == ADMISSION_GOOD, "Still trusted");
+	for (unsigned int i = 0; i < 100000; i++)
+		admission_record (scores, good, 4, true);
+	failures += check (admission_level (scores, good, 4) == ADMISSION_TRUSTED,
+			"A long history was lost");
+
+	free_admission_scores (scores);
+	return failures;
+} /* test_scores */
+
+/* a verifier behind an admission queue sheds rather than refuses */
+static int
+test_verifier (const SHA256OptMinter *minter)
+{
+	int failures = 0;
+	held_ok = 0;
+	held_shed = 0;
+
+	VerifierConfig config;
+	verifier_default_config (&config);
+	config.minter = minter;
+	config.max_age = 0;
+	config.nthreads = 1;
+	config.admission = 4;
+	config.deadline_ms = 60000;
+
+	PlutusVerifier *v = create_verifier (&config);
+	if (check (v != NULL, "Could not start the verifier"))
+		return 1;
+
+	/* the first request keeps the only worker busy in its callback */
+	held = true;
+	VerifyRequest reqs[8];
+	for (unsigned int j = 0; j < 8; j++)
+	{
+		level_request (&reqs[j], j, ADMISSION_UNKNOWN, 0);
+		reqs[j].done = hold_done;
+	}
+
+	verifier_submit (v, &reqs[0]);
+	while (held_ok == 0)
+		usleep (100);
+
+	/* one due shortly, three more to fill the queue */
+	reqs[1].deadline = admission_clock () + 1000000;
+	for (unsigned int j = 1; j < 5; j++)
+		failures += check (verifier_submit (v, &reqs[j]) == 0, "A request was refused");
+
+	/* a trusted client pushes out the oldest, a suspect one is turned away */
+	reqs[5].priority = ADMISSION_TRUSTED;
+	failures += check (verifier_submit (v, &reqs[5]) == 0, "A trusted request was refused");
+	failures += check (held_shed == 1 && reqs[1].status == VERIFY_SHED,
+			"The oldest request was not shed");
+	reqs[6].priority = ADMISSION_SUSPECT;
+	failures += check (verifier_submit (v, &reqs[6]) != 0, "A suspect request was taken");
+
+	/* one more, due before the worker is back */
+	reqs[7].deadline = admission_clock () + 1000000;
+	reqs[7].priority = ADMISSION_GOOD;
+	failures += check (verifier_submit (v, &reqs[7]) == 0, "A good request was refused");
+	usleep (10000);
+
+	held = false;
+	for (unsigned int i = 0; i < 20000 && held_ok + held_shed < 7; i++)
+		usleep (100);
+
+	failures += check (held_ok == 4 && held_shed == 3 && reqs[2].status == VERIFY_SHED
+			&& reqs[7].status == VERIFY_SHED, "Wrong verdicts");
+	failures += check (reqs[3].deadline != 0, "No deadline was set");
+
+	VerifierStats stats;
+	verifier_stats (v, &stats);
+	failures += check (stats.submitted == 7 && stats.refused == 1 && stats.shed == 2
+			&& stats.expired == 1 && stats.completed == 4 && stats.verified == 4
+			&& stats.depth == 0, "Wrong counters");
+
+	free_verifier (v);
+	return failures;
+} /* test_verifier */
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+
+	for (unsigned int i = 0; i < KEY_LEN; i++)
+		key[i] = (unsigned char) (i * 11 + 3);
+	memset (data, 'a', sizeof (data));
+
+	SHA256OptMinter minter;
+	if (init_minter (&minter, key, KEY_LEN, 0, 4, 8, 128) != 0)
+	{
+		printf ("[ERROR]: Could not set up the minter!\n");
+		return 1;
+	}
+
+	SHA256OptChallenge *challenge = mint_challenge (&minter, data, sizeof (data), 1);
+	SHA256OptSolution *sol = solveChallenge (challenge);
+	pkt_len = encode_solution (sol, minter.l, minter.k, pkt, sizeof (pkt));
+	OPENSSL_free (challenge->preimage);
+	free (challenge);
+	free_solution_mem (sol);
+
+	failures += test_order ();
+	failures += test_shed ();
+	failures += test_scores ();
+	failures += test_verifier (&minter);
+
+	clear_minter (&minter);
+
+	if (failures == 0)
+		printf ("[Log]: All admission checks passed.\n");
+
+	return failures;
+} /* main */
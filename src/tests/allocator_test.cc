@@ -0,0 +1,211 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  allocator_test.cc
+ *
+ *    Description:  Testing the slab pool and arena allocators with the puzzle
+ *    				factory functions
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 07:12:26 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/factory.h"
+#include "puzzle/allocator.h"
+#include "puzzle/crypto_util.h"
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <string.h>
+
+#ifndef NUM_SUBPUZZLES
+#define NUM_SUBPUZZLES 32
+#endif
+
+#ifndef NUM_ROUNDS
+#define NUM_ROUNDS 100000
+#endif
+
+#ifndef ZLEN
+#define ZLEN 8 /* in bytes */
+#endif
+
+#ifndef NUM_TRANSFERS
+#define NUM_TRANSFERS 1000000
+#endif
+
+#define TRANSFER_RING 	256		/* The blocks in flight between the threads */
+#define MAX_SLABS 		16		/* The slabs the producer may touch */
+#define SLAB_SIZE 		65536	/* See allocator.cc */
+
+/* build a solution of NUM_SUBPUZZLES sub solutions filled with a pattern */
+static SHA256OptSolution *
+build_solution (const PuzzleAllocator *allocator, unsigned char pattern)
+{
+	SHA256OptSolution *sol = create_optsolution (allocator);
+	initOptSolution (sol, pattern, NULL);
+
+	SHA256OptSubSolution *tail = NULL;
+	for (unsigned int i = 0; i < NUM_SUBPUZZLES; i++)
+	{
+		unsigned char *zi = (unsigned char *) puzzle_alloc (allocator, ZLEN);
+		memset (zi, pattern + i, ZLEN);
+
+		SHA256OptSubSolution *item = create_optsubsolution (allocator);
+		initOptSubSolution (item, zi, NULL);
+
+		if (tail)
+			tail->next = item;
+		else
+			sol->head = item;
+		tail = item;
+	}
+
+	return sol;
+} /* build_solution */
+
+/* check that nobody wrote over the solution */
+static int
+check_solution (SHA256OptSolution *sol, unsigned char pattern)
+{
+	SHA256OptSubSolution *item = sol->head;
+	for (unsigned int i = 0; i < NUM_SUBPUZZLES; i++, item = item->next)
+	{
+		for (unsigned int j = 0; j < ZLEN; j++)
+		{
+			if (item->zi[j] != (unsigned char) (pattern + i))
+			{
+				printf ("[ERROR]: Sub solution %u was overwritten!\n", i);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+} /* check_solution */
+
+/* build and free solutions through an allocator and time it */
+static int
+run_rounds (const char *name, const PuzzleAllocator *allocator, PuzzleArena *arena)
+{
+	int failures = 0;
+	timespec start, end;
+	clock_gettime (CLOCK_MONOTONIC, &start);
+
+	for (unsigned int r = 0; r < NUM_ROUNDS; r++)
+	{
+		SHA256OptSolution *a = build_solution (allocator, 1);
+		SHA256OptSolution *b = build_solution (allocator, 101);
+
+		failures += check_solution (a, 1) + check_solution (b, 101);
+
+		if (arena)
+		{ /* one handshake, everything goes at once */
+			reset_arena (arena);
+		} else
+		{
+			free_solution_mem (a, allocator);
+			free_solution_mem (b, allocator);
+		}
+	}
+
+	clock_gettime (CLOCK_MONOTONIC, &end);
+	printf ("[Log]: %s: %d rounds in %lf seconds.\n", name, NUM_ROUNDS,
+			time_diff (start, end));
+
+	return failures;
+} /* run_rounds */
+
+/* one thread allocates and another releases, as a server minting on one
+ * thread and freeing on another does. The released blocks must find their
+ * way back, or the producer keeps carving new slabs. */
+static int
+run_transfers ()
+{
+	void *ring[TRANSFER_RING];
+	std::atomic<size_t> head (0), tail (0);
+	std::set<uintptr_t> slabs;
+
+	std::thread consumer ([&ring, &head, &tail] () {
+		for (size_t j = 0; j < NUM_TRANSFERS; j++)
+		{
+			while (tail.load (std::memory_order_acquire) == j)
+				std::this_thread::yield ();
+			puzzle_release (pool_allocator (), ring[j % TRANSFER_RING]);
+			head.store (j + 1, std::memory_order_release);
+		}
+	});
+
+	for (size_t j = 0; j < NUM_TRANSFERS; j++)
+	{
+		while (j - head.load (std::memory_order_acquire) == TRANSFER_RING)
+			std::this_thread::yield ();
+
+		void *b = puzzle_alloc (pool_allocator (), 64);
+		slabs.insert ((uintptr_t) b & ~((uintptr_t) SLAB_SIZE - 1));
+		ring[j % TRANSFER_RING] = b;
+		tail.store (j + 1, std::memory_order_release);
+	}
+
+	consumer.join ();
+
+	printf ("[Log]: %d transfers across threads used %lu slabs.\n",
+			NUM_TRANSFERS, (unsigned long) slabs.size ());
+	if (slabs.size () > MAX_SLABS)
+	{
+		printf ("[ERROR]: Blocks released on another thread were never reused!\n");
+		return 1;
+	}
+
+	return 0;
+} /* run_transfers */
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+
+	failures += run_rounds ("malloc", NULL, NULL);
+	failures += run_rounds ("pool", pool_allocator (), NULL);
+
+	PuzzleArena *arena = create_arena (0);
+	failures += run_rounds ("arena", arena_allocator (arena), arena);
+	free_arena (arena);
+
+	/* blocks allocated on one thread and released on another */
+	SHA256OptSolution *sol = NULL;
+	std::thread producer ([&sol] () {
+		sol = build_solution (pool_allocator (), 7);
+	});
+	producer.join ();
+
+	failures += check_solution (sol, 7);
+	free_solution_mem (sol, pool_allocator ());
+
+	/* the lists left by the producer are reused */
+	sol = build_solution (pool_allocator (), 9);
+	failures += check_solution (sol, 9);
+	free_solution_mem (sol, pool_allocator ());
+
+	failures += run_transfers ();
+
+	/* blocks larger than the slab classes */
+	void *large = puzzle_alloc (pool_allocator (), 100000);
+	memset (large, 0xab, 100000);
+	puzzle_release (pool_allocator (), large);
+
+	if (failures)
+		printf ("[ERROR]: %d allocator checks failed!\n", failures);
+	else
+		printf ("[Log]: All allocator checks passed.\n");
+
+	return failures? 1 : 0;
+} /* main */
@@ -19,6 +19,8 @@
 #include "client/client.h"
 #include "puzzle/crypto_util.h"
 #include "puzzle/factory.h"
+#include "puzzle/random.h"
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <ctype.h>
@@ -42,7 +44,9 @@ read_comd_args (int argc, char **argv,
 unsigned char
 get_random_char()
 {
-	return (unsigned char) (rand()%255);
+	unsigned char c = 0;
+	random_bytes (&c, 1);
+	return c;
 } /* get_random_char */
 
 /* build a random subpuzzle */
@@ -76,6 +80,33 @@ build_random_subpuzzle (SHA256SubPuzzle *subpuzzle)
 	return 0;
 } /* build_random_subpuzzle */
 
+/* the masks and cleared bits of difficulties over one and two bytes */
+int
+check_masks ()
+{
+	int failures = 0;
+	unsigned int mask_len;
+
+	unsigned char *mask = get_puzzle_mask (0xabcde, 20, &mask_len);
+	if (mask_len != 3 || mask[0] != 0xab || mask[1] != 0xcd || mask[2] != 0xe0)
+		failures++;
+	free (mask);
+
+	mask = get_puzzle_mask (0x123456789aULL, 40, &mask_len);
+	if (mask_len != 5 || mask[0] != 0x12 || mask[4] != 0x9a)
+		failures++;
+	free (mask);
+
+	unsigned char msg[4] = { 0xff, 0xff, 0xff, 0xff };
+	clear_bits (msg, 20);
+	if (msg[0] != 0 || msg[1] != 0 || msg[2] != 0x0f || msg[3] != 0xff)
+		failures++;
+
+	if (failures)
+		printf ("[ERROR]: Wrong masks for wide difficulties!\n");
+	return failures;
+} /* check_masks */
+
 int
 main (int argc, char **argv)
 {
@@ -88,9 +119,6 @@ main (int argc, char **argv)
 
 	SHA256Challenge *challenge = createChallenge();
 
-	/* seed the random generator */
-	srand(time(NULL));
-
 	/* phony data and timestamps */
 	uint32_t 	timestamp = 1.0;
 	uint8_t 	num_subpuzzles = args.k; 	/* number of subpuzzles */
@@ -123,14 +151,40 @@ main (int argc, char **argv)
 
 	/* now solve the subpuzzle */
 	SHA256Solution *sol = solvePuzzle (challenge);
+	int failures = check_masks ();
+
+	/* every preimage found must hash to its image */
+	SHA256SubPuzzle *sub = challenge->puzzle;
+	SHA256SubSolution *it = sol? sol->solution : NULL;
+	for (; sub && it; sub = sub->next, it = it->next)
+	{
+		unsigned char digest[SHA256_DIGEST_LEN];
+		if (digest_message_into (it->solution, IMAGE_LEN, digest) != 0
+				|| memcmp (digest, sub->image, SHA256_DIGEST_LEN) != 0)
+			break;
+	}
+	if (!sol || sub || it)
+	{
+		printf ("[ERROR]: Could not solve %u bits of difficulty!\n", difficulty);
+		failures++;
+	}
 
 	/* print the solution  */
 	// print_digest (sol->solution->solution, IMAGE_LEN);
 
 	/* free stuff up */
+	if (sol)
+	{
+		free_solution_mem (sol);
+		free (sol);
+	}
 	free_challenge_mem (challenge);
 	free (challenge);
 
+	if (failures == 0)
+		printf ("[Log]: All client checks passed.\n");
+	return failures;
+
 } /* main */
 
 /* read command line arguments */
@@ -0,0 +1,293 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  difficulty_test.cc
+ *
+ *    Description:  A simulation harness for the difficulty controller. It replays
+ *    				load curves against a model of the server's verifier and checks
+ *    				how the controller reacts
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 12:06:33 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/difficulty.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef SERVER_HASH_RATE
+#define SERVER_HASH_RATE 2e6 /* the verifier's hashes per second */
+#endif
+
+#ifndef CLIENT_HASH_RATE
+#define CLIENT_HASH_RATE 2e6 /* a legitimate client's hashes per second */
+#endif
+
+#ifndef GARBAGE_COST
+#define GARBAGE_COST 2 /* hashes to reject a forged solution */
+#endif
+
+#ifndef QUEUE_LIMIT
+#define QUEUE_LIMIT 4096 /* the verifier drops what does not fit */
+#endif
+
+#ifndef MAX_PHASES
+#define MAX_PHASES 64
+#endif
+
+/* One phase of a load curve, one tick is one second */
+typedef struct {
+	unsigned int ticks;			/* The length of the phase */
+	double legit_rate;			/* Legitimate solutions per second */
+	double garbage_rate;		/* Forged solutions per second */
+	double attack_hashes;		/* The attackers' hashes per second spent solving */
+} phase_t;
+
+/* A load curve */
+typedef struct {
+	const char *name;
+	phase_t phases[MAX_PHASES];
+	unsigned int num_phases;
+} curve_t;
+
+/* What the controller did over a phase */
+typedef struct {
+	unsigned int changes;		/* The number of moves of the work */
+	unsigned int peak_level;	/* The highest level */
+	unsigned int end_level;		/* The level at the end */
+	double end_queue;			/* The queue depth at the end */
+	double peak_solve;			/* The longest solve time of a legit client */
+} phase_report_t;
+
+/* struct to hold the arguments for the program */
+typedef struct {
+	const char *curve_file;		/* A load curve to replay, NULL for the built in ones */
+	bool verbose;				/* Print every tick */
+} arguments_t;
+
+/* read command line arguments */
+static int
+read_cmd_args (int argc, char **argv, arguments_t *args);
+
+/* run a curve through the model of the verifier
+ *
+ * returns one report per phase
+ */
+static void
+simulate (const curve_t *curve, phase_report_t *reports, bool verbose)
+{
+	DifficultyController ctl;
+	init_difficulty (&ctl, NULL);
+
+	double queue = 0;
+	unsigned int t = 0;
+
+	if (verbose)
+		printf ("# %s\n# t,load,k,m,queue,cpu,fail_rate,legit_solve_s\n", curve->name);
+
+	for (unsigned int p = 0; p < curve->num_phases; p++)
+	{
+		const phase_t *phase = &curve->phases[p];
+		phase_report_t *report = &reports[p];
+		memset (report, 0, sizeof (phase_report_t));
+
+		for (unsigned int i = 0; i < phase->ticks; i++, t++)
+		{
+			uint16_t k, m;
+			difficulty_params (&ctl, &k, &m);
+			double work = k * ldexp (1.0, m);
+
+			/* the attackers solve as many challenges as their hashes allow */
+			double solved = phase->legit_rate + phase->attack_hashes / work;
+			double arrivals = solved + phase->garbage_rate;
+			double cost = arrivals > 0 ?
+				(solved * (k + 1) + phase->garbage_rate * GARBAGE_COST) / arrivals : 1;
+
+			/* the verifier drains what its hashes allow and drops what
+			 * does not fit in its queue */
+			queue += arrivals;
+			double done = fmin (queue, SERVER_HASH_RATE / cost);
+			queue = fmin (queue - done, QUEUE_LIMIT);
+
+			DifficultySignals signals;
+			signals.queue_depth = queue;
+			signals.cpu_util = done * cost / SERVER_HASH_RATE;
+			signals.verified = (uint64_t) (done * (solved / arrivals));
+			signals.failed = (uint64_t) (done * (phase->garbage_rate / arrivals));
+
+			int step = difficulty_update (&ctl, &signals);
+
+			double solve = work / CLIENT_HASH_RATE;
+			if (step != 0)
+				report->changes++;
+			if (ctl.level > report->peak_level)
+				report->peak_level = ctl.level;
+			if (solve > report->peak_solve)
+				report->peak_solve = solve;
+
+			if (verbose)
+				printf ("%u,%.3f,%u,%u,%.0f,%.3f,%.3f,%.4f\n", t, ctl.load, k, m,
+						queue, signals.cpu_util,
+						(double) signals.failed / fmax (1, signals.verified + signals.failed),
+						solve);
+		}
+
+		report->end_level = ctl.level;
+		report->end_queue = queue;
+	}
+} /* simulate */
+
+/* read a curve, one phase per line: ticks legit_rate garbage_rate attack_hashes */
+static int
+read_curve (const char *path, curve_t *curve)
+{
+	FILE *in = fopen (path, "r");
+	if (!in)
+	{
+		printf ("[ERROR]: Cannot open the load curve %s!\n", path);
+		return -1;
+	}
+
+	curve->name = path;
+	curve->num_phases = 0;
+
+	char line[256];
+	while (fgets (line, sizeof (line), in) && curve->num_phases < MAX_PHASES)
+	{
+		if (line[0] == '#' || line[0] == '\n')
+			continue; /* comments and blank lines */
+
+		phase_t *phase = &curve->phases[curve->num_phases];
+		if (sscanf (line, "%u %lf %lf %lf", &phase->ticks, &phase->legit_rate,
+					&phase->garbage_rate, &phase->attack_hashes) != 4)
+		{
+			printf ("[ERROR]: Bad phase in %s: %s", path, line);
+			fclose (in);
+			return -1;
+		}
+
+		curve->num_phases++;
+	}
+
+	fclose (in);
+	return 0;
+} /* read_curve */
+
+static int
+check (bool ok, const char *curve, const char *what)
+{
+	if (ok)
+		return 0;
+
+	printf ("[ERROR]: %s: %s!\n", curve, what);
+	return 1;
+} /* check */
+
+int
+main (int argc, char **argv)
+{
+	arguments_t args;
+	if (read_cmd_args (argc, argv, &args) != 0)
+		exit (-1);
+
+	phase_report_t reports[MAX_PHASES];
+
+	if (args.curve_file)
+	{ /* replay the given curve and report, there is nothing to expect */
+		curve_t curve;
+		if (read_curve (args.curve_file, &curve) != 0)
+			return 1;
+
+		simulate (&curve, reports, args.verbose);
+		for (unsigned int p = 0; p < curve.num_phases; p++)
+			printf ("[Log]: Phase %u: %u changes, peak level %u, end level %u, "
+					"queue %.0f, longest solve %.3fs\n", p, reports[p].changes,
+					reports[p].peak_level, reports[p].end_level, reports[p].end_queue,
+					reports[p].peak_solve);
+		return 0;
+	}
+
+	int failures = 0;
+
+	/* no attack, the clients keep the cheapest challenges */
+	curve_t quiet = { "quiet", { { 300, 1000, 0, 0 } }, 1 };
+	simulate (&quiet, reports, args.verbose);
+	failures += check (reports[0].peak_level == 0, quiet.name, "Work raised without an attack");
+
+	/* a botnet solving challenges, the work must price it out and come back down */
+	curve_t solvers = { "solvers", {
+		{ 60, 1000, 0, 0 },
+		{ 120, 1000, 0, 5e9 },
+		{ 180, 1000, 0, 0 } }, 3 };
+	simulate (&solvers, reports, args.verbose);
+	failures += check (reports[1].peak_level > 0, solvers.name, "Work not raised");
+	failures += check (reports[1].end_queue < 1024, solvers.name, "Queue not drained under attack");
+	failures += check (reports[1].changes <= 12, solvers.name, "Work flapping under attack");
+	failures += check (reports[2].end_level == 0, solvers.name, "Work not lowered after the attack");
+
+	/* forged solutions flood the verifier, the failures alone raise the work */
+	curve_t flood = { "flood", {
+		{ 60, 1000, 0, 0 },
+		{ 60, 1000, 100000, 0 },
+		{ 120, 1000, 0, 0 } }, 3 };
+	simulate (&flood, reports, args.verbose);
+	failures += check (reports[1].peak_level > 0, flood.name, "Work not raised");
+	failures += check (reports[2].end_level == 0, flood.name, "Work not lowered after the flood");
+
+	/* load hovering between the thresholds moves nothing */
+	curve_t steady = { "steady", { { 300, 1000, 0, 1.2e9 } }, 1 };
+	simulate (&steady, reports, args.verbose);
+	failures += check (reports[0].changes <= 4, steady.name, "Work flapping under steady load");
+
+	if (failures)
+		printf ("[ERROR]: %d difficulty checks failed!\n", failures);
+	else
+		printf ("[Log]: All difficulty checks passed.\n");
+
+	return failures? 1 : 0;
+} /* main */
+
+int
+read_cmd_args (int argc, char **argv, arguments_t *args)
+{
+	int c;
+	args->curve_file = NULL; /* default value */
+	args->verbose = false; /* default value */
+
+	while ( (c = getopt (argc, argv, "f:hv")) != -1)
+	{
+		switch (c)
+		{
+			case 'f':
+				args->curve_file = optarg;
+				break;
+			case 'v':
+				args->verbose = true;
+				break;
+			case 'h':
+				printf ("Usage: %s [-f load_curve] [-vh?]\n", argv[0]);
+				return -1;
+			case '?':
+				if (optopt == 'f')
+					printf ("[ERROR]: Option -%c requires an argument.\n", optopt);
+				else
+					printf ("[ERROR]: Unknow option `-%c'.\n", optopt);
+				return -1;
+			default:
+				return -1;
+		}
+	}
+
+	return 0;
+} /* read_cmd_args */
@@ -0,0 +1,606 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  gateway_test.cc
+ *
+ *    Description:  Driving the puzzle gateway over the loopback with simulated
+ *    				clients
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 04:12:36 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "gateway/gateway.h"
+#include "gateway/udp_gateway.h"
+#include "server/optserver.h"
+#include "puzzle/wire.h"
+#include "puzzle/factory.h"
+#include "puzzle/crypto_util.h"
+#include "client/optclient.h"
+#include "test_util.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifndef KEY_LEN
+#define KEY_LEN 32 /* in bytes */
+#endif
+
+#ifndef NUM_SUBPUZZLES
+#define NUM_SUBPUZZLES 4
+#endif
+
+#ifndef DIFFICULTY
+#define DIFFICULTY 8 /* in bits */
+#endif
+
+#ifndef PREFIX_LEN
+#define PREFIX_LEN 128 /* l, in bits */
+#endif
+
+/* the clients and handshakes of the load test */
+#define NUM_CLIENTS 8
+#define NUM_ROUNDS 16
+
+static unsigned char key[KEY_LEN];
+
+/* a gateway configuration for the tests */
+static void
+test_config (GatewayConfig *config)
+{
+	gateway_default_config (config);
+	config->host = "127.0.0.1";
+	config->key = key;
+	config->key_len = KEY_LEN;
+	config->k = NUM_SUBPUZZLES;
+	config->m = DIFFICULTY;
+	config->l = PREFIX_LEN;
+} /* test_config */
+
+/* connect to the gateway */
+static int
+dial (uint16_t port)
+{
+	int fd = socket (AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr;
+	memset (&addr, 0, sizeof (addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons (port);
+	addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+	if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0)
+	{
+		close (fd);
+		return -1;
+	}
+
+	return fd;
+} /* dial */
+
+/* read exactly n bytes, false on EOF or an error */
+static bool
+read_full (int fd, unsigned char *buf, size_t n)
+{
+	for (size_t got = 0; got < n; )
+	{
+		ssize_t r = read (fd, buf + got, n - got);
+		if (r <= 0)
+			return false;
+		got += r;
+	}
+
+	return true;
+} /* read_full */
+
+/* whether something arrives on fd within ms milliseconds */
+static bool
+readable (int fd, int ms)
+{
+	struct pollfd p = { fd, POLLIN, 0 };
+	return poll (&p, 1, ms) == 1;
+} /* readable */
+
+/* corrupt the solution a client sends on fd so that it can never verify.
+ * A flipped z_1 may still solve its sub puzzle, so it is changed until
+ * the gateway's key rejects it for the connection's data, its address
+ * and port as the gateway sees them. */
+static void
+corrupt_solution (int fd, unsigned char *spkt, size_t len)
+{
+	struct sockaddr_in local;
+	socklen_t addr_len = sizeof (local);
+	getsockname (fd, (struct sockaddr *) &local, &addr_len);
+
+	unsigned char data[GATEWAY_DATA_LEN];
+	memcpy (data, &local.sin_addr, 4);
+	memcpy (data + 4, &local.sin_port, 2);
+
+	SHA256OptMinter minter;
+	init_minter (&minter, key, KEY_LEN, 0, NUM_SUBPUZZLES, DIFFICULTY, PREFIX_LEN);
+	SHA256OptVerifyParams params = { 0, 0, NULL };
+	do
+		spkt[WIRE_HEADER_LEN]++;
+	while (minter_verify_packet (&minter, spkt, len, data, 6, &params) == VERIFY_OK);
+	clear_minter (&minter);
+} /* corrupt_solution */
+
+/* the client's side of the handshake: read the challenge, solve it and send
+ * the solution, corrupted if asked to. Returns the first byte the
+ * application writes back, 0 if the gateway closed the connection. */
+static int
+handshake (int fd, bool corrupt)
+{
+	unsigned char cpkt[WIRE_HEADER_LEN + PREFIX_LEN/16];
+	WirePacket wire;
+	if (!read_full (fd, cpkt, sizeof (cpkt))
+			|| wire_parse (cpkt, sizeof (cpkt), &wire) != WIRE_OK)
+		return -1;
+
+	SHA256OptChallenge *challenge = decode_optchallenge (&wire);
+	SHA256OptSolution *sol = solveChallenge (challenge);
+
+	unsigned char spkt[WIRE_HEADER_LEN + NUM_SUBPUZZLES * PREFIX_LEN/16];
+	size_t len = encode_solution (sol, PREFIX_LEN, NUM_SUBPUZZLES, spkt, sizeof (spkt));
+	if (corrupt)
+		corrupt_solution (fd, spkt, sizeof (spkt));
+
+	OPENSSL_free (challenge->preimage);
+	free (challenge);
+	free_solution_mem (sol);
+
+	if (len != sizeof (spkt) || write (fd, spkt, len) != (ssize_t) len)
+		return -1;
+
+	unsigned char answer;
+	return read_full (fd, &answer, 1)? answer : 0;
+} /* handshake */
+
+/* the application behind the gateway, it greets the admitted clients */
+static void
+greet (int fd, const unsigned char *, unsigned int, void *arg)
+{
+	std::atomic<unsigned int> *admitted = (std::atomic<unsigned int> *) arg;
+	admitted->fetch_add (1);
+
+	unsigned char hello = 'A';
+	if (write (fd, &hello, 1) != 1)
+		perror ("[ERROR]: could not greet a client");
+	close (fd);
+} /* greet */
+
+/* many clients at once through the admission callback, verified on the
+ * connection workers or handed to verify_threads of their own, in order
+ * or behind an admission queue of verify_queue */
+static int
+test_admit (unsigned int verify_threads, unsigned int verify_queue)
+{
+	int failures = 0;
+	std::atomic<unsigned int> admitted (0);
+
+	GatewayConfig config;
+	test_config (&config);
+	config.nthreads = 2;
+	config.verify_threads = verify_threads;
+	config.verify_queue = verify_queue;
+	config.verify_ms = 5000;
+	config.admit = greet;
+	config.admit_arg = &admitted;
+
+	PlutusGateway *gw = create_gateway (&config);
+	if (check (gw != NULL, "Could not start the gateway"))
+		return 1;
+	uint16_t port = gateway_port (gw);
+
+	std::atomic<unsigned int> greeted (0);
+	std::vector<std::thread> clients;
+	for (unsigned int c = 0; c < NUM_CLIENTS; c++)
+		clients.push_back (std::thread ([&greeted, port] () {
+					for (unsigned int r = 0; r < NUM_ROUNDS; r++)
+					{
+						int fd = dial (port);
+						if (fd >= 0 && handshake (fd, false) == 'A')
+							greeted.fetch_add (1);
+						close (fd);
+					}
+				}));
+	for (std::thread &t : clients)
+		t.join ();
+
+	failures += check (greeted == NUM_CLIENTS * NUM_ROUNDS, "Honest clients were not admitted");
+
+	/* a wrong solution gets the connection closed */
+	int fd = dial (port);
+	failures += check (handshake (fd, true) == 0, "A corrupted solution was admitted");
+	close (fd);
+
+	GatewayStats stats;
+	gateway_stats (gw, &stats);
+	failures += check (stats.admitted == NUM_CLIENTS * NUM_ROUNDS
+			&& admitted == stats.admitted, "Admissions miscounted");
+	failures += check (stats.rejected == 1, "Rejection miscounted");
+	failures += check (stats.shed == 0, "Solutions were shed without a flood");
+	failures += check (stats.accepted == stats.admitted + stats.rejected, "Accepts miscounted");
+
+	free_gateway (gw);
+	return failures;
+} /* test_admit */
+
+/* a handshake that starts before a rotation finishes after the new key
+ * has taken over, and the next one gets the new key */
+static int
+test_rotate ()
+{
+	int failures = 0;
+	std::atomic<unsigned int> admitted (0);
+
+	GatewayConfig config;
+	test_config (&config);
+	config.nthreads = 1;
+	config.admit = greet;
+	config.admit_arg = &admitted;
+
+	PlutusGateway *gw = create_gateway (&config);
+	if (check (gw != NULL, "Could not start the gateway"))
+		return 1;
+	uint16_t port = gateway_port (gw);
+
+	int fd = dial (port);
+	failures += check (readable (fd, 1000), "No challenge for a new client");
+
+	unsigned char next[KEY_LEN];
+	for (unsigned int i = 0; i < KEY_LEN; i++)
+		next[i] = key[i] ^ 0x5a;
+	failures += check (gateway_rotate_key (gw, next, KEY_LEN) == 1, "Wrong epoch of the new key");
+
+	/* well into the new key's time */
+	usleep (1500000);
+	failures += check (handshake (fd, false) == 'A', "A handshake in flight was lost");
+	close (fd);
+
+	fd = dial (port);
+	failures += check (handshake (fd, false) == 'A', "The new key does not admit");
+	close (fd);
+
+	failures += check (admitted == 2, "Admissions miscounted");
+
+	free_gateway (gw);
+	return failures;
+} /* test_rotate */
+
+/* a worker stops accepting at max_pending and picks up again once the
+ * silent clients time out */
+static int
+test_backpressure ()
+{
+	int failures = 0;
+	std::atomic<unsigned int> admitted (0);
+
+	GatewayConfig config;
+	test_config (&config);
+	config.nthreads = 1;
+	config.max_pending = 2;
+	config.resume_pending = 0;
+	config.handshake_ms = 300;
+	config.admit = greet;
+	config.admit_arg = &admitted;
+
+	PlutusGateway *gw = create_gateway (&config);
+	if (check (gw != NULL, "Could not start the gateway"))
+		return 1;
+	uint16_t port = gateway_port (gw);
+
+	/* two clients that never answer fill the worker */
+	int silent[2];
+	for (int i = 0; i < 2; i++)
+	{
+		silent[i] = dial (port);
+		failures += check (readable (silent[i], 1000), "No challenge for a new client");
+	}
+
+	/* the third waits in the backlog, then gets its turn */
+	int fd = dial (port);
+	failures += check (fd >= 0 && !readable (fd, 100), "The worker accepted past max_pending");
+	failures += check (readable (fd, 2000), "The worker did not resume accepting");
+	failures += check (handshake (fd, false) == 'A', "The waiting client was not admitted");
+	close (fd);
+
+	unsigned char buf[WIRE_HEADER_LEN + PREFIX_LEN/16];
+	for (int i = 0; i < 2; i++)
+	{
+		read_full (silent[i], buf, sizeof (buf));
+		failures += check (!read_full (silent[i], buf, 1), "A silent client was not dropped");
+		close (silent[i]);
+	}
+
+	GatewayStats stats;
+	gateway_stats (gw, &stats);
+	failures += check (stats.timed_out == 2, "Time outs miscounted");
+	failures += check (stats.paused >= 1, "Pauses miscounted");
+	failures += check (stats.pending == 0, "Handshakes left pending");
+
+	free_gateway (gw);
+	return failures;
+} /* test_backpressure */
+
+/* the admitted connections cross a Unix socket to another process */
+static int
+test_handoff ()
+{
+	int failures = 0;
+
+	char path[sizeof (((struct sockaddr_un *) 0)->sun_path)];
+	snprintf (path, sizeof (path), "/tmp/plutus_gateway_test.%d", getpid ());
+	unlink (path);
+
+	int lfd = socket (AF_UNIX, SOCK_SEQPACKET, 0);
+	struct sockaddr_un addr;
+	memset (&addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+	strcpy (addr.sun_path, path);
+	if (check (bind (lfd, (struct sockaddr *) &addr, sizeof (addr)) == 0
+				&& listen (lfd, 8) == 0, "Could not listen for handoffs"))
+		return 1;
+
+	GatewayConfig config;
+	test_config (&config);
+	config.nthreads = 1;
+	config.handoff_path = path;
+
+	PlutusGateway *gw = create_gateway (&config);
+	int receiver = accept (lfd, NULL, NULL);
+	if (check (gw != NULL && receiver >= 0, "Could not start the gateway"))
+		return 1;
+
+	/* the receiver answers on the handed off connection */
+	std::thread app ([receiver, &failures] () {
+			unsigned char data[GATEWAY_DATA_LEN];
+			unsigned int data_len = 0;
+			int fd = gateway_recv_handoff (receiver, data, &data_len);
+			failures += check (fd >= 0 && data_len == 6, "Nothing handed off");
+
+			unsigned char hello = 'H';
+			if (fd >= 0 && write (fd, &hello, 1) != 1)
+				perror ("[ERROR]: could not greet a client");
+			close (fd);
+			});
+
+	int fd = dial (gateway_port (gw));
+	failures += check (handshake (fd, false) == 'H', "The handed off client was not greeted");
+	close (fd);
+	app.join ();
+
+	/* the receiver learns the gateway is gone */
+	free_gateway (gw);
+	failures += check (gateway_recv_handoff (receiver, NULL, NULL) < 0,
+			"A handoff from a stopped gateway");
+
+	close (receiver);
+	close (lfd);
+	unlink (path);
+	return failures;
+} /* test_handoff */
+
+/* count the clients the datagram gateway lets in */
+static void
+count_udp (const struct sockaddr_in *, const unsigned char *, unsigned int, void *arg)
+{
+	((std::atomic<unsigned int> *) arg)->fetch_add (1);
+} /* count_udp */
+
+/* send a datagram and wait for the answer, -1 if there is none */
+static ssize_t
+exchange (int fd, const unsigned char *req, size_t req_len, unsigned char *resp, size_t resp_len)
+{
+	if (send (fd, req, req_len, 0) != (ssize_t) req_len || !readable (fd, 1000))
+		return -1;
+
+	return recv (fd, resp, resp_len, 0);
+} /* exchange */
+
+/* the datagram mode, one client through every step, then a crowd */
+static int
+test_udp ()
+{
+	int failures = 0;
+	std::atomic<unsigned int> admitted (0);
+
+	UdpGatewayConfig config;
+	udp_gateway_default_config (&config);
+	config.host = "127.0.0.1";
+	config.nthreads = 2;
+	config.key = key;
+	config.key_len = KEY_LEN;
+	config.k = NUM_SUBPUZZLES;
+	config.m = DIFFICULTY;
+	config.l = PREFIX_LEN;
+	config.admit = count_udp;
+	config.admit_arg = &admitted;
+
+	PlutusUdpGateway *gw = create_udp_gateway (&config);
+	if (check (gw != NULL, "Could not start the datagram gateway"))
+		return 1;
+
+	struct sockaddr_in addr;
+	memset (&addr, 0, sizeof (addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons (udp_gateway_port (gw));
+	addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+	int fd = socket (AF_INET, SOCK_DGRAM, 0);
+	connect (fd, (struct sockaddr *) &addr, sizeof (addr));
+
+	/* a hello smaller than its challenge is not answered */
+	unsigned char hello[WIRE_HEADER_LEN + PREFIX_LEN/16];
+	unsigned char cpkt[64];
+	encode_hello (0, hello, sizeof (hello));
+	send (fd, hello, WIRE_HEADER_LEN, 0);
+	failures += check (!readable (fd, 100), "A short hello was answered");
+
+	size_t hello_len = encode_hello (PREFIX_LEN/16, hello, sizeof (hello));
+	ssize_t clen = exchange (fd, hello, hello_len, cpkt, sizeof (cpkt));
+
+	WirePacket wire;
+	failures += check (clen == (ssize_t) hello_len && wire_parse (cpkt, clen, &wire) == WIRE_OK
+			&& wire.type == WIRE_OPT_CHALLENGE, "No challenge for a hello");
+
+	SHA256OptChallenge *challenge = decode_optchallenge (&wire);
+	SHA256OptSolution *sol = solveChallenge (challenge);
+	unsigned char spkt[WIRE_HEADER_LEN + NUM_SUBPUZZLES * PREFIX_LEN/16];
+	encode_solution (sol, PREFIX_LEN, NUM_SUBPUZZLES, spkt, sizeof (spkt));
+	OPENSSL_free (challenge->preimage);
+	free (challenge);
+	free_solution_mem (sol);
+
+	/* the solution, its replay and a corrupted copy */
+	uint8_t expected[3] = { VERIFY_OK, VERIFY_REPLAY, VERIFY_FAILED };
+	for (int round = 0; round < 3; round++)
+	{
+		if (round == 2)
+			corrupt_solution (fd, spkt, sizeof (spkt));
+
+		unsigned char verdict[64];
+		ssize_t vlen = exchange (fd, spkt, sizeof (spkt), verdict, sizeof (verdict));
+		failures += check (vlen > 0 && wire_parse (verdict, vlen, &wire) == WIRE_OK
+				&& wire.type == WIRE_VERDICT && wire.body[0] == expected[round],
+				"Wrong verdict on a solution");
+	}
+	close (fd);
+
+	/* a crowd of clients, the hellos arrive in batches */
+	const unsigned int crowd = 32;
+	int fds[crowd];
+	for (unsigned int c = 0; c < crowd; c++)
+	{
+		fds[c] = socket (AF_INET, SOCK_DGRAM, 0);
+		connect (fds[c], (struct sockaddr *) &addr, sizeof (addr));
+		send (fds[c], hello, hello_len, 0);
+	}
+
+	unsigned int answered = 0;
+	for (unsigned int c = 0; c < crowd; c++)
+	{
+		if (readable (fds[c], 1000) && recv (fds[c], cpkt, sizeof (cpkt), 0) == clen)
+			answered++;
+		close (fds[c]);
+	}
+	failures += check (answered == crowd, "Not every client got a challenge");
+
+	UdpGatewayStats stats;
+	udp_gateway_stats (gw, &stats);
+	failures += check (stats.minted == crowd + 1 && stats.admitted == 1 && admitted == 1
+			&& stats.rejected == 2 && stats.ignored == 1, "Datagrams miscounted");
+	failures += check (stats.received == stats.minted + stats.admitted + stats.rejected
+			+ stats.ignored, "Datagrams lost");
+
+	free_udp_gateway (gw);
+	return failures;
+} /* test_udp */
+
+/* the CPU time of the process so far, in ms */
+static uint64_t
+cpu_ms ()
+{
+	struct rusage usage;
+	getrusage (RUSAGE_SELF, &usage);
+	return (uint64_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+		+ (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+} /* cpu_ms */
+
+/* a worker out of descriptors waits with its clients in the backlog
+ * rather than spinning on its readable listening socket */
+static int
+test_descriptors ()
+{
+	int failures = 0;
+	std::atomic<unsigned int> admitted (0);
+
+	GatewayConfig config;
+	test_config (&config);
+	config.nthreads = 1;
+	config.admit = greet;
+	config.admit_arg = &admitted;
+
+	PlutusGateway *gw = create_gateway (&config);
+	if (check (gw != NULL, "Could not start the gateway"))
+		return 1;
+
+	struct sockaddr_in addr;
+	memset (&addr, 0, sizeof (addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons (gateway_port (gw));
+	addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+	/* use up the descriptors under a small limit, the client's socket is
+	 * made before and connects after */
+	struct rlimit saved, limit;
+	getrlimit (RLIMIT_NOFILE, &saved);
+	limit = saved;
+	limit.rlim_cur = 256;
+	setrlimit (RLIMIT_NOFILE, &limit);
+
+	int fd = socket (AF_INET, SOCK_STREAM, 0);
+	std::vector<int> fillers;
+	for (int f; (f = dup (fd)) >= 0; )
+		fillers.push_back (f);
+	failures += check (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) == 0,
+			"Could not connect");
+
+	uint64_t start = cpu_ms ();
+	failures += check (!readable (fd, 500), "A client was accepted without a descriptor");
+	failures += check (cpu_ms () - start < 250, "The worker spun out of descriptors");
+
+	for (int f : fillers)
+		close (f);
+	setrlimit (RLIMIT_NOFILE, &saved);
+
+	failures += check (readable (fd, 2000), "The worker did not accept again");
+	failures += check (handshake (fd, false) == 'A', "The waiting client was not admitted");
+	close (fd);
+
+	free_gateway (gw);
+	return failures;
+} /* test_descriptors */
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+	signal (SIGPIPE, SIG_IGN);
+
+	for (unsigned int i = 0; i < KEY_LEN; i++)
+		key[i] = (unsigned char) (i * 7 + 1);
+
+	failures += test_admit (0, 0);
+	failures += test_admit (2, 0);
+	failures += test_admit (2, 1024);
+	failures += test_rotate ();
+	failures += test_backpressure ();
+	failures += test_descriptors ();
+	failures += test_handoff ();
+	failures += test_udp ();
+
+	if (failures)
+		printf ("[ERROR]: %d gateway checks failed!\n", failures);
+	else
+		printf ("[Log]: All gateway checks passed.\n");
+
+	return failures? 1 : 0;
+} /* main */
@@ -0,0 +1,276 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  keyring_test.cc
+ *
+ *    Description:  Tests of the keys by epoch, their choice by timestamp and
+ *    				their rotation under readers
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 01:58:33 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/keyring.h"
+#include "server/verifier.h"
+#include "client/optclient.h"
+#include "puzzle/wire.h"
+#include "test_util.h"
+
+#include <openssl/crypto.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifndef KEY_LEN
+#define KEY_LEN 32 /* in bytes */
+#endif
+
+#define PKT_LEN 	(WIRE_HEADER_LEN + 4 * 8)
+#define NUM_READERS 4
+#define NUM_ROTATIONS 2000
+
+static unsigned char data[4] = { 'k', 'e', 'y', 's' };
+
+/* a key of its own for every epoch */
+static void
+make_key (unsigned char *key, unsigned int epoch)
+{
+	for (unsigned int i = 0; i < KEY_LEN; i++)
+		key[i] = (unsigned char) (i * 7 + epoch * 13 + 1);
+} /* make_key */
+
+/* solve the challenge the keyring mints at a timestamp, into its packet
+ *
+ * returns 0 on success, -1 otherwise
+ */
+static int
+solve_at (PlutusKeyring *ring, uint32_t timestamp, unsigned char *pkt)
+{
+	const KeyringSnapshot *keys = keyring_enter (ring);
+	const SHA256OptMinter *minter = keyring_select (keys, timestamp);
+	SHA256OptChallenge *challenge = minter?
+		mint_challenge (minter, data, sizeof (data), timestamp) : NULL;
+	uint16_t l = minter? minter->l : 0, k = minter? minter->k : 0;
+	keyring_exit (ring);
+
+	if (!challenge)
+		return -1;
+
+	SHA256OptSolution *sol = solveChallenge (challenge);
+	size_t len = encode_solution (sol, l, k, pkt, PKT_LEN);
+	OPENSSL_free (challenge->preimage);
+	free (challenge);
+	free_solution_mem (sol);
+
+	return (len == PKT_LEN)? 0 : -1;
+} /* solve_at */
+
+/* the key of a timestamp mints and verifies, the key before it keeps
+ * verifying, and the one before that is gone */
+static int
+test_epochs ()
+{
+	int failures = 0;
+	unsigned char key[KEY_LEN];
+	SHA256OptVerifyParams params = { 0, 0, NULL };
+
+	make_key (key, 0);
+	failures += check (create_keyring (key, KEY_LEN, 4, 8, 100) == NULL,
+			"A keyring took a bad prefix length");
+	failures += check (create_keyring (key, KEY_LEN, 4, 65, 128) == NULL,
+			"A keyring took more difficulty than x has bits");
+	PlutusKeyring *ring = create_keyring (key, KEY_LEN, 4, 8, 128);
+	if (check (ring != NULL && keyring_epoch (ring) == 0, "Could not create the keyring"))
+		return 1;
+
+	unsigned char old[PKT_LEN], late[PKT_LEN], fresh[PKT_LEN], newest[PKT_LEN];
+	failures += check (solve_at (ring, 100, old) == 0, "Could not solve in epoch 0");
+
+	make_key (key, 1);
+	failures += check (keyring_rotate (ring, key, KEY_LEN, 200) == 1
+			&& keyring_epoch (ring) == 1, "Wrong epoch after a rotation");
+	failures += check (keyring_rotate (ring, key, KEY_LEN, 200) == -1,
+			"A rotation went back in time");
+
+	/* before its since a new key mints nothing, the old one goes on */
+	failures += check (solve_at (ring, 150, late) == 0 && solve_at (ring, 250, fresh) == 0,
+			"Could not solve around the rotation");
+	failures += check (keyring_verify_packet (ring, old, PKT_LEN, data, sizeof (data), &params)
+			== VERIFY_OK, "The previous key stopped verifying");
+	failures += check (keyring_verify_packet (ring, late, PKT_LEN, data, sizeof (data), &params)
+			== VERIFY_OK, "A late challenge of the previous key failed");
+	failures += check (keyring_verify_packet (ring, fresh, PKT_LEN, data, sizeof (data), &params)
+			== VERIFY_OK, "The new key does not verify");
+
+	make_key (key, 2);
+	failures += check (keyring_rotate (ring, key, KEY_LEN, 300) == 2, "Wrong second epoch");
+	failures += check (solve_at (ring, 350, newest) == 0, "Could not solve in epoch 2");
+	failures += check (keyring_verify_packet (ring, old, PKT_LEN, data, sizeof (data), &params)
+			== VERIFY_STALE, "A dropped key still verifies");
+
+	/* a batch across the epochs, split in runs by key */
+	unsigned char corrupt[PKT_LEN];
+	memcpy (corrupt, newest, PKT_LEN);
+	corrupt[PKT_LEN - 1] ^= 1;
+
+	SHA256OptPacketItem items[5] = {
+		{ fresh, PKT_LEN, data, sizeof (data) },
+		{ newest, PKT_LEN, data, sizeof (data) },
+		{ corrupt, PKT_LEN, data, sizeof (data) },
+		{ old, PKT_LEN, data, sizeof (data) },
+		{ fresh, 3, data, sizeof (data) }
+	};
+	verify_status_t statuses[5];
+	unsigned int ok = keyring_verify_packets (ring, items, 5, &params, statuses);
+	failures += check (ok == 2 && statuses[0] == VERIFY_OK && statuses[1] == VERIFY_OK
+			&& statuses[2] == VERIFY_FAILED && statuses[3] == VERIFY_STALE
+			&& statuses[4] == VERIFY_MALFORMED, "Wrong verdicts of a mixed batch");
+
+	/* nothing is minted for a timestamp older than every key */
+	unsigned char pkt[WIRE_HEADER_LEN + SHA256_DIGEST_LEN];
+	SHA256OptPacketItem mint = { pkt, sizeof (pkt), data, sizeof (data) };
+	failures += check (keyring_mint_packets (ring, &mint, 1, 100) == 0 && mint.pkt_len == 0,
+			"A refused mint left its length");
+	mint.pkt_len = sizeof (pkt);
+	failures += check (keyring_mint_packets (ring, &mint, 1, 300) == 1, "Wrong mints");
+
+	free_keyring (ring);
+	return failures;
+} /* test_epochs */
+
+/* readers keep the keys they entered with while a writer rotates under
+ * them, a reclaimed snapshot would read as wiped */
+static int
+test_rotations ()
+{
+	unsigned char key[KEY_LEN];
+	make_key (key, 0);
+	PlutusKeyring *ring = create_keyring (key, KEY_LEN, 4, 8, 128);
+	if (check (ring != NULL, "Could not create the keyring"))
+		return 1;
+
+	std::atomic<bool> done (false);
+	std::atomic<unsigned int> torn (0), sections (0);
+	std::vector<std::thread> readers;
+	for (unsigned int t = 0; t < NUM_READERS; t++)
+		readers.push_back (std::thread ([ring, &done, &torn, &sections] () {
+					while (!done.load ())
+					{
+						const KeyringSnapshot *keys = keyring_enter (ring);
+						uint32_t epoch = keys->current.epoch;
+						uint16_t k = keys->current.k;
+						for (unsigned int i = 0; i < 64; i++)
+							__asm__ __volatile__ ("" ::: "memory");
+						if (keys->current.epoch != epoch || keys->current.k != k || k != 4
+								|| (keys->has_previous && keys->previous.epoch + 1 != epoch))
+							torn.fetch_add (1);
+						keyring_exit (ring);
+						sections.fetch_add (1);
+					}
+				}));
+
+	/* the readers are in before the first rotation */
+	while (sections.load () < NUM_READERS)
+		usleep (100);
+
+	int failures = 0;
+	for (unsigned int r = 1; r <= NUM_ROTATIONS; r++)
+	{
+		make_key (key, r);
+		if (keyring_rotate (ring, key, KEY_LEN, r) != (int64_t) r)
+			failures++;
+	}
+
+	done = true;
+	for (std::thread &t : readers)
+		t.join ();
+
+	failures += check (torn == 0, "A reader saw its keys change");
+	failures += check (failures == 0 && keyring_epoch (ring) == NUM_ROTATIONS,
+			"Wrong rotations");
+
+	free_keyring (ring);
+	return failures;
+} /* test_rotations */
+
+static std::atomic<unsigned int> verified;
+
+static void
+count_done (VerifyRequest *req)
+{
+	if (req->status == VERIFY_OK)
+		verified.fetch_add (1);
+} /* count_done */
+
+/* the verifier takes the keys from a keyring */
+static int
+test_verifier ()
+{
+	int failures = 0;
+	unsigned char key[KEY_LEN];
+	make_key (key, 0);
+	PlutusKeyring *ring = create_keyring (key, KEY_LEN, 4, 8, 128);
+
+	unsigned char before[PKT_LEN], after[PKT_LEN];
+	failures += check (solve_at (ring, 100, before) == 0, "Could not solve in epoch 0");
+	make_key (key, 1);
+	keyring_rotate (ring, key, KEY_LEN, 200);
+	failures += check (solve_at (ring, 200, after) == 0, "Could not solve in epoch 1");
+
+	VerifierConfig config;
+	verifier_default_config (&config);
+	config.keyring = ring;
+	config.max_age = 0;
+	config.nthreads = 1;
+	config.capacity = 4;
+
+	PlutusVerifier *v = create_verifier (&config);
+	if (check (v != NULL, "Could not start the verifier"))
+		return failures + 1;
+
+	verified = 0;
+	VerifyRequest reqs[2];
+	unsigned char *pkts[2] = { before, after };
+	for (unsigned int j = 0; j < 2; j++)
+	{
+		memset (&reqs[j], 0, sizeof (reqs[j]));
+		reqs[j].pkt = pkts[j];
+		reqs[j].pkt_len = PKT_LEN;
+		reqs[j].data = data;
+		reqs[j].data_len = sizeof (data);
+		reqs[j].done = count_done;
+		failures += check (verifier_submit (v, &reqs[j]) == 0, "A request was refused");
+	}
+
+	free_verifier (v);
+	failures += check (verified == 2, "The verifier did not use both keys");
+
+	free_keyring (ring);
+	return failures;
+} /* test_verifier */
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+
+	failures += test_epochs ();
+	failures += test_rotations ();
+	failures += test_verifier ();
+
+	if (failures == 0)
+		printf ("[Log]: All keyring checks passed.\n");
+
+	return failures;
+} /* main */
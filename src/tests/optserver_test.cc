@@ -20,11 +20,15 @@
 #include "server/optserver.h"
 #include "puzzle/factory.h"
 #include "puzzle/crypto_util.h"
+#include "puzzle/flatpuzzle.h"
 #include "client/optclient.h"
+#include "puzzle/metrics.h"
+#include "puzzle/random.h"
 
 #include <time.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <string.h>
 
 #ifndef KEY_LEN
 #define KEY_LEN 128 /* in bytes */
@@ -43,6 +47,8 @@
 typedef struct {
 	unsigned int k;
 	unsigned int m;
+	unsigned int threads;	/* the number of solver threads, 0 for serial */
+	unsigned int batch;		/* the size of a verification batch, 0 for none */
 	unsigned int l;
 	bool verbose;
 } arguments_t;
@@ -71,9 +77,6 @@ main (int argc, char **argv)
 	uint16_t m = args.m;
 	unsigned int l = args.l;
 
-	/* seed the pseudo-rando number generator */
-	srand (time(NULL));
-
 	/* we need to generatekey and a random set of data
 	 * they key size is KEY_LEN and the image length 
 	 * is IMAGE_LEN in bytes 
@@ -92,7 +95,16 @@ main (int argc, char **argv)
 				key, KEY_LEN, timestamp, k, m, l);
 
 	/* find the solution */
-	SHA256OptSolution *sol = solveChallenge (challenge);
+	SHA256OptSolution *sol;
+	if (args.threads > 0)
+	{ /* solve on a pool of workers */
+		SolverPool *pool = create_solver_pool (args.threads, 0);
+		sol = solveChallengeParallel (challenge, pool);
+		free_solver_pool (pool);
+	} else
+	{
+		sol = solveChallenge (challenge);
+	}
 
 	/* verify the solution */
 	bool verified = verify_solution (sol, data, DATA_LEN,
@@ -103,8 +115,117 @@ main (int argc, char **argv)
 	else
 		printf ("[Log]: Solution verified!\n");
 
+	/* the solution must survive a trip through the flat layout */
+	SHA256OptFlatSolution *flat = flatten_optsolution (sol, l, k);
+	SHA256OptSolution *rebuilt = unflatten_optsolution (flat);
+	if (verify_solution_ex (rebuilt, data, DATA_LEN, key, KEY_LEN,
+				l, k, m, NULL) != VERIFY_OK)
+		printf ("[Log]: Flattened solution verification failed!\n");
+	else
+		printf ("[Log]: Flattened solution verified!\n");
+	free_solution_mem (rebuilt);
+	free_optflatsolution (flat);
+
+	/* a minter must derive the same challenge and verify the same way */
+	SHA256OptMinter minter;
+	init_minter (&minter, key, KEY_LEN, 0, k, m, l);
+	SHA256OptChallenge *minted = mint_challenge (&minter, data, DATA_LEN, timestamp);
+	if (memcmp (minted->preimage, challenge->preimage, challenge->len/2) != 0
+			|| minter_verify (&minter, sol, data, DATA_LEN, NULL) != VERIFY_OK)
+		printf ("[Log]: Minted challenge verification failed!\n");
+	else
+		printf ("[Log]: Minted challenge verified!\n");
+	OPENSSL_free (minted->preimage);
+	free (minted);
+
+	/* garbage must be rejected before any hashing */
+	SHA256OptVerifyParams params = { timestamp + 10, 5, NULL };
+	verify_status_t stale = verify_solution_ex (sol, data, DATA_LEN,
+			key, KEY_LEN, l, k, m, &params);
+	verify_status_t shorter = verify_solution_ex (sol, data, DATA_LEN,
+			key, KEY_LEN, l, k + 1, m, NULL);
+	verify_status_t empty = verify_solution_ex (NULL, data, DATA_LEN,
+			key, KEY_LEN, l, k, m, NULL);
+	verify_status_t harder = verify_solution_ex (sol, data, DATA_LEN,
+			key, KEY_LEN, l, k, l/2 + 1, NULL);
+
+	if (stale != VERIFY_STALE || shorter != VERIFY_SHORT || empty != VERIFY_EMPTY
+			|| harder != VERIFY_BAD_PARAMS)
+		printf ("[Log]: Early rejection failed (%s, %s, %s, %s)!\n",
+				verify_status_name (stale), verify_status_name (shorter),
+				verify_status_name (empty), verify_status_name (harder));
+	else
+		printf ("[Log]: Malformed solutions rejected early!\n");
+
+	/* a solution is accepted once, its copies are rejected before hashing */
+	SHA256OptVerifyParams replay_params = { timestamp, 0, create_replay_cache (1 << 16, 60, NULL) };
+	verify_status_t first = minter_verify (&minter, sol, data, DATA_LEN, &replay_params);
+	verify_status_t again = minter_verify (&minter, sol, data, DATA_LEN, &replay_params);
+
+	SHA256OptVerifyItem copies[4];
+	for (unsigned int j = 0; j < 4; j++)
+		copies[j] = { sol, data, DATA_LEN };
+
+	uint64_t copies_ok;
+	SHA256OptVerifyParams batch_params = { timestamp, 0, create_replay_cache (1 << 16, 60, NULL) };
+	unsigned int accepted = minter_verify_batch_ex (&minter, copies, 4, &batch_params, &copies_ok);
+
+	if (first != VERIFY_OK || again != VERIFY_REPLAY || accepted != 1 || copies_ok != 1)
+		printf ("[Log]: Replay rejection failed (%s, %s, %u accepted)!\n",
+				verify_status_name (first), verify_status_name (again), accepted);
+	else
+		printf ("[Log]: Replayed solutions rejected!\n");
+	free_replay_cache (replay_params.replay);
+	free_replay_cache (batch_params.replay);
+
+	if (args.batch > 0)
+	{ /* verify the same solution many times in one batch */
+		SHA256OptVerifyItem *items = (SHA256OptVerifyItem *)
+			malloc (args.batch * sizeof (SHA256OptVerifyItem));
+		uint64_t *results = (uint64_t *)
+			malloc (((args.batch + 63) / 64) * sizeof (uint64_t));
+
+		for (unsigned int j = 0; j < args.batch; j++)
+		{
+			items[j].sol = sol;
+			items[j].data = data;
+			items[j].data_len = DATA_LEN;
+		}
+
+		unsigned int count = verify_solutions_batch (items, args.batch,
+				key, KEY_LEN, l, k, m, results);
+		if (minter_verify_batch (&minter, items, args.batch, results) != count)
+			count = 0;
+
+		if (count != args.batch)
+			printf ("[Log]: Batch verification failed, %u out of %u verified!\n",
+					count, args.batch);
+		else
+			printf ("[Log]: Batch of %u solutions verified!\n", count);
+
+		free (results);
+		free (items);
+	}
+
+#ifndef PLUTUS_NO_METRICS
+	/* every outcome above went through the counters */
+	metrics_snapshot_t snap;
+	metrics_snapshot (&snap);
+	if (snap.counters[METRIC_VERIFY_OK] < 5 || snap.counters[METRIC_VERIFY_STALE] < 1
+			|| snap.counters[METRIC_VERIFY_REPLAY] < 4
+			|| snap.counters[METRIC_VERIFY_SHORT] < 1 || snap.counters[METRIC_VERIFY_EMPTY] < 1
+			|| snap.counters[METRIC_CHALLENGES_MINTED] < 2 || snap.counters[METRIC_HASHES] == 0)
+		printf ("[Log]: Metrics do not match the operations!\n");
+	else
+		printf ("[Log]: Metrics counted %lu hashes!\n",
+				(unsigned long) snap.counters[METRIC_HASHES]);
+
+	if (args.verbose)
+		metrics_write_prometheus (stdout);
+#endif
 
 	/* free the memory allocated */
+	clear_minter (&minter);
 	free_solution_mem (sol);
 	free (key);
 	free (data);
@@ -120,10 +241,7 @@ create_random_bytes (unsigned char *buf, unsigned int buf_len)
 	if (! buf)
 		return; /* nothing to do */
 	
-	for (unsigned int i=0;i<buf_len;i++)
-	{
-		buf[i] = (unsigned char) rand()%255;
-	}
+	random_bytes (buf, buf_len);
 } /* create_random_bytes */
 
 
@@ -133,9 +251,12 @@ read_cmd_args (int argc, char **argv, arguments_t *args)
 	int c;
 	int k = -1;
 	int m = -1;
+	args->threads = 0; /* default value */
+	args->batch = 0; /* default value */
 	args->l = 128; /* default value */
+	args->verbose = false; /* default value */
 
-	while ( (c = getopt (argc, argv, "k:m:hv")) != -1)
+	while ( (c = getopt (argc, argv, "k:m:t:b:hv")) != -1)
 	{
 		switch (c)
 		{
@@ -145,6 +266,12 @@ read_cmd_args (int argc, char **argv, arguments_t *args)
 			case 'm':
 				m = atoi(optarg);
 				break;
+			case 't':
+				args->threads = atoi(optarg);
+				break;
+			case 'b':
+				args->batch = atoi(optarg);
+				break;
 			case 'v':
 				args->verbose = true;
 				break;
@@ -157,7 +284,7 @@ read_cmd_args (int argc, char **argv, arguments_t *args)
 				args->l = atoi(optarg);
 				break;
 			case '?':
-				if (optopt == 'k' || optopt == 'm' || optopt == 'l')
+				if (optopt == 'k' || optopt == 'm' || optopt == 't' || optopt == 'b' || optopt == 'l')
 					printf ("[ERROR]: Option -%c requires an argument.\n", optopt);
 				else if (isprint (optopt))
 					printf ("[ERROR]: Unknow option `-%c'.\n", optopt);
@@ -179,7 +306,7 @@ read_cmd_args (int argc, char **argv, arguments_t *args)
 	/* check that both k and m are set */
 	if (k == -1 || m == -1)
 	{
-		printf ("Usage: %s -k num_subpuzzle -m bits_difficulty -l prefix_len [-vh?]\n", 
+		printf ("Usage: %s -k num_subpuzzle -m bits_difficulty -l prefix_len [-t threads] [-b batch] [-vh?]\n", 
 				argv[0]);
 		return -1;
 	}
@@ -0,0 +1,136 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  plutus_test.cc
+ *
+ *    Description:  Tests of the C++ interface, a challenge goes through minting,
+ *    				the wire, solving and verifying
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 07:20:15 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "plutus/plutus.h"
+#include "puzzle/wire.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <array>
+#include <type_traits>
+#include <utility>
+
+#ifndef KEY_LEN
+#define KEY_LEN 32 /* in bytes */
+#endif
+
+#ifndef DATA_LEN
+#define DATA_LEN 18 /* in bytes */
+#endif
+
+/* the values are moved, never copied */
+static_assert (!std::is_copy_constructible_v<plutus::Challenge>);
+static_assert (!std::is_copy_constructible_v<plutus::Solution>);
+static_assert (!std::is_copy_constructible_v<plutus::Minter>);
+static_assert (std::is_nothrow_move_constructible_v<plutus::Solution>);
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+
+	std::array<unsigned char, KEY_LEN> key;
+	std::array<unsigned char, DATA_LEN> data;
+	for (unsigned int i = 0; i < KEY_LEN; i++)
+		key[i] = (unsigned char) (i * 13 + 5);
+	for (unsigned int i = 0; i < DATA_LEN; i++)
+		data[i] = (unsigned char) (i * 7 + 1);
+
+	const plutus::Params params = { 4, 8, 128 };
+	if (check (!plutus::Minter::create (key, { 4, 8, 120 }), "Bad parameters were taken"))
+		return 1;
+
+	std::optional<plutus::Minter> made = plutus::Minter::create (key, params, 3);
+	if (check (made.has_value (), "Could not create a minter"))
+		return 1;
+
+	/* a moved minter carries the key state, the old one is wiped */
+	plutus::Minter minter = std::move (*made);
+	failures += check (minter.epoch () == 3 && minter.params ().l == params.l,
+			"The minter lost its parameters");
+
+	/* the challenge makes it through the wire */
+	plutus::Challenge minted = minter.mint (data, 100);
+	std::array<unsigned char, WIRE_HEADER_LEN + 32> cpkt;
+	size_t clen = minted.encode (cpkt);
+	failures += check (clen == WIRE_HEADER_LEN + params.x_len (), "Wrong challenge length");
+
+	std::array<unsigned char, WIRE_HEADER_LEN + 32> direct;
+	failures += check (minter.mint_packet (data, 100, direct) == clen
+			&& memcmp (direct.data (), cpkt.data (), clen) == 0,
+			"Minted packets differ");
+
+	std::optional<plutus::Challenge> challenge =
+		plutus::Challenge::decode (std::span (cpkt.data (), clen));
+	failures += check (challenge && challenge->timestamp () == 100
+			&& challenge->params ().k == params.k
+			&& std::equal (challenge->x ().begin (), challenge->x ().end (), minted.x ().begin ()),
+			"The challenge did not survive the wire");
+	if (!challenge)
+		return 1;
+
+	/* solve it and verify both ways */
+	std::optional<plutus::Solution> sol = plutus::solve (*challenge);
+	if (check (sol.has_value (), "Could not solve the challenge"))
+		return 1;
+
+	std::optional<plutus::ReplayCache> replay = plutus::ReplayCache::create (1 << 16, 60);
+	plutus::Policy policy = { 100, 30, replay ? replay->get () : nullptr };
+	failures += check (minter.verify (*sol, data, policy) == VERIFY_OK, "The solution was rejected");
+	failures += check (minter.verify (*sol, data, policy) == VERIFY_REPLAY, "A replay was accepted");
+
+	std::array<unsigned char, WIRE_HEADER_LEN + 4 * 8> spkt;
+	size_t slen = sol->encode (spkt);
+	auto packet = std::span (spkt.data (), slen);
+	failures += check (slen == spkt.size () && minter.verify_packet (packet, data) == VERIFY_OK,
+			"The solution packet was rejected");
+
+	std::optional<plutus::Solution> decoded = plutus::Solution::decode (packet);
+	failures += check (decoded && minter.verify (*decoded, data) == VERIFY_OK,
+			"The decoded solution was rejected");
+
+	/* solving again reuses the solution's buffer */
+	plutus::Challenge next = minter.mint (data, 101);
+	const unsigned char *storage = sol->z (0).data ();
+	failures += check (plutus::solve_into (next, *sol) && sol->z (0).data () == storage
+			&& sol->timestamp () == 101 && minter.verify (*sol, data) == VERIFY_OK,
+			"Could not solve into a solution");
+
+	plutus::Solution small (2, params.x_len ());
+	failures += check (!plutus::solve_into (next, small), "Solved into a short solution");
+
+	/* rejections */
+	sol->z (params.k - 1)[0] ^= 1;
+	failures += check (minter.verify (*sol, data) == VERIFY_FAILED, "A wrong solution was accepted");
+	failures += check (minter.verify (small, data) == VERIFY_SHORT, "A short solution was accepted");
+	failures += check (minter.verify (*decoded, data, { 200, 30, nullptr }) == VERIFY_STALE,
+			"A stale solution was accepted");
+
+	plutus::Solution taken = std::move (*sol);
+	failures += check (minter.verify (*sol, data) == VERIFY_EMPTY, "A moved solution was accepted");
+	failures += check (made->verify (*decoded, data) == VERIFY_BAD_PARAMS,
+			"A moved minter kept its key");
+
+	if (failures == 0)
+		printf ("[Log]: All plutus checks passed.\n");
+
+	return failures;
+} /* main */
@@ -0,0 +1,169 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  random_test.cc
+ *
+ *    Description:  Tests of the random generator of every thread and of the
+ *    				scrambled bits of the naive puzzles
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 12:31:50 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/random.h"
+#include "server/server.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <thread>
+
+/* the block function against the test vector of RFC 8439, 2.3.2 */
+static int
+test_block ()
+{
+	unsigned char key[CHACHA20_KEY_LEN];
+	for (unsigned int i = 0; i < CHACHA20_KEY_LEN; i++)
+		key[i] = (unsigned char) i;
+	const unsigned char nonce[CHACHA20_NONCE_LEN] = { 0, 0, 0, 0x09, 0, 0, 0, 0x4a, 0, 0, 0, 0 };
+	const unsigned char expect[CHACHA20_BLOCK_LEN] = {
+		0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4,
+		0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0, 0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e,
+		0xd2, 0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05, 0xd9, 0x8b, 0x02, 0xa2,
+		0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e, 0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e
+	};
+
+	unsigned char out[CHACHA20_BLOCK_LEN];
+	chacha20_block (key, 1, nonce, out);
+	return check (memcmp (out, expect, sizeof (out)) == 0, "Wrong ChaCha20 block");
+} /* test_block */
+
+/* a fixed seed repeats, across the refills too, and the system seed does not */
+static int
+test_seed ()
+{
+	int failures = 0;
+	const size_t len = 3 * RANDOM_REFILL_BLOCKS * CHACHA20_BLOCK_LEN + 7;
+	unsigned char a[len], b[len], c[len];
+
+	random_seed (42);
+	random_bytes (a, 5);
+	random_bytes (a + 5, len - 5);
+	random_seed (42);
+	random_bytes (b, len);
+	failures += check (memcmp (a, b, len) == 0, "A fixed seed did not repeat");
+
+	random_seed (43);
+	random_bytes (c, len);
+	failures += check (memcmp (a, c, len) != 0, "Two seeds gave the same bytes");
+
+	failures += check (random_reseed () == 0, "Could not seed from the system");
+	random_bytes (c, len);
+	failures += check (memcmp (a, c, len) != 0, "The system seed repeated a fixed one");
+
+	/* no byte value is left out, unlike rand () % 255 */
+	bool seen[256] = { false };
+	for (size_t i = 0; i < len; i++)
+		seen[c[i]] = true;
+	unsigned int values = 0;
+	for (unsigned int v = 0; v < 256; v++)
+		values += seen[v];
+	failures += check (values == 256, "Byte values are missing");
+
+	return failures;
+} /* test_seed */
+
+/* every thread has a stream of its own, and so does a forked child */
+static int
+test_streams ()
+{
+	int failures = 0;
+	unsigned char mine[32], theirs[32];
+
+	random_bytes (mine, sizeof (mine));
+	std::thread t ([&theirs] () { random_bytes (theirs, sizeof (theirs)); });
+	t.join ();
+	failures += check (memcmp (mine, theirs, sizeof (mine)) != 0, "Two threads share a stream");
+
+	int fds[2];
+	if (check (pipe (fds) == 0, "Could not open a pipe"))
+		return failures + 1;
+
+	pid_t pid = fork ();
+	if (pid == 0)
+	{
+		random_bytes (theirs, sizeof (theirs));
+		_exit (write (fds[1], theirs, sizeof (theirs)) == sizeof (theirs)? 0 : 1);
+	}
+
+	random_bytes (mine, sizeof (mine));
+	bool got = read (fds[0], theirs, sizeof (theirs)) == sizeof (theirs);
+	waitpid (pid, NULL, 0);
+	close (fds[0]);
+	close (fds[1]);
+	failures += check (got && memcmp (mine, theirs, sizeof (mine)) != 0,
+			"A child repeats its parent");
+
+	return failures;
+} /* test_streams */
+
+/* the first bits change, whole bytes and the top of a partial one, and
+ * nothing after them */
+static int
+test_scramble ()
+{
+	int failures = 0;
+	const unsigned int cases[] = { 0, 5, 8, 20, 64 };
+
+	for (unsigned int bits : cases)
+	{
+		unsigned char orig[32], buf[32], mask[32];
+		memset (orig, 0xa5, sizeof (orig));
+		memset (mask, 0, sizeof (mask));
+
+		for (unsigned int trial = 0; trial < 64; trial++)
+		{
+			memcpy (buf, orig, sizeof (buf));
+			failures += check (scramble_bits (buf, bits) == buf, "Nothing was scrambled");
+			for (unsigned int i = 0; i < sizeof (buf); i++)
+				mask[i] |= buf[i] ^ orig[i];
+		}
+
+		/* 64 trials leave a bit unchanged with a chance of 2^-64 */
+		unsigned char expect[32];
+		memset (expect, 0, sizeof (expect));
+		memset (expect, 0xff, bits / 8);
+		if (bits % 8)
+			expect[bits / 8] = (unsigned char) (0xff << (8 - bits % 8));
+		failures += check (memcmp (mask, expect, sizeof (mask)) == 0, "Wrong bits scrambled");
+	}
+
+	failures += check (scramble_bits (NULL, 8) == NULL, "A missing buffer was scrambled");
+	return failures;
+} /* test_scramble */
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+
+	failures += test_block ();
+	failures += test_seed ();
+	failures += test_streams ();
+	failures += test_scramble ();
+
+	if (failures == 0)
+		printf ("[Log]: All random checks passed.\n");
+
+	return failures;
+} /* main */
@@ -0,0 +1,242 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  replay_test.cc
+ *
+ *    Description:  Testing the replay cache, its rotation, its bound, concurrent
+ *    				writers and the shared memory mode
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 10:58:40 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/replay.h"
+#include "test_util.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#ifndef WINDOW
+#define WINDOW 60 /* in seconds */
+#endif
+
+#ifndef NUM_THREADS
+#define NUM_THREADS 4
+#endif
+
+#ifndef NUM_RACES
+#define NUM_RACES 10000
+#endif
+
+/* remember, find again, and forget as the windows move on */
+static int
+test_rotation ()
+{
+	int failures = 0;
+	SHA256OptReplayCache *cache = create_replay_cache (1 << 16, WINDOW, NULL);
+	if (!cache)
+		return 1;
+
+	failures += check (!replay_seen (cache, 100, 42), "Empty cache saw a solution");
+	failures += check (replay_remember (cache, 100, 42) == REPLAY_FRESH, "First copy not fresh");
+	failures += check (replay_seen (cache, 100, 42), "Remembered solution not seen");
+	failures += check (replay_remember (cache, 100, 42) == REPLAY_SEEN, "Second copy accepted");
+	failures += check (!replay_seen (cache, 100, 43), "Other solution seen");
+
+	/* the next window keeps the previous one alive */
+	failures += check (replay_remember (cache, 100 + WINDOW, 7) == REPLAY_FRESH,
+			"Next window not fresh");
+	failures += check (replay_seen (cache, 100, 42), "Previous window forgotten");
+
+	/* two windows later the first one is gone, and too old to accept */
+	failures += check (replay_remember (cache, 100 + 2*WINDOW, 8) == REPLAY_FRESH,
+			"Later window not fresh");
+	failures += check (replay_seen (cache, 100, 43), "Expired window accepted");
+	failures += check (replay_remember (cache, 100, 43) == REPLAY_SEEN,
+			"Expired window remembered");
+
+	free_replay_cache (cache);
+	return failures;
+} /* test_rotation */
+
+/* the cache never grows past its bound and reuses expired slots */
+static int
+test_bound ()
+{
+	int failures = 0;
+
+	/* one bucket, all fingerprints land in it and differ in their high half */
+	SHA256OptReplayCache *cache = create_replay_cache (128, WINDOW, NULL);
+	if (!cache)
+		return 1;
+
+	size_t capacity = replay_cache_capacity (cache);
+	for (uint64_t j = 0; j < capacity; j++)
+		failures += check (replay_remember (cache, 0, (j + 1) << 33) == REPLAY_FRESH,
+				"Filling the cache failed");
+
+	failures += check (replay_remember (cache, 0, (capacity + 1) << 33) == REPLAY_FULL,
+			"Full cache took more");
+
+	/* two windows later the slots are free again */
+	failures += check (replay_remember (cache, 2*WINDOW, (capacity + 1) << 33) == REPLAY_FRESH,
+			"Expired slots not reused");
+
+	free_replay_cache (cache);
+	return failures;
+} /* test_bound */
+
+/* many threads remembering the same solutions, one of each gets in */
+static int
+test_race ()
+{
+	SHA256OptReplayCache *cache = create_replay_cache (1 << 20, WINDOW, NULL);
+	if (!cache)
+		return 1;
+
+	std::atomic<unsigned int> fresh (0);
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < NUM_THREADS; t++)
+	{
+		threads.emplace_back ([cache, &fresh] () {
+			for (uint64_t j = 0; j < NUM_RACES; j++)
+			{
+				if (replay_remember (cache, 5, j * 0x9e3779b97f4a7c15ULL) == REPLAY_FRESH)
+					fresh++;
+			}
+		});
+	}
+
+	for (std::thread &t : threads)
+		t.join ();
+
+	free_replay_cache (cache);
+	return check (fresh == NUM_RACES, "Concurrent copies accepted more than once");
+} /* test_race */
+
+/* another process attached to the same cache sees the same solutions */
+static int
+test_shared ()
+{
+	int failures = 0;
+	char name[64];
+	snprintf (name, sizeof (name), "/plutus_replay_test_%d", (int) getpid ());
+
+	SHA256OptReplayCache *cache = create_replay_cache (1 << 16, WINDOW, name);
+	if (!cache)
+		return 1;
+
+	replay_remember (cache, 100, 42);
+
+	pid_t pid = fork ();
+	if (pid == 0)
+	{ /* attach, check, and leave a solution behind */
+		SHA256OptReplayCache *other = create_replay_cache (1 << 16, WINDOW, name);
+		int rc = (other && replay_seen (other, 100, 42)
+				&& replay_remember (other, 100, 43) == REPLAY_FRESH) ? 0 : 1;
+		free_replay_cache (other);
+		_exit (rc);
+	}
+
+	int status = 1;
+	waitpid (pid, &status, 0);
+	failures += check (WIFEXITED (status) && WEXITSTATUS (status) == 0,
+			"Attached process did not share the cache");
+	failures += check (replay_remember (cache, 100, 43) == REPLAY_SEEN,
+			"Solution of the other process accepted");
+
+	/* a mismatched configuration is refused */
+	failures += check (create_replay_cache (1 << 16, WINDOW + 1, name) == NULL,
+			"Mismatched window attached");
+
+	free_replay_cache (cache);
+	unlink_replay_cache (name);
+	return failures;
+} /* test_shared */
+
+/* The layout of the header at the start of a shared cache, see replay.cc */
+typedef struct {
+	uint64_t magic;
+	uint64_t num_buckets;
+	uint64_t sipkey[2];
+	uint32_t window;
+	uint32_t newest;
+} test_header_t;
+
+/* a remember whose snapshot of the newest window is one behind keeps the
+ * slots of the window after it */
+static int
+test_snapshot ()
+{
+	int failures = 0;
+	char name[64];
+	snprintf (name, sizeof (name), "/plutus_replay_snapshot_%d", (int) getpid ());
+
+	SHA256OptReplayCache *cache = create_replay_cache (1 << 16, WINDOW, name);
+	if (!cache)
+		return 1;
+
+	int fd = shm_open (name, O_RDWR, 0600);
+	void *map = (fd < 0)? MAP_FAILED
+		: mmap (NULL, sizeof (test_header_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (fd >= 0)
+		close (fd);
+	if (check (map != MAP_FAILED, "Cannot map the shared cache"))
+	{
+		free_replay_cache (cache);
+		unlink_replay_cache (name);
+		return 1;
+	}
+
+	/* both land in bucket 0, the first one in window 6 */
+	failures += check (replay_remember (cache, 6*WINDOW, 1ULL << 33) == REPLAY_FRESH,
+			"Window 6 not fresh");
+
+	/* what a remember sees that loaded newest just before it moved on */
+	test_header_t *header = (test_header_t *) map;
+	__atomic_store_n (&header->newest, 5, __ATOMIC_RELEASE);
+	failures += check (replay_remember (cache, 5*WINDOW, 2ULL << 33) == REPLAY_FRESH,
+			"Window 5 not fresh");
+
+	failures += check (replay_seen (cache, 6*WINDOW, 1ULL << 33),
+			"A slot of a newer window was taken");
+	failures += check (replay_remember (cache, 6*WINDOW, 1ULL << 33) == REPLAY_SEEN,
+			"A solution of a newer window accepted again");
+
+	munmap (map, sizeof (test_header_t));
+	free_replay_cache (cache);
+	unlink_replay_cache (name);
+	return failures;
+} /* test_snapshot */
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+
+	failures += test_rotation ();
+	failures += test_bound ();
+	failures += test_race ();
+	failures += test_shared ();
+	failures += test_snapshot ();
+
+	if (failures)
+		printf ("[ERROR]: %d replay cache checks failed!\n", failures);
+	else
+		printf ("[Log]: All replay cache checks passed.\n");
+
+	return failures? 1 : 0;
+} /* main */
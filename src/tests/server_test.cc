@@ -20,6 +20,8 @@
 #include <client/client.h>
 #include <puzzle/crypto_util.h>
 #include <puzzle/factory.h>
+#include <puzzle/flatpuzzle.h>
+#include <puzzle/random.h>
 
 #include <time.h>
 #include <ctype.h>
@@ -41,6 +43,7 @@
 typedef struct {
 	unsigned int k;
 	unsigned int m;
+	unsigned int threads;	/* the number of solver threads, 0 for serial */
 	bool verbose;
 } arguments_t;
 
@@ -68,9 +71,6 @@ main (int argc, char **argv)
 	uint8_t k = args.k;
 	uint16_t m = args.m;
 
-	/* seed the pseudo-random number generator */
-	srand (time(NULL));
-
 	/* so we need a random set of data and a random secret key.
 	 * assume that the random key length is 128 bytes and generate
 	 * random data of size 512 bytes.
@@ -89,7 +89,16 @@ main (int argc, char **argv)
 			timestamp, k, m);
 
 	/* attempt puzzle solution */
-	SHA256Solution *sol = solvePuzzle (challenge);
+	SHA256Solution *sol;
+	if (args.threads > 0)
+	{ /* solve on a pool of workers */
+		SolverPool *pool = create_solver_pool (args.threads, 0);
+		sol = solvePuzzleParallel (challenge, pool);
+		free_solver_pool (pool);
+	} else
+	{
+		sol = solvePuzzle (challenge);
+	}
 
 	/* verify the solution */
 	bool v = verify_solution (sol, data, DATA_LEN, key, KEY_LEN, k);
@@ -98,6 +107,29 @@ main (int argc, char **argv)
 		printf ("[ERROR]: Solution verification failed!\n");
 	}
 
+	/* a wrong last subsolution, past a batch of lanes, is caught */
+	SHA256SubSolution *last = sol? sol->solution : NULL;
+	while (last && last->next)
+		last = last->next;
+	if (last)
+	{
+		last->solution[0] ^= 1;
+		if (verify_solution (sol, data, DATA_LEN, key, KEY_LEN, k))
+			printf ("[ERROR]: A wrong subsolution was verified!\n");
+		last->solution[0] ^= 1;
+	}
+
+	/* the solution must survive a trip through the flat layout */
+	SHA256FlatSolution *flat = flatten_solution (sol, k);
+	SHA256Solution *rebuilt = unflatten_solution (flat);
+	if (!verify_solution (rebuilt, data, DATA_LEN, key, KEY_LEN, k))
+	{
+		printf ("[ERROR]: Flattened solution verification failed!\n");
+	}
+	free_solution_mem (rebuilt);
+	free (rebuilt);
+	free_flatsolution (flat);
+
 	/* free things */
 	free_challenge_mem (challenge);
 	free_solution_mem (sol);
@@ -115,10 +147,7 @@ create_random_bytes (unsigned char *buf, unsigned int buf_len)
 	if (! buf)
 		return; /* nothing to do */
 	
-	for (unsigned int i=0;i<buf_len;i++)
-	{
-		buf[i] = (unsigned char) rand()%255;
-	}
+	random_bytes (buf, buf_len);
 } /* create_random_bytes */
 
 
@@ -128,8 +157,9 @@ read_cmd_args (int argc, char **argv, arguments_t *args)
 	int c;
 	int k = -1;
 	int m = -1;
+	args->threads = 0; /* default value */
 
-	while ( (c = getopt (argc, argv, "k:m:hv")) != -1)
+	while ( (c = getopt (argc, argv, "k:m:t:hv")) != -1)
 	{
 		switch (c)
 		{
@@ -139,14 +169,17 @@ read_cmd_args (int argc, char **argv, arguments_t *args)
 			case 'm':
 				m = atoi(optarg);
 				break;
+			case 't':
+				args->threads = atoi(optarg);
+				break;
 			case 'v':
 				args->verbose = true;
 				break;
 			case 'h':
-				printf ("Usage: %s -k num_subpuzzle -m bits_difficulty [-vh?]\n", argv[0]);
+				printf ("Usage: %s -k num_subpuzzle -m bits_difficulty [-t threads] [-vh?]\n", argv[0]);
 				return -1;
 			case '?':
-				if (optopt == 'k' || optopt == 'm')
+				if (optopt == 'k' || optopt == 'm' || optopt == 't')
 					printf ("[ERROR]: Option -%c requires an argument.\n", optopt);
 				else if (isprint (optopt))
 					printf ("[ERROR]: Unknow option `-%c'.\n", optopt);
@@ -168,7 +201,7 @@ read_cmd_args (int argc, char **argv, arguments_t *args)
 	/* check that both k and m are set */
 	if (k == -1 || m == -1)
 	{
-		printf ("[ERROR]: Usage: %s -k num_subpuzzle -m bits_difficulty [-vh?]\n", 
+		printf ("[ERROR]: Usage: %s -k num_subpuzzle -m bits_difficulty [-t threads] [-vh?]\n", 
 				argv[0]);
 		return -1;
 	}
@@ -0,0 +1,197 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  sha256_test.cc
+ *
+ *    Description:  Checking the low level SHA256 routines against OpenSSL
+ *
+ *        Version:  1.0
+ *        Created:  10/17/2026 10:02:11 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/sha256.h"
+#include "puzzle/sha256_mb.h"
+#include "puzzle/crypto_util.h"
+#include "puzzle/random.h"
+
+#include <string.h>
+
+#ifndef MAX_MSG_LEN
+#define MAX_MSG_LEN 300 /* in bytes */
+#endif
+
+/* create random set of bytes */
+static void create_random_bytes (unsigned char *buf,
+		unsigned int buf_len);
+
+/* compare a digest against the one computed by OpenSSL */
+static int
+check_digest (const char *what, unsigned char *msg, size_t len,
+		unsigned char *digest)
+{
+	unsigned int ref_len;
+	unsigned char *ref = digest_message (msg, len, &ref_len);
+
+	int err = (ref == NULL || memcmp (ref, digest, SHA256_DIGEST_LEN) != 0);
+	if (err)
+		printf ("[ERROR]: %s mismatch for a message of %lu bytes!\n",
+				what, (unsigned long) len);
+
+	OPENSSL_free (ref);
+	return err;
+} /* check_digest */
+
+/* check the single buffer routines on prefixes of msg */
+static int
+check_single_buffer (unsigned char *msg)
+{
+	unsigned char digest[SHA256_DIGEST_LEN];
+	int failures = 0;
+
+	for (size_t len = 0; len <= MAX_MSG_LEN; len++)
+	{ /* one shot digests of every length */
+		sha256_digest (msg, len, digest);
+		failures += check_digest ("sha256_digest", msg, len, digest);
+
+		/* streaming in uneven chunks */
+		SHA256Ctx ctx;
+		sha256_init (&ctx);
+		for (size_t off = 0; off < len; off += 7)
+			sha256_update (&ctx, msg + off, (len - off < 7)? len - off : 7);
+		sha256_final (&ctx, digest);
+		failures += check_digest ("sha256_update", msg, len, digest);
+	}
+
+	for (size_t plen = 0; plen <= 140; plen++)
+	{ /* midstates for a range of prefix and tail lengths */
+		for (size_t tlen = 0; tlen <= 64 && plen + tlen <= MAX_MSG_LEN; tlen++)
+		{
+			SHA256Midstate ms;
+			if (sha256_midstate_init (&ms, msg, plen, tlen) != 0)
+				continue; /* does not fit, nothing to check */
+
+			memcpy (sha256_midstate_tail (&ms), msg + plen, tlen);
+			sha256_midstate_digest (&ms, digest);
+			failures += check_digest ("sha256_midstate", msg, plen + tlen, digest);
+
+			/* the same prefix absorbed in two pieces */
+			SHA256Ctx ctx;
+			sha256_init (&ctx);
+			sha256_update (&ctx, msg, plen/3);
+			sha256_update (&ctx, msg + plen/3, plen - plen/3);
+			if (sha256_midstate_from_ctx (&ms, &ctx, tlen) != 0)
+			{
+				failures++;
+				continue;
+			}
+
+			memcpy (sha256_midstate_tail (&ms), msg + plen, tlen);
+			sha256_midstate_digest (&ms, digest);
+			failures += check_digest ("sha256_midstate_from_ctx", msg, plen + tlen, digest);
+		}
+	}
+
+	return failures;
+} /* check_single_buffer */
+
+int
+main (int argc, char **argv)
+{
+	unsigned char msg[MAX_MSG_LEN];
+	int failures = 0;
+
+	random_seed (1);
+	create_random_bytes (msg, MAX_MSG_LEN);
+
+	/* OpenSSL EVP is the reference for everything below */
+	set_hash_backend (HASH_BACKEND_EVP);
+
+	for (int shani = 0; shani <= 1; shani++)
+	{ /* with the portable and the SHA-NI compression functions */
+		if (sha256_set_shani (shani) != 0)
+		{
+			printf ("[Log]: Skipping the SHA-NI compression function.\n");
+			continue;
+		}
+
+		failures += check_single_buffer (msg);
+	}
+
+	if (set_hash_backend (HASH_BACKEND_SHANI) == 0)
+	{ /* digest_message without EVP */
+		for (size_t len = 0; len <= MAX_MSG_LEN; len += 17)
+		{
+			unsigned int dlen;
+			unsigned char *d = digest_message (msg, len, &dlen);
+
+			set_hash_backend (HASH_BACKEND_EVP);
+			failures += check_digest (hash_backend_name (HASH_BACKEND_SHANI),
+					msg, len, d);
+			set_hash_backend (HASH_BACKEND_SHANI);
+
+			OPENSSL_free (d);
+		}
+		set_hash_backend (HASH_BACKEND_EVP);
+	}
+
+	for (int b = SHA256_MB_SCALAR; b <= SHA256_MB_AVX512; b++)
+	{ /* every multi-buffer backend the CPU supports */
+		sha256_mb_backend_t backend = (sha256_mb_backend_t) b;
+		if (sha256_mb_set_backend (backend) != 0)
+		{
+			printf ("[Log]: Skipping the %s backend.\n", sha256_mb_backend_name (backend));
+			continue;
+		}
+
+		for (size_t plen = 0; plen <= 130; plen += 13)
+		{
+			for (size_t tlen = 1; tlen <= 40; tlen += 3)
+			{
+				SHA256Midstate ms;
+				if (sha256_midstate_init (&ms, msg, plen, tlen) != 0)
+					continue; /* does not fit, nothing to check */
+
+				/* n tails cut from the random bytes, with ragged batch sizes */
+				unsigned int n = 1 + (plen + tlen) % (2 * SHA256_MB_MAX_LANES + 3);
+				unsigned char tails[(2 * SHA256_MB_MAX_LANES + 3) * 40];
+				unsigned char digests[(2 * SHA256_MB_MAX_LANES + 3) * SHA256_DIGEST_LEN];
+				for (unsigned int j = 0; j < n; j++)
+					create_random_bytes (tails + j*tlen, tlen);
+
+				sha256_mb_digest (&ms, tails, n, digests);
+
+				for (unsigned int j = 0; j < n; j++)
+				{
+					unsigned char full[MAX_MSG_LEN];
+					memcpy (full, msg, plen);
+					memcpy (full + plen, tails + j*tlen, tlen);
+					failures += check_digest (sha256_mb_backend_name (backend),
+							full, plen + tlen, digests + j*SHA256_DIGEST_LEN);
+				}
+			}
+		}
+	}
+
+	if (failures)
+		printf ("[ERROR]: %d SHA256 checks failed!\n", failures);
+	else
+		printf ("[Log]: All SHA256 checks passed.\n");
+
+	return failures? 1 : 0;
+} /* main */
+
+void
+create_random_bytes (unsigned char *buf, unsigned int buf_len)
+{
+	if (! buf)
+		return; /* nothing to do */
+
+	random_bytes (buf, buf_len);
+} /* create_random_bytes */
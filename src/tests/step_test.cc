@@ -0,0 +1,213 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  step_test.cc
+ *
+ *    Description:  Tests of the step solvers, challenges of both schemes are
+ *    				solved in small steps, cancelled and left to expire
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 08:31:50 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "client/client.h"
+#include "client/optclient.h"
+#include "server/server.h"
+#include "server/optserver.h"
+#include "test_util.h"
+
+#include <openssl/crypto.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef KEY_LEN
+#define KEY_LEN 32 /* in bytes */
+#endif
+
+#ifndef DATA_LEN
+#define DATA_LEN 18 /* in bytes */
+#endif
+
+static unsigned char key[KEY_LEN];
+static unsigned char data[DATA_LEN];
+
+/* free a challenge of the optimized scheme */
+static void
+free_optchallenge (SHA256OptChallenge *challenge)
+{
+	OPENSSL_free (challenge->preimage);
+	free (challenge);
+} /* free_optchallenge */
+
+/* a challenge solved a hundred candidates at a time matches the blocking
+ * solver and verifies */
+static int
+test_small_steps (const SHA256OptMinter *minter)
+{
+	int failures = 0;
+	SHA256OptChallenge *challenge = mint_challenge (minter, data, DATA_LEN, 7);
+
+	StepSolver *solver = solveChallengeStart (challenge, 0);
+	if (check (solver != NULL, "Could not start a step solver"))
+		return 1;
+
+	unsigned int steps = 0;
+	uint64_t last = 0;
+	bool forward = true;
+	StepProgress progress;
+	while (step_solver_run (solver, 100, 0) == STEP_RUNNING)
+	{ /* the position carries over, every step hashes its full budget */
+		step_solver_progress (solver, &progress);
+		forward = forward && progress.tried == last + 100;
+		last = progress.tried;
+		steps++;
+	}
+
+	step_solver_progress (solver, &progress);
+	failures += check (step_solver_status (solver) == STEP_SOLVED, "The steps did not solve it");
+	failures += check (forward, "A step lost its position");
+	failures += check (steps > 1 && progress.solved == progress.total
+			&& progress.expected_left == 0 && progress.eta_us == 0,
+			"Wrong progress of a solved challenge");
+
+	SHA256OptSolution *stepped = solveChallengeFinish (solver);
+	SHA256OptSolution *blocking = solveChallenge (challenge);
+	failures += check (stepped && minter_verify (minter, stepped, data, DATA_LEN, NULL) == VERIFY_OK,
+			"The stepped solution was rejected");
+
+	/* both walk the candidates in the same order */
+	bool same = stepped && blocking && stepped->timestamp == blocking->timestamp;
+	for (SHA256OptSubSolution *a = same ? stepped->head : NULL, *b = blocking->head;
+			a && b; a = a->next, b = b->next)
+		same = same && memcmp (a->zi, b->zi, challenge->len/2) == 0;
+	failures += check (same, "The stepped solution differs from the blocking one");
+
+	free_solution_mem (stepped);
+	free_solution_mem (blocking);
+	free_optchallenge (challenge);
+
+	return failures;
+} /* test_small_steps */
+
+/* a time budget is kept, and the rate and ETA are known after a step */
+static int
+test_time_budget (const SHA256OptMinter *minter)
+{
+	int failures = 0;
+	SHA256OptChallenge *challenge = mint_challenge (minter, data, DATA_LEN, 8);
+	challenge->difficulty = 40;
+
+	StepSolver *solver = solveChallengeStart (challenge, 0);
+	free_optchallenge (challenge);
+	if (check (solver != NULL, "Could not start a step solver"))
+		return 1;
+
+	StepProgress progress;
+	step_solver_progress (solver, &progress);
+	failures += check (progress.eta_us == UINT64_MAX, "An ETA was given before any step");
+
+	failures += check (step_solver_run (solver, 0, 2000) == STEP_RUNNING,
+			"A time slice did not leave the search running");
+	step_solver_progress (solver, &progress);
+	failures += check (progress.busy_us >= 2000 && progress.busy_us < 50000,
+			"A time slice was not kept");
+	failures += check (progress.tried > 0 && progress.hashes_per_sec > 0
+			&& progress.eta_us > progress.busy_us && progress.eta_us != UINT64_MAX,
+			"Wrong rate or ETA");
+
+	/* cancel between steps, nothing comes out */
+	step_solver_cancel (solver);
+	failures += check (step_solver_run (solver, 0, 0) == STEP_CANCELLED,
+			"A cancelled search kept running");
+	failures += check (solveChallengeFinish (solver) == NULL, "A cancelled search was solved");
+
+	return failures;
+} /* test_time_budget */
+
+/* a search past its deadline expires */
+static int
+test_deadline (const SHA256OptMinter *minter)
+{
+	int failures = 0;
+	SHA256OptChallenge *challenge = mint_challenge (minter, data, DATA_LEN, 9);
+	challenge->difficulty = 40;
+
+	StepSolver *solver = solveChallengeStart (challenge, 1);
+	free_optchallenge (challenge);
+	if (check (solver != NULL, "Could not start a step solver"))
+		return 1;
+
+	/* without a budget, only the deadline stops it */
+	failures += check (step_solver_run (solver, 0, 0) == STEP_EXPIRED,
+			"The search did not expire");
+	failures += check (step_solver_run (solver, 1000, 0) == STEP_EXPIRED,
+			"An expired search was resumed");
+	failures += check (step_solver_winners (solver) == NULL, "An expired search has winners");
+	free_step_solver (solver);
+
+	return failures;
+} /* test_deadline */
+
+/* a naive puzzle solved in steps verifies */
+static int
+test_naive ()
+{
+	int failures = 0;
+	SHA256Challenge *challenge = generate_puzzle (data, DATA_LEN, key, KEY_LEN, 10, 3, 10);
+
+	StepSolver *solver = solvePuzzleStart (challenge, 0);
+	if (check (solver != NULL, "Could not start a naive step solver"))
+		return 1;
+
+	/* the challenge is copied, it can go before the search ends */
+	free_challenge_mem (challenge);
+	free (challenge);
+
+	while (step_solver_run (solver, 64, 0) == STEP_RUNNING)
+		;
+
+	SHA256Solution *sol = solvePuzzleFinish (solver);
+	failures += check (sol && verify_solution (sol, data, DATA_LEN, key, KEY_LEN, 3),
+			"The stepped naive solution was rejected");
+
+	free_solution_mem (sol);
+	free (sol);
+
+	return failures;
+} /* test_naive */
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+
+	for (unsigned int i = 0; i < KEY_LEN; i++)
+		key[i] = (unsigned char) (i * 13 + 5);
+	for (unsigned int i = 0; i < DATA_LEN; i++)
+		data[i] = (unsigned char) (i * 7 + 1);
+
+	SHA256OptMinter minter;
+	if (check (init_minter (&minter, key, KEY_LEN, 0, 4, 10, 128) == 0,
+				"Could not create a minter"))
+		return 1;
+
+	failures += test_small_steps (&minter);
+	failures += test_time_budget (&minter);
+	failures += test_deadline (&minter);
+	failures += test_naive ();
+
+	clear_minter (&minter);
+
+	if (failures == 0)
+		printf ("[Log]: All step solver checks passed.\n");
+
+	return failures;
+} /* main */
@@ -0,0 +1,43 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  test_util.h
+ *
+ *    Description:  The helpers shared by all the tests
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 03:12:40 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __TEST_UTIL_H
+#define __TEST_UTIL_H
+
+#include <stdio.h>
+
+/* report a failed check
+ *
+ * arguments are:
+ *
+ *  ok				-- Whether the check passed
+ *  what			-- What went wrong otherwise
+ *
+ * returns 0 if the check passed, 1 otherwise
+ */
+static inline int
+check (bool ok, const char *what)
+{
+	if (ok)
+		return 0;
+
+	printf ("[ERROR]: %s!\n", what);
+	return 1;
+} /* check */
+
+#endif /* test_util.h */
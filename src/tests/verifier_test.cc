@@ -0,0 +1,276 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  verifier_test.cc
+ *
+ *    Description:  Tests of the asynchronous verification service, from many
+ *    				submitters, through callbacks and completion queues
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 10:02:37 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "server/verifier.h"
+#include "client/optclient.h"
+#include "puzzle/wire.h"
+#include "test_util.h"
+#include "verifier_util.h"
+
+#include <openssl/crypto.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifndef KEY_LEN
+#define KEY_LEN 32 /* in bytes */
+#endif
+
+#define NUM_PACKETS 	4		/* The distinct solutions, the last one corrupted */
+#define NUM_SUBMITTERS 	4
+#define NUM_REQUESTS 	2000	/* Per submitter */
+
+static unsigned char key[KEY_LEN];
+static unsigned char datas[NUM_PACKETS][4];
+static unsigned char pkts[NUM_PACKETS][WIRE_HEADER_LEN + 4 * 8];
+static size_t pkt_len;
+
+/* solve a challenge for every data and keep the solution packets */
+static int
+build_packets (const SHA256OptMinter *minter)
+{
+	for (unsigned int i = 0; i < NUM_PACKETS; i++)
+	{
+		memset (datas[i], 'a' + i, sizeof (datas[i]));
+
+		SHA256OptChallenge *challenge = mint_challenge (minter, datas[i], sizeof (datas[i]), 1);
+		SHA256OptSolution *sol = solveChallenge (challenge);
+		pkt_len = encode_solution (sol, minter->l, minter->k, pkts[i], sizeof (pkts[i]));
+		OPENSSL_free (challenge->preimage);
+		free (challenge);
+		free_solution_mem (sol);
+
+		if (pkt_len != sizeof (pkts[i]))
+			return -1;
+	}
+
+	pkts[NUM_PACKETS - 1][pkt_len - 1] ^= 1;
+	return 0;
+} /* build_packets */
+
+/* the request of the j-th packet */
+static void
+packet_request (VerifyRequest *req, unsigned int j)
+{
+	fill_request (req, pkts[j % NUM_PACKETS], pkt_len,
+			datas[j % NUM_PACKETS], sizeof (datas[0]), j);
+} /* packet_request */
+
+static std::atomic<unsigned int> done_ok;
+static std::atomic<unsigned int> done_bad;
+
+/* count the verdicts of the callbacks */
+static void
+count_done (VerifyRequest *req)
+{
+	uintptr_t j = (uintptr_t) req->user;
+	bool expect = (j % NUM_PACKETS) != NUM_PACKETS - 1;
+
+	if ((req->status == VERIFY_OK) == expect)
+		done_ok.fetch_add (1);
+	else
+		done_bad.fetch_add (1);
+} /* count_done */
+
+/* many submitters at once, every verdict comes back through its callback */
+static int
+test_callbacks (const SHA256OptMinter *minter)
+{
+	int failures = 0;
+	done_ok = 0;
+	done_bad = 0;
+
+	VerifierConfig config;
+	verifier_default_config (&config);
+	config.minter = minter;
+	config.max_age = 0;
+	config.nthreads = 2;
+	config.capacity = NUM_SUBMITTERS * NUM_REQUESTS;
+
+	PlutusVerifier *v = create_verifier (&config);
+	if (check (v != NULL && verifier_size (v) == 2, "Could not start the verifier"))
+		return 1;
+
+	std::vector<VerifyRequest> reqs (NUM_SUBMITTERS * NUM_REQUESTS);
+	std::atomic<unsigned int> refused (0);
+	std::vector<std::thread> submitters;
+	for (unsigned int t = 0; t < NUM_SUBMITTERS; t++)
+		submitters.push_back (std::thread ([&reqs, &refused, v, t] () {
+					for (unsigned int r = 0; r < NUM_REQUESTS; r++)
+					{
+						VerifyRequest *req = &reqs[t * NUM_REQUESTS + r];
+						packet_request (req, t * NUM_REQUESTS + r);
+						req->done = count_done;
+						if (verifier_submit (v, req) != 0)
+							refused.fetch_add (1);
+					}
+				}));
+	for (std::thread &t : submitters)
+		t.join ();
+
+	/* freeing drains the queue first */
+	free_verifier (v);
+
+	failures += check (refused == 0, "Requests were refused below capacity");
+	failures += check (done_ok == NUM_SUBMITTERS * NUM_REQUESTS && done_bad == 0,
+			"Wrong or missing verdicts");
+
+	return failures;
+} /* test_callbacks */
+
+/* the verdicts come back through a completion queue and its eventfd */
+static int
+test_queue (const SHA256OptMinter *minter)
+{
+	int failures = 0;
+
+	VerifierConfig config;
+	verifier_default_config (&config);
+	config.minter = minter;
+	config.max_age = 0;
+	config.nthreads = 1;
+	config.capacity = 64;
+
+	PlutusVerifier *v = create_verifier (&config);
+	VerifierQueue *cq = create_verifier_queue (64);
+	if (check (v != NULL && cq != NULL, "Could not start the verifier"))
+		return 1;
+
+	VerifyRequest reqs[64];
+	for (unsigned int j = 0; j < 64; j++)
+	{
+		packet_request (&reqs[j], j);
+		reqs[j].cq = cq;
+		failures += check (verifier_submit (v, &reqs[j]) == 0, "A request was refused");
+	}
+
+	/* the way an event loop waits, a few at a time */
+	unsigned int got = 0, right = 0;
+	struct pollfd p = { verifier_queue_fd (cq), POLLIN, 0 };
+	while (got < 64 && poll (&p, 1, 2000) == 1)
+	{
+		VerifyRequest *done[8];
+		unsigned int n = verifier_queue_poll (cq, done, 8);
+		for (unsigned int i = 0; i < n; i++)
+		{
+			uintptr_t j = (uintptr_t) done[i]->user;
+			bool expect = (j % NUM_PACKETS) != NUM_PACKETS - 1;
+			right += (done[i] == &reqs[j] && (done[i]->status == VERIFY_OK) == expect);
+		}
+		got += n;
+	}
+
+	failures += check (got == 64 && right == 64, "Wrong or missing completions");
+
+	VerifierStats stats;
+	verifier_stats (v, &stats);
+	failures += check (stats.submitted == 64 && stats.completed == 64 && stats.depth == 0
+			&& stats.verified == 48 && stats.batches > 0 && stats.batches <= 64,
+			"Wrong counters");
+
+	free_verifier (v);
+	free_verifier_queue (cq);
+
+	return failures;
+} /* test_queue */
+
+/* a busy service refuses what it has no room for, and says how deep it is */
+static int
+test_capacity (const SHA256OptMinter *minter)
+{
+	int failures = 0;
+
+	VerifierConfig config;
+	verifier_default_config (&config);
+	config.minter = minter;
+	config.max_age = 0;
+	config.nthreads = 1;
+	config.capacity = 4;
+
+	PlutusVerifier *v = create_verifier (&config);
+	if (check (v != NULL, "Could not start the verifier"))
+		return 1;
+
+	/* the first request keeps the only worker busy in its callback */
+	held = true;
+	VerifyRequest reqs[6];
+	for (unsigned int j = 0; j < 6; j++)
+	{
+		packet_request (&reqs[j], j);
+		reqs[j].done = hold_done;
+	}
+
+	verifier_submit (v, &reqs[0]);
+	while (verifier_depth (v) != 0)
+		usleep (100);
+
+	for (unsigned int j = 1; j < 5; j++)
+		failures += check (verifier_submit (v, &reqs[j]) == 0, "A request was refused");
+	failures += check (verifier_depth (v) == 4, "Wrong depth");
+	failures += check (verifier_submit (v, &reqs[5]) != 0, "A full service took a request");
+
+	VerifyRequest bad;
+	packet_request (&bad, 0);
+	failures += check (verifier_submit (v, &bad) != 0, "A request with no way back was taken");
+
+	held = false;
+	free_verifier (v);
+
+	VerifierStats stats;
+	verifier_stats (NULL, &stats);
+	failures += check (stats.submitted == 0, "A missing service has counters");
+
+	/* a node that does not exist */
+	config.numa_node = 1 << 20;
+	failures += check (create_verifier (&config) == NULL, "A verifier ran on a missing node");
+
+	return failures;
+} /* test_capacity */
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+
+	for (unsigned int i = 0; i < KEY_LEN; i++)
+		key[i] = (unsigned char) (i * 11 + 3);
+
+	SHA256OptMinter minter;
+	if (init_minter (&minter, key, KEY_LEN, 0, 4, 8, 128) != 0 || build_packets (&minter) != 0)
+	{
+		printf ("[ERROR]: Could not build the solutions!\n");
+		return 1;
+	}
+
+	failures += test_callbacks (&minter);
+	failures += test_queue (&minter);
+	failures += test_capacity (&minter);
+
+	clear_minter (&minter);
+
+	if (failures == 0)
+		printf ("[Log]: All verifier checks passed.\n");
+
+	return failures;
+} /* main */
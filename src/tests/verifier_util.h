@@ -0,0 +1,81 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  verifier_util.h
+ *
+ *    Description:  The helpers of the tests that hand requests to a
+ *    				verifier
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 03:14:02 PM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#ifndef __VERIFIER_UTIL_H
+#define __VERIFIER_UTIL_H
+
+#include "server/verifier.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+
+/* fill a request for a verifier, numbered by user
+ *
+ * arguments are:
+ *
+ *  req				-- The request to fill
+ *  pkt				-- The solution packet
+ *  pkt_len			-- The length of the packet in bytes
+ *  data			-- The data of the connection
+ *  data_len		-- The length of the data in bytes
+ *  j				-- The number of the request, kept in user
+ *  priority		-- The admission level of the client
+ *  deadline		-- When the request is due, 0 for none
+ */
+static inline void
+fill_request (VerifyRequest *req, const unsigned char *pkt, size_t pkt_len,
+		const unsigned char *data, unsigned int data_len, unsigned int j,
+		unsigned int priority = 0, uint64_t deadline = 0)
+{
+	memset (req, 0, sizeof (*req));
+	req->pkt = pkt;
+	req->pkt_len = pkt_len;
+	req->data = data;
+	req->data_len = data_len;
+	req->user = (void *) (uintptr_t) j;
+	req->priority = priority;
+	req->deadline = deadline;
+	req->status = VERIFY_EMPTY;
+} /* fill_request */
+
+/* While set, hold_done keeps a verifier's worker in its callback */
+inline std::atomic<bool> held (false);
+
+/* The verdicts hold_done saw */
+inline std::atomic<unsigned int> held_ok (0);
+inline std::atomic<unsigned int> held_shed (0);
+
+/* count the verdict and hold the worker until released. A shed request
+ * is not held, it is called back from the submitting thread. */
+static inline void
+hold_done (VerifyRequest *req)
+{
+	if (req->status == VERIFY_SHED)
+		held_shed.fetch_add (1);
+	else if (req->status == VERIFY_OK)
+		held_ok.fetch_add (1);
+
+	while (held.load () && req->status != VERIFY_SHED)
+		usleep (100);
+} /* hold_done */
+
+#endif /* verifier_util.h */
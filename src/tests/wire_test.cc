@@ -0,0 +1,302 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  wire_test.cc
+ *
+ *    Description:  Testing the binary encoding of the challenges and solutions,
+ *    				and the verification of packets in place
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026 01:52:14 AM
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Mohammad Noureddine (nouredd2), nouredd2@illinois.edu
+ *   Organization:  University of Illinois at Urbana-Champaign
+ *
+ * =====================================================================================
+ */
+
+#include "puzzle/wire.h"
+#include "puzzle/factory.h"
+#include "puzzle/crypto_util.h"
+#include "server/server.h"
+#include "server/optserver.h"
+#include "client/client.h"
+#include "client/optclient.h"
+#include "test_util.h"
+
+#include <string.h>
+#include <vector>
+
+#ifndef KEY_LEN
+#define KEY_LEN 128 /* in bytes */
+#endif
+
+#ifndef DATA_LEN
+#define DATA_LEN 256 /* in bytes */
+#endif
+
+#ifndef NUM_SUBPUZZLES
+#define NUM_SUBPUZZLES 4
+#endif
+
+#ifndef DIFFICULTY
+#define DIFFICULTY 8 /* in bits */
+#endif
+
+#ifndef PREFIX_LEN
+#define PREFIX_LEN 128 /* l, in bits */
+#endif
+
+/* encode into a vector of the right size */
+template <typename F>
+static std::vector<unsigned char>
+encode (F encoder)
+{
+	std::vector<unsigned char> pkt (encoder (NULL, 0));
+	if (!pkt.empty ())
+		encoder (pkt.data (), pkt.size ());
+
+	return pkt;
+} /* encode */
+
+/* the naive scheme, a challenge and its solution through the wire */
+static int
+test_naive (unsigned char *key, unsigned char *data)
+{
+	int failures = 0;
+	SHA256Challenge *challenge = generate_puzzle (data, DATA_LEN, key, KEY_LEN,
+			7, NUM_SUBPUZZLES, DIFFICULTY);
+
+	std::vector<unsigned char> cpkt = encode ([challenge] (unsigned char *b, size_t n) {
+			return encode_challenge (challenge, b, n); });
+
+	WirePacket wire;
+	failures += check (wire_parse (cpkt.data (), cpkt.size (), &wire) == WIRE_OK,
+			"Challenge packet rejected");
+	SHA256Challenge *decoded = decode_challenge (&wire);
+	failures += check (decoded && decoded->timestamp == 7
+			&& decoded->num_subpuzzles == NUM_SUBPUZZLES
+			&& decoded->difficulty == DIFFICULTY
+			&& memcmp (decoded->puzzle->image, challenge->puzzle->image, SHA256_DIGEST_LEN) == 0,
+			"Decoded challenge differs");
+
+	/* the client solves what it decoded */
+	SHA256Solution *sol = solvePuzzle (decoded);
+	std::vector<unsigned char> spkt = encode ([sol] (unsigned char *b, size_t n) {
+			return encode_solution (sol, NUM_SUBPUZZLES, b, n); });
+
+	failures += check (verify_solution_packet (spkt.data (), spkt.size (),
+				data, DATA_LEN, key, KEY_LEN, NUM_SUBPUZZLES), "Solution packet not verified");
+
+	failures += check (wire_parse (spkt.data (), spkt.size (), &wire) == WIRE_OK,
+			"Solution packet rejected");
+	SHA256Solution *back = decode_solution (&wire);
+	failures += check (verify_solution (back, data, DATA_LEN, key, KEY_LEN, NUM_SUBPUZZLES),
+			"Decoded solution not verified");
+
+	/* a flipped bit fails, a wrong number of sub solutions too */
+	spkt[WIRE_HEADER_LEN] ^= 1;
+	failures += check (!verify_solution_packet (spkt.data (), spkt.size (),
+				data, DATA_LEN, key, KEY_LEN, NUM_SUBPUZZLES), "Corrupted solution verified");
+	failures += check (!verify_solution_packet (spkt.data (), spkt.size (),
+				data, DATA_LEN, key, KEY_LEN, NUM_SUBPUZZLES + 1), "Short solution verified");
+
+	free_challenge_mem (challenge);
+	free_challenge_mem (decoded);
+	free_solution_mem (sol);
+	free_solution_mem (back);
+	free (challenge);
+	free (decoded);
+	free (sol);
+	free (back);
+
+	return failures;
+} /* test_naive */
+
+/* the optimized scheme, a challenge and its solution through the wire */
+static int
+test_opt (unsigned char *key, unsigned char *data)
+{
+	int failures = 0;
+	SHA256OptMinter minter;
+	init_minter (&minter, key, KEY_LEN, 0, NUM_SUBPUZZLES, DIFFICULTY, PREFIX_LEN);
+
+	SHA256OptChallenge *challenge = mint_challenge (&minter, data, DATA_LEN, 7);
+	std::vector<unsigned char> cpkt = encode ([challenge] (unsigned char *b, size_t n) {
+			return encode_challenge (challenge, b, n); });
+
+	WirePacket wire;
+	failures += check (wire_parse (cpkt.data (), cpkt.size (), &wire) == WIRE_OK,
+			"Opt challenge packet rejected");
+	uint32_t timestamp = 0;
+	failures += check (wire_peek_timestamp (cpkt.data (), cpkt.size (), &timestamp) == 0
+			&& timestamp == 7, "Wrong timestamp peeked");
+	failures += check (wire_peek_timestamp (cpkt.data (), WIRE_HEADER_LEN - 1, &timestamp) != 0,
+			"A timestamp peeked out of a short packet");
+	SHA256OptChallenge *decoded = decode_optchallenge (&wire);
+	failures += check (decoded && decoded->timestamp == 7 && decoded->len == challenge->len
+			&& decoded->num_subpuzzles == NUM_SUBPUZZLES
+			&& memcmp (decoded->preimage, challenge->preimage, challenge->len/2) == 0,
+			"Decoded opt challenge differs");
+
+	SHA256OptSolution *sol = solveChallenge (decoded);
+	std::vector<unsigned char> spkt = encode ([sol] (unsigned char *b, size_t n) {
+			return encode_solution (sol, PREFIX_LEN, NUM_SUBPUZZLES, b, n); });
+
+	failures += check (verify_solution_packet (spkt.data (), spkt.size (), data, DATA_LEN,
+				key, KEY_LEN, PREFIX_LEN, NUM_SUBPUZZLES, DIFFICULTY, NULL) == VERIFY_OK,
+			"Opt solution packet not verified");
+
+	failures += check (wire_parse (spkt.data (), spkt.size (), &wire) == WIRE_OK,
+			"Opt solution packet rejected");
+	SHA256OptSolution *back = decode_optsolution (&wire);
+	failures += check (minter_verify (&minter, back, data, DATA_LEN, NULL) == VERIFY_OK,
+			"Decoded opt solution not verified");
+
+	/* the packet and the list share their fingerprint */
+	SHA256OptVerifyParams params = { 7, 0, create_replay_cache (1 << 16, 60, NULL) };
+	failures += check (minter_verify_packet (&minter, spkt.data (), spkt.size (),
+				data, DATA_LEN, &params) == VERIFY_OK, "Opt solution packet not accepted");
+	failures += check (minter_verify (&minter, back, data, DATA_LEN, &params) == VERIFY_REPLAY,
+			"Replay of a packet accepted");
+	free_replay_cache (params.replay);
+
+	/* a batch of packets, verified where they lie */
+	{
+		std::vector<unsigned char> bad = spkt;
+		bad[WIRE_HEADER_LEN] ^= 1;
+
+		SHA256OptVerifyParams batch_params = { 7, 0, create_replay_cache (1 << 16, 60, NULL) };
+		SHA256OptPacketItem items[4] = {
+			{ spkt.data (), spkt.size (), data, DATA_LEN },
+			{ bad.data (), bad.size (), data, DATA_LEN },
+			{ spkt.data (), spkt.size () - 1, data, DATA_LEN },
+			{ spkt.data (), spkt.size (), data, DATA_LEN } };
+		verify_status_t statuses[4];
+		failures += check (minter_verify_packets (&minter, items, 4, &batch_params, statuses) == 1
+				&& statuses[0] == VERIFY_OK && statuses[1] == VERIFY_FAILED
+				&& statuses[2] == VERIFY_MALFORMED && statuses[3] == VERIFY_REPLAY,
+				"Packet batch outcomes differ");
+		free_replay_cache (batch_params.replay);
+
+		/* minting into packets gives the same challenge as mint_challenge */
+		unsigned char minted[64];
+		SHA256OptPacketItem mint = { minted, sizeof (minted), data, DATA_LEN };
+		failures += check (minter_mint_packets (&minter, &mint, 1, 7) == 1
+				&& mint.pkt_len == cpkt.size ()
+				&& memcmp (minted, cpkt.data (), cpkt.size ()) == 0,
+				"Minted packet differs");
+	}
+
+	/* malformed packets never reach the hashes */
+	failures += check (minter_verify_packet (&minter, cpkt.data (), cpkt.size (),
+				data, DATA_LEN, NULL) == VERIFY_MALFORMED, "Challenge taken for a solution");
+	failures += check (minter_verify_packet (&minter, spkt.data (), spkt.size () - 1,
+				data, DATA_LEN, NULL) == VERIFY_MALFORMED, "Truncated packet accepted");
+
+	spkt[WIRE_HEADER_LEN] ^= 1;
+	failures += check (minter_verify_packet (&minter, spkt.data (), spkt.size (),
+				data, DATA_LEN, NULL) != VERIFY_OK, "Corrupted opt solution verified");
+
+	clear_minter (&minter);
+	OPENSSL_free (challenge->preimage);
+	OPENSSL_free (decoded->preimage);
+	free (challenge);
+	free (decoded);
+	free_solution_mem (sol);
+	free_solution_mem (back);
+
+	return failures;
+} /* test_opt */
+
+/* the header checks */
+static int
+test_malformed ()
+{
+	int failures = 0;
+
+	SHA256OptSolution sol = { 9, NULL };
+	SHA256OptSubSolution sub = { NULL, NULL };
+	unsigned char z[PREFIX_LEN/16] = { 0 };
+	sub.zi = z;
+	sol.head = &sub;
+
+	unsigned char pkt[64];
+	size_t len = encode_solution (&sol, PREFIX_LEN, 1, pkt, sizeof (pkt));
+
+	WirePacket wire;
+	failures += check (wire_parse (pkt, len, &wire) == WIRE_OK, "Good packet rejected");
+	failures += check (wire_parse (pkt, WIRE_HEADER_LEN - 1, &wire) == WIRE_TRUNCATED,
+			"Short header accepted");
+	failures += check (wire_parse (pkt, len - 1, &wire) == WIRE_TRUNCATED,
+			"Short body accepted");
+	failures += check (wire_parse (pkt, len + 1, &wire) == WIRE_BAD_LENGTH,
+			"Trailing bytes accepted");
+
+	pkt[2] = WIRE_VERSION + 1;
+	failures += check (wire_parse (pkt, len, &wire) == WIRE_BAD_VERSION, "Bad version accepted");
+	pkt[2] = WIRE_VERSION;
+
+	pkt[3] = 0;
+	failures += check (wire_parse (pkt, len, &wire) == WIRE_BAD_TYPE, "Bad type accepted");
+	pkt[3] = WIRE_OPT_SOLUTION;
+
+	pkt[12] = SHA256_DIGEST_LEN + 1;
+	failures += check (wire_parse (pkt, len, &wire) == WIRE_BAD_LENGTH, "Long z_i accepted");
+	pkt[12] = PREFIX_LEN/16;
+
+	pkt[0] ^= 0xff;
+	failures += check (wire_parse (pkt, len, &wire) == WIRE_BAD_MAGIC, "Bad magic accepted");
+
+	return failures;
+} /* test_malformed */
+
+/* the requests and answers of the datagram mode */
+static int
+test_datagrams ()
+{
+	int failures = 0;
+	unsigned char pkt[64];
+	WirePacket wire;
+
+	size_t len = encode_hello (24, pkt, sizeof (pkt));
+	failures += check (len == WIRE_HEADER_LEN + 24 && wire_parse (pkt, len, &wire) == WIRE_OK
+			&& wire.type == WIRE_HELLO && wire.elem_len == 24, "Hello packet rejected");
+	failures += check (encode_hello (64, pkt, sizeof (pkt)) == WIRE_HEADER_LEN + 64,
+			"Hello length miscounted");
+
+	len = encode_verdict (9, 3, pkt, sizeof (pkt));
+	failures += check (wire_parse (pkt, len, &wire) == WIRE_OK && wire.type == WIRE_VERDICT
+			&& wire.timestamp == 9 && wire.body[0] == 3, "Verdict packet rejected");
+
+	pkt[8] = 1; /* a verdict has no sub puzzles */
+	failures += check (wire_parse (pkt, len, &wire) == WIRE_BAD_LENGTH, "Verdict with k accepted");
+
+	return failures;
+} /* test_datagrams */
+
+int
+main (int argc, char **argv)
+{
+	int failures = 0;
+
+	unsigned char key[KEY_LEN], data[DATA_LEN];
+	for (unsigned int i = 0; i < KEY_LEN; i++)
+		key[i] = (unsigned char) (i * 7 + 1);
+	for (unsigned int i = 0; i < DATA_LEN; i++)
+		data[i] = (unsigned char) (i * 13 + 5);
+
+	failures += test_naive (key, data);
+	failures += test_opt (key, data);
+	failures += test_malformed ();
+	failures += test_datagrams ();
+
+	if (failures)
+		printf ("[ERROR]: %d wire checks failed!\n", failures);
+	else
+		printf ("[Log]: All wire checks passed.\n");
+
+	return failures? 1 : 0;
+} /* main */